@@ -111,6 +111,15 @@ extern "C" {
  */
 #define TRANSCEIVER_RX_ENABLE_PORT_BIT PORTS_BIT_POS_1
 
+/**
+ * @brief Use the USART, timer & input capture modules above at compile time.
+ *
+ * When this is defined, the module ids, vectors & interrupt sources in
+ * TransceiverHardwareSettings are ignored. This allows the PLIB calls in the
+ * transceiver to inline to direct register accesses.
+ */
+#define TRANSCEIVER_STATIC_HARDWARE
+
 /**
  * @}
  *
@@ -171,6 +180,16 @@ extern "C" {
  */
 #define SPI_USE_ENHANCED_BUFFERING true
 
+/**
+ * @brief Use DMA to transmit the pixel data.
+ */
+#define SPI_USE_DMA true
+
+/**
+ * @brief The DMA channel to use for the SPI output.
+ */
+#define SPI_DMA_CHANNEL DMA_CHANNEL_0
+
 /**
  * @}
  * @}
@@ -46,6 +46,9 @@
 #define PIPELINE_TRANSCEIVER_RX_EVENT(event) \
   Responder_Receive(event);
 
+#define PIPELINE_TRANSCEIVER_SNIFFER_EVENT(event) \
+  Sniffer_Receive(event);
+
 #define PIPELINE_RDMRESPONDER_SEND(include_break, iov, iov_len) \
   Transceiver_QueueRDMResponse(include_break, iov, iov_len);
 
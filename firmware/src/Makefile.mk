@@ -1,9 +1,18 @@
 noinst_LTLIBRARIES += firmware/src/libcoarsetimer.la \
+                      firmware/src/libdimmercurve.la \
                       firmware/src/libdimmermodel.la \
+                      firmware/src/libdmxforwarder.la \
+                      firmware/src/libdmxrle.la \
+                      firmware/src/libdmxsnapshot.la \
+                      firmware/src/libevents.la \
+                      firmware/src/libfader.la \
                       firmware/src/libflags.la \
                       firmware/src/libledmodel.la \
                       firmware/src/libmessagehandler.la \
+                      firmware/src/libmodelarena.la \
                       firmware/src/libnetworkmodel.la \
+                      firmware/src/libpixelencoder.la \
+                      firmware/src/libpixelmapper.la \
                       firmware/src/libproxymodel.la \
                       firmware/src/librandom.la \
                       firmware/src/librdmbuffer.la \
@@ -12,32 +21,80 @@ noinst_LTLIBRARIES += firmware/src/libcoarsetimer.la \
                       firmware/src/librdmutil.la \
                       firmware/src/libreceivercounters.la \
                       firmware/src/libresponder.la \
+                      firmware/src/libscheduler.la \
+                      firmware/src/libsniffer.la \
                       firmware/src/libspi.la \
                       firmware/src/libspirgb.la \
                       firmware/src/libstreamdecoder.la \
+                      firmware/src/libtimerwheel.la \
+                      firmware/src/libtrace.la \
                       firmware/src/libtransceiver.la \
                       firmware/src/libusbtransport.la
 
 firmware_src_libcoarsetimer_la_SOURCES = firmware/src/coarse_timer.c
 firmware_src_libcoarsetimer_la_CFLAGS = $(BUILD_FLAGS)
 
+firmware_src_libdimmercurve_la_SOURCES = firmware/src/dimmer_curve.c
+firmware_src_libdimmercurve_la_CFLAGS = $(BUILD_FLAGS)
+
 firmware_src_libdimmermodel_la_SOURCES = firmware/src/dimmer_model.c
 firmware_src_libdimmermodel_la_CFLAGS = $(BUILD_FLAGS)
+firmware_src_libdimmermodel_la_LIBADD = firmware/src/libdimmercurve.la \
+                                       firmware/src/libdmxsnapshot.la \
+                                       firmware/src/libfader.la \
+                                       firmware/src/libmodelarena.la \
+                                       firmware/src/libpixelmapper.la \
+                                       firmware/src/libtimerwheel.la
+
+firmware_src_libdmxforwarder_la_SOURCES = firmware/src/dmx_forwarder.c
+firmware_src_libdmxforwarder_la_CFLAGS = $(BUILD_FLAGS)
+firmware_src_libdmxforwarder_la_LIBADD = firmware/src/libdmxsnapshot.la \
+                                        firmware/src/libscheduler.la
+
+firmware_src_libdmxrle_la_SOURCES = firmware/src/dmx_rle.c
+firmware_src_libdmxrle_la_CFLAGS = $(BUILD_FLAGS)
+
+firmware_src_libdmxsnapshot_la_SOURCES = firmware/src/dmx_snapshot.c
+firmware_src_libdmxsnapshot_la_CFLAGS = $(BUILD_FLAGS)
+firmware_src_libdmxsnapshot_la_LIBADD = firmware/src/libscheduler.la
+
+firmware_src_libevents_la_SOURCES = firmware/src/events.c
+firmware_src_libevents_la_CFLAGS = $(BUILD_FLAGS)
+
+firmware_src_libfader_la_SOURCES = firmware/src/fader.c
+firmware_src_libfader_la_CFLAGS = $(BUILD_FLAGS)
 
 firmware_src_libflags_la_SOURCES = firmware/src/flags.c
 firmware_src_libflags_la_CFLAGS = $(BUILD_FLAGS)
 
 firmware_src_libledmodel_la_SOURCES = firmware/src/led_model.c
 firmware_src_libledmodel_la_CFLAGS = $(BUILD_FLAGS)
+firmware_src_libledmodel_la_LIBADD = firmware/src/libpixelencoder.la \
+                                    firmware/src/libpixelmapper.la
 
 firmware_src_libmessagehandler_la_SOURCES = firmware/src/message_handler.c
 firmware_src_libmessagehandler_la_CFLAGS = $(BUILD_FLAGS)
+firmware_src_libmessagehandler_la_LIBADD = firmware/src/libdmxforwarder.la \
+                                          firmware/src/libdmxrle.la \
+                                          firmware/src/libtrace.la
+
+firmware_src_libmodelarena_la_SOURCES = firmware/src/model_arena.c
+firmware_src_libmodelarena_la_CFLAGS = $(BUILD_FLAGS)
 
 firmware_src_libnetworkmodel_la_SOURCES = firmware/src/network_model.c
 firmware_src_libnetworkmodel_la_CFLAGS = $(BUILD_FLAGS)
+firmware_src_libnetworkmodel_la_LIBADD = firmware/src/libmodelarena.la
+
+firmware_src_libpixelencoder_la_SOURCES = firmware/src/pixel_encoder.c
+firmware_src_libpixelencoder_la_CFLAGS = $(BUILD_FLAGS)
+
+firmware_src_libpixelmapper_la_SOURCES = firmware/src/pixel_mapper.c
+firmware_src_libpixelmapper_la_CFLAGS = $(BUILD_FLAGS)
 
 firmware_src_libproxymodel_la_SOURCES = firmware/src/proxy_model.c
 firmware_src_libproxymodel_la_CFLAGS = $(BUILD_FLAGS)
+firmware_src_libproxymodel_la_LIBADD = firmware/src/libevents.la \
+                                      firmware/src/libmodelarena.la
 
 firmware_src_librandom_la_SOURCES = firmware/src/random.c
 firmware_src_librandom_la_CFLAGS = $(BUILD_FLAGS)
@@ -50,6 +107,7 @@ firmware_src_librdmhandler_la_CFLAGS = $(BUILD_FLAGS)
 
 firmware_src_librdmresponder_la_SOURCES = firmware/src/rdm_responder.c
 firmware_src_librdmresponder_la_CFLAGS = $(BUILD_FLAGS)
+firmware_src_librdmresponder_la_LIBADD = firmware/src/libtimerwheel.la
 
 firmware_src_librdmutil_la_SOURCES = firmware/src/rdm_util.c
 firmware_src_librdmutil_la_CFLAGS = $(BUILD_FLAGS)
@@ -59,9 +117,21 @@ firmware_src_libreceivercounters_la_CFLAGS = $(BUILD_FLAGS)
 
 firmware_src_libresponder_la_SOURCES = firmware/src/responder.c
 firmware_src_libresponder_la_CFLAGS = $(BUILD_FLAGS)
+firmware_src_libresponder_la_LIBADD = firmware/src/libdmxsnapshot.la \
+                                     firmware/src/libevents.la \
+                                     firmware/src/libpixelmapper.la
+
+firmware_src_libscheduler_la_SOURCES = firmware/src/scheduler.c
+firmware_src_libscheduler_la_CFLAGS = $(BUILD_FLAGS)
+
+firmware_src_libsniffer_la_SOURCES = firmware/src/sniffer.c
+firmware_src_libsniffer_la_CFLAGS = $(BUILD_FLAGS)
+firmware_src_libsniffer_la_LIBADD = firmware/src/libscheduler.la
 
 firmware_src_libspirgb_la_SOURCES = firmware/src/spi_rgb.c
 firmware_src_libspirgb_la_CFLAGS = $(BUILD_FLAGS)
+firmware_src_libspirgb_la_LIBADD = firmware/src/libpixelencoder.la \
+                                   firmware/src/libscheduler.la
 
 firmware_src_libspi_la_SOURCES = firmware/src/spi.c
 firmware_src_libspi_la_CFLAGS = $(BUILD_FLAGS)
@@ -69,9 +139,21 @@ firmware_src_libspi_la_CFLAGS = $(BUILD_FLAGS)
 firmware_src_libstreamdecoder_la_SOURCES = firmware/src/stream_decoder.c
 firmware_src_libstreamdecoder_la_CFLAGS = $(BUILD_FLAGS)
 
+firmware_src_libtimerwheel_la_SOURCES = firmware/src/timer_wheel.c
+firmware_src_libtimerwheel_la_CFLAGS = $(BUILD_FLAGS)
+firmware_src_libtimerwheel_la_LIBADD = firmware/src/libscheduler.la
+
+firmware_src_libtrace_la_SOURCES = firmware/src/trace.c
+firmware_src_libtrace_la_CFLAGS = $(BUILD_FLAGS)
+
 firmware_src_libtransceiver_la_SOURCES = firmware/src/transceiver.c
 firmware_src_libtransceiver_la_CFLAGS = $(BUILD_FLAGS)
-firmware_src_libtransceiver_la_LIBADD = firmware/src/librandom.la
+firmware_src_libtransceiver_la_LIBADD = firmware/src/libdmxrle.la \
+                                       firmware/src/libevents.la \
+                                       firmware/src/librandom.la \
+                                       firmware/src/libscheduler.la \
+                                       firmware/src/libtrace.la
 
 firmware_src_libusbtransport_la_SOURCES = firmware/src/usb_transport.c
 firmware_src_libusbtransport_la_CFLAGS = $(BUILD_FLAGS)
+firmware_src_libusbtransport_la_LIBADD = firmware/src/libscheduler.la
@@ -23,6 +23,8 @@
 
 #include "coarse_timer.h"
 #include "dimmer_model.h"
+#include "dmx_forwarder.h"
+#include "events.h"
 #include "led_model.h"
 #include "message_handler.h"
 #include "moving_light.h"
@@ -32,13 +34,18 @@
 #include "rdm_handler.h"
 #include "rdm_responder.h"
 #include "receiver_counters.h"
+#include "responder.h"
+#include "scheduler.h"
 #include "sensor_model.h"
 #include "setting_macros.h"
+#include "sniffer.h"
 #include "spi_rgb.h"
 #include "stream_decoder.h"
 #include "syslog.h"
 #include "system_definitions.h"
 #include "temperature.h"
+#include "timer_wheel.h"
+#include "trace.h"
 #include "transceiver.h"
 #include "uid_store.h"
 #include "usb_descriptors.h"
@@ -49,6 +56,68 @@
 
 void __ISR(AS_TIMER_ISR_VECTOR(COARSE_TIMER_ID), ipl6AUTO) TimerEvent() {
   CoarseTimer_TimerEvent();
+  Scheduler_TimerEvent(CoarseTimer_GetTime());
+}
+
+/*
+ * @brief Merge a task's deadline into the earliest deadline.
+ */
+static inline void MergeDeadline(bool has_deadline, uint32_t task_delay,
+                                 bool *wake, uint32_t *delay) {
+  if (has_deadline && (!*wake || task_delay < *delay)) {
+    *wake = true;
+    *delay = task_delay;
+  }
+}
+
+/*
+ * @brief Set the wake time to the earliest deadline of the tasks which poll
+ * the clock.
+ *
+ * Everything else posts work when it's ready, so if there are no deadlines
+ * the core idles until the next USB or transceiver interrupt.
+ */
+static void SetWakeTime() {
+  bool wake = false;
+  uint32_t delay = 0u;
+  uint32_t task_delay = 0u;
+
+  MergeDeadline(TimerWheel_NextDeadline(&task_delay), task_delay,
+                &wake, &delay);
+  MergeDeadline(Transceiver_NextDeadline(&task_delay), task_delay,
+                &wake, &delay);
+  MergeDeadline(Sniffer_NextDeadline(&task_delay), task_delay, &wake, &delay);
+  MergeDeadline(DMXForwarder_NextDeadline(&task_delay), task_delay,
+                &wake, &delay);
+  if (Transceiver_GetMode() == T_MODE_RESPONDER) {
+    MergeDeadline(SPIRGB_NextDeadline(&task_delay), task_delay,
+                  &wake, &delay);
+    MergeDeadline(Temperature_NextDeadline(&task_delay), task_delay,
+                  &wake, &delay);
+  }
+
+  if (!wake) {
+    Scheduler_ClearWakeTime();
+  } else if (delay == 0u) {
+    Scheduler_ClearWakeTime();
+    Scheduler_Post(SCHEDULER_TICK);
+  } else {
+    Scheduler_SetWakeTime(CoarseTimer_GetTime() + delay);
+  }
+}
+
+/*
+ * @brief Idle the CPU until the next interrupt, if there is no pending work.
+ */
+static void Idle() {
+  // Interrupts are disabled so an ISR can't post work between the check and
+  // the WAIT. A pending interrupt still takes the core out of WAIT when
+  // interrupts are disabled, the ISR then runs once they're restored.
+  bool interrupts_enabled = SYS_INT_Disable();
+  if (!Scheduler_HasWork()) {
+    __asm__ __volatile__("wait");
+  }
+  SYS_INT_Restore(interrupts_enabled);
 }
 
 void APP_Initialize(void) {
@@ -67,7 +136,10 @@ void APP_Initialize(void) {
   };
   SYS_INT_VectorPrioritySet(AS_TIMER_INTERRUPT_VECTOR(COARSE_TIMER_ID),
                             INT_PRIORITY_LEVEL6);
+  Scheduler_Initialize();
   CoarseTimer_Initialize(&timer_settings);
+  TimerWheel_Initialize();
+  Trace_Initialize();
 
   // Initialize the Logging system, bottom up
   USBTransport_Initialize(NULL);
@@ -107,6 +179,7 @@ void APP_Initialize(void) {
   memcpy(responder_settings.uid, UIDStore_GetUID(), UID_LENGTH);
   RDMResponder_Initialize(&responder_settings);
   ReceiverCounters_ResetCounters();
+  Responder_Initialize();
 
   // RDM Handler
   RDMHandlerSettings rdm_handler_settings = {
@@ -139,30 +212,66 @@ void APP_Initialize(void) {
   StreamDecoder_Initialize(NULL);
 
   Flags_Initialize();
+  Events_Initialize(NULL);
+  Sniffer_Initialize(NULL);
+  DMXForwarder_Initialize(NULL);
 
   // SPI DMX Output
   SPIRGBConfiguration spi_config;
   spi_config.module_id = SPI_MODULE_ID;
   spi_config.baud_rate = SPI_BAUD_RATE;
   spi_config.use_enhanced_buffering = SPI_USE_ENHANCED_BUFFERING;
+  spi_config.use_dma = SPI_USE_DMA;
+  spi_config.dma_channel = SPI_DMA_CHANNEL;
   SPIRGB_Init(&spi_config);
 
   // Send a frame with all pixels set to 0.
   SPIRGB_BeginUpdate();
   SPIRGB_CompleteUpdate();
+
+  // Run all the tasks once, which sets the first wake time.
+  Scheduler_Post(SCHEDULER_TICK);
 }
 
 void APP_Tasks(void) {
-  USBTransport_Tasks();
-  Transceiver_Tasks();
-  USBConsole_Tasks();
+  // The tick means a deadline was reached. Deadlines are only checked by
+  // polling the clock, so it runs all the tasks. Otherwise only the tasks
+  // with work run.
+  bool tick = Scheduler_Take(SCHEDULER_TICK);
+  bool host = Scheduler_Take(SCHEDULER_HOST) || tick;
+  bool transceiver = Scheduler_Take(SCHEDULER_TRANSCEIVER) || tick;
 
-  if (Transceiver_GetMode() == T_MODE_RESPONDER) {
-    RDMResponder_Tasks();
+  if (tick) {
+    TimerWheel_Tasks();
+  }
+  if (host) {
+    USBTransport_Tasks();
+  }
+  if (transceiver) {
+    Transceiver_Tasks();
+  }
+  if (host || transceiver) {
+    // After the transceiver, so responses go ahead of events.
+    Events_Tasks();
+    Sniffer_Tasks();
+    DMXForwarder_Tasks();
+    USBConsole_Tasks();
+  }
+
+  if (transceiver && Transceiver_GetMode() == T_MODE_RESPONDER) {
     RDMHandler_Tasks();
+    Responder_Tasks();
     SPIRGB_Tasks();
     Temperature_Tasks();
   }
+
+  // The tick cleared the wake time. Otherwise the current wake time holds
+  // until a task notes a new, or earlier, deadline.
+  bool deadline_changed = Scheduler_TakeDeadlineChanged();
+  if (tick || deadline_changed) {
+    SetWakeTime();
+  }
+  Idle();
 }
 
 void APP_Reset() {
@@ -22,6 +22,13 @@
 typedef struct {
   CoarseTimer_Settings settings;
   volatile uint32_t timer_count;
+  /*
+   * @brief The timer_count when the timer interrupt was last cleared.
+   *
+   * This differs from timer_count while TimerEvent() is running, which lets
+   * a higher priority ISR tell if the rollover has been counted yet.
+   */
+  volatile uint32_t cleared_count;
 } CoarseTimer_Data;
 
 CoarseTimer_Data g_coarse_timer;
@@ -29,10 +36,12 @@ CoarseTimer_Data g_coarse_timer;
 void CoarseTimer_TimerEvent() {
   g_coarse_timer.timer_count++;
   SYS_INT_SourceStatusClear(g_coarse_timer.settings.interrupt_source);
+  g_coarse_timer.cleared_count = g_coarse_timer.timer_count;
 }
 
 void CoarseTimer_Initialize(const CoarseTimer_Settings *settings) {
   g_coarse_timer.timer_count = 0u;
+  g_coarse_timer.cleared_count = 0u;
   g_coarse_timer.settings = *settings;
 
   PLIB_TMR_Stop(settings->timer_id);
@@ -51,10 +60,35 @@ void CoarseTimer_Initialize(const CoarseTimer_Settings *settings) {
 }
 
 CoarseTimer_Value CoarseTimer_GetTime() {
-  SYS_INT_SourceDisable(g_coarse_timer.settings.interrupt_source);
-  CoarseTimer_Value value = g_coarse_timer.timer_count;
-  SYS_INT_SourceEnable(g_coarse_timer.settings.interrupt_source);
-  return value;
+  // The counter is an aligned 32 bit word, which is read with a single load,
+  // so there's no need to mask the timer interrupt.
+  return g_coarse_timer.timer_count;
+}
+
+uint32_t CoarseTimer_GetMicroseconds() {
+  uint32_t count;
+  uint16_t ticks;
+  bool rolled_over;
+  do {
+    count = g_coarse_timer.timer_count;
+    ticks = PLIB_TMR_Counter16BitGet(g_coarse_timer.settings.timer_id);
+    // If the timer interrupt is pending, the hardware timer has rolled over
+    // but the ISR hasn't run yet, either because it's between the reads or
+    // we're in a higher priority ISR. If we preempted TimerEvent() after it
+    // incremented the count, but before it cleared the interrupt, the
+    // rollover has already been counted.
+    rolled_over = SYS_INT_SourceStatusGet(
+        g_coarse_timer.settings.interrupt_source) &&
+        count == g_coarse_timer.cleared_count;
+    if (rolled_over) {
+      ticks = PLIB_TMR_Counter16BitGet(g_coarse_timer.settings.timer_id);
+    }
+  } while (count != g_coarse_timer.timer_count);
+
+  if (rolled_over) {
+    count++;
+  }
+  return count * 100u + ticks / (SYS_CLK_FREQ / 1000000u);
 }
 
 uint32_t CoarseTimer_ElapsedTime(CoarseTimer_Value start_time) {
@@ -84,4 +118,5 @@ bool CoarseTimer_HasElapsed(uint32_t start_time, uint32_t duration) {
 
 void CoarseTimer_SetCounter(uint32_t count) {
   g_coarse_timer.timer_count = count;
+  g_coarse_timer.cleared_count = count;
 }
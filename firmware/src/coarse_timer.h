@@ -98,10 +98,23 @@ void CoarseTimer_TimerEvent();
  * @returns The current value of the timer counter.
  *
  * The value returned can be later passed to CoarseTimer_HasElapsed() and
- * CoarseTimer_ElapsedTime().
+ * CoarseTimer_ElapsedTime(). This doesn't mask the timer interrupt, so it's
+ * cheap to call from any ISR.
  */
 CoarseTimer_Value CoarseTimer_GetTime();
 
+/**
+ * @brief Get a high resolution timestamp.
+ * @returns The time since the timer was initialized, in microseconds. This
+ *   wraps after about 71 minutes.
+ *
+ * This combines the counter with the hardware timer value, so unlike
+ * CoarseTimer_GetTime() it's accurate to a microsecond. It doesn't mask the
+ * timer interrupt, and it's safe to call from any ISR, including one which
+ * preempts CoarseTimer_TimerEvent().
+ */
+uint32_t CoarseTimer_GetMicroseconds();
+
 /**
  * @brief Return the interval since the start_time.
  * @param start_time The time to measure from.
@@ -135,6 +148,22 @@ uint32_t CoarseTimer_Delta(CoarseTimer_Value start_time,
  */
 bool CoarseTimer_HasElapsed(CoarseTimer_Value start_time, uint32_t interval);
 
+/**
+ * @brief Return the time until a time interval has passed.
+ * @param start_time The time to measure from.
+ * @param interval The time interval in 10ths of a millisecond.
+ * @returns The time until CoarseTimer_HasElapsed() returns true for the
+ *   interval, in 10ths of a millisecond. This is 0 if it already does.
+ */
+static inline uint32_t CoarseTimer_Remaining(CoarseTimer_Value start_time,
+                                             uint32_t interval) {
+  const uint32_t elapsed = CoarseTimer_ElapsedTime(start_time);
+  if (interval == 0u || elapsed > interval) {
+    return 0u;
+  }
+  return interval + 1u - elapsed;
+}
+
 /**
  * @brief Manually set the internal counter.
  * @param count the new value of the internal counter.
@@ -198,6 +198,23 @@ typedef enum {
 
   // DMX
   TX_DMX = 0x30,  //!< Transmit a DMX frame. See @ref message-commands-txdmx.
+  /**
+   * @brief Transmit a run length encoded DMX frame.
+   * See @ref message-commands-txdmxrle.
+   */
+  COMMAND_TX_DMX_RLE = 0x31,
+
+  /**
+   * @brief Set the interval used to forward received DMX512 to the host.
+   * See @ref message-commands-setdmxforwarding.
+   */
+  COMMAND_SET_DMX_FORWARDING = 0x32,
+
+  /**
+   * @brief Get the interval used to forward received DMX512 to the host.
+   * See @ref message-commands-getdmxforwarding.
+   */
+  COMMAND_GET_DMX_FORWARDING = 0x33,
 
   // RDM
   /**
@@ -218,9 +235,39 @@ typedef enum {
    */
   COMMAND_RDM_BROADCAST_REQUEST = 0x42,
 
+  // Device initiated
+  /**
+   * @brief Sent by the device when the flow control credits rise from zero.
+   * See @ref message-commands-creditupdate.
+   */
+  COMMAND_CREDIT_UPDATE = 0x50,
+
+  /**
+   * @brief Sent by the device when events occur.
+   * See @ref message-commands-event.
+   */
+  COMMAND_EVENT = 0x51,
+
+  /**
+   * @brief Sent by the device in sniffer mode with the captured frames.
+   * See @ref message-commands-snifferdata.
+   */
+  COMMAND_SNIFFER_DATA = 0x52,
+
+  /**
+   * @brief Sent by the device in responder mode when the DMX512 data changes.
+   * See @ref message-commands-dmxdata.
+   */
+  COMMAND_DMX_DATA = 0x53,
+
   // Experimental / testing
   COMMAND_ECHO = 0xf0,  //!< Echo the data back. See @ref message-commands-echo
   GET_FLAGS = 0xf2,  //!< Get the flags state
+  /**
+   * @brief Fetch the transceiver trace records.
+   * See @ref message-commands-gettrace.
+   */
+  COMMAND_GET_TRACE = 0xf3,
 } Command;
 
 /**
@@ -260,6 +307,13 @@ typedef enum {
  */
 #define END_OF_MESSAGE_ID 0xa5u
 
+/**
+ * @brief The token used for messages the device sends unprompted.
+ *
+ * The Host must not use this token in requests.
+ */
+#define EVENT_TOKEN 0xffu
+
 /**
  * @brief The maximum payload size in a message.
  */
@@ -0,0 +1,78 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * dimmer_curve.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "dimmer_curve.h"
+
+enum { MAX_SLOT_VALUE = 255u };
+enum { MAX_LEVEL = 0xffffu };
+
+/*
+ * @brief Evaluate a curve, at full scale.
+ * @param type The curve type.
+ * @param value The slot value.
+ * @returns The level, from 0 to MAX_LEVEL.
+ */
+static uint32_t Evaluate(DimmerCurveType type, uint8_t value) {
+  // 255 * 255 * 0xffff fits within 32 bits.
+  const uint32_t linear = value * (MAX_LEVEL / MAX_SLOT_VALUE);
+  const uint32_t square = (uint32_t) value * value * MAX_LEVEL /
+                          (MAX_SLOT_VALUE * MAX_SLOT_VALUE);
+  switch (type) {
+    case DIMMER_CURVE_MODIFIED_LINEAR:
+      // Linear plus half the difference between linear & inverse square.
+      return (3u * linear - square) / 2u;
+    case DIMMER_CURVE_SQUARE:
+      return square;
+    case DIMMER_CURVE_MODIFIED_SQUARE:
+      return (linear + square) / 2u;
+    case DIMMER_CURVE_LINEAR:
+    default:
+      return linear;
+  }
+}
+
+uint16_t DimmerCurve_Level(const DimmerCurveSettings *settings,
+                           uint8_t value) {
+  const uint32_t min_level = settings->min_level;
+  if (value == 0u) {
+    return settings->on_below_min ? min_level : 0u;
+  }
+
+  uint32_t range = 0u;
+  if (settings->max_level > settings->min_level) {
+    range = settings->max_level - settings->min_level;
+  }
+  return min_level + Evaluate(settings->type, value) * range / MAX_LEVEL;
+}
+
+void DimmerCurve_Build(DimmerCurve *curve,
+                       const DimmerCurveSettings *settings) {
+  unsigned int value = 0u;
+  for (; value <= MAX_SLOT_VALUE; value++) {
+    curve->levels[value] = DimmerCurve_Level(settings, value);
+  }
+}
+
+void DimmerCurve_Apply(const DimmerCurve *curve, uint16_t *levels,
+                       const uint8_t *slots, unsigned int count) {
+  const uint8_t *end = slots + count;
+  while (slots != end) {
+    *levels++ = curve->levels[*slots++];
+  }
+}
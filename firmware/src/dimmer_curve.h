@@ -0,0 +1,128 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * dimmer_curve.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup dimmer_curve Dimmer Curve
+ * @brief Convert DMX512 slot values to dimmer output levels.
+ *
+ * A dimmer curve maps an 8-bit slot value to a 16-bit output level. The
+ * curves are:
+ *  - Linear, the output is proportional to the slot value.
+ *  - Modified Linear, half way between linear and inverse square, this gives
+ *    more output at the low end.
+ *  - Square, the output is proportional to the square of the slot value.
+ *  - Modified Square, half way between linear and square.
+ *
+ * The curve is then scaled to between the minimum & maximum levels. A slot
+ * value of 0 is off, unless on_below_min is set, in which case it's the
+ * minimum level.
+ *
+ * The levels for all 256 slot values are precomputed into a table when the
+ * settings change, so applying the curve to a frame is a single lookup per
+ * slot. When there are too many outputs to hold a table for each, the level
+ * can be calculated for a single slot value with DimmerCurve_Level().
+ *
+ * @addtogroup dimmer_curve
+ * @{
+ * @file dimmer_curve.h
+ * @brief Convert DMX512 slot values to dimmer output levels.
+ */
+
+#ifndef FIRMWARE_SRC_DIMMER_CURVE_H_
+#define FIRMWARE_SRC_DIMMER_CURVE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The dimmer curves.
+ *
+ * These are the values used by PID_CURVE.
+ */
+typedef enum {
+  DIMMER_CURVE_LINEAR = 1,  //!< Linear
+  DIMMER_CURVE_MODIFIED_LINEAR = 2,  //!< Modified Linear
+  DIMMER_CURVE_SQUARE = 3,  //!< Square
+  DIMMER_CURVE_MODIFIED_SQUARE = 4,  //!< Modified Square
+} DimmerCurveType;
+
+/**
+ * @brief The number of dimmer curves.
+ */
+enum { DIMMER_CURVE_COUNT = 4u };
+
+/**
+ * @brief The settings used to build a dimmer curve.
+ */
+typedef struct {
+  DimmerCurveType type;  //!< The curve, unknown curves are treated as linear.
+  uint16_t min_level;  //!< The output level for a slot value of 1.
+  uint16_t max_level;  //!< The output level for a slot value of 255.
+  bool on_below_min;  //!< If true, a slot value of 0 is min_level, not off.
+} DimmerCurveSettings;
+
+/**
+ * @brief A dimmer curve.
+ */
+typedef struct {
+  uint16_t levels[256];  //!< The output level for each slot value.
+} DimmerCurve;
+
+/**
+ * @brief Build a dimmer curve.
+ * @param curve The curve to build.
+ * @param settings The settings to use. If max_level is less than min_level,
+ *   min_level is used for both.
+ */
+void DimmerCurve_Build(DimmerCurve *curve,
+                       const DimmerCurveSettings *settings);
+
+/**
+ * @brief Calculate the output level for a single slot value.
+ * @param settings The settings to use, see DimmerCurve_Build().
+ * @param value The slot value.
+ * @returns The output level, this matches the level in a curve built with the
+ *   same settings.
+ */
+uint16_t DimmerCurve_Level(const DimmerCurveSettings *settings, uint8_t value);
+
+/**
+ * @brief Convert slot values to output levels.
+ * @param curve The curve to use.
+ * @param levels The memory to write the levels to, this must be at least
+ *   count entries.
+ * @param slots The slot values.
+ * @param count The number of slots.
+ */
+void DimmerCurve_Apply(const DimmerCurve *curve, uint16_t *levels,
+                       const uint8_t *slots, unsigned int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif  // FIRMWARE_SRC_DIMMER_CURVE_H_
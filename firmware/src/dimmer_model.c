@@ -19,14 +19,22 @@
 #include "dimmer_model.h"
 
 #include <stdlib.h>
+#include <string.h>
 
-#include "coarse_timer.h"
 #include "constants.h"
+#include "dimmer_curve.h"
+#include "dmx_snapshot.h"
+#include "dmx_spec.h"
+#include "fader.h"
 #include "macros.h"
+#include "model_arena.h"
+#include "pixel_mapper.h"
 #include "rdm_frame.h"
 #include "rdm_buffer.h"
 #include "rdm_responder.h"
 #include "rdm_util.h"
+#include "spi_rgb.h"
+#include "timer_wheel.h"
 #include "utils.h"
 
 #include <syslog.h>
@@ -34,10 +42,30 @@
 #include <system_config.h>
 
 // Various constants
-enum { NUMBER_OF_SUB_DEVICES = 4 };
+#ifndef DIMMER_MODEL_SUB_DEVICES
+#define DIMMER_MODEL_SUB_DEVICES 4
+#endif
+#if DIMMER_MODEL_SUB_DEVICES < 1 || DIMMER_MODEL_SUB_DEVICES > 512
+#error "DIMMER_MODEL_SUB_DEVICES must be between 1 and 512"
+#endif
+enum { NUMBER_OF_SUB_DEVICES = DIMMER_MODEL_SUB_DEVICES };
+// Leave a gap at sub-device 2, since sub devices aren't required to be
+// contiguous. There isn't room for one with the maximum number of sub-devices.
+#if DIMMER_MODEL_SUB_DEVICES < 512
+enum { SKIPPED_SUB_DEVICE = 2 };
+#else
+enum { SKIPPED_SUB_DEVICE = 0 };
+#endif
+enum { SUB_DEVICE_FOOTPRINT = 1 };
+// Only the first SPIRGB_MAX_PIXELS sub-devices drive a pixel.
+enum {
+  OUTPUT_PIXELS = (int) NUMBER_OF_SUB_DEVICES < (int) SPIRGB_MAX_PIXELS ?
+      (int) NUMBER_OF_SUB_DEVICES : (int) SPIRGB_MAX_PIXELS
+};
+enum { SUB_DEVICE_STATUS_MESSAGES = 4 };
 enum { NUMBER_OF_SCENES = 3 };
 enum { NUMBER_OF_LOCK_STATES = 3 };
-enum { NUMBER_OF_CURVES = 4 };
+enum { NUMBER_OF_CURVES = DIMMER_CURVE_COUNT };
 enum { NUMBER_OF_OUTPUT_RESPONSE_TIMES = 2 };
 enum { NUMBER_OF_MODULATION_FREQUENCIES = 4 };
 enum { NUMBER_OF_SELF_TESTS = 2 };
@@ -50,7 +78,14 @@ static const char DEFAULT_DEVICE_LABEL[] = "Ja Rule";
 static const char PERSONALITY_DESCRIPTION[] = "Dimmer";
 static const uint8_t STATUS_TYPE_MASK = 0xf;
 static const uint16_t INITIAL_START_ADDRESSS = 1u;
+static const uint16_t DEFAULT_MAX_LEVEL = 0xfffe;
 static const uint32_t STATUS_MESSAGE_TRIGGER_INTERVAL = 300000;  // 30s
+static const uint32_t TICK_INTERVAL = 200u;  // 20ms, less than a DMX frame
+static const uint32_t TICKS_PER_TENTH = 5u;  // Times are in 10ths of a s
+static const uint16_t INFINITE_TIME = 0xffffu;
+// The maximum time between DMX breaks is 1.25s, so don't declare the signal
+// lost before then.
+static const uint32_t MIN_LOSS_OF_SIGNAL_TICKS = 63u;
 
 static const char LOCK_STATE_DESCRIPTION_UNLOCKED[] = "Unlocked";
 static const char LOCK_STATE_DESCRIPTION_SUBDEVICES_LOCKED[] =
@@ -87,11 +122,26 @@ typedef struct {
   const char *description;
 } ModulationFrequency;
 
+typedef enum {
+  PLAYBACK_IDLE,  //!< No fade is in progress.
+  PLAYBACK_FADING,  //!< Fading to a scene.
+  PLAYBACK_WAITING,  //!< Waiting before fading to the next scene.
+} PlaybackState;
+
+typedef enum {
+  SIGNAL_STARTUP_DELAY,  //!< No DMX since startup, waiting to play a scene.
+  SIGNAL_STARTUP_HOLD,  //!< Holding the startup scene.
+  SIGNAL_PRESENT,  //!< DMX is being received.
+  SIGNAL_FAIL_HOLD,  //!< DMX was lost, holding the fail scene.
+  SIGNAL_RELEASED,  //!< The hold time expired, DMX is treated as 0.
+} SignalState;
+
 typedef struct {
   uint16_t up_fade_time;
   uint16_t down_fade_time;
   uint16_t wait_time;
   uint8_t programmed_state;
+  uint8_t levels[NUMBER_OF_SUB_DEVICES];
 } Scene;
 
 typedef struct {
@@ -115,8 +165,8 @@ typedef struct {
    * Remember this when using the array.
    */
   Scene scenes[NUMBER_OF_SCENES];
-  CoarseTimer_Value status_message_timer;
-  CoarseTimer_Value self_test_timer;
+  TimerWheel_Timer status_message_timer;
+  TimerWheel_Timer self_test_timer;
   StatusMessage status_message;
 
   uint16_t playback_mode;
@@ -136,32 +186,67 @@ typedef struct {
 
   bool power_on_self_test;
   uint8_t running_self_test;
+
+  /*
+   * @brief The DMXSnapshot generation last written to the output.
+   */
+  uint32_t output_generation;
+  bool output_changed;  //!< True if the output needs to be sent again.
+
+  PlaybackState playback_state;
+  uint16_t active_scene;  //!< The scene being played back, indexed from 1.
+  uint16_t active_mode;  //!< The playback mode, which may be overridden.
+  uint8_t active_level;  //!< The playback level, which may be overridden.
+  uint32_t wait_ticks;  //!< The ticks remaining before the next scene.
+  TimerWheel_Timer tick_timer;  //!< Runs every TICK_INTERVAL.
+
+  SignalState signal_state;
+  /*
+   * @brief The ticks remaining until the signal state changes.
+   *
+   * UINT32_MAX means the state never changes.
+   */
+  uint32_t signal_ticks;
+  /*
+   * @brief True if the startup or fail scene is overriding the output.
+   */
+  bool scene_override;
 } RootDevice;
 
-typedef struct {
-  RDMResponder responder;
-  StatusMessage status_message;
+enum {
+  SUB_DEVICE_IDENTIFY = 0x01,  //!< The identify state.
+  SUB_DEVICE_LTP_DMX = 0x02,  //!< DMX changed more recently than the preset.
+};
 
-  uint16_t index;
-  uint16_t min_level_increasing;
-  uint16_t min_level_decreasing;
-  uint16_t max_level;
-  uint8_t on_below_min;
-  uint8_t identify_mode;
-  uint8_t burn_in;
-  uint8_t curve;
-  uint8_t output_response_time;
-  uint8_t modulation_frequency;
-  RDMStatusType sd_report_threshold;
-} DimmerSubDevice;
+/*
+ * @brief The settings of the sub-devices.
+ *
+ * Each array is indexed by the position of the sub-device, see
+ * SubDeviceIndex(). Keeping the settings in arrays costs 17 bytes per
+ * sub-device, rather than a RDMResponder & a curve table for each, so the
+ * model can scale to the 512 sub-devices allowed by E1.20.
+ */
+typedef struct {
+  uint16_t start_address[NUMBER_OF_SUB_DEVICES];
+  uint16_t min_level_increasing[NUMBER_OF_SUB_DEVICES];
+  uint16_t min_level_decreasing[NUMBER_OF_SUB_DEVICES];
+  uint16_t max_level[NUMBER_OF_SUB_DEVICES];
+  uint8_t on_below_min[NUMBER_OF_SUB_DEVICES];
+  uint8_t identify_mode[NUMBER_OF_SUB_DEVICES];
+  uint8_t burn_in[NUMBER_OF_SUB_DEVICES];
+  uint8_t curve[NUMBER_OF_SUB_DEVICES];
+  uint8_t output_response_time[NUMBER_OF_SUB_DEVICES];
+  uint8_t modulation_frequency[NUMBER_OF_SUB_DEVICES];
+  uint8_t sd_report_threshold[NUMBER_OF_SUB_DEVICES];
+  uint8_t dmx_level[NUMBER_OF_SUB_DEVICES];
+  uint8_t flags[NUMBER_OF_SUB_DEVICES];  //!< SUB_DEVICE_IDENTIFY etc.
+} SubDeviceSettings;
 
 typedef struct {
   StatusMessage last[STATUS_MESSAGE_QUEUE_SIZE];
   uint8_t count;
 } StatusMessages;
 
-static DimmerSubDevice g_subdevices[NUMBER_OF_SUB_DEVICES];
-
 static const char* LOCK_STATES[NUMBER_OF_LOCK_STATES] = {
   LOCK_STATE_DESCRIPTION_UNLOCKED,
   LOCK_STATE_DESCRIPTION_SUBDEVICES_LOCKED,
@@ -214,15 +299,126 @@ static const SelfTest SELF_TESTS[NUMBER_OF_SELF_TESTS] = {
 static const ResponderDefinition ROOT_RESPONDER_DEFINITION;
 static const ResponderDefinition SUBDEVICE_RESPONDER_DEFINITION;
 
-static StatusMessages g_status_messages;
+/*
+ * @brief The state kept in the model arena while the dimmer is active.
+ *
+ * The root device isn't part of this, since it holds the settings that are
+ * preserved across a restart, like the startup & fail scenes.
+ */
+typedef struct {
+  SubDeviceSettings sub_devices;
+  RDMResponder sub_device_responder;
+  FaderChannel fade_channels[NUMBER_OF_SUB_DEVICES];
+  StatusMessage sub_device_messages[SUB_DEVICE_STATUS_MESSAGES];
+  StatusMessages status_messages;
+  uint8_t slots[DMX_FRAME_SIZE];
+} DimmerModelState;
+
+MODEL_ARENA_CHECK(DimmerModelState);
+
+/*
+ * @brief The sub-devices, these point into the model arena.
+ */
+static SubDeviceSettings *g_sub_devices = NULL;
+
+/*
+ * @brief The responder shared by the sub-devices.
+ *
+ * The mutable fields are loaded from g_sub_devices before each request.
+ */
+static RDMResponder *g_sub_device_responder = NULL;
+
+/*
+ * @brief The status messages queued by the sub-devices.
+ *
+ * Only a few sub-devices queue messages, so rather than a message per
+ * sub-device they share a small pool.
+ */
+static StatusMessage *g_sub_device_messages = NULL;
+
+static StatusMessages *g_status_messages = NULL;
+
+/*
+ * @brief The slots of the last DMX frame.
+ */
+static uint8_t *g_slots = NULL;
+
+/*
+ * @brief The pixel data sent to the SPI output, one pixel per sub-device.
+ */
+static uint8_t g_pixel_data[OUTPUT_PIXELS * PIXEL_MAPPER_SLOTS_PER_PIXEL];
+
+/*
+ * @brief The preset level of each sub-device.
+ */
+static FaderChannel *g_fade_channels = NULL;
 
 
 static RootDevice g_root_device;
-static DimmerSubDevice *g_active_device = NULL;
+
+/*
+ * @brief The sub-devices a request applies to.
+ *
+ * This is the index of a single sub-device, or all of them for SUBDEVICE_ALL.
+ */
+static unsigned int g_active_index = 0u;
+static unsigned int g_active_count = 0u;
 
 // Helper functions
 // ----------------------------------------------------------------------------
 
+/*
+ * @brief Find a sub-device.
+ * @param sub_device The sub-device number.
+ * @returns The index of the sub-device in g_sub_devices, or -1 if there isn't
+ *   a sub-device with that number.
+ */
+static int SubDeviceIndex(uint16_t sub_device) {
+  if (sub_device == SUBDEVICE_ROOT || sub_device == SKIPPED_SUB_DEVICE) {
+    return -1;
+  }
+  const unsigned int index = sub_device -
+      (SKIPPED_SUB_DEVICE && sub_device > SKIPPED_SUB_DEVICE ? 2u : 1u);
+  return index < NUMBER_OF_SUB_DEVICES ? (int) index : -1;
+}
+
+/*
+ * @brief The sub-device number for an index in g_sub_devices.
+ */
+static uint16_t SubDeviceNumber(unsigned int index) {
+  return index +
+      (SKIPPED_SUB_DEVICE && index >= SKIPPED_SUB_DEVICE - 1u ? 2u : 1u);
+}
+
+/*
+ * @brief Set a uint8_t setting of the sub-devices the request applies to.
+ */
+static void SetSubDeviceUInt8(uint8_t *setting, uint8_t value) {
+  memset(&setting[g_active_index], value, g_active_count);
+}
+
+/*
+ * @brief Set a uint16_t setting of the sub-devices the request applies to.
+ */
+static void SetSubDeviceUInt16(uint16_t *setting, uint16_t value) {
+  uint16_t *ptr = &setting[g_active_index];
+  const uint16_t *end = ptr + g_active_count;
+  while (ptr != end) {
+    *ptr++ = value;
+  }
+}
+
+/*
+ * @brief Set or clear a flag of the sub-devices the request applies to.
+ */
+static void SetSubDeviceFlag(uint8_t flag, bool value) {
+  uint8_t *ptr = &g_sub_devices->flags[g_active_index];
+  const uint8_t *end = ptr + g_active_count;
+  for (; ptr != end; ptr++) {
+    *ptr = value ? (*ptr | flag) : (*ptr & ~flag);
+  }
+}
+
 /*
  * @brief Set a block address for all the sub devices.
  * @param start_address the new start address
@@ -230,27 +426,302 @@ static DimmerSubDevice *g_active_device = NULL;
  *   footprint of the sub devices would exceed the last slot (512).
  */
 bool ResetToBlockAddress(uint16_t start_address) {
-  unsigned int footprint = 0u;
+  const unsigned int footprint = NUMBER_OF_SUB_DEVICES * SUB_DEVICE_FOOTPRINT;
+  if ((uint16_t) (MAX_DMX_START_ADDRESS - start_address + 1u) < footprint) {
+    return false;
+  }
+
   unsigned int i = 0u;
   for (; i < NUMBER_OF_SUB_DEVICES; i++) {
-    RDMResponder *responder = &g_subdevices[i].responder;
-    footprint +=
-        responder->def->personalities[responder->current_personality - 1u]
-            .slot_count;
+    g_sub_devices->start_address[i] = start_address;
+    start_address += SUB_DEVICE_FOOTPRINT;
   }
+  return true;
+}
 
-  if ((uint16_t) (MAX_DMX_START_ADDRESS - start_address + 1u) < footprint) {
-    return false;
+/*
+ * @brief Merge the DMX & preset levels of a sub device.
+ * @param index The index of the sub-device in g_sub_devices.
+ * @returns The level.
+ */
+static uint8_t MergedLevel(unsigned int index) {
+  const uint8_t dmx_level = g_sub_devices->dmx_level[index];
+  if (g_root_device.active_mode == PRESET_PLAYBACK_OFF) {
+    return dmx_level;
+  }
+
+  const uint8_t preset_level = Fader_Level(&g_fade_channels[index]);
+  if (g_root_device.scene_override) {
+    return preset_level;
+  }
+
+  switch (g_root_device.merge_mode) {
+    case MERGE_MODE_HTP:
+      return preset_level > dmx_level ? preset_level : dmx_level;
+    case MERGE_MODE_LTP:
+      return g_sub_devices->flags[index] & SUB_DEVICE_LTP_DMX ?
+          dmx_level : preset_level;
+    case MERGE_MODE_DMX_ONLY:
+      return dmx_level;
+    case MERGE_MODE_DEFAULT:
+    default:
+      // The preset overrides DMX.
+      return preset_level;
+  }
+}
+
+/*
+ * @brief The output level of a sub device.
+ * @param index The index of the sub-device in g_sub_devices.
+ * @returns The upper 8 bits of the output level.
+ *
+ * The curve is calculated for each level, rather than being stored as a table
+ * for each sub-device. The decreasing minimum level isn't used, since the
+ * curve doesn't track the direction of the change.
+ */
+static uint8_t OutputLevel(unsigned int index) {
+  const DimmerCurveSettings settings = {
+    .type = (DimmerCurveType) g_sub_devices->curve[index],
+    .min_level = g_sub_devices->min_level_increasing[index],
+    .max_level = g_sub_devices->max_level[index],
+    .on_below_min = g_sub_devices->on_below_min[index]
+  };
+  return DimmerCurve_Level(&settings, MergedLevel(index)) >> 8;
+}
+
+/*
+ * @brief Start fading to a scene.
+ * @param scene_index The scene to fade to, indexed from 1.
+ */
+static void StartScene(uint16_t scene_index) {
+  const Scene *scene = &g_root_device.scenes[scene_index - 1u];
+  uint8_t targets[NUMBER_OF_SUB_DEVICES];
+  unsigned int i = 0u;
+  for (; i < NUMBER_OF_SUB_DEVICES; i++) {
+    targets[i] = (uint16_t) scene->levels[i] * g_root_device.active_level /
+                 UINT8_MAX;
+    // For LTP, the preset is now the latest change.
+    g_sub_devices->flags[i] &= ~SUB_DEVICE_LTP_DMX;
+  }
+
+  Fader_Start(g_fade_channels, targets, NUMBER_OF_SUB_DEVICES,
+              scene->up_fade_time * TICKS_PER_TENTH,
+              scene->down_fade_time * TICKS_PER_TENTH);
+  g_root_device.active_scene = scene_index;
+  g_root_device.playback_state = PLAYBACK_FADING;
+  g_root_device.output_changed = true;
+}
+
+/*
+ * @brief Start playing back scenes.
+ * @param mode The scene to play, PRESET_PLAYBACK_OFF or PRESET_PLAYBACK_ALL.
+ * @param level The level to play the scenes at.
+ */
+static void StartPlayback(uint16_t mode, uint8_t level) {
+  g_root_device.active_mode = mode;
+  g_root_device.active_level = level;
+  if (mode == PRESET_PLAYBACK_OFF) {
+    g_root_device.playback_state = PLAYBACK_IDLE;
+    g_root_device.output_changed = true;
+  } else {
+    StartScene(mode == PRESET_PLAYBACK_ALL ? 1u : mode);
   }
+}
+
+/*
+ * @brief Convert a time from the fail or startup modes to ticks.
+ */
+static uint32_t TimeToTicks(uint16_t time) {
+  return time == INFINITE_TIME ? UINT32_MAX : time * TICKS_PER_TENTH;
+}
+
+/*
+ * @brief Restart the loss of signal timeout.
+ */
+static void ResetLossOfSignal() {
+  const uint32_t ticks = TimeToTicks(
+      g_root_device.fail_loss_of_signal_delay);
+  g_root_device.signal_ticks = ticks < MIN_LOSS_OF_SIGNAL_TICKS ?
+      MIN_LOSS_OF_SIGNAL_TICKS : ticks;
+}
 
-  for (i = 0u; i < NUMBER_OF_SUB_DEVICES; i++) {
-    RDMResponder *responder = &g_subdevices[i].responder;
-    responder->dmx_start_address = start_address;
-    const PersonalityDefinition *personality =
-        &responder->def->personalities[responder->current_personality - 1u];
-    start_address += personality->slot_count;
+/*
+ * @brief Called when a DMX frame arrives.
+ *
+ * This ends the startup or fail scene and returns to the playback mode set
+ * with PRESET_PLAYBACK.
+ */
+static void SignalPresent() {
+  ResetLossOfSignal();
+  if (g_root_device.signal_state == SIGNAL_PRESENT) {
+    return;
+  }
+  g_root_device.signal_state = SIGNAL_PRESENT;
+  if (g_root_device.scene_override) {
+    g_root_device.scene_override = false;
+    StartPlayback(g_root_device.playback_mode, g_root_device.playback_level);
+  }
+}
+
+/*
+ * @brief Override the output with the startup or fail scene.
+ * @param state The new signal state.
+ * @param scene The scene to play, PRESET_PLAYBACK_OFF holds the last levels.
+ * @param level The level to play the scene at.
+ * @param hold_time The time to hold the scene for.
+ */
+static void HoldScene(SignalState state, uint16_t scene, uint8_t level,
+                      uint16_t hold_time) {
+  g_root_device.signal_state = state;
+  g_root_device.signal_ticks = TimeToTicks(hold_time);
+  if (scene != PRESET_PLAYBACK_OFF) {
+    g_root_device.scene_override = true;
+    StartPlayback(scene, level);
+  }
+}
+
+/*
+ * @brief Release the startup or fail scene once the hold time expires.
+ *
+ * The last DMX levels are dropped and the output returns to the playback mode
+ * set with PRESET_PLAYBACK.
+ */
+static void ReleaseScene() {
+  g_root_device.signal_state = SIGNAL_RELEASED;
+  g_root_device.signal_ticks = UINT32_MAX;
+  memset(g_sub_devices->dmx_level, 0u, NUMBER_OF_SUB_DEVICES);
+  g_root_device.output_changed = true;
+  if (g_root_device.scene_override) {
+    g_root_device.scene_override = false;
+    StartPlayback(g_root_device.playback_mode, g_root_device.playback_level);
+  }
+}
+
+/*
+ * @brief Advance the signal timers, called once per tick.
+ */
+static void SignalTick() {
+  if (g_root_device.signal_ticks == UINT32_MAX) {
+    return;
+  }
+  if (g_root_device.signal_ticks) {
+    g_root_device.signal_ticks--;
+    return;
+  }
+
+  switch (g_root_device.signal_state) {
+    case SIGNAL_STARTUP_DELAY:
+      HoldScene(SIGNAL_STARTUP_HOLD, g_root_device.startup_scene,
+                g_root_device.startup_level, g_root_device.startup_hold);
+      break;
+    case SIGNAL_PRESENT:
+      HoldScene(SIGNAL_FAIL_HOLD, g_root_device.fail_scene,
+                g_root_device.fail_level, g_root_device.fail_hold_time);
+      break;
+    case SIGNAL_STARTUP_HOLD:
+    case SIGNAL_FAIL_HOLD:
+      ReleaseScene();
+      break;
+    case SIGNAL_RELEASED:
+      break;
+  }
+}
+
+/*
+ * @brief Return the scene after the active one, when playing all scenes.
+ */
+static uint16_t NextScene() {
+  uint16_t scene_index = g_root_device.active_scene;
+  do {
+    scene_index = scene_index % NUMBER_OF_SCENES + 1u;
+  } while (g_root_device.scenes[scene_index - 1u].programmed_state ==
+           PRESET_NOT_PROGRAMMED);
+  return scene_index;
+}
+
+/*
+ * @brief Advance the scene playback, called once per tick.
+ */
+static void PlaybackTick() {
+  if (g_root_device.playback_state == PLAYBACK_IDLE) {
+    return;
+  }
+
+  if (g_root_device.playback_state == PLAYBACK_FADING) {
+    g_root_device.output_changed = true;
+    if (Fader_Tick(g_fade_channels, NUMBER_OF_SUB_DEVICES)) {
+      return;
+    }
+
+    if (g_root_device.active_mode != PRESET_PLAYBACK_ALL) {
+      // Hold the scene.
+      g_root_device.playback_state = PLAYBACK_IDLE;
+      return;
+    }
+    g_root_device.playback_state = PLAYBACK_WAITING;
+    g_root_device.wait_ticks =
+        g_root_device.scenes[g_root_device.active_scene - 1u].wait_time *
+        TICKS_PER_TENTH;
+  }
+
+  if (g_root_device.wait_ticks) {
+    g_root_device.wait_ticks--;
+  } else {
+    StartScene(NextScene());
   }
-  return true;
+}
+
+/*
+ * @brief Advance the signal & playback state, called every TICK_INTERVAL.
+ *
+ * The arrival of DMX is handled in UpdateOutput.
+ */
+static void Tick() {
+  SignalTick();
+  PlaybackTick();
+}
+
+/*
+ * @brief Send the output levels of the sub devices to the SPI output.
+ *
+ * Each sub-device, up to SPIRGB_MAX_PIXELS, drives a single white pixel using
+ * the upper 8 bits of the output level.
+ */
+static void UpdateOutput() {
+  unsigned int i = 0u;
+  if (DMXSnapshot_Generation() != g_root_device.output_generation) {
+    uint16_t slot_count;
+    g_root_device.output_generation = DMXSnapshot_Read(
+        g_slots, 0u, DMX_FRAME_SIZE, &slot_count);
+
+    for (; i < NUMBER_OF_SUB_DEVICES; i++) {
+      const uint16_t offset = g_sub_devices->start_address[i] - 1u;
+      const uint8_t slot = offset < slot_count ? g_slots[offset] : 0u;
+      if (slot != g_sub_devices->dmx_level[i]) {
+        g_sub_devices->dmx_level[i] = slot;
+        g_sub_devices->flags[i] |= SUB_DEVICE_LTP_DMX;
+      }
+    }
+    g_root_device.output_changed = true;
+    SignalPresent();
+  }
+
+  if (!g_root_device.output_changed) {
+    return;
+  }
+  g_root_device.output_changed = false;
+
+  uint8_t *pixel = g_pixel_data;
+  for (i = 0u; i < OUTPUT_PIXELS; i++) {
+    const uint8_t level = OutputLevel(i);
+    *pixel++ = level;
+    *pixel++ = level;
+    *pixel++ = level;
+  }
+
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixels(g_pixel_data, OUTPUT_PIXELS);
+  SPIRGB_CompleteUpdate();
 }
 
 uint8_t *AddStatusMessageToResponse(uint8_t *ptr,
@@ -277,23 +748,114 @@ void QueueStatusMessage(StatusMessage *message,
   message->data_value2 = data_value2;
 }
 
-void QueueSubDeviceStatusMessage(DimmerSubDevice *device,
+/*
+ * @brief Find the status message queued by a sub-device.
+ * @param sub_device The sub-device number.
+ * @returns The queued message, or a free entry in g_sub_device_messages if the
+ *   sub-device doesn't have a message queued. NULL if there are no free
+ *   entries.
+ */
+static StatusMessage *FindStatusMessage(uint16_t sub_device) {
+  StatusMessage *free_message = NULL;
+  unsigned int i = 0u;
+  for (; i < SUB_DEVICE_STATUS_MESSAGES; i++) {
+    StatusMessage *message = &g_sub_device_messages[i];
+    if (message->is_active) {
+      if (message->sub_device == sub_device) {
+        return message;
+      }
+    } else if (!free_message) {
+      free_message = message;
+    }
+  }
+  return free_message;
+}
+
+void QueueSubDeviceStatusMessage(unsigned int index,
                                  RDMStatusType status_type,
                                  RDMStatusMessageId status_id,
                                  uint16_t data_value1,
                                  uint16_t data_value2) {
-  if (device->sd_report_threshold == STATUS_NONE ||
-      (status_type & STATUS_TYPE_MASK) < device->sd_report_threshold) {
+  const uint8_t threshold = g_sub_devices->sd_report_threshold[index];
+  if (threshold == STATUS_NONE ||
+      (status_type & STATUS_TYPE_MASK) < threshold) {
     return;
   }
 
-  QueueStatusMessage(&device->status_message, device->index,
-                     status_type, status_id, data_value1, data_value2);
+  const uint16_t sub_device = SubDeviceNumber(index);
+  StatusMessage *message = FindStatusMessage(sub_device);
+  if (message) {
+    QueueStatusMessage(message, sub_device, status_type, status_id,
+                       data_value1, data_value2);
+  }
+}
+
+/*
+ * @brief Called when a self test completes.
+ */
+static void SelfTestComplete() {
+  // Queue a status message for the root.
+  QueueStatusMessage(
+      &g_root_device.status_message, SUBDEVICE_ROOT, STATUS_ADVISORY,
+      (uint16_t) (g_root_device.running_self_test == 1u ?
+          STS_OLP_SELFTEST_PASSED : STS_OLP_SELFTEST_FAILED),
+      g_root_device.running_self_test, 0u);
+
+  g_root_device.running_self_test = SELF_TEST_OFF;
+}
+
+/*
+ * @brief We generate status messages for each device, based on a periodic
+ * timer. This makes it easier to reproduce problems (and test!).
+ */
+static void QueueStatusMessages() {
+  // The cycle counter is used to generate status messages for each sub device.
+  static uint8_t cycle = 0u;
+  static uint16_t complete_cycles = 0u;
+
+  const int first_index = SubDeviceIndex(1u);
+  if (first_index >= 0) {
+    // The cycle for the first device is:
+    //  - 0, NOOP
+    //  - 1, Queue breaker trip warning
+    //  - 2, NOOP
+    //  - 3, Clear breaker trip warning
+    //  - 4, NOOP
+    if (cycle == 1) {
+      // Queue a message
+      QueueSubDeviceStatusMessage(first_index, STATUS_WARNING,
+                                  STS_BREAKER_TRIP, 0u, 0u);
+    } else if (cycle == 3u) {
+      StatusMessage *message = FindStatusMessage(1u);
+      if (message && message->is_active) {
+        // The previous message is still in the queue, cancel it.
+        message->is_active = false;
+      } else {
+        // Queue a 'cleared' message
+        QueueSubDeviceStatusMessage(first_index, STATUS_WARNING_CLEARED,
+                                    STS_BREAKER_TRIP, 0u, 0u);
+      }
+    }
+  }
+
+  const int third_index = SubDeviceIndex(3u);
+  if (third_index >= 0) {
+    // This subdevice just queues a manufacturer-defined advisory message
+    // each cycle.
+    QueueSubDeviceStatusMessage(third_index, STATUS_ADVISORY,
+                                (uint16_t) STS_OLP_TESTING,
+                                complete_cycles, cycle);
+  }
+  cycle++;
+  cycle %= 5u;
+  if (cycle == 0u) {
+    complete_cycles++;
+  }
 }
 
 /*
  * @brief Dequeue a status message if it's at or above the threshold.
- * @pre There is at least one message slot available in g_status_messages.
+ * @pre There is at least one message slot available in g_status_messages->
  * @returns true if the message was added, false otherwise.
  */
 bool MaybeDequeueStatusMessage(StatusMessage *message, uint8_t threshold) {
@@ -303,7 +865,7 @@ bool MaybeDequeueStatusMessage(StatusMessage *message, uint8_t threshold) {
   }
 
   message->is_active = false;
-  g_status_messages.last[g_status_messages.count] = *message;
+  g_status_messages->last[g_status_messages->count] = *message;
   return true;
 }
 
@@ -322,31 +884,29 @@ int DimmerModel_GetStatusMessages(const RDMHeader *header,
   if (threshold == STATUS_GET_LAST_MESSAGE) {
     // Return the last set of messages.
     unsigned int i = 0u;
-    for (; i < g_status_messages.count; i++) {
-      ptr = AddStatusMessageToResponse(ptr, &g_status_messages.last[i]);
+    for (; i < g_status_messages->count; i++) {
+      ptr = AddStatusMessageToResponse(ptr, &g_status_messages->last[i]);
     }
   } else {
     // Build the list of status messages.
-    g_status_messages.count = 0u;
+    g_status_messages->count = 0u;
 
     // Check the root
     if (g_root_device.status_message.is_active &&
         MaybeDequeueStatusMessage(&g_root_device.status_message, threshold)) {
       ptr = AddStatusMessageToResponse(
-                ptr, &g_status_messages.last[g_status_messages.count]);
-      g_status_messages.count++;
+                ptr, &g_status_messages->last[g_status_messages->count]);
+      g_status_messages->count++;
     }
 
     // Check the sub devices.
     unsigned int i = 0u;
-    for (; i < NUMBER_OF_SUB_DEVICES &&
-           g_status_messages.count < STATUS_MESSAGE_QUEUE_SIZE; i++) {
-      DimmerSubDevice *subdevice = &g_subdevices[i];
-
-      if (MaybeDequeueStatusMessage(&subdevice->status_message, threshold)) {
+    for (; i < SUB_DEVICE_STATUS_MESSAGES &&
+           g_status_messages->count < STATUS_MESSAGE_QUEUE_SIZE; i++) {
+      if (MaybeDequeueStatusMessage(&g_sub_device_messages[i], threshold)) {
         ptr = AddStatusMessageToResponse(
-                  ptr, &g_status_messages.last[g_status_messages.count]);
-        g_status_messages.count++;
+                  ptr, &g_status_messages->last[g_status_messages->count]);
+        g_status_messages->count++;
       }
     }
   }
@@ -389,13 +949,16 @@ int DimmerModel_PerformSelfTest(const RDMHeader *header,
 
   if (self_test_id == SELF_TEST_OFF) {
     g_root_device.running_self_test = SELF_TEST_OFF;
+    TimerWheel_Cancel(&g_root_device.self_test_timer);
   } else {
     if (g_root_device.running_self_test) {
       return RDMResponder_BuildNack(header, NR_ACTION_NOT_SUPPORTED);
     }
 
     g_root_device.running_self_test = self_test_id;
-    g_root_device.self_test_timer = CoarseTimer_GetTime();
+    TimerWheel_Add(&g_root_device.self_test_timer,
+                   SELF_TESTS[self_test_id - 1].duration, 0u,
+                   SelfTestComplete);
   }
   return RDMResponder_BuildSetAck(header);
 }
@@ -440,6 +1003,10 @@ int DimmerModel_CapturePreset(const RDMHeader *header,
   scene->down_fade_time = down_fade_time;
   scene->wait_time = wait_time;
   scene->programmed_state = PRESET_PROGRAMMED;
+  unsigned int i = 0u;
+  for (; i < NUMBER_OF_SUB_DEVICES; i++) {
+    scene->levels[i] = MergedLevel(i);
+  }
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -466,37 +1033,28 @@ int DimmerModel_SetPresetPlayback(const RDMHeader *header,
   g_root_device.playback_mode = playback_mode;
   g_root_device.playback_level = param_data[2];
 
+  if (!g_root_device.scene_override) {
+    StartPlayback(playback_mode, g_root_device.playback_level);
+  }
   return RDMResponder_BuildSetAck(header);
 }
 
 int DimmerModel_GetDMXBlockAddress(const RDMHeader *header,
                                    UNUSED const uint8_t *param_data) {
-  uint16_t total_footprint = 0u;
-  uint16_t expected_start_address = 0u;
+  const uint16_t *start_address = g_sub_devices->start_address;
   bool is_contiguous = true;
-  unsigned int i = 0u;
+  unsigned int i = 1u;
   for (; i < NUMBER_OF_SUB_DEVICES; i++) {
-    RDMResponder *responder = &g_subdevices[i].responder;
-    uint16_t sub_device_footprint = responder->def
-        ->personalities[responder->current_personality - 1u].slot_count;
-    total_footprint += sub_device_footprint;
-    if (expected_start_address &&
-        expected_start_address != responder->dmx_start_address) {
+    if (start_address[i] != start_address[0] + i * SUB_DEVICE_FOOTPRINT) {
       is_contiguous = false;
-    } else if (expected_start_address) {
-      expected_start_address += sub_device_footprint;
-    } else {
-      expected_start_address = responder->dmx_start_address +
-                               sub_device_footprint;
+      break;
     }
   }
 
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
-  ptr = PushUInt16(ptr, total_footprint);
+  ptr = PushUInt16(ptr, NUMBER_OF_SUB_DEVICES * SUB_DEVICE_FOOTPRINT);
   ptr = PushUInt16(
-      ptr,
-      is_contiguous ? g_subdevices[0].responder.dmx_start_address :
-          INVALID_DMX_START_ADDRESS);
+      ptr, is_contiguous ? start_address[0] : INVALID_DMX_START_ADDRESS);
   return RDMResponder_AddHeaderAndChecksum(header, ACK,
                                            ptr - g_rdm_buffer);
 }
@@ -547,6 +1105,9 @@ int DimmerModel_SetDMXFailMode(const RDMHeader *header,
   g_root_device.fail_loss_of_signal_delay = loss_of_signal_delay;
   g_root_device.fail_hold_time = hold_time;
   g_root_device.fail_level = param_data[6];
+  if (g_root_device.signal_state == SIGNAL_PRESENT) {
+    ResetLossOfSignal();
+  }
 
   return RDMResponder_BuildSetAck(header);
 }
@@ -733,6 +1294,7 @@ int DimmerModel_SetPresetStatus(const RDMHeader *header,
     scene->down_fade_time = 0u;
     scene->wait_time = 0u;
     scene->programmed_state = PRESET_NOT_PROGRAMMED;
+    memset(scene->levels, 0, NUMBER_OF_SUB_DEVICES);
   } else {
     // don't change the state here, if we haven't been programmed, just update
     // the timing params
@@ -767,7 +1329,18 @@ int DimmerModel_SetPresetMergeMode(const RDMHeader *header,
 // ----------------------------------------------------------------------------
 int DimmerModel_ClearStatusId(const RDMHeader *header,
                               UNUSED const uint8_t *param_data) {
-  g_active_device->status_message.is_active = false;
+  unsigned int i = 0u;
+  for (; i < SUB_DEVICE_STATUS_MESSAGES; i++) {
+    StatusMessage *message = &g_sub_device_messages[i];
+    if (!message->is_active) {
+      continue;
+    }
+    const int index = SubDeviceIndex(message->sub_device);
+    if (index >= (int) g_active_index &&
+        index < (int) (g_active_index + g_active_count)) {
+      message->is_active = false;
+    }
+  }
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -775,7 +1348,7 @@ int DimmerModel_GetSubDeviceReportingThreshold(
     const RDMHeader *header,
     UNUSED const uint8_t *param_data) {
   return RDMResponder_GenericGetUInt8(
-      header, g_active_device->sd_report_threshold);
+      header, g_sub_devices->sd_report_threshold[g_active_index]);
 }
 
 int DimmerModel_SetSubDeviceReportingThreshold(const RDMHeader *header,
@@ -790,13 +1363,43 @@ int DimmerModel_SetSubDeviceReportingThreshold(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  g_active_device->sd_report_threshold = threshold;
+  SetSubDeviceUInt8(g_sub_devices->sd_report_threshold, threshold);
+  return RDMResponder_BuildSetAck(header);
+}
+
+int DimmerModel_SetDMXStartAddress(const RDMHeader *header,
+                                   const uint8_t *param_data) {
+  if (header->param_data_length != sizeof(uint16_t)) {
+    return RDMResponder_BuildNack(header, NR_FORMAT_ERROR);
+  }
+
+  const uint16_t address = ExtractUInt16(param_data);
+  if (address == 0u || address > MAX_DMX_START_ADDRESS) {
+    return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
+  }
+
+  SetSubDeviceUInt16(g_sub_devices->start_address, address);
   return RDMResponder_BuildSetAck(header);
 }
 
+int DimmerModel_SetIdentifyDevice(const RDMHeader *header,
+                                  const uint8_t *param_data) {
+  if (header->param_data_length != sizeof(uint8_t)) {
+    return RDMResponder_BuildNack(header, NR_FORMAT_ERROR);
+  }
+  if (param_data[0] > 1u) {
+    return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
+  }
+
+  SetSubDeviceFlag(SUB_DEVICE_IDENTIFY, param_data[0]);
+  // This drives the identify LED.
+  return RDMResponder_SetIdentifyDevice(header, param_data);
+}
+
 int DimmerModel_GetIdentifyMode(const RDMHeader *header,
                                 UNUSED const uint8_t *param_data) {
-  return RDMResponder_GenericGetUInt8(header, g_active_device->identify_mode);
+  return RDMResponder_GenericGetUInt8(
+      header, g_sub_devices->identify_mode[g_active_index]);
 }
 
 int DimmerModel_SetIdentifyMode(const RDMHeader *header,
@@ -810,20 +1413,25 @@ int DimmerModel_SetIdentifyMode(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  g_active_device->identify_mode = mode;
+  SetSubDeviceUInt8(g_sub_devices->identify_mode, mode);
   return RDMResponder_BuildSetAck(header);
 }
 
 int DimmerModel_GetBurnIn(const RDMHeader *header,
                           UNUSED const uint8_t *param_data) {
-  return RDMResponder_GenericGetUInt8(header, g_active_device->burn_in);
+  return RDMResponder_GenericGetUInt8(
+      header, g_sub_devices->burn_in[g_active_index]);
 }
 
 int DimmerModel_SetBurnIn(const RDMHeader *header,
                           const uint8_t *param_data) {
   // TODO(simon): it would be nice to decrement this once an hour.
-  return RDMResponder_GenericSetUInt8(header, param_data,
-                                      &g_active_device->burn_in);
+  if (header->param_data_length != sizeof(uint8_t)) {
+    return RDMResponder_BuildNack(header, NR_FORMAT_ERROR);
+  }
+
+  SetSubDeviceUInt8(g_sub_devices->burn_in, param_data[0]);
+  return RDMResponder_BuildSetAck(header);
 }
 
 int DimmerModel_GetDimmerInfo(const RDMHeader *header,
@@ -842,9 +1450,9 @@ int DimmerModel_GetDimmerInfo(const RDMHeader *header,
 int DimmerModel_GetMinimumLevel(const RDMHeader *header,
                                 UNUSED const uint8_t *param_data) {
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
-  ptr = PushUInt16(ptr, g_active_device->min_level_increasing);
-  ptr = PushUInt16(ptr, g_active_device->min_level_decreasing);
-  *ptr++ = g_active_device->on_below_min;
+  ptr = PushUInt16(ptr, g_sub_devices->min_level_increasing[g_active_index]);
+  ptr = PushUInt16(ptr, g_sub_devices->min_level_decreasing[g_active_index]);
+  *ptr++ = g_sub_devices->on_below_min[g_active_index];
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
 
@@ -862,27 +1470,36 @@ int DimmerModel_SetMinimumLevel(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  g_active_device->min_level_increasing = min_level_increasing;
-  g_active_device->min_level_decreasing = min_level_decreasing;
-  g_active_device->on_below_min = on_below_min;
+  SetSubDeviceUInt16(g_sub_devices->min_level_increasing,
+                     min_level_increasing);
+  SetSubDeviceUInt16(g_sub_devices->min_level_decreasing,
+                     min_level_decreasing);
+  SetSubDeviceUInt8(g_sub_devices->on_below_min, on_below_min);
+  g_root_device.output_changed = true;
   return RDMResponder_BuildSetAck(header);
 }
 
 int DimmerModel_GetMaximumLevel(const RDMHeader *header,
                                 UNUSED const uint8_t *param_data) {
-  return RDMResponder_GenericGetUInt16(header, g_active_device->max_level);
+  return RDMResponder_GenericGetUInt16(
+      header, g_sub_devices->max_level[g_active_index]);
 }
 
 int DimmerModel_SetMaximumLevel(const RDMHeader *header,
                                 const uint8_t *param_data) {
-  return RDMResponder_GenericSetUInt16(header, param_data,
-                                       &g_active_device->max_level);
+  if (header->param_data_length != sizeof(uint16_t)) {
+    return RDMResponder_BuildNack(header, NR_FORMAT_ERROR);
+  }
+
+  SetSubDeviceUInt16(g_sub_devices->max_level, ExtractUInt16(param_data));
+  g_root_device.output_changed = true;
+  return RDMResponder_BuildSetAck(header);
 }
 
 int DimmerModel_GetCurve(const RDMHeader *header,
                          UNUSED const uint8_t *param_data) {
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
-  *ptr++ = g_active_device->curve;
+  *ptr++ = g_sub_devices->curve[g_active_index];
   *ptr++ = NUMBER_OF_CURVES;
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
@@ -899,11 +1516,21 @@ int DimmerModel_SetCurve(const RDMHeader *header,
   }
 
   // To make it interesting, not every sub-device supports each curve type.
-  if (curve % 2 && g_active_device->index % 2 == 0) {
-    return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
+  // For SUBDEVICE_ALL, the curve is set on the sub-devices that support it.
+  bool supported = false;
+  unsigned int i = g_active_index;
+  for (; i < g_active_index + g_active_count; i++) {
+    if (curve % 2 && SubDeviceNumber(i) % 2 == 0) {
+      continue;
+    }
+    g_sub_devices->curve[i] = curve;
+    supported = true;
   }
 
-  g_active_device->curve = curve;
+  if (!supported) {
+    return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
+  }
+  g_root_device.output_changed = true;
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -925,7 +1552,7 @@ int DimmerModel_GetCurveDescription(const RDMHeader *header,
 int DimmerModel_GetOutputResponseTime(const RDMHeader *header,
                                       UNUSED const uint8_t *param_data) {
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
-  *ptr++ = g_active_device->output_response_time;
+  *ptr++ = g_sub_devices->output_response_time[g_active_index];
   *ptr++ = NUMBER_OF_OUTPUT_RESPONSE_TIMES;
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
@@ -941,7 +1568,7 @@ int DimmerModel_SetOutputResponseTime(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  g_active_device->output_response_time = setting;
+  SetSubDeviceUInt8(g_sub_devices->output_response_time, setting);
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -963,7 +1590,7 @@ int DimmerModel_GetOutputResponseDescription(const RDMHeader *header,
 int DimmerModel_GetModulationFrequency(const RDMHeader *header,
                                        UNUSED const uint8_t *param_data) {
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
-  *ptr++ = g_active_device->modulation_frequency;
+  *ptr++ = g_sub_devices->modulation_frequency[g_active_index];
   *ptr++ = NUMBER_OF_MODULATION_FREQUENCIES;
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
@@ -979,7 +1606,7 @@ int DimmerModel_SetModulationFrequency(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  g_active_device->modulation_frequency = setting;
+  SetSubDeviceUInt8(g_sub_devices->modulation_frequency, setting);
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -1012,10 +1639,21 @@ void DimmerModel_Initialize() {
     g_root_device.scenes[i].wait_time = 0u;
     g_root_device.scenes[i].programmed_state = i == 0u ?
         PRESET_PROGRAMMED_READ_ONLY : PRESET_NOT_PROGRAMMED;
+    // The factory scene is all sub-devices at full.
+    memset(g_root_device.scenes[i].levels, i == 0u ? UINT8_MAX : 0u,
+           NUMBER_OF_SUB_DEVICES);
   }
 
   g_root_device.playback_mode = PRESET_PLAYBACK_OFF;
   g_root_device.playback_level = 0u;
+  g_root_device.playback_state = PLAYBACK_IDLE;
+  g_root_device.active_scene = 0u;
+  g_root_device.active_mode = PRESET_PLAYBACK_OFF;
+  g_root_device.active_level = 0u;
+  g_root_device.wait_ticks = 0u;
+  g_root_device.signal_state = SIGNAL_STARTUP_DELAY;
+  g_root_device.signal_ticks = 0u;
+  g_root_device.scene_override = false;
   g_root_device.startup_scene = PRESET_PLAYBACK_OFF;
   g_root_device.startup_hold = 0u;
   g_root_device.startup_delay = 0u;
@@ -1029,64 +1667,90 @@ void DimmerModel_Initialize() {
   g_root_device.merge_mode = MERGE_MODE_DEFAULT;
   g_root_device.power_on_self_test = false;
   g_root_device.running_self_test = SELF_TEST_OFF;
+  TimerWheel_Cancel(&g_root_device.self_test_timer);
+}
 
-  // Initialize the subdevices.
-  uint8_t parent_uid[UID_LENGTH];
-  RDMResponder_GetUID(parent_uid);
-
-  uint16_t sub_device_index = 1u;
-  for (i = 0u; i < NUMBER_OF_SUB_DEVICES; i++) {
-    if (i == 1) {
-      // Leave a gap at sub-device 2, since sub devices aren't required to be
-      // contiguous.
-      sub_device_index++;
-    }
-
-    DimmerSubDevice *subdevice = &g_subdevices[i];
-    subdevice->responder.def = &SUBDEVICE_RESPONDER_DEFINITION;
-
-    subdevice->index = sub_device_index++;
-    subdevice->min_level_increasing = 0u;
-    subdevice->min_level_decreasing = 0u;
-    subdevice->max_level = 0u;
-    subdevice->on_below_min = 0u;
-    subdevice->identify_mode = IDENTIFY_MODE_QUIET;
-    subdevice->burn_in = 0u;
-    subdevice->curve = 1u;
-    subdevice->output_response_time = 1u;
-    subdevice->modulation_frequency = 1u;
-    subdevice->sd_report_threshold = STATUS_ADVISORY;
-    subdevice->status_message.is_active = false;
-
-    RDMResponder_SwitchResponder(&subdevice->responder);
-    memcpy(g_responder->uid, parent_uid, UID_LENGTH);
-    RDMResponder_InitResponder();
-    g_responder->is_subdevice = true;
-    g_responder->sub_device_count = NUMBER_OF_SUB_DEVICES;
-  }
-
-  // restore
-  RDMResponder_RestoreResponder();
+static void DimmerModel_Activate() {
+  DimmerModelState *state = (DimmerModelState*) ModelArena_Claim();
+  g_sub_devices = &state->sub_devices;
+  g_sub_device_responder = &state->sub_device_responder;
+  g_sub_device_messages = state->sub_device_messages;
+  g_fade_channels = state->fade_channels;
+  g_status_messages = &state->status_messages;
+  g_slots = state->slots;
+  g_active_index = 0u;
+  g_active_count = 0u;
+  Fader_Set(g_fade_channels, NUMBER_OF_SUB_DEVICES, 0u);
+
+  // Initialize the subdevices, the rest of the settings are 0.
+  unsigned int i = 0u;
+  for (; i < NUMBER_OF_SUB_DEVICES; i++) {
+    g_sub_devices->max_level[i] = DEFAULT_MAX_LEVEL;
+  }
+  memset(g_sub_devices->identify_mode, IDENTIFY_MODE_QUIET,
+         NUMBER_OF_SUB_DEVICES);
+  memset(g_sub_devices->curve, 1u, NUMBER_OF_SUB_DEVICES);
+  memset(g_sub_devices->output_response_time, 1u, NUMBER_OF_SUB_DEVICES);
+  memset(g_sub_devices->modulation_frequency, 1u, NUMBER_OF_SUB_DEVICES);
+  memset(g_sub_devices->sd_report_threshold, STATUS_ADVISORY,
+         NUMBER_OF_SUB_DEVICES);
   if (!ResetToBlockAddress(INITIAL_START_ADDRESSS)) {
     // Set them all to 1
     for (i = 0u; i < NUMBER_OF_SUB_DEVICES; i++) {
-      RDMResponder *responder = &g_subdevices[i].responder;
-      responder->dmx_start_address = INITIAL_START_ADDRESSS;
+      g_sub_devices->start_address[i] = INITIAL_START_ADDRESSS;
     }
   }
 
-  // init status messages
-  g_status_messages.count = 0u;
-}
+  uint8_t parent_uid[UID_LENGTH];
+  RDMResponder_GetUID(parent_uid);
+  RDMResponder_SwitchResponder(g_sub_device_responder);
+  memcpy(g_responder->uid, parent_uid, UID_LENGTH);
+  g_responder->def = &SUBDEVICE_RESPONDER_DEFINITION;
+  RDMResponder_InitResponder();
+  g_responder->is_subdevice = true;
+  g_responder->sub_device_count = NUMBER_OF_SUB_DEVICES;
 
-static void DimmerModel_Activate() {
+  // restore
+  RDMResponder_RestoreResponder();
+
+  // Initialize the root.
   g_responder->def = &ROOT_RESPONDER_DEFINITION;
   RDMResponder_InitResponder();
   g_responder->sub_device_count = NUMBER_OF_SUB_DEVICES;
-  g_root_device.status_message_timer = CoarseTimer_GetTime();
+  TimerWheel_Add(&g_root_device.status_message_timer,
+                 STATUS_MESSAGE_TRIGGER_INTERVAL,
+                 STATUS_MESSAGE_TRIGGER_INTERVAL, QueueStatusMessages);
+
+  // The sub devices drive the SPI output, rather than the pixel mapper.
+  PixelMapperSettings settings = {
+    .start_address = 1u,
+    .pixel_count = 0u,
+    .group_size = 1u,
+    .order = PIXEL_ORDER_RGB,
+    .reverse = false
+  };
+  PixelMapper_Configure(&settings);
+  // A frame received before the model was active isn't a signal.
+  g_root_device.output_generation = DMXSnapshot_Generation();
+  g_root_device.output_changed = true;
+
+  // Start the startup delay.
+  TimerWheel_Add(&g_root_device.tick_timer, TICK_INTERVAL, TICK_INTERVAL, Tick);
+  g_root_device.signal_state = SIGNAL_STARTUP_DELAY;
+  g_root_device.signal_ticks = TimeToTicks(g_root_device.startup_delay);
+  g_root_device.scene_override = false;
+  StartPlayback(g_root_device.playback_mode, g_root_device.playback_level);
 }
 
-static void DimmerModel_Deactivate() {}
+static void DimmerModel_Deactivate() {
+  TimerWheel_Cancel(&g_root_device.status_message_timer);
+  TimerWheel_Cancel(&g_root_device.tick_timer);
+  // The self test result is reported via the status messages, which are lost
+  // along with the rest of the arena.
+  TimerWheel_Cancel(&g_root_device.self_test_timer);
+  g_root_device.running_self_test = SELF_TEST_OFF;
+  PixelMapper_Initialize();
+}
 
 static int DimmerModel_HandleRequest(const RDMHeader *header,
                                      const uint8_t *param_data) {
@@ -1126,103 +1790,38 @@ static int DimmerModel_HandleRequest(const RDMHeader *header,
     }
   }
 
-  unsigned int i = 0u;
-  bool handled = false;
-  int response_size = RDM_RESPONDER_NO_RESPONSE;
-  for (; i < NUMBER_OF_SUB_DEVICES; i++) {
-    if (sub_device == g_subdevices[i].index || sub_device == SUBDEVICE_ALL) {
-      if (!locked) {
-        g_active_device = &g_subdevices[i];
-        RDMResponder_SwitchResponder(&g_subdevices[i].responder);
-        response_size = RDMResponder_DispatchPID(header, param_data);
-      }
-      handled = true;
+  if (sub_device == SUBDEVICE_ALL) {
+    g_active_index = 0u;
+    g_active_count = NUMBER_OF_SUB_DEVICES;
+  } else {
+    const int index = SubDeviceIndex(sub_device);
+    if (index < 0) {
+      return RDMResponder_BuildNack(header, NR_SUB_DEVICE_OUT_OF_RANGE);
     }
-  }
-
-  RDMResponder_RestoreResponder();
-
-  if (!handled) {
-    return RDMResponder_BuildNack(header, NR_SUB_DEVICE_OUT_OF_RANGE);
+    g_active_index = index;
+    g_active_count = 1u;
   }
 
   if (locked) {
     return RDMResponder_BuildNack(header, NR_WRITE_PROTECT);
   }
 
-  // If it was an all-subdevices call, it's not really clear how to handle the
-  // response, in this case we return the last one.
+  // The sub-devices share a responder, load the state of the (first)
+  // sub-device. The SET handlers write to the settings of each sub-device the
+  // request applies to, so SUBDEVICE_ALL is dispatched once, rather than once
+  // per sub-device.
+  g_sub_device_responder->dmx_start_address =
+      g_sub_devices->start_address[g_active_index];
+  g_sub_device_responder->identify_on =
+      g_sub_devices->flags[g_active_index] & SUB_DEVICE_IDENTIFY;
+  RDMResponder_SwitchResponder(g_sub_device_responder);
+  int response_size = RDMResponder_DispatchPID(header, param_data);
+  RDMResponder_RestoreResponder();
   return response_size;
 }
 
-/*
- * @brief We generate status messages for each device, based on a periodic
- * timer. This makes it easier to reproduce problems (and test!).
- */
 static void DimmerModel_Tasks() {
-  // The cycle counter is used to generate status messages for each sub device.
-  static uint8_t cycle = 0u;
-  static uint16_t complete_cycles = 0u;
-
-  if (g_root_device.running_self_test &&
-      CoarseTimer_HasElapsed(
-          g_root_device.self_test_timer,
-          SELF_TESTS[g_root_device.running_self_test - 1].duration)) {
-    // Queue a status message for the root.
-    QueueStatusMessage(
-        &g_root_device.status_message, SUBDEVICE_ROOT, STATUS_ADVISORY,
-        (uint16_t) (g_root_device.running_self_test == 1u ?
-            STS_OLP_SELFTEST_PASSED : STS_OLP_SELFTEST_FAILED),
-        g_root_device.running_self_test, 0u);
-
-    g_root_device.running_self_test = 0u;
-  }
-
-  if (!CoarseTimer_HasElapsed(g_root_device.status_message_timer,
-                             STATUS_MESSAGE_TRIGGER_INTERVAL)) {
-    return;
-  }
-
-  g_root_device.status_message_timer = CoarseTimer_GetTime();
-
-  unsigned int subdevice_index = 0u;
-  for (; subdevice_index < NUMBER_OF_SUB_DEVICES; subdevice_index++) {
-    DimmerSubDevice *subdevice = &g_subdevices[subdevice_index];
-
-    if (subdevice->index == 1u) {
-      // The cycle for the first device is:
-      //  - 0, NOOP
-      //  - 1, Queue breaker trip warning
-      //  - 2, NOOP
-      //  - 3, Clear breaker trip warning
-      //  - 4, NOOP
-      if (cycle == 1) {
-        // Queue a message
-        QueueSubDeviceStatusMessage(subdevice, STATUS_WARNING,
-                                    STS_BREAKER_TRIP, 0u, 0u);
-      } else if (cycle == 3u) {
-        if (subdevice->status_message.is_active) {
-          // The previous message is still in the queue, cancel it.
-          subdevice->status_message.is_active = false;
-        } else {
-          // Queue a 'cleared' message
-          QueueSubDeviceStatusMessage(subdevice, STATUS_WARNING_CLEARED,
-                                      STS_BREAKER_TRIP, 0u, 0u);
-        }
-      }
-    } else if (subdevice->index == 3u) {
-      // This subdevice just queues a manufacturer-defined advisory message
-      // each cycle.
-      QueueSubDeviceStatusMessage(subdevice, STATUS_ADVISORY,
-                                  (uint16_t) STS_OLP_TESTING,
-                                  complete_cycles, cycle);
-    }
-  }
-  cycle++;
-  cycle %= 5u;
-  if (cycle == 0u) {
-    complete_cycles++;
-  }
+  UpdateOutput();
 }
 
 const ModelEntry DIMMER_MODEL_ENTRY = {
@@ -1327,11 +1926,11 @@ static const PIDDescriptor SUBDEVICE_PID_DESCRIPTORS[] = {
   {PID_MANUFACTURER_LABEL, RDMResponder_GetManufacturerLabel, 0u,
     (PIDCommandHandler) NULL},
   {PID_DMX_START_ADDRESS, RDMResponder_GetDMXStartAddress, 0u,
-    RDMResponder_SetDMXStartAddress},
+    DimmerModel_SetDMXStartAddress},
   {PID_SOFTWARE_VERSION_LABEL, RDMResponder_GetSoftwareVersionLabel, 0u,
     (PIDCommandHandler) NULL},
   {PID_IDENTIFY_DEVICE, RDMResponder_GetIdentifyDevice, 0u,
-    RDMResponder_SetIdentifyDevice},
+    DimmerModel_SetIdentifyDevice},
   {PID_BURN_IN, DimmerModel_GetBurnIn, 0u, DimmerModel_SetBurnIn},
   {PID_IDENTIFY_MODE, DimmerModel_GetIdentifyMode, 0u,
     DimmerModel_SetIdentifyMode},
@@ -1373,10 +1972,10 @@ static const SlotDefinition PERSONALITY_SLOTS[] = {
 
 static const PersonalityDefinition PERSONALITIES[PERSONALITY_COUNT] = {
   {
-    .dmx_footprint = 1u,
+    .dmx_footprint = SUB_DEVICE_FOOTPRINT,
     .description = PERSONALITY_DESCRIPTION,
     .slots = PERSONALITY_SLOTS,
-    .slot_count = 1u
+    .slot_count = SUB_DEVICE_FOOTPRINT
   },
 };
 
@@ -29,10 +29,16 @@
  * ### Sub-devices
  *
  * The model has multiple sub-devices, that each take a single slot of DMX
- * data. The sub-devices are not contiguous.
+ * data. The sub-devices are not contiguous, sub-device 2 is skipped.
+ *
+ * There are 4 sub-devices by default. This can be changed, up to the 512
+ * allowed by E1.20, with the DIMMER_MODEL_SUB_DEVICES preprocessor
+ * definition. With 512 sub-devices there's no gap. More sub-devices will also
+ * need a larger MODEL_ARENA_SIZE, each one takes 33 bytes of the arena.
  *
  * DMX_BLOCK_ADDRESS can be used to set the start address of all sub-devices in
- * a single operation.
+ * a single operation. SETs to SUBDEVICE_ALL are applied to all sub-devices in
+ * a single operation as well.
  *
  * ### Dimmer Settings
  *
@@ -40,14 +46,28 @@
  * things interesting, not all sub-devices support all the dimmer curves /
  * modulation frequencies.
  *
+ * ### Output
+ *
+ * Each sub-device drives a single white pixel on the SPI output. The slot
+ * value is converted to a level using the sub-device's curve and minimum /
+ * maximum levels, see @ref dimmer_curve. Only the first SPIRGB_MAX_PIXELS
+ * sub-devices have an output.
+ *
  * ### Presets & Scenes.
  *
  * The root device provides 3 scenes. The first scene (index 1) is a factory
  * programed scene, which can't be modified. The 2nd and 3rd scenes can be
  * 'updated' with capture preset.
  *
+ * PRESET_PLAYBACK fades to a scene, and PRESET_MERGEMODE controls how the
+ * scene is merged with DMX. Fades are advanced every 20ms.
+ *
  * DMX_FAIL_MODE and DMX_STARTUP_MODE can be used to change the on-failure and
- * on-startup scenes.
+ * on-startup scenes. The startup scene is played if no DMX arrives within the
+ * startup delay of the model being activated. The fail scene is played once
+ * no DMX has arrived for the loss of signal delay, which is at least 1.25s.
+ * Scene 0 holds the last DMX levels. When the hold time expires, the DMX
+ * levels are set to 0. The next DMX frame ends the startup or fail scene.
  *
  * ### Status Messages
  *
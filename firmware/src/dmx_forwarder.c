@@ -0,0 +1,253 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * dmx_forwarder.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "dmx_forwarder.h"
+
+#include <string.h>
+
+#include "app_pipeline.h"
+#include "coarse_timer.h"
+#include "constants.h"
+#include "dmx_snapshot.h"
+#include "dmx_spec.h"
+#include "scheduler.h"
+#include "utils.h"
+
+typedef struct {
+  uint8_t latest[DMX_FRAME_SIZE];  //!< The frame being sent.
+  uint8_t sent[DMX_FRAME_SIZE];  //!< The slot data the Host has.
+  uint16_t latest_length;
+  uint16_t sent_length;
+  uint16_t interval;  //!< The minimum time between messages, 0 is disabled.
+  uint32_t generation;  //!< The snapshot generation of the latest frame.
+  bool more;  //!< True if the latest frame has changes that weren't sent.
+  CoarseTimer_Value last_send;  //!< When the last message was sent.
+} DMXForwarderData;
+
+static DMXForwarderData g_forwarder;
+
+// PAYLOAD_SIZE is the most the transport will send in a single message, so a
+// message that was accepted reached the Host in full.
+static uint8_t g_forwarder_message[PAYLOAD_SIZE];
+
+#ifndef PIPELINE_TRANSPORT_TX
+static TransportTXFunction g_forwarder_tx_cb;
+#endif
+
+static uint8_t* PackUInt16(uint8_t *ptr, uint16_t value) {
+  // Messages are little endian, see @ref message-endian.
+  *ptr++ = ShortLSB(value);
+  *ptr++ = ShortMSB(value);
+  return ptr;
+}
+
+static inline uint16_t UnpackUInt16(const uint8_t *ptr) {
+  return (ptr[1] << 8) + ptr[0];
+}
+
+static inline bool SlotChanged(unsigned int slot) {
+  return slot >= g_forwarder.sent_length ||
+         g_forwarder.latest[slot] != g_forwarder.sent[slot];
+}
+
+/*
+ * @brief Find the next changed slot.
+ * @returns The index of the changed slot, or length if none changed.
+ */
+static unsigned int FindRangeStart(unsigned int slot, unsigned int length) {
+  while (slot < length && !SlotChanged(slot)) {
+    slot++;
+  }
+  return slot;
+}
+
+/*
+ * @brief Find the end of a range of changed slots.
+ *
+ * Gaps of fewer unchanged slots than a range header are included in the
+ * range.
+ * @returns The index after the last changed slot in the range.
+ */
+static unsigned int FindRangeEnd(unsigned int start, unsigned int length) {
+  unsigned int end = start + 1u;
+  unsigned int slot = end;
+  while (slot < length && slot - end < DMX_FORWARDER_RANGE_HEADER_SIZE) {
+    if (SlotChanged(slot)) {
+      end = slot + 1u;
+    }
+    slot++;
+  }
+  return end;
+}
+
+/*
+ * @brief Update the copy of the Host's data from a message that was sent.
+ * @param end The end of the message.
+ * @param complete true if the message contained all the changed slots.
+ *
+ * If the message was incomplete, only the slots up to the end of the last
+ * range are known to the Host. The slots after that are compared against the
+ * previous copy, so they must not be marked as sent.
+ */
+static void ApplyMessage(const uint8_t *end, bool complete) {
+  const uint8_t *ptr = g_forwarder_message;
+  uint16_t length = UnpackUInt16(ptr);
+  uint16_t sent_length = g_forwarder.sent_length;
+  ptr += DMX_FORWARDER_HEADER_SIZE;
+  while (ptr < end) {
+    uint16_t start = UnpackUInt16(ptr);
+    uint16_t size = UnpackUInt16(ptr + 2u);
+    ptr += DMX_FORWARDER_RANGE_HEADER_SIZE;
+    memcpy(g_forwarder.sent + start, ptr, size);
+    ptr += size;
+    if (start + size > sent_length) {
+      sent_length = start + size;
+    }
+  }
+
+  if (complete || sent_length > length) {
+    sent_length = length;
+  }
+  g_forwarder.sent_length = sent_length;
+}
+
+// Public Functions
+// ----------------------------------------------------------------------------
+void DMXForwarder_Initialize(TransportTXFunction tx_cb) {
+  DMXForwarder_SetInterval(0u);
+#ifndef PIPELINE_TRANSPORT_TX
+  g_forwarder_tx_cb = tx_cb;
+#endif
+}
+
+void DMXForwarder_SetInterval(uint16_t interval) {
+  g_forwarder.interval = interval;
+  g_forwarder.latest_length = 0u;
+  g_forwarder.sent_length = 0u;
+  g_forwarder.generation = DMXSnapshot_Generation();
+  g_forwarder.more = false;
+  g_forwarder.last_send = CoarseTimer_GetTime();
+}
+
+uint16_t DMXForwarder_GetInterval() {
+  return g_forwarder.interval;
+}
+
+bool DMXForwarder_NextDeadline(uint32_t *delay) {
+  if (!g_forwarder.interval ||
+      (!g_forwarder.more &&
+       DMXSnapshot_Generation() == g_forwarder.generation)) {
+    return false;
+  }
+
+  *delay = g_forwarder.more ?
+      0u : CoarseTimer_Remaining(g_forwarder.last_send, g_forwarder.interval);
+  if (*delay == 0u) {
+    // Either there's more of the frame to send, or the last attempt to send
+    // failed. Try again on the next tick.
+    *delay = 1u;
+  }
+  return true;
+}
+
+void DMXForwarder_Tasks() {
+  if (!g_forwarder.interval) {
+    return;
+  }
+
+  // Rate limit, unless we're sending the rest of the latest frame.
+  if (!g_forwarder.more &&
+      (DMXSnapshot_Generation() == g_forwarder.generation ||
+       !CoarseTimer_HasElapsed(g_forwarder.last_send, g_forwarder.interval))) {
+    return;
+  }
+
+#ifndef PIPELINE_TRANSPORT_TX
+  if (!g_forwarder_tx_cb) {
+    return;
+  }
+#endif
+
+  if (!g_forwarder.more) {
+    g_forwarder.generation = DMXSnapshot_Read(g_forwarder.latest, 0u,
+                                              DMX_FRAME_SIZE,
+                                              &g_forwarder.latest_length);
+  }
+
+  uint16_t length = g_forwarder.latest_length;
+  uint8_t *ptr = PackUInt16(g_forwarder_message, length);
+  bool complete = true;
+
+  unsigned int start = FindRangeStart(0u, length);
+  while (start < length) {
+    unsigned int space = g_forwarder_message + PAYLOAD_SIZE - ptr;
+    if (space <= DMX_FORWARDER_RANGE_HEADER_SIZE) {
+      complete = false;
+      break;
+    }
+
+    unsigned int end = FindRangeEnd(start, length);
+    unsigned int size = end - start;
+    if (size > space - DMX_FORWARDER_RANGE_HEADER_SIZE) {
+      size = space - DMX_FORWARDER_RANGE_HEADER_SIZE;
+      complete = false;
+    }
+
+    ptr = PackUInt16(ptr, start);
+    ptr = PackUInt16(ptr, size);
+    memcpy(ptr, g_forwarder.latest + start, size);
+    ptr += size;
+
+    if (!complete) {
+      break;
+    }
+    start = FindRangeStart(end, length);
+  }
+
+  if (ptr == g_forwarder_message + DMX_FORWARDER_HEADER_SIZE &&
+      length == g_forwarder.sent_length) {
+    // Nothing changed.
+    g_forwarder.more = false;
+    return;
+  }
+
+  IOVec iovec;
+  iovec.base = g_forwarder_message;
+  iovec.length = ptr - g_forwarder_message;
+
+#ifdef PIPELINE_TRANSPORT_TX
+  bool ok = PIPELINE_TRANSPORT_TX(EVENT_TOKEN, COMMAND_DMX_DATA, RC_OK,
+                                  &iovec, 1u);
+#else
+  bool ok = g_forwarder_tx_cb(EVENT_TOKEN, COMMAND_DMX_DATA, RC_OK, &iovec,
+                              1u);
+#endif
+  if (ok) {
+    ApplyMessage(ptr, complete);
+    g_forwarder.more = !complete;
+    g_forwarder.last_send = CoarseTimer_GetTime();
+  } else {
+    // Try again with the same frame.
+    g_forwarder.more = true;
+  }
+  if (g_forwarder.more) {
+    // The rest of the frame goes on the next tick.
+    Scheduler_DeadlineChanged();
+  }
+}
@@ -0,0 +1,121 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * dmx_forwarder.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup dmx_forwarder DMX Forwarder
+ * @brief Forward the DMX512 received in responder mode to the Host.
+ *
+ * Forwarding is off by default, it's enabled by setting a non-0 interval with
+ * DMXForwarder_SetInterval().
+ *
+ * The forwarder keeps a copy of the slot data the Host has been sent. When a
+ * new frame is available in the @ref dmx_snapshot, DMXForwarder_Tasks()
+ * compares it with the copy and only sends the ranges of slots that changed,
+ * in a COMMAND_DMX_DATA message, see @ref message-commands-dmxdata. Ranges
+ * separated by a few unchanged slots are merged, since the unchanged slots
+ * cost less than a new range header.
+ *
+ * At most one message is sent per interval, so the USB load tracks the rate
+ * of change rather than the DMX512 frame rate. Frames which arrive within
+ * the interval are coalesced, only the latest is sent.
+ *
+ * If the changes don't fit in a single message, the remaining ranges are
+ * sent straight away in the next message.
+ *
+ * @addtogroup dmx_forwarder
+ * @{
+ * @file dmx_forwarder.h
+ * @brief Forward received DMX512 to the Host.
+ */
+
+#ifndef FIRMWARE_SRC_DMX_FORWARDER_H_
+#define FIRMWARE_SRC_DMX_FORWARDER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "transport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The size of the slot count at the start of a COMMAND_DMX_DATA
+ * message.
+ */
+enum { DMX_FORWARDER_HEADER_SIZE = 2u };
+
+/**
+ * @brief The size of a range header in a COMMAND_DMX_DATA message.
+ */
+enum { DMX_FORWARDER_RANGE_HEADER_SIZE = 4u };
+
+/**
+ * @brief Initialize the DMX Forwarder module.
+ * @param tx_cb The function used to send messages to the Host. If
+ *   PIPELINE_TRANSPORT_TX is defined in app_pipeline.h, the macro will
+ *   override this value.
+ *
+ * Forwarding is disabled.
+ */
+void DMXForwarder_Initialize(TransportTXFunction tx_cb);
+
+/**
+ * @brief Set the minimum time between COMMAND_DMX_DATA messages.
+ * @param interval The interval in 10ths of a millisecond, 0 disables
+ *   forwarding.
+ *
+ * Changing the interval resets the copy of the Host's data, so the next
+ * message contains all the slots.
+ */
+void DMXForwarder_SetInterval(uint16_t interval);
+
+/**
+ * @brief Get the minimum time between COMMAND_DMX_DATA messages.
+ * @returns The interval in 10ths of a millisecond, 0 means forwarding is
+ *   disabled.
+ */
+uint16_t DMXForwarder_GetInterval();
+
+/**
+ * @brief Send any changes to the Host.
+ *
+ * This should be called from the main event loop.
+ */
+void DMXForwarder_Tasks();
+
+/**
+ * @brief Get the time until DMXForwarder_Tasks() next needs to run.
+ * @param[out] delay The time until the next message can be sent, in 10ths
+ *   of a millisecond.
+ * @returns false if there is nothing to send. New frames are received by
+ *   the transceiver tasks, which also run the forwarder.
+ */
+bool DMXForwarder_NextDeadline(uint32_t *delay);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif  // FIRMWARE_SRC_DMX_FORWARDER_H_
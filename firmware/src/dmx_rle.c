@@ -0,0 +1,152 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * dmx_rle.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "dmx_rle.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "dmx_spec.h"
+
+// The first control byte of each segment type.
+enum {
+  LITERAL_CONTROL = 0x00,
+  ZERO_RUN_CONTROL = 0x80,
+  VALUE_RUN_CONTROL = 0xc0
+};
+
+int DMXRLE_DecodedSize(const uint8_t *data, unsigned int size) {
+  const uint8_t *end = data + size;
+  unsigned int slots = 0u;
+
+  while (data < end) {
+    uint8_t control = *data++;
+    if (control < ZERO_RUN_CONTROL) {
+      unsigned int length = control - LITERAL_CONTROL + 1u;
+      if (length > (unsigned int) (end - data)) {
+        return -1;
+      }
+      data += length;
+      slots += length;
+    } else if (control < VALUE_RUN_CONTROL) {
+      slots += control - ZERO_RUN_CONTROL + 1u;
+    } else {
+      if (data == end) {
+        return -1;
+      }
+      data++;
+      slots += control - VALUE_RUN_CONTROL + 1u;
+    }
+    if (slots > DMX_FRAME_SIZE) {
+      return -1;
+    }
+  }
+  return slots;
+}
+
+unsigned int DMXRLE_Decode(uint8_t *output, const uint8_t *data,
+                           unsigned int size) {
+  const uint8_t *end = data + size;
+  uint8_t *out = output;
+  const uint8_t *out_end = output + DMX_FRAME_SIZE;
+
+  while (data < end) {
+    uint8_t control = *data++;
+    unsigned int length;
+    if (control < ZERO_RUN_CONTROL) {
+      length = control - LITERAL_CONTROL + 1u;
+      if (length > (unsigned int) (end - data) ||
+          length > (unsigned int) (out_end - out)) {
+        break;
+      }
+      memcpy(out, data, length);
+      data += length;
+    } else if (control < VALUE_RUN_CONTROL) {
+      length = control - ZERO_RUN_CONTROL + 1u;
+      if (length > (unsigned int) (out_end - out)) {
+        break;
+      }
+      memset(out, 0, length);
+    } else {
+      length = control - VALUE_RUN_CONTROL + 1u;
+      if (data == end || length > (unsigned int) (out_end - out)) {
+        break;
+      }
+      memset(out, *data++, length);
+    }
+    out += length;
+  }
+  return out - output;
+}
+
+unsigned int DMXRLE_Encode(uint8_t *output, unsigned int output_size,
+                           const uint8_t *data, unsigned int size) {
+  unsigned int in = 0u;
+  unsigned int out = 0u;
+  // The offset of the control byte for the current literal segment.
+  unsigned int literal_control = 0u;
+  bool in_literal = false;
+
+  while (in < size) {
+    uint8_t value = data[in];
+    unsigned int run = 1u;
+    while (in + run < size && run < DMX_RLE_MAX_RUN &&
+           data[in + run] == value) {
+      run++;
+    }
+
+    // A zero run costs 1 byte and a value run 2, so only use them when it's
+    // no worse than extending a literal.
+    if (run >= (value == 0u ? 2u : 3u)) {
+      if (value == 0u) {
+        if (out + 1u > output_size) {
+          return 0u;
+        }
+        output[out++] = ZERO_RUN_CONTROL + run - 1u;
+      } else {
+        if (out + 2u > output_size) {
+          return 0u;
+        }
+        output[out++] = VALUE_RUN_CONTROL + run - 1u;
+        output[out++] = value;
+      }
+      in += run;
+      in_literal = false;
+      continue;
+    }
+
+    if (in_literal &&
+        output[literal_control] - LITERAL_CONTROL + 1u < DMX_RLE_MAX_LITERAL) {
+      if (out + 1u > output_size) {
+        return 0u;
+      }
+      output[literal_control]++;
+    } else {
+      if (out + 2u > output_size) {
+        return 0u;
+      }
+      literal_control = out;
+      output[out++] = LITERAL_CONTROL;
+      in_literal = true;
+    }
+    output[out++] = value;
+    in++;
+  }
+  return out;
+}
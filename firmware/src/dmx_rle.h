@@ -0,0 +1,112 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * dmx_rle.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup dmx_rle DMX Run Length Encoding
+ * @brief Compact encoding of DMX512 slot data.
+ *
+ * Sparse universes often contain long runs of zeros or repeated values. This
+ * encoding reduces the number of bytes the Host needs to send for such
+ * universes.
+ *
+ * The encoded data is a sequence of segments. Each segment starts with a
+ * control byte:
+ *  - 0x00 - 0x7f: A literal segment. The next (control + 1) bytes are copied
+ *    to the output.
+ *  - 0x80 - 0xbf: A zero run. (control - 0x80 + 1) slots are set to 0.
+ *  - 0xc0 - 0xff: A value run. The next byte is repeated (control - 0xc0 + 1)
+ *    times.
+ *
+ * The decoded data must not exceed DMX_FRAME_SIZE slots.
+ *
+ * @addtogroup dmx_rle
+ * @{
+ * @file dmx_rle.h
+ * @brief Compact encoding of DMX512 slot data.
+ */
+
+#ifndef FIRMWARE_SRC_DMX_RLE_H_
+#define FIRMWARE_SRC_DMX_RLE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The maximum length of a literal segment.
+ */
+#define DMX_RLE_MAX_LITERAL 128u
+
+/**
+ * @brief The maximum length of a zero or value run.
+ */
+#define DMX_RLE_MAX_RUN 64u
+
+/**
+ * @brief Check encoded data and return the number of slots it decodes to.
+ * @param data The encoded data.
+ * @param size The size of the encoded data.
+ * @returns The number of slots, or -1 if the data is malformed or decodes to
+ *   more than DMX_FRAME_SIZE slots.
+ *
+ * This only inspects the control bytes, so it's much cheaper than a full
+ * decode.
+ */
+int DMXRLE_DecodedSize(const uint8_t *data, unsigned int size);
+
+/**
+ * @brief Decode data into a slot buffer.
+ * @param output The buffer to write the slot data to, must be at least
+ *   DMX_FRAME_SIZE bytes.
+ * @param data The encoded data.
+ * @param size The size of the encoded data.
+ * @returns The number of slots written to output.
+ *
+ * Decoding stops at the first malformed segment, or once DMX_FRAME_SIZE
+ * slots have been written.
+ */
+unsigned int DMXRLE_Decode(uint8_t *output, const uint8_t *data,
+                           unsigned int size);
+
+/**
+ * @brief Encode slot data.
+ * @param output The buffer to write the encoded data to.
+ * @param output_size The size of the output buffer.
+ * @param data The slot data.
+ * @param size The number of slots.
+ * @returns The size of the encoded data, or 0 if the output buffer was too
+ *   small.
+ *
+ * The firmware doesn't need this, it's provided for the Host tools and tests.
+ * In the worst case the encoded data is size + ceil(size / 128) bytes.
+ */
+unsigned int DMXRLE_Encode(uint8_t *output, unsigned int output_size,
+                           const uint8_t *data, unsigned int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif  // FIRMWARE_SRC_DMX_RLE_H_
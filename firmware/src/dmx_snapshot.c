@@ -0,0 +1,120 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * dmx_snapshot.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "dmx_snapshot.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "dmx_spec.h"
+#include "scheduler.h"
+
+typedef struct {
+  uint8_t slots[DMX_FRAME_SIZE];
+  uint16_t slot_count;
+} DMXFrame;
+
+typedef struct {
+  DMXFrame frames[2];
+  uint16_t rx_count;  //!< The slots received into the back buffer.
+  bool receiving;  //!< True if the back buffer has data.
+  /**
+   * @brief The number of frames completed. The front buffer is
+   * frames[generation & 1].
+   */
+  volatile uint32_t generation;
+} DMXSnapshotData;
+
+static DMXSnapshotData g_snapshot;
+
+/*
+ * @brief Stop the compiler moving memory accesses across this point.
+ *
+ * The PIC32MX is a single core, so a compiler barrier is enough to order the
+ * slot copy against the reads of the generation.
+ */
+static inline void CompilerBarrier() {
+  __asm__ __volatile__("" ::: "memory");
+}
+
+static inline DMXFrame *BackBuffer() {
+  return &g_snapshot.frames[(g_snapshot.generation + 1u) & 1u];
+}
+
+// Public Functions
+// ----------------------------------------------------------------------------
+void DMXSnapshot_Initialize() {
+  g_snapshot.frames[0].slot_count = 0u;
+  g_snapshot.frames[1].slot_count = 0u;
+  g_snapshot.rx_count = 0u;
+  g_snapshot.receiving = false;
+  g_snapshot.generation = 0u;
+}
+
+void DMXSnapshot_Receive(const uint8_t *slots, unsigned int count) {
+  if (count > DMX_FRAME_SIZE) {
+    count = DMX_FRAME_SIZE;
+  }
+  // Only copy the slots we haven't seen yet.
+  if (count > g_snapshot.rx_count) {
+    memcpy(BackBuffer()->slots + g_snapshot.rx_count,
+           slots + g_snapshot.rx_count,
+           count - g_snapshot.rx_count);
+    g_snapshot.rx_count = count;
+  }
+  g_snapshot.receiving = true;
+}
+
+void DMXSnapshot_FrameComplete() {
+  if (!g_snapshot.receiving) {
+    return;
+  }
+
+  BackBuffer()->slot_count = g_snapshot.rx_count;
+  CompilerBarrier();
+  g_snapshot.generation++;
+  g_snapshot.rx_count = 0u;
+  g_snapshot.receiving = false;
+  // The DMX forwarder sends new frames once its interval has passed.
+  Scheduler_DeadlineChanged();
+}
+
+uint32_t DMXSnapshot_Generation() {
+  return g_snapshot.generation;
+}
+
+uint32_t DMXSnapshot_Read(uint8_t *slots, unsigned int offset,
+                          unsigned int size, uint16_t *slot_count) {
+  uint32_t generation;
+  do {
+    generation = g_snapshot.generation;
+    CompilerBarrier();
+    const DMXFrame *frame = &g_snapshot.frames[generation & 1u];
+    *slot_count = frame->slot_count;
+    if (offset < *slot_count) {
+      unsigned int copy_size = *slot_count - offset;
+      memcpy(slots, frame->slots + offset,
+             copy_size < size ? copy_size : size);
+    }
+    CompilerBarrier();
+    // If a frame completed, the buffer we read from is now the back buffer
+    // and may have been overwritten.
+  } while (generation != g_snapshot.generation);
+  return generation;
+}
@@ -0,0 +1,111 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * dmx_snapshot.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup dmx_snapshot DMX Snapshot
+ * @brief The last complete DMX512 frame received.
+ *
+ * The responder writes the slots into the snapshot as they're received, from
+ * the transceiver callback. Models read the last complete frame from task
+ * context, rather than handling each slot as it arrives.
+ *
+ * There are two frame buffers. The front buffer holds the last complete
+ * frame, the back buffer is filled as a frame is received. When the frame
+ * completes the buffers are swapped and the generation counter is
+ * incremented.
+ *
+ * Readers use the generation as a sequence lock: the generation is read
+ * before & after the slots are copied, if it changed the back buffer may have
+ * been written to during the copy, so the read is retried. The writer never
+ * waits, so this is safe to use from an ISR.
+ *
+ * @addtogroup dmx_snapshot
+ * @{
+ * @file dmx_snapshot.h
+ * @brief The last complete DMX512 frame received.
+ */
+
+#ifndef FIRMWARE_SRC_DMX_SNAPSHOT_H_
+#define FIRMWARE_SRC_DMX_SNAPSHOT_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize the DMX Snapshot module.
+ *
+ * This discards any frames received, and resets the generation to 0.
+ */
+void DMXSnapshot_Initialize();
+
+/**
+ * @brief Called as the slots of a DMX512 frame are received.
+ * @param slots The slot data received so far, not including the start code.
+ * @param count The number of slots received so far.
+ *
+ * This is called from the transceiver callback, with interrupts disabled.
+ */
+void DMXSnapshot_Receive(const uint8_t *slots, unsigned int count);
+
+/**
+ * @brief Called when a DMX512 frame is complete.
+ *
+ * This is called from the transceiver callback, with interrupts disabled.
+ * It has no effect if DMXSnapshot_Receive() wasn't called since the last
+ * frame completed.
+ */
+void DMXSnapshot_FrameComplete();
+
+/**
+ * @brief Return the generation of the last complete frame.
+ * @returns The generation, this is 0 until the first frame completes.
+ *
+ * Models can compare this against the generation returned by
+ * DMXSnapshot_Read() to check for a new frame, without copying the slots.
+ */
+uint32_t DMXSnapshot_Generation();
+
+/**
+ * @brief Copy slots from the last complete frame.
+ * @param slots The memory to copy the slot data to.
+ * @param offset The index of the first slot to copy, the slot after the start
+ *   code is 0.
+ * @param size The maximum number of slots to copy.
+ * @param[out] slot_count The number of slots in the frame, not including the
+ *   start code.
+ * @returns The generation of the frame the slots were copied from.
+ *
+ * Slots beyond the end of the frame aren't copied, so at most
+ * slot_count - offset slots are copied.
+ */
+uint32_t DMXSnapshot_Read(uint8_t *slots, unsigned int offset,
+                          unsigned int size, uint16_t *slot_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif  // FIRMWARE_SRC_DMX_SNAPSHOT_H_
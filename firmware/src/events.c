@@ -0,0 +1,117 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * events.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "events.h"
+
+#include "app_pipeline.h"
+#include "constants.h"
+#include "utils.h"
+
+typedef struct {
+  uint8_t type;
+  uint8_t arg;
+  uint32_t value;
+} Event;
+
+typedef struct {
+  Event queue[EVENT_QUEUE_SIZE];
+  uint8_t size;
+  uint32_t dropped;  //!< The number of events dropped since the last send.
+} EventsData;
+
+static EventsData g_events;
+
+// Room for a full queue and the overflow event.
+static uint8_t g_event_buffer[(EVENT_QUEUE_SIZE + 1u) * EVENT_SIZE];
+
+#ifndef PIPELINE_TRANSPORT_TX
+static TransportTXFunction g_events_tx_cb;
+#endif
+
+static uint8_t* PackEvent(uint8_t *ptr, uint8_t type, uint8_t arg,
+                          uint32_t value) {
+  // Messages are little endian, see @ref message-endian.
+  *ptr++ = type;
+  *ptr++ = arg;
+  *ptr++ = UInt32Byte3(value);
+  *ptr++ = UInt32Byte2(value);
+  *ptr++ = UInt32Byte1(value);
+  *ptr++ = UInt32Byte0(value);
+  return ptr;
+}
+
+void Events_Initialize(TransportTXFunction tx_cb) {
+  g_events.size = 0u;
+  g_events.dropped = 0u;
+#ifndef PIPELINE_TRANSPORT_TX
+  g_events_tx_cb = tx_cb;
+#endif
+}
+
+void Events_Push(EventType type, uint8_t arg, uint32_t value) {
+  if (g_events.size == EVENT_QUEUE_SIZE) {
+    g_events.dropped++;
+    return;
+  }
+  Event *event = &g_events.queue[g_events.size++];
+  event->type = type;
+  event->arg = arg;
+  event->value = value;
+}
+
+unsigned int Events_PendingCount() {
+  return g_events.size;
+}
+
+void Events_Tasks() {
+  if (g_events.size == 0u && g_events.dropped == 0u) {
+    return;
+  }
+
+#ifndef PIPELINE_TRANSPORT_TX
+  if (!g_events_tx_cb) {
+    return;
+  }
+#endif
+
+  uint8_t *ptr = g_event_buffer;
+  unsigned int i = 0u;
+  for (; i < g_events.size; i++) {
+    const Event *event = &g_events.queue[i];
+    ptr = PackEvent(ptr, event->type, event->arg, event->value);
+  }
+  if (g_events.dropped) {
+    ptr = PackEvent(ptr, EVENT_QUEUE_OVERFLOW, 0u, g_events.dropped);
+  }
+
+  IOVec iovec;
+  iovec.base = g_event_buffer;
+  iovec.length = ptr - g_event_buffer;
+
+#ifdef PIPELINE_TRANSPORT_TX
+  bool ok = PIPELINE_TRANSPORT_TX(EVENT_TOKEN, COMMAND_EVENT, RC_OK, &iovec,
+                                  1u);
+#else
+  bool ok = g_events_tx_cb(EVENT_TOKEN, COMMAND_EVENT, RC_OK, &iovec, 1u);
+#endif
+  if (ok) {
+    g_events.size = 0u;
+    g_events.dropped = 0u;
+  }
+}
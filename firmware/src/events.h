@@ -0,0 +1,133 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * events.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup events Events
+ * @brief Push notifications to the Host.
+ *
+ * Rather than having the Host poll for state changes, modules queue an event
+ * with Events_Push(). Events_Tasks() then sends all queued events in a single
+ * COMMAND_EVENT message, using the reserved EVENT_TOKEN, once the transport
+ * is free.
+ *
+ * If the queue fills before the events can be sent, further events are
+ * dropped and an EVENT_QUEUE_OVERFLOW event with the number of dropped events
+ * is appended to the next message.
+ *
+ * @addtogroup events
+ * @{
+ * @file events.h
+ * @brief The Events Module.
+ */
+
+#ifndef FIRMWARE_SRC_EVENTS_H_
+#define FIRMWARE_SRC_EVENTS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "transport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The types of event.
+ */
+typedef enum {
+  /**
+   * @brief The transceiver mode changed. The argument is the new
+   * TransceiverMode.
+   */
+  EVENT_MODE_CHANGED = 1,
+  /**
+   * @brief A receiver error counter crossed a threshold. The argument is the
+   * ReceiverErrorCounter and the value is the current count.
+   */
+  EVENT_RECEIVER_COUNTER = 2,
+  /**
+   * @brief The set of UIDs the device responds to changed, the controller
+   * should re-run discovery. The value is the number of proxied child devices
+   * now visible, the argument is unused.
+   */
+  EVENT_TOD_CHANGED = 3,
+  /**
+   * @brief The log buffer overflowed and some messages were dropped.
+   */
+  EVENT_LOG_OVERFLOW = 4,
+  /**
+   * @brief The event queue overflowed. The value is the number of events
+   * that were dropped.
+   */
+  EVENT_QUEUE_OVERFLOW = 5
+} EventType;
+
+/**
+ * @brief The number of events that can be queued.
+ */
+#define EVENT_QUEUE_SIZE 8u
+
+/**
+ * @brief The size of a single event on the wire.
+ */
+#define EVENT_SIZE 6u
+
+/**
+ * @brief Initialize the Events sub-system.
+ * @param tx_cb The callback to use for sending events. This can be
+ *   overridden, see the note below.
+ *
+ * If PIPELINE_TRANSPORT_TX is defined in app_pipeline.h, the macro
+ * will override the tx_cb argument.
+ */
+void Events_Initialize(TransportTXFunction tx_cb);
+
+/**
+ * @brief Queue an event for the Host.
+ * @param type The type of event.
+ * @param arg An 8-bit argument, see EventType for the meaning.
+ * @param value A 32-bit value, see EventType for the meaning.
+ *
+ * This must not be called from an ISR.
+ */
+void Events_Push(EventType type, uint8_t arg, uint32_t value);
+
+/**
+ * @brief The number of events waiting to be sent.
+ */
+unsigned int Events_PendingCount();
+
+/**
+ * @brief Send any queued events.
+ *
+ * This should be called in the main event loop. If the transport is busy the
+ * events remain queued and are sent on a later call.
+ */
+void Events_Tasks();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FIRMWARE_SRC_EVENTS_H_
+
+/**
+ * @}
+ */
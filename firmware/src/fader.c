@@ -0,0 +1,69 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * fader.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "fader.h"
+
+enum { FRACTION_BITS = 16u };
+
+void Fader_Set(FaderChannel *channels, unsigned int count, uint8_t level) {
+  const FaderChannel *end = channels + count;
+  for (; channels != end; channels++) {
+    channels->level = (uint32_t) level << FRACTION_BITS;
+    channels->step = 0;
+    channels->ticks = 0u;
+    channels->target = level;
+  }
+}
+
+void Fader_Start(FaderChannel *channels, const uint8_t *targets,
+                 unsigned int count, uint32_t up_ticks, uint32_t down_ticks) {
+  const FaderChannel *end = channels + count;
+  for (; channels != end; channels++) {
+    const uint32_t target = (uint32_t) *targets << FRACTION_BITS;
+    const uint32_t ticks = target > channels->level ? up_ticks : down_ticks;
+    channels->target = *targets++;
+    if (target == channels->level || ticks == 0u) {
+      channels->level = target;
+      channels->step = 0;
+      channels->ticks = 0u;
+    } else {
+      channels->step = ((int32_t) target - (int32_t) channels->level) /
+                       (int32_t) ticks;
+      channels->ticks = ticks;
+    }
+  }
+}
+
+bool Fader_Tick(FaderChannel *channels, unsigned int count) {
+  bool fading = false;
+  const FaderChannel *end = channels + count;
+  for (; channels != end; channels++) {
+    if (channels->ticks == 0u) {
+      continue;
+    }
+    channels->ticks--;
+    if (channels->ticks) {
+      channels->level += channels->step;
+      fading = true;
+    } else {
+      channels->level = (uint32_t) channels->target << FRACTION_BITS;
+    }
+  }
+  return fading;
+}
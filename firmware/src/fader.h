@@ -0,0 +1,105 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * fader.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup fader Fader
+ * @brief Fade channels between levels at a fixed tick rate.
+ *
+ * Each channel holds its level in 8.16 fixed point. When a fade starts, the
+ * change per tick is calculated once for each channel, so each tick is a
+ * single addition per channel. On the last tick the level is set to the
+ * target, so rounding errors don't accumulate.
+ *
+ * Channels that are increasing use the up fade time, and channels that are
+ * decreasing use the down fade time.
+ *
+ * @addtogroup fader
+ * @{
+ * @file fader.h
+ * @brief Fade channels between levels at a fixed tick rate.
+ */
+
+#ifndef FIRMWARE_SRC_FADER_H_
+#define FIRMWARE_SRC_FADER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief A channel which can be faded.
+ */
+typedef struct {
+  uint32_t level;  //!< The current level, in 8.16 fixed point.
+  int32_t step;  //!< The change per tick, in 8.16 fixed point.
+  uint32_t ticks;  //!< The number of ticks until the fade completes.
+  uint8_t target;  //!< The level at the end of the fade.
+} FaderChannel;
+
+/**
+ * @brief Set the level of channels, without fading.
+ * @param channels The channels to set.
+ * @param count The number of channels.
+ * @param level The new level.
+ */
+void Fader_Set(FaderChannel *channels, unsigned int count, uint8_t level);
+
+/**
+ * @brief Start fading channels towards new levels.
+ * @param channels The channels to fade.
+ * @param targets The new level for each channel.
+ * @param count The number of channels.
+ * @param up_ticks The number of ticks to fade channels which are increasing.
+ * @param down_ticks The number of ticks to fade channels which are
+ *   decreasing.
+ *
+ * A fade time of 0 ticks sets the level immediately.
+ */
+void Fader_Start(FaderChannel *channels, const uint8_t *targets,
+                 unsigned int count, uint32_t up_ticks, uint32_t down_ticks);
+
+/**
+ * @brief Advance the fade by a single tick.
+ * @param channels The channels to fade.
+ * @param count The number of channels.
+ * @returns true if any of the channels are still fading.
+ */
+bool Fader_Tick(FaderChannel *channels, unsigned int count);
+
+/**
+ * @brief Get the current level of a channel.
+ * @param channel The channel.
+ * @returns The level, rounded to the nearest integer.
+ */
+static inline uint8_t Fader_Level(const FaderChannel *channel) {
+  return (channel->level + 0x8000u) >> 16;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif  // FIRMWARE_SRC_FADER_H_
@@ -22,9 +22,12 @@
 
 #include "constants.h"
 #include "macros.h"
+#include "pixel_encoder.h"
+#include "pixel_mapper.h"
 #include "rdm_frame.h"
 #include "rdm_responder.h"
 #include "rdm_util.h"
+#include "spi_rgb.h"
 #include "utils.h"
 
 // Various constants
@@ -33,19 +36,30 @@ enum {SOFTWARE_VERSION = 0x00000000 };
 static const char DEVICE_MODEL_DESCRIPTION[] = "Ja Rule LED Driver";
 static const char SOFTWARE_LABEL[] = "Alpha";
 static const char DEFAULT_DEVICE_LABEL[] = "Ja Rule";
-enum { MAX_PIXEL_COUNT = 170u };
+static const char PERSONALITY_DESCRIPTION1[] = "RGB per pixel";
+static const char PERSONALITY_DESCRIPTION2[] = "RGB per pixel, reversed";
+static const char PERSONALITY_DESCRIPTION3[] = "RGB per 2 pixels";
+static const char PERSONALITY_DESCRIPTION4[] = "Single RGB";
+enum { MAX_PIXEL_COUNT = PIXEL_MAPPER_MAX_PIXELS };
 enum { DEFAULT_PIXEL_COUNT = 2u };
+enum { PERSONALITY_COUNT = 4u };
 
 static const ResponderDefinition RESPONDER_DEFINITION;
 
-typedef enum {
-  PIXEL_TYPE_LPD8806 = 0x0001,
-  /*
-  PIXEL_TYPE_WS2801 = 0x0002,
-  PIXEL_TYPE_P9813 = 0x0003,
-  PIXEL_TYPE_APA102 = 0x0004,
-  */
-} PixelType;
+/*
+ * @brief How the slots are mapped to pixels, for each personality.
+ */
+typedef struct {
+  uint16_t group_size;  //!< The pixels per group of 3 slots, 0 means all.
+  bool reverse;
+} PixelLayout;
+
+static const PixelLayout PIXEL_LAYOUTS[PERSONALITY_COUNT] = {
+  {1u, false},
+  {1u, true},
+  {2u, false},
+  {0u, false}
+};
 
 typedef struct {
   PixelType pixel_type;
@@ -57,6 +71,9 @@ typedef struct {
    * case we could have up to 512 of them.
    */
   uint16_t pixel_count;
+
+  uint16_t mapped_start_address;  //!< The start address given to the mapper.
+  uint8_t mapped_personality;  //!< The personality given to the mapper.
 } LEDModel;
 
 
@@ -70,7 +87,7 @@ static const ParameterDescription PIXEL_TYPE_DESCRIPTION = {
   .unit = UNITS_NONE,
   .prefix = PREFIX_NONE,
   .min_valid_value = PIXEL_TYPE_LPD8806,
-  .max_valid_value = PIXEL_TYPE_LPD8806,
+  .max_valid_value = PIXEL_TYPE_WS2812,
   .default_value = PIXEL_TYPE_LPD8806,
   .description = PIXEL_TYPE_STRING,
 };
@@ -89,6 +106,79 @@ static const ParameterDescription PIXEL_COUNT_DESCRIPTION = {
 
 static LEDModel g_model;
 
+/*
+ * @brief The footprints depend on the pixel count, so these aren't const.
+ */
+static PersonalityDefinition g_personalities[PERSONALITY_COUNT] = {
+  {
+    .dmx_footprint = DEFAULT_PIXEL_COUNT * PIXEL_MAPPER_SLOTS_PER_PIXEL,
+    .description = PERSONALITY_DESCRIPTION1,
+    .slots = NULL,
+    .slot_count = 0u
+  },
+  {
+    .dmx_footprint = DEFAULT_PIXEL_COUNT * PIXEL_MAPPER_SLOTS_PER_PIXEL,
+    .description = PERSONALITY_DESCRIPTION2,
+    .slots = NULL,
+    .slot_count = 0u
+  },
+  {
+    .dmx_footprint = PIXEL_MAPPER_SLOTS_PER_PIXEL,
+    .description = PERSONALITY_DESCRIPTION3,
+    .slots = NULL,
+    .slot_count = 0u
+  },
+  {
+    .dmx_footprint = PIXEL_MAPPER_SLOTS_PER_PIXEL,
+    .description = PERSONALITY_DESCRIPTION4,
+    .slots = NULL,
+    .slot_count = 0u
+  }
+};
+
+static inline uint16_t GroupSize(const PixelLayout *layout) {
+  if (layout->group_size == 0u) {
+    return g_model.pixel_count ? g_model.pixel_count : 1u;
+  }
+  return layout->group_size;
+}
+
+/*
+ * @brief Recalculate the personality footprints from the pixel count.
+ */
+static void UpdateFootprints() {
+  unsigned int i = 0u;
+  for (; i < PERSONALITY_COUNT; i++) {
+    const uint16_t group_size = GroupSize(&PIXEL_LAYOUTS[i]);
+    g_personalities[i].dmx_footprint =
+        ((g_model.pixel_count + group_size - 1u) / group_size) *
+        PIXEL_MAPPER_SLOTS_PER_PIXEL;
+  }
+}
+
+/*
+ * @brief Configure the pixel mapper from the current settings.
+ */
+static void ConfigureMapper() {
+  g_model.mapped_start_address = g_responder->dmx_start_address;
+  g_model.mapped_personality = g_responder->current_personality;
+
+  const PixelLayout *layout = &PIXEL_LAYOUTS[0];
+  if (g_model.mapped_personality >= 1u &&
+      g_model.mapped_personality <= PERSONALITY_COUNT) {
+    layout = &PIXEL_LAYOUTS[g_model.mapped_personality - 1u];
+  }
+
+  PixelMapperSettings settings = {
+    .start_address = g_model.mapped_start_address,
+    .pixel_count = g_model.pixel_count,
+    .group_size = GroupSize(layout),
+    .order = PixelEncoder_Get(g_model.pixel_type)->order,
+    .reverse = layout->reverse
+  };
+  PixelMapper_Configure(&settings);
+}
+
 // PID Handlers
 // ----------------------------------------------------------------------------
 int LEDModel_GetParameterDescription(const RDMHeader *header,
@@ -123,10 +213,12 @@ int LEDModel_SetPixelType(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_FORMAT_ERROR);
   }
   const uint16_t type = ExtractUInt16(param_data);
-  if (type != PIXEL_TYPE_LPD8806) {
+  if (!PixelEncoder_Get(type)) {
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
   g_model.pixel_type = type;
+  SPIRGB_SetPixelType(g_model.pixel_type);
+  ConfigureMapper();
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -146,6 +238,8 @@ int LEDModel_SetPixelCount(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
   g_model.pixel_count = count;
+  UpdateFootprints();
+  ConfigureMapper();
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -158,9 +252,15 @@ static void LEDModel_Activate() {
   RDMResponder_InitResponder();
   g_model.pixel_type = PIXEL_TYPE_LPD8806;
   g_model.pixel_count = DEFAULT_PIXEL_COUNT;
+  SPIRGB_SetPixelType(g_model.pixel_type);
+  UpdateFootprints();
+  ConfigureMapper();
 }
 
-static void LEDModel_Deactivate() {}
+static void LEDModel_Deactivate() {
+  SPIRGB_SetPixelType(PIXEL_TYPE_LPD8806);
+  PixelMapper_Initialize();
+}
 
 static int LEDModel_HandleRequest(const RDMHeader *header,
                                   const uint8_t *param_data) {
@@ -187,7 +287,13 @@ static int LEDModel_HandleRequest(const RDMHeader *header,
   return RDMResponder_DispatchPID(header, param_data);
 }
 
-static void LEDModel_Tasks() {}
+static void LEDModel_Tasks() {
+  // The start address & personality are set by the generic PID handlers.
+  if (g_responder->dmx_start_address != g_model.mapped_start_address ||
+      g_responder->current_personality != g_model.mapped_personality) {
+    ConfigureMapper();
+  }
+}
 
 const ModelEntry LED_MODEL_ENTRY = {
   .model_id = LED_MODEL_ID,
@@ -214,6 +320,12 @@ static const PIDDescriptor PID_DESCRIPTORS[] = {
     RDMResponder_SetDeviceLabel},
   {PID_SOFTWARE_VERSION_LABEL, RDMResponder_GetSoftwareVersionLabel, 0u,
     (PIDCommandHandler) NULL},
+  {PID_DMX_PERSONALITY, RDMResponder_GetDMXPersonality, 0u,
+    RDMResponder_SetDMXPersonality},
+  {PID_DMX_PERSONALITY_DESCRIPTION, RDMResponder_GetDMXPersonalityDescription,
+    1u, (PIDCommandHandler) NULL},
+  {PID_DMX_START_ADDRESS, RDMResponder_GetDMXStartAddress, 0u,
+    RDMResponder_SetDMXStartAddress},
   {PID_IDENTIFY_DEVICE, RDMResponder_GetIdentifyDevice, 0u,
     RDMResponder_SetIdentifyDevice},
   {PID_PIXEL_TYPE, LEDModel_GetPixelType, 0u, LEDModel_SetPixelType},
@@ -230,8 +342,8 @@ static const ResponderDefinition RESPONDER_DEFINITION = {
   .descriptor_count = sizeof(PID_DESCRIPTORS) / sizeof(PIDDescriptor),
   .sensors = NULL,
   .sensor_count = 0,
-  .personalities = NULL,
-  .personality_count = 0u,
+  .personalities = g_personalities,
+  .personality_count = PERSONALITY_COUNT,
   .software_version_label = SOFTWARE_LABEL,
   .manufacturer_label = MANUFACTURER_LABEL,
   .model_description = DEVICE_MODEL_DESCRIPTION,
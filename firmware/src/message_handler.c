@@ -26,11 +26,14 @@
 #include "app.h"
 #include "app_pipeline.h"
 #include "constants.h"
+#include "dmx_forwarder.h"
+#include "dmx_rle.h"
 #include "flags.h"
 #include "peripheral/eth/plib_eth.h"
 #include "rdm_frame.h"
 #include "rdm_handler.h"
 #include "syslog.h"
+#include "trace.h"
 #include "transceiver.h"
 
 #include "app_settings.h"
@@ -314,6 +317,50 @@ static void ReturnRDMResponderJitter(uint8_t token, unsigned int length) {
   SendMessage(token, COMMAND_GET_RDM_RESPONDER_JITTER, RC_OK, &iovec, 1u);
 }
 
+static void SetDMXForwarding(uint8_t token,
+                             const uint8_t* payload,
+                             unsigned int length) {
+  uint16_t interval;
+  if (length != sizeof(interval)) {
+    SendMessage(token, COMMAND_SET_DMX_FORWARDING, RC_BAD_PARAM, NULL, 0u);
+    return;
+  }
+
+  interval = JoinUInt16(payload[1], payload[0]);
+  DMXForwarder_SetInterval(interval);
+  SendMessage(token, COMMAND_SET_DMX_FORWARDING, RC_OK, NULL, 0u);
+}
+
+static void ReturnDMXForwarding(uint8_t token, unsigned int length) {
+  if (length) {
+    SendMessage(token, COMMAND_GET_DMX_FORWARDING, RC_BAD_PARAM, NULL, 0u);
+    return;
+  }
+  uint16_t interval = DMXForwarder_GetInterval();
+  IOVec iovec;
+  iovec.base = (uint8_t*) &interval;
+  iovec.length = sizeof(interval);
+  SendMessage(token, COMMAND_GET_DMX_FORWARDING, RC_OK, &iovec, 1u);
+}
+
+static void ReturnTrace(uint8_t token, unsigned int length) {
+  if (length) {
+    SendMessage(token, COMMAND_GET_TRACE, RC_BAD_PARAM, NULL, 0u);
+    return;
+  }
+
+  uint32_t lost;
+  TraceRecord records[TRACE_RECORDS_PER_RESPONSE];
+  unsigned int count = Trace_Read(records, TRACE_RECORDS_PER_RESPONSE, &lost);
+
+  IOVec iovec[2];
+  iovec[0].base = (uint8_t*) &lost;
+  iovec[0].length = sizeof(lost);
+  iovec[1].base = (uint8_t*) records;
+  iovec[1].length = count * sizeof(TraceRecord);
+  SendMessage(token, COMMAND_GET_TRACE, RC_OK, iovec, 2u);
+}
+
 static bool CheckForTXMode(const Message *message) {
   if (Transceiver_GetMode() == T_MODE_CONTROLLER) {
     return true;
@@ -342,9 +389,29 @@ void MessageHandler_HandleMessage(const Message *message) {
         SendMessage(message->token, message->command, RC_BUFFER_FULL, NULL, 0u);
       }
       break;
+    case COMMAND_TX_DMX_RLE:
+      if (!CheckForTXMode(message)) {
+        break;
+      }
+      if (DMXRLE_DecodedSize(message->payload, message->length) < 0) {
+        SendMessage(message->token, message->command, RC_BAD_PARAM, NULL, 0u);
+      } else if (!Transceiver_QueueRLEDMX(message->token, message->payload,
+                                          message->length)) {
+        SendMessage(message->token, message->command, RC_BUFFER_FULL, NULL, 0u);
+      }
+      break;
+    case COMMAND_SET_DMX_FORWARDING:
+      SetDMXForwarding(message->token, message->payload, message->length);
+      break;
+    case COMMAND_GET_DMX_FORWARDING:
+      ReturnDMXForwarding(message->token, message->length);
+      break;
     case GET_FLAGS:
       Flags_SendResponse(message->token);
       break;
+    case COMMAND_GET_TRACE:
+      ReturnTrace(message->token, message->length);
+      break;
     case COMMAND_RESET_DEVICE:
       APP_Reset();
       SendMessage(message->token, message->command, RC_OK, NULL, 0u);
@@ -465,6 +532,9 @@ void MessageHandler_TransceiverEvent(const TransceiverEvent *event) {
     case T_OP_TX_ONLY:
       command = TX_DMX;
       break;
+    case T_OP_TX_DMX_RLE:
+      command = COMMAND_TX_DMX_RLE;
+      break;
     case T_OP_RDM_DUB:
       command = COMMAND_RDM_DUB_REQUEST;
       iovec[vector_size].base = &event->timing->dub_response;
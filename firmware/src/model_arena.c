@@ -0,0 +1,34 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * model_arena.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "model_arena.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static union {
+  uint8_t data[MODEL_ARENA_SIZE];
+  uint64_t align;
+  void *pointer_align;
+} g_arena;
+
+void *ModelArena_Claim() {
+  memset(g_arena.data, 0, MODEL_ARENA_SIZE);
+  return g_arena.data;
+}
@@ -0,0 +1,83 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * model_arena.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup model_arena Model Arena
+ * @brief Shared RAM for the state of the active RDM model.
+ *
+ * The RDM Handler only activates one model at a time, so rather than each
+ * model allocating all of its state statically, the models share a single
+ * block of RAM.
+ *
+ * A model claims the arena in its activate_fn and initializes its state there.
+ * The next model to be activated overwrites the state, so anything that
+ * should survive a model change needs to be kept outside the arena, or copied
+ * out in the deactivate_fn.
+ *
+ * @addtogroup model_arena
+ * @{
+ * @file model_arena.h
+ * @brief Shared RAM for the state of the active RDM model.
+ */
+
+#ifndef FIRMWARE_SRC_MODEL_ARENA_H_
+#define FIRMWARE_SRC_MODEL_ARENA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MODEL_ARENA_SIZE
+/**
+ * @brief The size of the arena, in bytes.
+ *
+ * This must be at least as large as the biggest model's state, which is
+ * checked at compile time with MODEL_ARENA_CHECK(). Builds that enlarge a
+ * model, e.g. with DIMMER_MODEL_SUB_DEVICES, can override this with a
+ * preprocessor definition.
+ */
+#define MODEL_ARENA_SIZE 4096u
+#endif
+
+/**
+ * @brief Check at compile time that a type fits in the arena.
+ * @param type The type of the model's state.
+ */
+#define MODEL_ARENA_CHECK(type) \
+  typedef char type ## _FitsInModelArena[ \
+      (sizeof(type) <= MODEL_ARENA_SIZE) ? 1 : -1]
+
+/**
+ * @brief Claim the arena for the model being activated.
+ * @returns A pointer to the arena, which is MODEL_ARENA_SIZE bytes and cleared
+ *   to 0. The pointer is suitably aligned for any type.
+ *
+ * Any state from the previously active model is lost.
+ */
+void *ModelArena_Claim();
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif  // FIRMWARE_SRC_MODEL_ARENA_H_
@@ -20,13 +20,14 @@
 
 #include <stdlib.h>
 
-#include "coarse_timer.h"
 #include "constants.h"
 #include "macros.h"
+#include "model_arena.h"
 #include "rdm_buffer.h"
 #include "rdm_frame.h"
 #include "rdm_responder.h"
 #include "rdm_util.h"
+#include "timer_wheel.h"
 #include "utils.h"
 
 // Various constants
@@ -55,8 +56,8 @@ typedef struct {
   uint32_t lamp_hours;
   uint32_t lamp_strikes;
   uint32_t device_power_cycles;
-  CoarseTimer_Value lamp_strike_time;
-  CoarseTimer_Value clock_timer;
+  TimerWheel_Timer lamp_strike_timer;
+  TimerWheel_Timer clock_timer;
   uint8_t lamp_state;
   uint8_t lamp_on_mode;
   uint8_t display_level;
@@ -82,20 +83,35 @@ static const char *LANGUAGES[NUMBER_OF_LANGUAGES] = {
   LANGUAGE_FRENCH,
 };
 
-static MovingLightModel g_moving_light;
+MODEL_ARENA_CHECK(MovingLightModel);
+
+/*
+ * @brief The model state, this points into the model arena.
+ */
+static MovingLightModel *g_moving_light = NULL;
+
+/*
+ * @brief The counters that are preserved when the model is deactivated.
+ */
+static struct {
+  uint32_t device_hours;
+  uint32_t lamp_hours;
+  uint32_t lamp_strikes;
+  uint32_t device_power_cycles;
+} g_counters;
 
 // Helper functions
 // ----------------------------------------------------------------------------
 static void MovingLightModel_ResetToFactoryDefaults() {
-  g_moving_light.lamp_state = LAMP_OFF;
-  g_moving_light.lamp_on_mode = LAMP_ON_MODE_ON;
-  g_moving_light.display_level = 255u;
-  g_moving_light.display_invert = false;
-  g_moving_light.power_state = POWER_STATE_NORMAL;
-  g_moving_light.pan_invert = false;
-  g_moving_light.tilt_invert = false;
-  g_moving_light.pan_tilt_swap = false;
-  g_moving_light.using_factory_defaults = true;
+  g_moving_light->lamp_state = LAMP_OFF;
+  g_moving_light->lamp_on_mode = LAMP_ON_MODE_ON;
+  g_moving_light->display_level = 255u;
+  g_moving_light->display_invert = false;
+  g_moving_light->power_state = POWER_STATE_NORMAL;
+  g_moving_light->pan_invert = false;
+  g_moving_light->tilt_invert = false;
+  g_moving_light->pan_tilt_swap = false;
+  g_moving_light->using_factory_defaults = true;
 }
 
 uint8_t DaysInMonth(uint16_t year, uint8_t month) {
@@ -132,6 +148,44 @@ uint8_t DaysInMonth(uint16_t year, uint8_t month) {
   }
 }
 
+/*
+ * @brief Called when the lamp strike completes.
+ */
+static void LampStrikeComplete() {
+  if (g_moving_light->lamp_state == LAMP_STRIKE) {
+    g_moving_light->lamp_state = LAMP_ON;
+    g_moving_light->lamp_strikes++;
+  }
+}
+
+/*
+ * @brief Advance the clock by a second.
+ */
+static void ClockTick() {
+  g_moving_light->second++;
+  if (g_moving_light->second >= 60u) {
+    g_moving_light->second = 0u;
+    g_moving_light->minute++;
+  }
+  if (g_moving_light->minute >= 60u) {
+    g_moving_light->minute = 0u;
+    g_moving_light->hour++;
+  }
+  if (g_moving_light->hour >= 24u) {
+    g_moving_light->hour = 0u;
+    g_moving_light->day++;
+  }
+  if (g_moving_light->day >
+      DaysInMonth(g_moving_light->year, g_moving_light->month)) {
+    g_moving_light->day = 1u;
+    g_moving_light->month++;
+  }
+  if (g_moving_light->month > 12u) {
+    g_moving_light->month = 1u;
+    g_moving_light->year++;
+  }
+}
+
 // PID Handlers
 // ----------------------------------------------------------------------------
 int MovingLightModel_GetLanguageCapabilities(const RDMHeader *header,
@@ -149,7 +203,7 @@ int MovingLightModel_GetLanguage(const RDMHeader *header,
                                  UNUSED const uint8_t *param_data) {
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
   ptr += RDMUtil_StringCopy((char*) ptr, RDM_LANGUAGE_STRING_SIZE,
-                            LANGUAGES[g_moving_light.language_index],
+                            LANGUAGES[g_moving_light->language_index],
                             RDM_LANGUAGE_STRING_SIZE);
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
@@ -165,7 +219,7 @@ int MovingLightModel_SetLanguage(const RDMHeader *header,
   unsigned int i = 0;
   for (; i < NUMBER_OF_LANGUAGES; i++) {
     if (memcmp(LANGUAGES[i], new_lang, RDM_LANGUAGE_STRING_SIZE) == 0) {
-      g_moving_light.language_index = i;
+      g_moving_light->language_index = i;
       matched = true;
       break;
     }
@@ -181,11 +235,11 @@ int MovingLightModel_GetBool(const RDMHeader *header,
                              UNUSED const uint8_t *param_data) {
   switch (ntohs(header->param_id)) {
     case PID_PAN_INVERT:
-      return RDMResponder_GenericGetBool(header, g_moving_light.pan_invert);
+      return RDMResponder_GenericGetBool(header, g_moving_light->pan_invert);
     case PID_TILT_INVERT:
-      return RDMResponder_GenericGetBool(header, g_moving_light.tilt_invert);
+      return RDMResponder_GenericGetBool(header, g_moving_light->tilt_invert);
     case PID_PAN_TILT_SWAP:
-      return RDMResponder_GenericGetBool(header, g_moving_light.pan_tilt_swap);
+      return RDMResponder_GenericGetBool(header, g_moving_light->pan_tilt_swap);
     default:
       return RDM_RESPONDER_NO_RESPONSE;
   }
@@ -196,13 +250,13 @@ int MovingLightModel_SetBool(const RDMHeader *header,
   bool *value = NULL;
   switch (ntohs(header->param_id)) {
     case PID_PAN_INVERT:
-      value = &g_moving_light.pan_invert;
+      value = &g_moving_light->pan_invert;
       break;
     case PID_TILT_INVERT:
-      value = &g_moving_light.tilt_invert;
+      value = &g_moving_light->tilt_invert;
       break;
     case PID_PAN_TILT_SWAP:
-      value = &g_moving_light.pan_tilt_swap;
+      value = &g_moving_light->pan_tilt_swap;
       break;
     default:
       return RDM_RESPONDER_NO_RESPONSE;
@@ -211,7 +265,7 @@ int MovingLightModel_SetBool(const RDMHeader *header,
   bool old_value = *value;
   int response_size = RDMResponder_GenericSetBool(header, param_data, value);
   if (*value != old_value) {
-    g_moving_light.using_factory_defaults = false;
+    g_moving_light->using_factory_defaults = false;
   }
   return response_size;
 }
@@ -220,16 +274,17 @@ int MovingLightModel_GetUInt8(const RDMHeader *header,
                               UNUSED const uint8_t *param_data) {
   switch (ntohs(header->param_id)) {
     case PID_LAMP_STATE:
-      return RDMResponder_GenericGetUInt8(header, g_moving_light.lamp_state);
+      return RDMResponder_GenericGetUInt8(header, g_moving_light->lamp_state);
     case PID_LAMP_ON_MODE:
-      return RDMResponder_GenericGetUInt8(header, g_moving_light.lamp_on_mode);
+      return RDMResponder_GenericGetUInt8(header, g_moving_light->lamp_on_mode);
     case PID_DISPLAY_INVERT:
       return RDMResponder_GenericGetUInt8(header,
-                                          g_moving_light.display_invert);
+                                          g_moving_light->display_invert);
     case PID_DISPLAY_LEVEL:
-      return RDMResponder_GenericGetUInt8(header, g_moving_light.display_level);
+      return RDMResponder_GenericGetUInt8(header,
+                                          g_moving_light->display_level);
     case PID_POWER_STATE:
-      return RDMResponder_GenericGetUInt8(header, g_moving_light.power_state);
+      return RDMResponder_GenericGetUInt8(header, g_moving_light->power_state);
     default:
       return RDM_RESPONDER_NO_RESPONSE;
   }
@@ -240,11 +295,11 @@ int MovingLightModel_SetUInt8(const RDMHeader *header,
   if (ntohs(header->param_id) != PID_DISPLAY_LEVEL) {
     return RDM_RESPONDER_NO_RESPONSE;
   }
-  uint8_t old_value = g_moving_light.display_level;
+  uint8_t old_value = g_moving_light->display_level;
   int response_size = RDMResponder_GenericSetUInt8(
-      header, param_data, &g_moving_light.display_level);
-  if (g_moving_light.display_level != old_value) {
-    g_moving_light.using_factory_defaults = false;
+      header, param_data, &g_moving_light->display_level);
+  if (g_moving_light->display_level != old_value) {
+    g_moving_light->using_factory_defaults = false;
   }
   return response_size;
 }
@@ -253,14 +308,16 @@ int MovingLightModel_GetUInt32(const RDMHeader *header,
                                UNUSED const uint8_t *param_data) {
   switch (ntohs(header->param_id)) {
     case PID_DEVICE_HOURS:
-      return RDMResponder_GenericGetUInt32(header, g_moving_light.device_hours);
+      return RDMResponder_GenericGetUInt32(header,
+                                           g_moving_light->device_hours);
     case PID_LAMP_HOURS:
-      return RDMResponder_GenericGetUInt32(header, g_moving_light.lamp_hours);
+      return RDMResponder_GenericGetUInt32(header, g_moving_light->lamp_hours);
     case PID_LAMP_STRIKES:
-      return RDMResponder_GenericGetUInt32(header, g_moving_light.lamp_strikes);
+      return RDMResponder_GenericGetUInt32(header,
+                                           g_moving_light->lamp_strikes);
     case PID_DEVICE_POWER_CYCLES:
       return RDMResponder_GenericGetUInt32(
-          header, g_moving_light.device_power_cycles);
+          header, g_moving_light->device_power_cycles);
     default:
       return RDM_RESPONDER_NO_RESPONSE;
   }
@@ -271,16 +328,16 @@ int MovingLightModel_SetUInt32(const RDMHeader *header,
   switch (ntohs(header->param_id)) {
     case PID_DEVICE_HOURS:
       return RDMResponder_GenericSetUInt32(header, param_data,
-                                           &g_moving_light.device_hours);
+                                           &g_moving_light->device_hours);
     case PID_LAMP_HOURS:
       return RDMResponder_GenericSetUInt32(header, param_data,
-                                           &g_moving_light.lamp_hours);
+                                           &g_moving_light->lamp_hours);
     case PID_LAMP_STRIKES:
       return RDMResponder_GenericSetUInt32(header, param_data,
-                                           &g_moving_light.lamp_strikes);
+                                           &g_moving_light->lamp_strikes);
     case PID_DEVICE_POWER_CYCLES:
-      return RDMResponder_GenericSetUInt32(header, param_data,
-                                           &g_moving_light.device_power_cycles);
+      return RDMResponder_GenericSetUInt32(
+          header, param_data, &g_moving_light->device_power_cycles);
     default:
       return RDM_RESPONDER_NO_RESPONSE;
   }
@@ -288,7 +345,7 @@ int MovingLightModel_SetUInt32(const RDMHeader *header,
 
 int MovingLightModel_GetFactoryDefaults(const RDMHeader *header,
                                         const uint8_t *param_data) {
-  bool using_defaults = (g_moving_light.using_factory_defaults &&
+  bool using_defaults = (g_moving_light->using_factory_defaults &&
                          g_responder->using_factory_defaults);
   return RDMResponder_GenericGetBool(header, using_defaults);
 }
@@ -313,15 +370,16 @@ int MovingLightModel_SetLampState(const RDMHeader *header,
   if (param_data[0] > LAMP_STRIKE) {
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
-  if (g_moving_light.lamp_state == LAMP_OFF && param_data[0] == LAMP_ON) {
-    g_moving_light.lamp_strikes++;
+  if (g_moving_light->lamp_state == LAMP_OFF && param_data[0] == LAMP_ON) {
+    g_moving_light->lamp_strikes++;
   }
-  if (g_moving_light.lamp_state != param_data[0]) {
-    g_moving_light.using_factory_defaults = false;
+  if (g_moving_light->lamp_state != param_data[0]) {
+    g_moving_light->using_factory_defaults = false;
   }
-  g_moving_light.lamp_state = param_data[0];
-  if (g_moving_light.lamp_state == LAMP_STRIKE) {
-    g_moving_light.lamp_strike_time = CoarseTimer_GetTime();
+  g_moving_light->lamp_state = param_data[0];
+  if (g_moving_light->lamp_state == LAMP_STRIKE) {
+    TimerWheel_Add(&g_moving_light->lamp_strike_timer, LAMP_STRIKE_DELAY, 0u,
+                   LampStrikeComplete);
   }
   return RDMResponder_BuildSetAck(header);
 }
@@ -335,10 +393,10 @@ int MovingLightModel_SetLampOnMode(const RDMHeader *header,
   if (param_data[0] > LAMP_ON_MODE_ON_AFTER_CAL) {
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
-  if (g_moving_light.lamp_on_mode != param_data[0]) {
-    g_moving_light.using_factory_defaults = false;
+  if (g_moving_light->lamp_on_mode != param_data[0]) {
+    g_moving_light->using_factory_defaults = false;
   }
-  g_moving_light.lamp_on_mode = param_data[0];
+  g_moving_light->lamp_on_mode = param_data[0];
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -351,10 +409,10 @@ int MovingLightModel_SetDisplayInvert(const RDMHeader *header,
   if (param_data[0] > DISPLAY_INVERT_AUTO) {
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
-  if (g_moving_light.display_invert != param_data[0]) {
-    g_moving_light.using_factory_defaults = false;
+  if (g_moving_light->display_invert != param_data[0]) {
+    g_moving_light->using_factory_defaults = false;
   }
-  g_moving_light.display_invert = param_data[0];
+  g_moving_light->display_invert = param_data[0];
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -367,22 +425,22 @@ int MovingLightModel_SetPowerState(const RDMHeader *header,
   if (param_data[0] > POWER_STATE_NORMAL) {
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
-  if (g_moving_light.power_state != param_data[0]) {
-    g_moving_light.using_factory_defaults = false;
+  if (g_moving_light->power_state != param_data[0]) {
+    g_moving_light->using_factory_defaults = false;
   }
-  g_moving_light.power_state = param_data[0];
+  g_moving_light->power_state = param_data[0];
   return RDMResponder_BuildSetAck(header);
 }
 
 int MovingLightModel_GetClock(const RDMHeader *header,
                               UNUSED const uint8_t *param_data) {
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
-  ptr = PushUInt16(ptr, g_moving_light.year);
-  *ptr++ = g_moving_light.month;
-  *ptr++ = g_moving_light.day;
-  *ptr++ = g_moving_light.hour;
-  *ptr++ = g_moving_light.minute;
-  *ptr++ = g_moving_light.second;
+  ptr = PushUInt16(ptr, g_moving_light->year);
+  *ptr++ = g_moving_light->month;
+  *ptr++ = g_moving_light->day;
+  *ptr++ = g_moving_light->hour;
+  *ptr++ = g_moving_light->minute;
+  *ptr++ = g_moving_light->second;
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
 
@@ -409,12 +467,12 @@ int MovingLightModel_SetClock(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  g_moving_light.year = year;
-  g_moving_light.month = month;
-  g_moving_light.day = day;
-  g_moving_light.hour = hour;
-  g_moving_light.minute = minute;
-  g_moving_light.second = second;
+  g_moving_light->year = year;
+  g_moving_light->month = month;
+  g_moving_light->day = day;
+  g_moving_light->hour = hour;
+  g_moving_light->minute = minute;
+  g_moving_light->second = second;
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -436,32 +494,51 @@ int MovingLightModel_ResetDevice(const RDMHeader *header,
 // Public Functions
 // ----------------------------------------------------------------------------
 void MovingLightModel_Initialize() {
-  MovingLightModel_ResetToFactoryDefaults();
-  g_moving_light.lamp_state = LAMP_OFF;
-  g_moving_light.lamp_on_mode = LAMP_ON_MODE_ON;
-  g_moving_light.display_level = 255u;
-  g_moving_light.display_invert = false;
-  g_moving_light.power_state = POWER_STATE_NORMAL;
-  g_moving_light.pan_invert = false;
-  g_moving_light.tilt_invert = false;
-  g_moving_light.pan_tilt_swap = false;
-  g_moving_light.language_index = 0;
-
-  g_moving_light.year = 2003u;
-  g_moving_light.month = 1u;
-  g_moving_light.day = 1u;
-  g_moving_light.hour = 0u;
-  g_moving_light.minute = 0u;
-  g_moving_light.second = 0u;
+  g_counters.device_hours = 0u;
+  g_counters.lamp_hours = 0u;
+  g_counters.lamp_strikes = 0u;
+  g_counters.device_power_cycles = 0u;
 }
 
 static void MovingLightModel_Activate() {
+  g_moving_light = (MovingLightModel*) ModelArena_Claim();
+  g_moving_light->device_hours = g_counters.device_hours;
+  g_moving_light->lamp_hours = g_counters.lamp_hours;
+  g_moving_light->lamp_strikes = g_counters.lamp_strikes;
+  g_moving_light->device_power_cycles = g_counters.device_power_cycles;
+
+  MovingLightModel_ResetToFactoryDefaults();
+  g_moving_light->lamp_state = LAMP_OFF;
+  g_moving_light->lamp_on_mode = LAMP_ON_MODE_ON;
+  g_moving_light->display_level = 255u;
+  g_moving_light->display_invert = false;
+  g_moving_light->power_state = POWER_STATE_NORMAL;
+  g_moving_light->pan_invert = false;
+  g_moving_light->tilt_invert = false;
+  g_moving_light->pan_tilt_swap = false;
+  g_moving_light->language_index = 0;
+
+  g_moving_light->year = 2003u;
+  g_moving_light->month = 1u;
+  g_moving_light->day = 1u;
+  g_moving_light->hour = 0u;
+  g_moving_light->minute = 0u;
+  g_moving_light->second = 0u;
+
   g_responder->def = &RESPONDER_DEFINITION;
   RDMResponder_InitResponder();
-  g_moving_light.clock_timer = CoarseTimer_GetTime();
+  TimerWheel_Add(&g_moving_light->clock_timer, ONE_SECOND, ONE_SECOND,
+                 ClockTick);
 }
 
 static void MovingLightModel_Deactivate() {
+  TimerWheel_Cancel(&g_moving_light->clock_timer);
+  TimerWheel_Cancel(&g_moving_light->lamp_strike_timer);
+
+  g_counters.device_hours = g_moving_light->device_hours;
+  g_counters.lamp_hours = g_moving_light->lamp_hours;
+  g_counters.lamp_strikes = g_moving_light->lamp_strikes;
+  g_counters.device_power_cycles = g_moving_light->device_power_cycles;
 }
 
 static int MovingLightModel_HandleRequest(const RDMHeader *header,
@@ -489,40 +566,7 @@ static int MovingLightModel_HandleRequest(const RDMHeader *header,
   return RDMResponder_DispatchPID(header, param_data);
 }
 
-static void MovingLightModel_Tasks() {
-  if (g_moving_light.lamp_state == LAMP_STRIKE &&
-      CoarseTimer_HasElapsed(g_moving_light.lamp_strike_time,
-                             LAMP_STRIKE_DELAY)) {
-    g_moving_light.lamp_state = LAMP_ON;
-    g_moving_light.lamp_strikes++;
-  }
-
-  if (CoarseTimer_HasElapsed(g_moving_light.clock_timer, ONE_SECOND)) {
-    g_moving_light.clock_timer = CoarseTimer_GetTime();
-    g_moving_light.second++;
-    if (g_moving_light.second >= 60u) {
-      g_moving_light.second = 0u;
-      g_moving_light.minute++;
-    }
-    if (g_moving_light.minute >= 60u) {
-      g_moving_light.minute = 0u;
-      g_moving_light.hour++;
-    }
-    if (g_moving_light.hour >= 24u) {
-      g_moving_light.hour = 0u;
-      g_moving_light.day++;
-    }
-    if (g_moving_light.day >
-        DaysInMonth(g_moving_light.year, g_moving_light.month)) {
-      g_moving_light.day = 1u;
-      g_moving_light.month++;
-    }
-    if (g_moving_light.month > 12u) {
-      g_moving_light.month = 1u;
-      g_moving_light.year++;
-    }
-  }
-}
+static void MovingLightModel_Tasks() {}
 
 const ModelEntry MOVING_LIGHT_MODEL_ENTRY = {
   .model_id = MOVING_LIGHT_MODEL_ID,
@@ -22,6 +22,7 @@
 
 #include "constants.h"
 #include "macros.h"
+#include "model_arena.h"
 #include "random.h"
 #include "rdm_buffer.h"
 #include "rdm_frame.h"
@@ -133,16 +134,28 @@ static const InterfaceDefinition INTERFACE_DEFINITIONS[] = {
   },
 };
 
-static InterfaceState g_interfaces[NUMBER_OF_INTERFACES];
+/*
+ * @brief The state kept in the model arena while the network model is active.
+ */
+typedef struct {
+  NetworkModel model;
+  InterfaceState interfaces[NUMBER_OF_INTERFACES];
+} NetworkModelState;
 
-static NetworkModel g_network_model;
+MODEL_ARENA_CHECK(NetworkModelState);
+
+/*
+ * @brief These point into the model arena.
+ */
+static InterfaceState *g_interfaces = NULL;
+static NetworkModel *g_network_model = NULL;
 
 // Helper functions
 // ----------------------------------------------------------------------------
 
 static int LookupIndex(unsigned int id) {
   unsigned int i = 0;
-  for (; i < g_network_model.interface_count; i++) {
+  for (; i < g_network_model->interface_count; i++) {
     if (INTERFACE_DEFINITIONS[i].id == id) {
       return i;
     }
@@ -179,7 +192,7 @@ static void UseZeroconfOrUnassign(InterfaceState *interface) {
 }
 
 static void ConfigureInterface(unsigned int index) {
-  InterfaceState *interface = &g_network_model.interfaces[index];
+  InterfaceState *interface = &g_network_model->interfaces[index];
   interface->current_dhcp_mode = interface->configured_dhcp_mode;
   interface->current_zeroconf_mode = interface->configured_zeroconf_mode;
 
@@ -206,7 +219,7 @@ int NetworkModel_GetListInterfaces(const RDMHeader *header,
                                    UNUSED const uint8_t *param_data) {
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
   unsigned int i = 0u;
-  for (; i < g_network_model.interface_count; i++) {
+  for (; i < g_network_model->interface_count; i++) {
     ptr = PushUInt32(ptr, INTERFACE_DEFINITIONS[i].id);
     ptr = PushUInt16(ptr, INTERFACE_DEFINITIONS[i].hardware_type);
   }
@@ -261,7 +274,7 @@ int NetworkModel_GetDHCPMode(const RDMHeader *header,
   memcpy(g_rdm_buffer + offset, param_data, INTERFACE_ID_SIZE);
   offset += INTERFACE_ID_SIZE;
   g_rdm_buffer[offset] =
-      g_network_model.interfaces[index].configured_dhcp_mode;
+      g_network_model->interfaces[index].configured_dhcp_mode;
   offset++;
   return RDMResponder_AddHeaderAndChecksum(header, ACK, offset);
 }
@@ -281,7 +294,7 @@ int NetworkModel_SetDHCPMode(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_ACTION_NOT_SUPPORTED);
   }
 
-  g_network_model.interfaces[index].configured_dhcp_mode =
+  g_network_model->interfaces[index].configured_dhcp_mode =
       param_data[INTERFACE_ID_SIZE];
 
   return RDMResponder_BuildSetAck(header);
@@ -298,7 +311,7 @@ int NetworkModel_GetZeroconfMode(const RDMHeader *header,
   memcpy(g_rdm_buffer + offset, param_data, INTERFACE_ID_SIZE);
   offset += INTERFACE_ID_SIZE;
   g_rdm_buffer[offset++] =
-      g_network_model.interfaces[index].configured_zeroconf_mode;
+      g_network_model->interfaces[index].configured_zeroconf_mode;
   return RDMResponder_AddHeaderAndChecksum(header, ACK, offset);
 }
 
@@ -317,7 +330,7 @@ int NetworkModel_SetZeroconfMode(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_ACTION_NOT_SUPPORTED);
   }
 
-  g_network_model.interfaces[index].configured_zeroconf_mode =
+  g_network_model->interfaces[index].configured_zeroconf_mode =
       param_data[INTERFACE_ID_SIZE];
 
   return RDMResponder_BuildSetAck(header);
@@ -330,7 +343,7 @@ int NetworkModel_GetCurrentAddress(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  InterfaceState *interface = &g_network_model.interfaces[index];
+  InterfaceState *interface = &g_network_model->interfaces[index];
 
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
   memcpy(ptr, param_data, INTERFACE_ID_SIZE);
@@ -354,7 +367,7 @@ int NetworkModel_GetStaticAddress(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  InterfaceState *interface = &g_network_model.interfaces[index];
+  InterfaceState *interface = &g_network_model->interfaces[index];
 
 
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
@@ -384,8 +397,8 @@ int NetworkModel_SetStaticAddress(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  g_network_model.interfaces[index].configured_ip = ip;
-  g_network_model.interfaces[index].configured_netmask = netmask;
+  g_network_model->interfaces[index].configured_ip = ip;
+  g_network_model->interfaces[index].configured_netmask = netmask;
 
   return RDMResponder_BuildSetAck(header);
 }
@@ -401,7 +414,7 @@ int NetworkModel_RenewDHCP(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  InterfaceState *interface = &g_network_model.interfaces[index];
+  InterfaceState *interface = &g_network_model->interfaces[index];
   if (interface->config_source == CONFIG_SOURCE_STATIC ||
       interface->current_dhcp_mode == false) {
     return RDMResponder_BuildNack(header, NR_ACTION_NOT_SUPPORTED);
@@ -437,7 +450,7 @@ int NetworkModel_ReleaseDHCP(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  InterfaceState *interface = &g_network_model.interfaces[index];
+  InterfaceState *interface = &g_network_model->interfaces[index];
   if (interface->config_source != CONFIG_SOURCE_DHCP) {
     return RDMResponder_BuildNack(header, NR_ACTION_NOT_SUPPORTED);
   }
@@ -464,8 +477,8 @@ int NetworkModel_ApplyInterfaceConfiguration(const RDMHeader *header,
 int NetworkModel_GetDefaultRoute(const RDMHeader *header,
                                  UNUSED const uint8_t *param_data) {
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
-  ptr = PushUInt32(ptr, g_network_model.default_interface_route);
-  ptr = PushUInt32(ptr, g_network_model.default_route);
+  ptr = PushUInt32(ptr, g_network_model->default_interface_route);
+  ptr = PushUInt32(ptr, g_network_model->default_route);
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
 
@@ -487,8 +500,8 @@ int NetworkModel_SetDefaultRoute(const RDMHeader *header,
     // Only the ptp IPsec interface can be used as the default route
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
-  g_network_model.default_interface_route = interface_id;
-  g_network_model.default_route = ip;
+  g_network_model->default_interface_route = interface_id;
+  g_network_model->default_route = ip;
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -501,7 +514,7 @@ int NetworkModel_GetNameServer(const RDMHeader *header,
 
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
   *ptr++ = index;
-  ptr = PushUInt32(ptr, g_network_model.nameservers[index]);
+  ptr = PushUInt32(ptr, g_network_model->nameservers[index]);
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
 
@@ -516,13 +529,13 @@ int NetworkModel_SetNameServer(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  g_network_model.nameservers[index] = ExtractUInt32(&param_data[1]);
+  g_network_model->nameservers[index] = ExtractUInt32(&param_data[1]);
   return RDMResponder_BuildSetAck(header);
 }
 
 int NetworkModel_GetHostname(const RDMHeader *header,
                              UNUSED const uint8_t *param_data) {
-  return RDMResponder_GenericReturnString(header, g_network_model.hostname,
+  return RDMResponder_GenericReturnString(header, g_network_model->hostname,
                                           DNS_HOST_NAME_SIZE);
 }
 
@@ -533,7 +546,7 @@ int NetworkModel_SetHostname(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  RDMUtil_StringCopy(g_network_model.hostname, DNS_HOST_NAME_SIZE,
+  RDMUtil_StringCopy(g_network_model->hostname, DNS_HOST_NAME_SIZE,
                      (const char*) param_data,
                      header->param_data_length);
   return RDMResponder_BuildSetAck(header);
@@ -541,7 +554,7 @@ int NetworkModel_SetHostname(const RDMHeader *header,
 
 int NetworkModel_GetDomainName(const RDMHeader *header,
                                UNUSED const uint8_t *param_data) {
-  return RDMResponder_GenericReturnString(header, g_network_model.domain_name,
+  return RDMResponder_GenericReturnString(header, g_network_model->domain_name,
                                           DNS_DOMAIN_NAME_SIZE);
 }
 
@@ -551,7 +564,7 @@ int NetworkModel_SetDomainName(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  RDMUtil_StringCopy(g_network_model.domain_name, DNS_DOMAIN_NAME_SIZE,
+  RDMUtil_StringCopy(g_network_model->domain_name, DNS_DOMAIN_NAME_SIZE,
                      (const char*) param_data,
                      header->param_data_length);
   return RDMResponder_BuildSetAck(header);
@@ -559,7 +572,13 @@ int NetworkModel_SetDomainName(const RDMHeader *header,
 
 // Public Functions
 // ----------------------------------------------------------------------------
-void NetworkModel_Initialize() {
+void NetworkModel_Initialize() {}
+
+static void NetworkModel_Activate() {
+  NetworkModelState *state = (NetworkModelState*) ModelArena_Claim();
+  g_network_model = &state->model;
+  g_interfaces = state->interfaces;
+
   // Initialize the InterfaceState array to something interesting.
 
   // eth0 is 192.168.0.1/24
@@ -580,26 +599,24 @@ void NetworkModel_Initialize() {
   g_interfaces[2].configured_ip = IPV4_UNCONFIGURED;
   g_interfaces[2].configured_netmask = 0u;
 
-  g_network_model.interface_count = NUMBER_OF_INTERFACES;
-  g_network_model.interfaces = g_interfaces;
+  g_network_model->interface_count = NUMBER_OF_INTERFACES;
+  g_network_model->interfaces = g_interfaces;
 
   unsigned int i = 0u;
-  for (; i < g_network_model.interface_count; i++) {
+  for (; i < g_network_model->interface_count; i++) {
     ConfigureInterface(i);
   }
 
-  g_network_model.default_interface_route = NO_DEFAULT_ROUTE;
-  g_network_model.default_route = NO_DEFAULT_ROUTE;
+  g_network_model->default_interface_route = NO_DEFAULT_ROUTE;
+  g_network_model->default_route = NO_DEFAULT_ROUTE;
   for (i = 0u; i < NUMBER_OF_NAMESERVERS; i++) {
-    g_network_model.nameservers[i] = IPV4_UNCONFIGURED;
+    g_network_model->nameservers[i] = IPV4_UNCONFIGURED;
   }
-  RDMUtil_StringCopy(g_network_model.hostname, DNS_HOST_NAME_SIZE,
+  RDMUtil_StringCopy(g_network_model->hostname, DNS_HOST_NAME_SIZE,
                     DEFAULT_HOSTNAME, DNS_HOST_NAME_SIZE);
-  RDMUtil_StringCopy(g_network_model.domain_name, DNS_DOMAIN_NAME_SIZE,
+  RDMUtil_StringCopy(g_network_model->domain_name, DNS_DOMAIN_NAME_SIZE,
                      DEFAULT_DOMAINNAME, DNS_DOMAIN_NAME_SIZE);
-}
 
-static void NetworkModel_Activate() {
   g_responder->def = &RESPONDER_DEFINITION;
   RDMResponder_InitResponder();
 }
@@ -0,0 +1,195 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * pixel_encoder.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "pixel_encoder.h"
+
+#include <string.h>
+
+enum { SLOTS_PER_PIXEL = PIXEL_MAPPER_SLOTS_PER_PIXEL };
+
+/*
+ * @brief The SPI clock for the WS2812, each SPI bit is 417ns.
+ */
+enum { WS2812_BAUD_RATE = 2400000u };
+
+/*
+ * @brief The WS2812 SPI bits for each nibble.
+ *
+ * A 1 bit is sent as 110 and a 0 bit as 100, so each nibble becomes 12 SPI
+ * bits.
+ */
+static const uint16_t WS2812_NIBBLES[16] = {
+  0x924, 0x926, 0x934, 0x936, 0x9a4, 0x9a6, 0x9b4, 0x9b6,
+  0xd24, 0xd26, 0xd34, 0xd36, 0xda4, 0xda6, 0xdb4, 0xdb6
+};
+
+static void EncodeLPD8806(uint8_t *output, const uint8_t *data,
+                          uint16_t pixel_count) {
+  const uint8_t *end = data + SLOTS_PER_PIXEL * pixel_count;
+  while (data != end) {
+    *output++ = 0x80u | *data++ >> 1;
+  }
+}
+
+static void EncodeWS2801(uint8_t *output, const uint8_t *data,
+                         uint16_t pixel_count) {
+  memcpy(output, data, SLOTS_PER_PIXEL * pixel_count);
+}
+
+static void EncodeP9813(uint8_t *output, const uint8_t *data,
+                        uint16_t pixel_count) {
+  const uint8_t *end = data + SLOTS_PER_PIXEL * pixel_count;
+  while (data != end) {
+    // The flag byte is 11, followed by the inverse of the 2 MSBs of B, G & R.
+    *output++ = 0xffu ^ ((data[0] >> 6) << 4 | (data[1] >> 6) << 2 |
+                         data[2] >> 6);
+    *output++ = *data++;
+    *output++ = *data++;
+    *output++ = *data++;
+  }
+}
+
+static void EncodeAPA102(uint8_t *output, const uint8_t *data,
+                         uint16_t pixel_count) {
+  const uint8_t *end = data + SLOTS_PER_PIXEL * pixel_count;
+  while (data != end) {
+    // 111 followed by the maximum global brightness.
+    *output++ = 0xffu;
+    *output++ = *data++;
+    *output++ = *data++;
+    *output++ = *data++;
+  }
+}
+
+static void EncodeWS2812(uint8_t *output, const uint8_t *data,
+                         uint16_t pixel_count) {
+  const uint8_t *end = data + SLOTS_PER_PIXEL * pixel_count;
+  while (data != end) {
+    const uint8_t value = *data++;
+    const uint32_t bits = (uint32_t) WS2812_NIBBLES[value >> 4] << 12 |
+                          WS2812_NIBBLES[value & 0x0fu];
+    *output++ = bits >> 16;
+    *output++ = bits >> 8;
+    *output++ = bits;
+  }
+}
+
+static const PixelEncoder LPD8806_ENCODER = {
+  .order = PIXEL_ORDER_GRB,
+  .header_size = 0u,
+  .pixel_size = 3u,
+  .trailer_size = 0u,
+  .trailer_pixels_per_byte = 32u,
+  .baud_rate = 0u,
+  .clock_polarity = SPI_CLOCK_POLARITY_IDLE_HIGH,
+  .latch_time = 0u,
+  .encode = EncodeLPD8806
+};
+
+static const PixelEncoder WS2801_ENCODER = {
+  .order = PIXEL_ORDER_RGB,
+  .header_size = 0u,
+  .pixel_size = 3u,
+  .trailer_size = 0u,
+  .trailer_pixels_per_byte = 0u,
+  .baud_rate = 0u,
+  .clock_polarity = SPI_CLOCK_POLARITY_IDLE_LOW,
+  .latch_time = 500u,  // Latched by holding the clock low for 500us.
+  .encode = EncodeWS2801
+};
+
+static const PixelEncoder P9813_ENCODER = {
+  .order = PIXEL_ORDER_BGR,
+  .header_size = 4u,
+  .pixel_size = 4u,
+  .trailer_size = 4u,
+  .trailer_pixels_per_byte = 0u,
+  .baud_rate = 0u,
+  .clock_polarity = SPI_CLOCK_POLARITY_IDLE_HIGH,
+  .latch_time = 0u,
+  .encode = EncodeP9813
+};
+
+static const PixelEncoder APA102_ENCODER = {
+  .order = PIXEL_ORDER_BGR,
+  .header_size = 4u,
+  .pixel_size = 4u,
+  .trailer_size = 0u,
+  .trailer_pixels_per_byte = 16u,  // Half a clock per pixel.
+  .baud_rate = 0u,
+  .clock_polarity = SPI_CLOCK_POLARITY_IDLE_HIGH,
+  .latch_time = 0u,
+  .encode = EncodeAPA102
+};
+
+static const PixelEncoder WS2812_ENCODER = {
+  .order = PIXEL_ORDER_GRB,
+  .header_size = 0u,
+  .pixel_size = 9u,
+  .trailer_size = 24u,  // An 80us reset.
+  .trailer_pixels_per_byte = 0u,
+  .baud_rate = WS2812_BAUD_RATE,
+  .clock_polarity = SPI_CLOCK_POLARITY_IDLE_HIGH,
+  .latch_time = 0u,
+  .encode = EncodeWS2812
+};
+
+const PixelEncoder *PixelEncoder_Get(PixelType type) {
+  switch (type) {
+    case PIXEL_TYPE_LPD8806:
+      return &LPD8806_ENCODER;
+    case PIXEL_TYPE_WS2801:
+      return &WS2801_ENCODER;
+    case PIXEL_TYPE_P9813:
+      return &P9813_ENCODER;
+    case PIXEL_TYPE_APA102:
+      return &APA102_ENCODER;
+    case PIXEL_TYPE_WS2812:
+      return &WS2812_ENCODER;
+  }
+  return NULL;
+}
+
+static inline unsigned int TrailerSize(const PixelEncoder *encoder,
+                                       uint16_t pixel_count) {
+  unsigned int size = encoder->trailer_size;
+  if (encoder->trailer_pixels_per_byte) {
+    size += (pixel_count + encoder->trailer_pixels_per_byte - 1u) /
+            encoder->trailer_pixels_per_byte;
+  }
+  return size;
+}
+
+unsigned int PixelEncoder_FrameSize(const PixelEncoder *encoder,
+                                    uint16_t pixel_count) {
+  return encoder->header_size + encoder->pixel_size * pixel_count +
+         TrailerSize(encoder, pixel_count);
+}
+
+unsigned int PixelEncoder_Encode(const PixelEncoder *encoder, uint8_t *output,
+                                 const uint8_t *data, uint16_t pixel_count) {
+  uint8_t *ptr = output;
+  memset(ptr, 0, encoder->header_size);
+  ptr += encoder->header_size;
+  encoder->encode(ptr, data, pixel_count);
+  ptr += encoder->pixel_size * pixel_count;
+  const unsigned int trailer_size = TrailerSize(encoder, pixel_count);
+  memset(ptr, 0, trailer_size);
+  return ptr + trailer_size - output;
+}
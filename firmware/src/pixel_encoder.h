@@ -0,0 +1,181 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * pixel_encoder.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup pixel_encoder Pixel Encoder
+ * @brief Encode pixel data for the SPI pixel protocols.
+ *
+ * Each pixel type has an encoder, which converts 8-bit color values into the
+ * bytes sent on the SPI bus. A frame is made up of:
+ *  - a header of zero bytes,
+ *  - the encoded pixels, each of which are a fixed size,
+ *  - a latch, or trailer of zero bytes, which may depend on the number of
+ *    pixels.
+ *
+ * The supported types are:
+ *  - LPD8806, 7-bit GRB values with the MSB set.
+ *  - WS2801, 8-bit RGB values. The clock idles low, and the pixels latch
+ *    once it's been low for 500us.
+ *  - P9813, a flag byte followed by 8-bit BGR values.
+ *  - APA102, a global brightness byte followed by 8-bit BGR values.
+ *  - WS2812, GRB values where each bit is expanded to 3 SPI bits. This
+ *    requires a 2.4MHz SPI clock, and the data must be sent without gaps
+ *    between the bytes, i.e. using DMA or enhanced buffering.
+ *
+ * @addtogroup pixel_encoder
+ * @{
+ * @file pixel_encoder.h
+ * @brief Encode pixel data for the SPI pixel protocols.
+ */
+
+#ifndef FIRMWARE_SRC_PIXEL_ENCODER_H_
+#define FIRMWARE_SRC_PIXEL_ENCODER_H_
+
+#include <stdint.h>
+
+#include "peripheral/spi/plib_spi.h"
+#include "pixel_mapper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The types of pixels.
+ *
+ * These are the values used by PID_PIXEL_TYPE.
+ */
+typedef enum {
+  PIXEL_TYPE_LPD8806 = 0x0001,  //!< LPD8806
+  PIXEL_TYPE_WS2801 = 0x0002,  //!< WS2801
+  PIXEL_TYPE_P9813 = 0x0003,  //!< P9813
+  PIXEL_TYPE_APA102 = 0x0004,  //!< APA102
+  PIXEL_TYPE_WS2812 = 0x0005,  //!< WS2812, using 3 SPI bits per bit.
+} PixelType;
+
+/**
+ * @brief The maximum size of an encoded frame.
+ * @param pixel_count The number of pixels.
+ *
+ * The WS2812 encoding is the largest, at 9 bytes per pixel and a 24 byte
+ * reset.
+ */
+#define PIXEL_ENCODER_MAX_FRAME_SIZE(pixel_count) (9u * (pixel_count) + 24u)
+
+/**
+ * @brief Encode pixels.
+ * @param output The memory to write the encoded pixels to.
+ * @param data The color values, 3 bytes per pixel in the order given by the
+ *   encoder.
+ * @param pixel_count The number of pixels to encode.
+ */
+typedef void (*PixelEncodeFunction)(uint8_t *output, const uint8_t *data,
+                                    uint16_t pixel_count);
+
+/**
+ * @brief An encoder for a type of pixel.
+ */
+typedef struct {
+  /**
+   * @brief The order the pixels expect the color values in.
+   */
+  PixelOrder order;
+
+  /**
+   * @brief The number of zero bytes sent before the first pixel.
+   */
+  uint8_t header_size;
+
+  /**
+   * @brief The number of bytes used to encode each pixel.
+   */
+  uint8_t pixel_size;
+
+  /**
+   * @brief The number of zero bytes sent after the last pixel.
+   */
+  uint8_t trailer_size;
+
+  /**
+   * @brief An additional zero byte is sent after the last pixel for each
+   *   group of this many pixels, 0 disables this.
+   */
+  uint8_t trailer_pixels_per_byte;
+
+  /**
+   * @brief The SPI baud rate the pixels require, or 0 to use the configured
+   *   rate.
+   */
+  uint32_t baud_rate;
+
+  /**
+   * @brief The level of the SPI clock between bytes & frames.
+   */
+  SPI_CLOCK_POLARITY clock_polarity;
+
+  /**
+   * @brief The minimum time the SPI module must be idle between frames, in
+   *   microseconds, or 0 if the trailer latches the frame.
+   */
+  uint16_t latch_time;
+
+  /**
+   * @brief The function used to encode the pixels.
+   */
+  PixelEncodeFunction encode;
+} PixelEncoder;
+
+/**
+ * @brief Get the encoder for a type of pixel.
+ * @param type The type of pixel.
+ * @returns The encoder, or NULL if the type isn't supported.
+ */
+const PixelEncoder *PixelEncoder_Get(PixelType type);
+
+/**
+ * @brief Get the size of an encoded frame.
+ * @param encoder The encoder to use.
+ * @param pixel_count The number of pixels in the frame.
+ * @returns The size of the frame, including the header & trailer.
+ */
+unsigned int PixelEncoder_FrameSize(const PixelEncoder *encoder,
+                                    uint16_t pixel_count);
+
+/**
+ * @brief Encode a frame of pixels.
+ * @param encoder The encoder to use.
+ * @param output The memory to write the frame to, this must be at least
+ *   PixelEncoder_FrameSize() bytes.
+ * @param data The color values, 3 bytes per pixel in the order given by the
+ *   encoder.
+ * @param pixel_count The number of pixels.
+ * @returns The size of the frame, including the header & trailer.
+ */
+unsigned int PixelEncoder_Encode(const PixelEncoder *encoder, uint8_t *output,
+                                 const uint8_t *data, uint16_t pixel_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif  // FIRMWARE_SRC_PIXEL_ENCODER_H_
@@ -0,0 +1,119 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * pixel_mapper.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "pixel_mapper.h"
+
+#include "dmx_spec.h"
+
+enum { DEFAULT_PIXEL_COUNT = 2u };
+
+/*
+ * @brief The slot offset of each color, for each PixelOrder.
+ */
+static const uint8_t COLOR_OFFSETS[][PIXEL_MAPPER_SLOTS_PER_PIXEL] = {
+  {0u, 1u, 2u},  // RGB
+  {1u, 0u, 2u},  // GRB
+  {2u, 1u, 0u},  // BGR
+};
+
+typedef struct {
+  uint16_t start_address;
+  uint16_t footprint;
+  uint16_t pixel_count;
+  /**
+   * @brief The slot offset for each byte of pixel data.
+   */
+  uint16_t table[PIXEL_MAPPER_MAX_PIXELS * PIXEL_MAPPER_SLOTS_PER_PIXEL];
+} PixelMapper;
+
+static PixelMapper g_mapper;
+
+void PixelMapper_Initialize() {
+  PixelMapperSettings settings = {
+    .start_address = 1u,
+    .pixel_count = DEFAULT_PIXEL_COUNT,
+    .group_size = 1u,
+    .order = PIXEL_ORDER_GRB,
+    .reverse = false
+  };
+  PixelMapper_Configure(&settings);
+}
+
+void PixelMapper_Configure(const PixelMapperSettings *settings) {
+  g_mapper.start_address = settings->start_address;
+  if (g_mapper.start_address == 0u ||
+      g_mapper.start_address > DMX_FRAME_SIZE) {
+    g_mapper.start_address = 1u;
+  }
+
+  g_mapper.pixel_count = settings->pixel_count;
+  if (g_mapper.pixel_count > PIXEL_MAPPER_MAX_PIXELS) {
+    g_mapper.pixel_count = PIXEL_MAPPER_MAX_PIXELS;
+  }
+  const uint16_t group_size = settings->group_size ? settings->group_size : 1u;
+  const uint8_t *offsets = COLOR_OFFSETS[
+      settings->order <= PIXEL_ORDER_BGR ? settings->order : PIXEL_ORDER_RGB];
+
+  uint16_t *entry = g_mapper.table;
+  unsigned int i = 0u;
+  for (; i < g_mapper.pixel_count; i++) {
+    const unsigned int pixel = settings->reverse ?
+        g_mapper.pixel_count - 1u - i : i;
+    const uint16_t slot = (pixel / group_size) * PIXEL_MAPPER_SLOTS_PER_PIXEL;
+    *entry++ = slot + offsets[0];
+    *entry++ = slot + offsets[1];
+    *entry++ = slot + offsets[2];
+  }
+
+  const unsigned int groups = (g_mapper.pixel_count + group_size - 1u) /
+                              group_size;
+  g_mapper.footprint = groups * PIXEL_MAPPER_SLOTS_PER_PIXEL;
+}
+
+uint16_t PixelMapper_StartAddress() {
+  return g_mapper.start_address;
+}
+
+uint16_t PixelMapper_Footprint() {
+  return g_mapper.footprint;
+}
+
+uint16_t PixelMapper_PixelCount() {
+  return g_mapper.pixel_count;
+}
+
+unsigned int PixelMapper_Map(uint8_t *output, const uint8_t *slots,
+                             unsigned int slot_count) {
+  const uint16_t *entry = g_mapper.table;
+  const uint16_t *end = entry +
+      g_mapper.pixel_count * PIXEL_MAPPER_SLOTS_PER_PIXEL;
+
+  if (slot_count >= g_mapper.footprint) {
+    // The common case, a full frame. No bounds checks are required.
+    while (entry != end) {
+      *output++ = slots[*entry++];
+    }
+  } else {
+    while (entry != end) {
+      *output++ = *entry < slot_count ? slots[*entry] : 0u;
+      entry++;
+    }
+  }
+  return g_mapper.pixel_count * PIXEL_MAPPER_SLOTS_PER_PIXEL;
+}
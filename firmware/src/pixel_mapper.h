@@ -0,0 +1,159 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * pixel_mapper.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup pixel_mapper Pixel Mapper
+ * @brief Map DMX512 slots to RGB pixels.
+ *
+ * The mapper converts the slots of a DMX512 frame into pixel data, in the
+ * order the pixels expect it on the wire. It supports:
+ *  - a DMX start address,
+ *  - RGB, GRB & BGR color orders,
+ *  - grouping, where a number of adjacent pixels share the same 3 slots,
+ *  - reversal, where the first slots control the last pixel in the strip.
+ *
+ * The mapping is precomputed into a table when the settings change, each
+ * output byte has an entry holding the offset of the slot it comes from.
+ * Mapping a frame is then a single pass over the table.
+ *
+ * @addtogroup pixel_mapper
+ * @{
+ * @file pixel_mapper.h
+ * @brief Map DMX512 slots to RGB pixels.
+ */
+
+#ifndef FIRMWARE_SRC_PIXEL_MAPPER_H_
+#define FIRMWARE_SRC_PIXEL_MAPPER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The maximum number of pixels.
+ *
+ * 170 pixels use 510 of the 512 slots in a universe.
+ */
+enum { PIXEL_MAPPER_MAX_PIXELS = 170u };
+
+/**
+ * @brief The number of slots used to control each pixel.
+ */
+enum { PIXEL_MAPPER_SLOTS_PER_PIXEL = 3u };
+
+/**
+ * @brief The order the pixels expect the color values in.
+ *
+ * The slots are always in RGB order.
+ */
+typedef enum {
+  PIXEL_ORDER_RGB = 0,  //!< Red, Green, Blue
+  PIXEL_ORDER_GRB = 1,  //!< Green, Red, Blue
+  PIXEL_ORDER_BGR = 2,  //!< Blue, Green, Red
+} PixelOrder;
+
+/**
+ * @brief The settings for the pixel mapper.
+ */
+typedef struct {
+  /**
+   * @brief The DMX start address, 1 - 512.
+   */
+  uint16_t start_address;
+
+  /**
+   * @brief The number of pixels, 0 - PIXEL_MAPPER_MAX_PIXELS.
+   */
+  uint16_t pixel_count;
+
+  /**
+   * @brief The number of adjacent pixels controlled by each group of 3 slots.
+   *
+   * Values less than 1 are treated as 1.
+   */
+  uint16_t group_size;
+
+  /**
+   * @brief The color order of the pixels.
+   */
+  PixelOrder order;
+
+  /**
+   * @brief True if the first slots control the last pixel.
+   */
+  bool reverse;
+} PixelMapperSettings;
+
+/**
+ * @brief Initialize the pixel mapper.
+ *
+ * This resets the mapper to 2 GRB pixels, starting at slot 1.
+ */
+void PixelMapper_Initialize();
+
+/**
+ * @brief Change the pixel mapping.
+ * @param settings The new settings. Out of range values are clamped.
+ *
+ * This rebuilds the mapping table, it shouldn't be called for every frame.
+ */
+void PixelMapper_Configure(const PixelMapperSettings *settings);
+
+/**
+ * @brief Get the DMX start address.
+ * @returns The start address, 1 - 512.
+ */
+uint16_t PixelMapper_StartAddress();
+
+/**
+ * @brief Get the number of slots used by the mapping.
+ * @returns The DMX footprint.
+ */
+uint16_t PixelMapper_Footprint();
+
+/**
+ * @brief Get the number of pixels.
+ * @returns The number of pixels.
+ */
+uint16_t PixelMapper_PixelCount();
+
+/**
+ * @brief Map slot data to pixel data.
+ * @param output The memory to write the pixel data to, this must be at least
+ *   PixelMapper_PixelCount() * PIXEL_MAPPER_SLOTS_PER_PIXEL bytes.
+ * @param slots The slot data, starting from the DMX start address.
+ * @param slot_count The number of slots available. Pixels controlled by
+ *   slots beyond this are set to 0.
+ * @returns The number of bytes written to output.
+ */
+unsigned int PixelMapper_Map(uint8_t *output, const uint8_t *slots,
+                             unsigned int slot_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif  // FIRMWARE_SRC_PIXEL_MAPPER_H_
@@ -21,7 +21,9 @@
 #include <stdlib.h>
 
 #include "constants.h"
+#include "events.h"
 #include "macros.h"
+#include "model_arena.h"
 #include "rdm_frame.h"
 #include "rdm_buffer.h"
 #include "rdm_responder.h"
@@ -76,7 +78,19 @@ typedef struct {
   unsigned int free_size_count;  // Number of items on the free list.
 } ChildDevice;
 
-static ChildDevice g_children[NUMBER_OF_CHILDREN];
+/*
+ * @brief The state kept in the model arena while the proxy is active.
+ */
+typedef struct {
+  ChildDevice children[NUMBER_OF_CHILDREN];
+} ProxyModelState;
+
+MODEL_ARENA_CHECK(ProxyModelState);
+
+/*
+ * @brief The child devices, these point into the model arena.
+ */
+static ChildDevice *g_children = NULL;
 
 static const ResponderDefinition ROOT_RESPONDER_DEFINITION;
 static const ResponderDefinition CHILD_DEVICE_RESPONDER_DEFINITION;
@@ -249,7 +263,12 @@ int ProxyModelChild_GetQueuedMessage(const RDMHeader *header,
 
 // Public Functions
 // ----------------------------------------------------------------------------
-void ProxyModel_Initialize() {
+void ProxyModel_Initialize() {}
+
+static void ProxyModel_Activate() {
+  ProxyModelState *state = (ProxyModelState*) ModelArena_Claim();
+  g_children = state->children;
+
   uint8_t parent_uid[UID_LENGTH];
   RDMResponder_GetUID(parent_uid);
 
@@ -267,16 +286,17 @@ void ProxyModel_Initialize() {
   }
 
   RDMResponder_RestoreResponder();
-}
 
-static void ProxyModel_Activate() {
   g_responder->def = &ROOT_RESPONDER_DEFINITION;
   RDMResponder_InitResponder();
   g_responder->is_managed_proxy = true;
   ResetProxyBuffers();
+  Events_Push(EVENT_TOD_CHANGED, 0u, NUMBER_OF_CHILDREN);
 }
 
-static void ProxyModel_Deactivate() {}
+static void ProxyModel_Deactivate() {
+  Events_Push(EVENT_TOD_CHANGED, 0u, 0u);
+}
 
 static int ProxyModel_HandleRequest(const RDMHeader *header,
                                     const uint8_t *param_data) {
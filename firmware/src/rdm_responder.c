@@ -20,12 +20,12 @@
 
 #include <string.h>
 
-#include "coarse_timer.h"
 #include "constants.h"
 #include "macros.h"
 #include "rdm_buffer.h"
 #include "rdm_util.h"
 #include "receiver_counters.h"
+#include "timer_wheel.h"
 #include "utils.h"
 
 const char MANUFACTURER_LABEL[] = "Open Lighting Project";
@@ -65,12 +65,12 @@ RDMResponder *g_responder = &root_responder;
  */
 typedef struct {
   // Mute params
-  CoarseTimer_Value mute_timer;
+  TimerWheel_Timer mute_timer;
   PORTS_CHANNEL mute_port;
   PORTS_BIT_POS mute_bit;
 
   // Identify params
-  CoarseTimer_Value identify_timer;
+  TimerWheel_Timer identify_timer;
   PORTS_CHANNEL identify_port;
   PORTS_BIT_POS identify_bit;
 } InternalResponderState;
@@ -146,14 +146,32 @@ static inline uint16_t GetControlField() {
          (g_responder->is_proxied_device ? MUTE_PROXY_FLAG : 0);
 }
 
+/*
+ * @brief Flash the identify LED while identify is on.
+ */
+static void FlashIdentify() {
+  if (g_responder->identify_on) {
+    PLIB_PORTS_PinToggle(PORTS_ID_0, g_internal_state.identify_port,
+                         g_internal_state.identify_bit);
+  }
+}
+
+/*
+ * @brief Flash the mute LED while the responder is unmuted.
+ */
+static void FlashMute() {
+  if (!g_responder->is_muted) {
+    PLIB_PORTS_PinToggle(PORTS_ID_0, g_internal_state.mute_port,
+                         g_internal_state.mute_bit);
+  }
+}
+
 // Public Functions
 // ----------------------------------------------------------------------------
 void RDMResponder_Initialize(const RDMResponderSettings *settings) {
-  g_internal_state.mute_timer = CoarseTimer_GetTime();
   g_internal_state.mute_port = settings->mute_port;
   g_internal_state.mute_bit = settings->mute_bit;
 
-  g_internal_state.identify_timer = 0u;
   g_internal_state.identify_port = settings->identify_port;
   g_internal_state.identify_bit = settings->identify_bit;
 
@@ -168,29 +186,16 @@ void RDMResponder_Initialize(const RDMResponderSettings *settings) {
   PLIB_PORTS_PinSet(PORTS_ID_0, g_internal_state.mute_port,
                     g_internal_state.mute_bit);
 
+  TimerWheel_Add(&g_internal_state.identify_timer, FLASH_FAST, FLASH_FAST,
+                 FlashIdentify);
+  TimerWheel_Add(&g_internal_state.mute_timer, FLASH_SLOW, FLASH_SLOW,
+                 FlashMute);
+
   memcpy(g_responder->uid, settings->uid, UID_LENGTH);
   g_responder->def = NULL;
   RDMResponder_InitResponder();
 }
 
-void RDMResponder_Tasks() {
-  if (g_responder->identify_on) {
-    if (CoarseTimer_HasElapsed(g_internal_state.identify_timer, FLASH_FAST)) {
-      g_internal_state.identify_timer = CoarseTimer_GetTime();
-      PLIB_PORTS_PinToggle(PORTS_ID_0, g_internal_state.identify_port,
-                           g_internal_state.identify_bit);
-    }
-  }
-
-  if (!g_responder->is_muted) {
-    if (CoarseTimer_HasElapsed(g_internal_state.mute_timer, FLASH_SLOW)) {
-      g_internal_state.mute_timer = CoarseTimer_GetTime();
-      PLIB_PORTS_PinToggle(PORTS_ID_0, g_internal_state.mute_port,
-                           g_internal_state.mute_bit);
-    }
-  }
-}
-
 void RDMResponder_SwitchResponder(RDMResponder *responder) {
   g_responder = responder;
 }
@@ -529,7 +534,8 @@ int RDMResponder_SetUnMute(const RDMHeader *header) {
   g_responder->is_muted = false;
   PLIB_PORTS_PinSet(PORTS_ID_0, g_internal_state.mute_port,
                     g_internal_state.mute_bit);
-  g_internal_state.mute_timer = CoarseTimer_GetTime();
+  TimerWheel_Add(&g_internal_state.mute_timer, FLASH_SLOW, FLASH_SLOW,
+                 FlashMute);
 
   ReturnUnlessUnicast(header);
 
@@ -932,7 +938,8 @@ int RDMResponder_SetIdentifyDevice(const RDMHeader *header,
   }
   g_responder->using_factory_defaults = false;
   if (g_responder->identify_on) {
-    g_internal_state.identify_timer = CoarseTimer_GetTime();
+    TimerWheel_Add(&g_internal_state.identify_timer, FLASH_FAST, FLASH_FAST,
+                   FlashIdentify);
     PLIB_PORTS_PinSet(PORTS_ID_0, g_internal_state.identify_port,
                       g_internal_state.identify_bit);
   } else {
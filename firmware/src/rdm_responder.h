@@ -340,13 +340,6 @@ typedef struct {
  */
 void RDMResponder_Initialize(const RDMResponderSettings *settings);
 
-/**
- * @brief Perform the periodic tasks.
- *
- * This should be called in the main event loop.
- */
-void RDMResponder_Tasks();
-
 /**
  * @brief Switch the current responder.
  * @param responder The new responder to use.
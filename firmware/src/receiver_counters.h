@@ -52,6 +52,18 @@ typedef struct {
 
 // @endcond
 
+/**
+ * @brief The receiver error counters, used in EVENT_RECEIVER_COUNTER events.
+ */
+typedef enum {
+  RECEIVER_COUNTER_RDM_SHORT_FRAME = 0,
+  RECEIVER_COUNTER_RDM_LENGTH_MISMATCH = 1,
+  RECEIVER_COUNTER_RDM_SUB_START_CODE_INVALID = 2,
+  RECEIVER_COUNTER_RDM_MSG_LEN_INVALID = 3,
+  RECEIVER_COUNTER_RDM_PARAM_DATA_LEN_INVALID = 4,
+  RECEIVER_COUNTER_RDM_CHECKSUM_INVALID = 5
+} ReceiverErrorCounter;
+
 /**
  * @brief The counters for the receiver.
  */
@@ -22,7 +22,10 @@
 #include <stdlib.h>
 
 #include "constants.h"
+#include "dmx_snapshot.h"
 #include "dmx_spec.h"
+#include "events.h"
+#include "pixel_mapper.h"
 #include "rdm_frame.h"
 #include "rdm_handler.h"
 #include "receiver_counters.h"
@@ -53,6 +56,10 @@ typedef enum {
 
 static const uint16_t UNINITIALIZED_COUNTER = 0xffffu;
 
+enum {
+  PIXEL_DATA_SIZE = PIXEL_MAPPER_MAX_PIXELS * PIXEL_MAPPER_SLOTS_PER_PIXEL
+};
+
 /*
  * @brief The timing information for the current frame.
  */
@@ -68,6 +75,21 @@ static ResponderState g_state = STATE_START_CODE;
  */
 static unsigned int g_offset = 0u;
 
+/*
+ * @brief The snapshot generation last sent to the SPI output.
+ */
+static uint32_t g_spi_generation = 0u;
+
+/*
+ * @brief The slots within the pixel footprint.
+ */
+static uint8_t g_pixel_slots[PIXEL_DATA_SIZE];
+
+/*
+ * @brief The mapped pixel data.
+ */
+static uint8_t g_pixel_data[PIXEL_DATA_SIZE];
+
 /*
  * @brief Call the RDM handler when we have a complete and valid frame.
  */
@@ -87,6 +109,20 @@ static inline void DispatchRDMRequest(const uint8_t *frame) {
       header->param_data_length);
 }
 
+/*
+ * @brief Increment an error counter.
+ *
+ * The host is notified on the 1st, 2nd, 4th, 8th... error, which bounds the
+ * number of events a noisy line can generate.
+ */
+static inline void IncrementErrorCounter(uint32_t *counter,
+                                         ReceiverErrorCounter counter_id) {
+  (*counter)++;
+  if ((*counter & (*counter - 1u)) == 0u) {
+    Events_Push(EVENT_RECEIVER_COUNTER, counter_id, *counter);
+  }
+}
+
 /*
  * @brief Increment the bad-checksum counter if the frame was for us.
  */
@@ -96,7 +132,8 @@ static inline void PossiblyIncrementChecksumCounter(const uint8_t *frame) {
   RDMHeader *header = (RDMHeader*) frame;
   if (RDMUtil_RequiresAction(uid, header->dest_uid)) {
     SysLog_Message(SYSLOG_ERROR, "Checksum mismatch");
-    g_responder_counters.rdm_checksum_invalid++;
+    IncrementErrorCounter(&g_responder_counters.rdm_checksum_invalid,
+                          RECEIVER_COUNTER_RDM_CHECKSUM_INVALID);
   }
 }
 
@@ -109,13 +146,38 @@ static inline void PossiblyIncrementLengthMismatchCounter(
   RDMHandler_GetUID(uid);
   RDMHeader *header = (RDMHeader*) frame;
   if (RDMUtil_RequiresAction(uid, header->dest_uid)) {
-    g_responder_counters.rdm_length_mismatch++;
+    IncrementErrorCounter(&g_responder_counters.rdm_length_mismatch,
+                          RECEIVER_COUNTER_RDM_LENGTH_MISMATCH);
   }
 }
 
 // Public Functions
 // ----------------------------------------------------------------------------
-void Responder_Initialize() {}
+void Responder_Initialize() {
+  DMXSnapshot_Initialize();
+  PixelMapper_Initialize();
+  g_spi_generation = DMXSnapshot_Generation();
+}
+
+void Responder_Tasks() {
+  // If there are no pixels, another model is driving the SPI output.
+  if (DMXSnapshot_Generation() == g_spi_generation ||
+      PixelMapper_PixelCount() == 0u) {
+    return;
+  }
+
+  // Only the slots within the footprint are copied.
+  const unsigned int offset = PixelMapper_StartAddress() - 1u;
+  uint16_t slot_count;
+  g_spi_generation = DMXSnapshot_Read(g_pixel_slots, offset,
+                                      PixelMapper_Footprint(), &slot_count);
+  const unsigned int available = slot_count > offset ? slot_count - offset : 0u;
+
+  PixelMapper_Map(g_pixel_data, g_pixel_slots, available);
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixels(g_pixel_data, PixelMapper_PixelCount());
+  SPIRGB_CompleteUpdate();
+}
 
 void Responder_Receive(const TransceiverEvent *event) {
   // While this function is running, UART interrupts are disabled.
@@ -135,11 +197,15 @@ void Responder_Receive(const TransceiverEvent *event) {
       g_responder_counters.dmx_min_slot_count =
         g_responder_counters.dmx_last_slot_count;
     }
+    if (g_state == STATE_DMX_DATA) {
+      DMXSnapshot_FrameComplete();
+    }
     if (g_state == STATE_RDM_SUB_START_CODE ||
         g_state == STATE_RDM_MESSAGE_LENGTH ||
         (g_state == STATE_RDM_BODY && g_offset < 9)) {
       // COMMS_STATUS, short frame
-      g_responder_counters.rdm_short_frame++;
+      IncrementErrorCounter(&g_responder_counters.rdm_short_frame,
+                            RECEIVER_COUNTER_RDM_SHORT_FRAME);
     }
 
     g_offset = 0u;
@@ -150,7 +216,9 @@ void Responder_Receive(const TransceiverEvent *event) {
   }
 
   if (event->result == T_RESULT_RX_FRAME_TIMEOUT) {
-    SPIRGB_CompleteUpdate();
+    if (g_state == STATE_DMX_DATA) {
+      DMXSnapshot_FrameComplete();
+    }
     return;
   }
 
@@ -164,7 +232,6 @@ void Responder_Receive(const TransceiverEvent *event) {
           SysLog_Message(SYSLOG_DEBUG, "DMX frame");
           g_responder_counters.dmx_frames++;
           g_state = STATE_DMX_DATA;
-          SPIRGB_BeginUpdate();
         } else if (b == RDM_START_CODE) {
           g_responder_counters.rdm_frames++;
           g_state = STATE_RDM_SUB_START_CODE;
@@ -178,7 +245,9 @@ void Responder_Receive(const TransceiverEvent *event) {
         if (b != RDM_SUB_START_CODE) {
           SysLog_Print(SYSLOG_ERROR, "RDM sub-start-code mismatch: %d",
                        (int) b);
-          g_responder_counters.rdm_sub_start_code_invalid++;
+          IncrementErrorCounter(
+              &g_responder_counters.rdm_sub_start_code_invalid,
+              RECEIVER_COUNTER_RDM_SUB_START_CODE_INVALID);
           g_state = STATE_DISCARD;
         } else {
           g_state = STATE_RDM_MESSAGE_LENGTH;
@@ -187,7 +256,8 @@ void Responder_Receive(const TransceiverEvent *event) {
       case STATE_RDM_MESSAGE_LENGTH:
         if (b < sizeof(RDMHeader)) {
           SysLog_Print(SYSLOG_INFO, "RDM msg len too short: %d", (int) b);
-          g_responder_counters.rdm_msg_len_invalid++;
+          IncrementErrorCounter(&g_responder_counters.rdm_msg_len_invalid,
+                                RECEIVER_COUNTER_RDM_MSG_LEN_INVALID);
           g_state = STATE_DISCARD;
         } else {
           g_state = STATE_RDM_BODY;
@@ -200,7 +270,9 @@ void Responder_Receive(const TransceiverEvent *event) {
             SysLog_Print(SYSLOG_INFO, "Invalid RDM PDL: %d, msg len: %d",
                          (int) b, event->data[MESSAGE_LENGTH_OFFSET]);
             g_state = STATE_DISCARD;
-            g_responder_counters.rdm_param_data_len_invalid++;
+            IncrementErrorCounter(
+                &g_responder_counters.rdm_param_data_len_invalid,
+                RECEIVER_COUNTER_RDM_PARAM_DATA_LEN_INVALID);
             continue;
           }
         }
@@ -224,13 +296,6 @@ void Responder_Receive(const TransceiverEvent *event) {
         g_state = STATE_DISCARD;
         break;
       case STATE_DMX_DATA:
-        // TODO(simon): configure this with DMX_START_ADDRESS and footprints.
-        if (g_offset - 1u < 6u) {
-          SPIRGB_SetPixel((g_offset - 1u) / 3u, (g_offset - 1u) % 3u, b);
-        } else if (g_offset - 1u == 6u) {
-          SPIRGB_CompleteUpdate();
-        }
-
         g_responder_counters.dmx_last_checksum += b;
         g_responder_counters.dmx_last_slot_count++;
         if (g_responder_counters.dmx_max_slot_count == UNINITIALIZED_COUNTER ||
@@ -244,4 +309,8 @@ void Responder_Receive(const TransceiverEvent *event) {
         break;
     }
   }
+
+  if (g_state == STATE_DMX_DATA) {
+    DMXSnapshot_Receive(event->data + 1u, g_offset - 1u);
+  }
 }
@@ -24,6 +24,10 @@
  * The responder receives data from the transceiver module and de-mulitplexes
  * based on start code.
  *
+ * DMX512 frames are stored in the @ref dmx_snapshot. Responder_Tasks() updates
+ * the SPI output from the snapshot once a frame is complete, using the
+ * @ref pixel_mapper to convert slots to pixels.
+ *
  * @addtogroup responder
  * @{
  * @file responder.h
@@ -41,9 +45,18 @@ extern "C" {
 
 /**
  * @brief Initialize the Responder sub-system.
+ *
+ * This also initializes the @ref dmx_snapshot and the @ref pixel_mapper.
  */
 void Responder_Initialize();
 
+/**
+ * @brief Update the SPI output if a new DMX512 frame is available.
+ *
+ * This should be called from the main event loop.
+ */
+void Responder_Tasks();
+
 /**
  * @brief Called when data is received.
  * @param event The transceiver event.
@@ -0,0 +1,93 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * scheduler.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "scheduler.h"
+
+#include <stdint.h>
+
+static volatile uint8_t g_pending[SCHEDULER_WORK_COUNT];
+static volatile uint32_t g_wake_time;
+static volatile uint8_t g_wake_armed;
+static volatile uint8_t g_deadline_changed;
+
+void Scheduler_Initialize() {
+  unsigned int i = 0u;
+  for (; i < SCHEDULER_WORK_COUNT; i++) {
+    g_pending[i] = 0u;
+  }
+  g_wake_armed = 0u;
+  g_deadline_changed = 1u;
+}
+
+void Scheduler_Post(Scheduler_Work work) {
+  g_pending[work] = 1u;
+}
+
+bool Scheduler_Take(Scheduler_Work work) {
+  if (!g_pending[work]) {
+    return false;
+  }
+  // If an ISR posts between the check & the clear, the tasks still run after
+  // the ISR, so the work isn't lost.
+  g_pending[work] = 0u;
+  return true;
+}
+
+bool Scheduler_HasWork() {
+  unsigned int i = 0u;
+  for (; i < SCHEDULER_WORK_COUNT; i++) {
+    if (g_pending[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Scheduler_SetWakeTime(uint32_t time) {
+  // The time is stored before the flag, so if the ISR runs in between it
+  // either sees the new time or the previous flag value.
+  g_wake_time = time;
+  g_wake_armed = 1u;
+}
+
+void Scheduler_ClearWakeTime() {
+  g_wake_armed = 0u;
+}
+
+void Scheduler_TimerEvent(uint32_t now) {
+  // The signed difference handles the counter wrapping.
+  if (g_wake_armed && (int32_t) (now - g_wake_time) >= 0) {
+    g_wake_armed = 0u;
+    g_pending[SCHEDULER_TICK] = 1u;
+  }
+}
+
+void Scheduler_DeadlineChanged() {
+  g_deadline_changed = 1u;
+}
+
+bool Scheduler_TakeDeadlineChanged() {
+  if (!g_deadline_changed) {
+    return false;
+  }
+  // The flag is cleared before the deadlines are read, so a change made by an
+  // ISR in between is either seen now or on the next pass.
+  g_deadline_changed = 0u;
+  return true;
+}
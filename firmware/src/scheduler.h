@@ -0,0 +1,145 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * scheduler.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup scheduler Scheduler
+ * @brief Track which parts of the main loop have work to do.
+ *
+ * ISRs and transfer completions post work, and the main loop takes the work
+ * and runs the matching tasks functions. When no work is pending, the main
+ * loop can idle the CPU until the next interrupt.
+ *
+ * Each work item is a separate byte, so posting from an ISR doesn't need a
+ * read-modify-write, and it's safe to post at any time. Work is cleared when
+ * it's taken, before the tasks run, so work posted while the tasks are
+ * running is picked up on the next pass of the loop.
+ *
+ * SCHEDULER_TICK is posted from the coarse timer ISR, but only once the wake
+ * time set by the main loop is reached. The main loop sets the wake time to
+ * the earliest deadline of the tasks which poll the clock, so the core stays
+ * idle between deadlines rather than running every task on every timer
+ * interrupt.
+ *
+ * The wake time is absolute, so it stays correct until a task gets a new
+ * deadline, or an earlier one. Tasks note this with
+ * Scheduler_DeadlineChanged(), and the main loop only recalculates the wake
+ * time then, or after a tick. A deadline which moves later doesn't need to be
+ * noted, the tick arrives early and the wake time is recalculated.
+ *
+ * @addtogroup scheduler
+ * @{
+ * @file scheduler.h
+ * @brief Track which parts of the main loop have work to do.
+ */
+
+#ifndef FIRMWARE_SRC_SCHEDULER_H_
+#define FIRMWARE_SRC_SCHEDULER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The types of work.
+ */
+typedef enum {
+  SCHEDULER_TICK,  //!< The wake time was reached.
+  SCHEDULER_TRANSCEIVER,  //!< The transceiver state changed.
+  SCHEDULER_HOST,  //!< A USB event or transfer completed.
+  SCHEDULER_WORK_COUNT  //!< The number of types of work.
+} Scheduler_Work;
+
+/**
+ * @brief Initialize the scheduler.
+ *
+ * This clears any pending work.
+ */
+void Scheduler_Initialize();
+
+/**
+ * @brief Post work for the main loop.
+ * @param work The type of work.
+ *
+ * This can be called from an ISR.
+ */
+void Scheduler_Post(Scheduler_Work work);
+
+/**
+ * @brief Take pending work.
+ * @param work The type of work.
+ * @returns true if the work was pending. The work is cleared.
+ */
+bool Scheduler_Take(Scheduler_Work work);
+
+/**
+ * @brief Check if there is any pending work.
+ * @returns true if there is pending work, false if the main loop can idle.
+ */
+bool Scheduler_HasWork();
+
+/**
+ * @brief Set the time to post SCHEDULER_TICK at.
+ * @param time The CoarseTimer_Value to post the tick at. This replaces any
+ *   previous wake time.
+ *
+ * This should only be called from the main loop.
+ */
+void Scheduler_SetWakeTime(uint32_t time);
+
+/**
+ * @brief Clear the wake time, SCHEDULER_TICK won't be posted.
+ *
+ * This should only be called from the main loop.
+ */
+void Scheduler_ClearWakeTime();
+
+/**
+ * @brief Called from the coarse timer ISR.
+ * @param now The current CoarseTimer_Value.
+ *
+ * This posts SCHEDULER_TICK, and clears the wake time, once the wake time is
+ * reached.
+ */
+void Scheduler_TimerEvent(uint32_t now);
+
+/**
+ * @brief Note that a task has a new deadline, or an earlier one.
+ *
+ * This can be called from an ISR.
+ */
+void Scheduler_DeadlineChanged();
+
+/**
+ * @brief Check if a deadline changed, and clear the flag.
+ * @returns true if the wake time needs to be recalculated.
+ */
+bool Scheduler_TakeDeadlineChanged();
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif  // FIRMWARE_SRC_SCHEDULER_H_
@@ -20,12 +20,12 @@
 
 #include <stdlib.h>
 
-#include "coarse_timer.h"
 #include "constants.h"
 #include "rdm_frame.h"
 #include "rdm_responder.h"
 #include "rdm_util.h"
 #include "temperature.h"
+#include "timer_wheel.h"
 #include "utils.h"
 
 #include "app_settings.h"
@@ -49,7 +49,7 @@ static const ResponderDefinition RESPONDER_DEFINITION;
  * @brief The sensor model state.
  */
 typedef struct {
-  CoarseTimer_Value sensor_sample_time;
+  TimerWheel_Timer sample_timer;
   SensorData sensors[NUMBER_OF_SENSORS];
 } SensorModel;
 
@@ -68,8 +68,6 @@ static uint16_t GetSensorValue(unsigned int i) {
 }
 
 void SampleSensors() {
-  g_sensor_model.sensor_sample_time = CoarseTimer_GetTime();
-
   unsigned int i = 0;
   for (; i < NUMBER_OF_SENSORS; i++) {
     RDMUtil_UpdateSensor(
@@ -103,10 +101,14 @@ static void SensorModel_Activate() {
 
   RDMResponder_InitResponder();
   SampleSensors();
+  TimerWheel_Add(&g_sensor_model.sample_timer, SENSOR_SAMPLE_RATE,
+                 SENSOR_SAMPLE_RATE, SampleSensors);
   g_responder->sensors = g_sensor_model.sensors;
 }
 
-static void SensorModel_Deactivate() {}
+static void SensorModel_Deactivate() {
+  TimerWheel_Cancel(&g_sensor_model.sample_timer);
+}
 
 static int SensorModel_Ioctl(ModelIoctl command, uint8_t *data,
                              unsigned int length) {
@@ -146,12 +148,7 @@ static int SensorModel_HandleRequest(const RDMHeader *header,
   return RDMResponder_DispatchPID(header, param_data);
 }
 
-static void SensorModel_Tasks() {
-  if (CoarseTimer_HasElapsed(g_sensor_model.sensor_sample_time,
-                             SENSOR_SAMPLE_RATE)) {
-    SampleSensors();
-  }
-}
+static void SensorModel_Tasks() {}
 
 const ModelEntry SENSOR_MODEL_ENTRY = {
   .model_id = SENSOR_MODEL_ID,
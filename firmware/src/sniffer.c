@@ -0,0 +1,282 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * sniffer.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "sniffer.h"
+
+#include <string.h>
+
+#include "app_pipeline.h"
+#include "coarse_timer.h"
+#include "constants.h"
+#include "dmx_spec.h"
+#include "scheduler.h"
+#include "utils.h"
+
+/*
+ * @brief The header stored in front of each record in the ring buffer.
+ */
+typedef struct {
+  CoarseTimer_Value timestamp;
+  uint16_t break_time;
+  uint16_t mark_time;
+  uint16_t length;
+} SnifferRecordHeader;
+
+enum {
+  // The most slots in a frame, including the start code.
+  MAX_FRAME_SIZE = DMX_FRAME_SIZE + 1u,
+  // The space reserved for a new record.
+  MAX_RECORD_SIZE = sizeof(SnifferRecordHeader) + MAX_FRAME_SIZE,
+  // The dropped frame counter at the start of each message.
+  DROPPED_COUNTER_SIZE = sizeof(uint32_t)
+};
+
+typedef struct {
+  uint8_t buffer[SNIFFER_BUFFER_SIZE];
+  uint32_t write_index;  //!< The end of the last closed record.
+  uint32_t read_index;  //!< The start of the oldest unsent record.
+  uint16_t read_offset;  //!< The slots of the oldest record already sent.
+  bool recording;  //!< True if a record is open.
+  SnifferRecordHeader header;  //!< The header of the open record.
+  uint32_t dropped;  //!< The frames dropped since the last message.
+  CoarseTimer_Value last_send;  //!< When the last message was sent.
+} SnifferData;
+
+static SnifferData g_sniffer;
+
+static uint8_t g_sniffer_message[PAYLOAD_SIZE];
+
+#ifndef PIPELINE_TRANSPORT_TX
+static TransportTXFunction g_sniffer_tx_cb;
+#endif
+
+/*
+ * @brief Copy data into the ring buffer.
+ */
+static void CopyIn(uint32_t index, const void *data, unsigned int size) {
+  unsigned int offset = index & (SNIFFER_BUFFER_SIZE - 1u);
+  unsigned int first = SNIFFER_BUFFER_SIZE - offset;
+  if (first > size) {
+    first = size;
+  }
+  memcpy(g_sniffer.buffer + offset, data, first);
+  memcpy(g_sniffer.buffer, (const uint8_t*) data + first, size - first);
+}
+
+/*
+ * @brief Copy data out of the ring buffer.
+ */
+static void CopyOut(void *data, uint32_t index, unsigned int size) {
+  unsigned int offset = index & (SNIFFER_BUFFER_SIZE - 1u);
+  unsigned int first = SNIFFER_BUFFER_SIZE - offset;
+  if (first > size) {
+    first = size;
+  }
+  memcpy(data, g_sniffer.buffer + offset, first);
+  memcpy((uint8_t*) data + first, g_sniffer.buffer, size - first);
+}
+
+static uint8_t* PackUInt16(uint8_t *ptr, uint16_t value) {
+  // Messages are little endian, see @ref message-endian.
+  *ptr++ = ShortLSB(value);
+  *ptr++ = ShortMSB(value);
+  return ptr;
+}
+
+static uint8_t* PackUInt32(uint8_t *ptr, uint32_t value) {
+  *ptr++ = UInt32Byte3(value);
+  *ptr++ = UInt32Byte2(value);
+  *ptr++ = UInt32Byte1(value);
+  *ptr++ = UInt32Byte0(value);
+  return ptr;
+}
+
+static void OpenRecord(const TransceiverTiming *timing) {
+  if (SNIFFER_BUFFER_SIZE - (g_sniffer.write_index - g_sniffer.read_index) <
+      MAX_RECORD_SIZE) {
+    g_sniffer.dropped++;
+    return;
+  }
+  g_sniffer.recording = true;
+  g_sniffer.header.timestamp = CoarseTimer_GetTime();
+  g_sniffer.header.break_time = timing ? timing->request.break_time : 0u;
+  g_sniffer.header.mark_time = timing ? timing->request.mark_time : 0u;
+  g_sniffer.header.length = 0u;
+}
+
+static void AppendSlots(const TransceiverEvent *event) {
+  if (!g_sniffer.recording) {
+    return;
+  }
+  unsigned int length = event->length > MAX_FRAME_SIZE ?
+      MAX_FRAME_SIZE : event->length;
+  if (length > g_sniffer.header.length) {
+    CopyIn(g_sniffer.write_index + sizeof(SnifferRecordHeader) +
+               g_sniffer.header.length,
+           event->data + g_sniffer.header.length,
+           length - g_sniffer.header.length);
+    g_sniffer.header.length = length;
+  }
+}
+
+static void CloseRecord() {
+  if (!g_sniffer.recording) {
+    return;
+  }
+  CopyIn(g_sniffer.write_index, &g_sniffer.header,
+         sizeof(SnifferRecordHeader));
+  bool was_empty = (g_sniffer.write_index == g_sniffer.read_index &&
+                    g_sniffer.dropped == 0u);
+  g_sniffer.write_index += sizeof(SnifferRecordHeader) +
+                           g_sniffer.header.length;
+  g_sniffer.recording = false;
+
+  // The flush interval starts with the first record, and a full message is
+  // sent straight away.
+  uint32_t pending = g_sniffer.write_index - g_sniffer.read_index;
+  if (was_empty || pending >= PAYLOAD_SIZE - DROPPED_COUNTER_SIZE) {
+    Scheduler_DeadlineChanged();
+  }
+}
+
+// Public Functions
+// ----------------------------------------------------------------------------
+void Sniffer_Initialize(TransportTXFunction tx_cb) {
+  g_sniffer.write_index = 0u;
+  g_sniffer.read_index = 0u;
+  g_sniffer.read_offset = 0u;
+  g_sniffer.recording = false;
+  g_sniffer.dropped = 0u;
+  g_sniffer.last_send = CoarseTimer_GetTime();
+#ifndef PIPELINE_TRANSPORT_TX
+  g_sniffer_tx_cb = tx_cb;
+#endif
+}
+
+void Sniffer_Receive(const TransceiverEvent *event) {
+  if (event->op != T_OP_RX) {
+    return;
+  }
+
+  switch (event->result) {
+    case T_RESULT_RX_START_FRAME:
+      // Frames that end with a break don't get a timeout event, so the start
+      // of the next frame closes the open record.
+      CloseRecord();
+      OpenRecord(event->timing);
+      AppendSlots(event);
+      break;
+    case T_RESULT_RX_CONTINUE_FRAME:
+      AppendSlots(event);
+      break;
+    case T_RESULT_RX_FRAME_TIMEOUT:
+      AppendSlots(event);
+      CloseRecord();
+      break;
+    default:
+      {}
+  }
+}
+
+bool Sniffer_NextDeadline(uint32_t *delay) {
+  uint32_t pending = g_sniffer.write_index - g_sniffer.read_index;
+  if (pending == 0u && g_sniffer.dropped == 0u) {
+    return false;
+  }
+
+  *delay = CoarseTimer_Remaining(g_sniffer.last_send, SNIFFER_FLUSH_INTERVAL);
+  if (pending >= PAYLOAD_SIZE - DROPPED_COUNTER_SIZE || *delay == 0u) {
+    // The records are due, but the last attempt to send them failed. Try
+    // again on the next tick.
+    *delay = 1u;
+  }
+  return true;
+}
+
+void Sniffer_Tasks() {
+  uint32_t pending = g_sniffer.write_index - g_sniffer.read_index;
+  if (pending == 0u && g_sniffer.dropped == 0u) {
+    return;
+  }
+
+  // Batch records until a message is full or the flush interval passes.
+  if (pending < PAYLOAD_SIZE - DROPPED_COUNTER_SIZE &&
+      !CoarseTimer_HasElapsed(g_sniffer.last_send, SNIFFER_FLUSH_INTERVAL)) {
+    return;
+  }
+
+#ifndef PIPELINE_TRANSPORT_TX
+  if (!g_sniffer_tx_cb) {
+    return;
+  }
+#endif
+
+  uint8_t *ptr = PackUInt32(g_sniffer_message, g_sniffer.dropped);
+  uint32_t index = g_sniffer.read_index;
+  uint16_t offset = g_sniffer.read_offset;
+
+  while (index != g_sniffer.write_index) {
+    unsigned int space = g_sniffer_message + PAYLOAD_SIZE - ptr;
+    if (space <= SNIFFER_FRAGMENT_HEADER_SIZE) {
+      break;
+    }
+
+    SnifferRecordHeader header;
+    CopyOut(&header, index, sizeof(header));
+    unsigned int size = header.length - offset;
+    if (size > space - SNIFFER_FRAGMENT_HEADER_SIZE) {
+      size = space - SNIFFER_FRAGMENT_HEADER_SIZE;
+    }
+
+    ptr = PackUInt32(ptr, header.timestamp);
+    ptr = PackUInt16(ptr, header.break_time);
+    ptr = PackUInt16(ptr, header.mark_time);
+    ptr = PackUInt16(ptr, header.length);
+    ptr = PackUInt16(ptr, offset);
+    CopyOut(ptr, index + sizeof(header) + offset, size);
+    ptr += size;
+
+    if (offset + size == header.length) {
+      index += sizeof(header) + header.length;
+      offset = 0u;
+    } else {
+      // The rest of the record goes in the next message.
+      offset += size;
+      break;
+    }
+  }
+
+  IOVec iovec;
+  iovec.base = g_sniffer_message;
+  iovec.length = ptr - g_sniffer_message;
+
+#ifdef PIPELINE_TRANSPORT_TX
+  bool ok = PIPELINE_TRANSPORT_TX(EVENT_TOKEN, COMMAND_SNIFFER_DATA, RC_OK,
+                                  &iovec, 1u);
+#else
+  bool ok = g_sniffer_tx_cb(EVENT_TOKEN, COMMAND_SNIFFER_DATA, RC_OK, &iovec,
+                            1u);
+#endif
+  if (ok) {
+    g_sniffer.read_index = index;
+    g_sniffer.read_offset = offset;
+    g_sniffer.dropped = 0u;
+    g_sniffer.last_send = CoarseTimer_GetTime();
+  }
+}
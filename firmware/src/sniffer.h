@@ -0,0 +1,110 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * sniffer.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup sniffer Sniffer
+ * @brief Capture the frames on the line.
+ *
+ * In T_MODE_SNIFFER the transceiver receives like a responder, but never
+ * transmits. Each frame, DMX512, RDM or an alternate start code, is stored
+ * in a ring buffer as a capture record containing the timestamp, the break &
+ * mark times and the slot data, including the start code.
+ *
+ * Sniffer_Tasks() packs the records into COMMAND_SNIFFER_DATA messages, using
+ * the reserved EVENT_TOKEN. Records are batched: a message is sent once there
+ * is enough data to fill one, or when SNIFFER_FLUSH_INTERVAL has passed. A
+ * record that doesn't fit in the rest of a message is continued in the next
+ * one, see @ref message-commands-snifferdata.
+ *
+ * If the Host can't keep up and the ring buffer fills, new frames are
+ * dropped. The number of dropped frames is sent in the next message.
+ *
+ * @addtogroup sniffer
+ * @{
+ * @file sniffer.h
+ * @brief The Sniffer Module.
+ */
+
+#ifndef FIRMWARE_SRC_SNIFFER_H_
+#define FIRMWARE_SRC_SNIFFER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "transceiver.h"
+#include "transport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The size of the capture ring buffer, must be a power of 2.
+ */
+enum { SNIFFER_BUFFER_SIZE = 4096u };
+
+/**
+ * @brief Send any buffered records after this long, in 10ths of a
+ * millisecond.
+ */
+enum { SNIFFER_FLUSH_INTERVAL = 100u };
+
+/**
+ * @brief The size of a record header in a COMMAND_SNIFFER_DATA message.
+ */
+enum { SNIFFER_FRAGMENT_HEADER_SIZE = 12u };
+
+/**
+ * @brief Initialize the Sniffer module.
+ * @param tx_cb The function used to send messages to the Host. If
+ *   PIPELINE_TRANSPORT_TX is defined in app_pipeline.h, the macro will
+ *   override this value.
+ */
+void Sniffer_Initialize(TransportTXFunction tx_cb);
+
+/**
+ * @brief Called when data is received in sniffer mode.
+ * @param event The transceiver event.
+ */
+void Sniffer_Receive(const TransceiverEvent *event);
+
+/**
+ * @brief Send the captured records to the Host.
+ *
+ * This should be called from the main event loop.
+ */
+void Sniffer_Tasks();
+
+/**
+ * @brief Get the time until Sniffer_Tasks() next needs to run.
+ * @param[out] delay The time until the batched records should be sent, in
+ *   10ths of a millisecond.
+ * @returns false if there are no records to send.
+ */
+bool Sniffer_NextDeadline(uint32_t *delay);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif  // FIRMWARE_SRC_SNIFFER_H_
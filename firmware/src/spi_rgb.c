@@ -21,93 +21,404 @@
 
 #include <string.h>
 
+#include "coarse_timer.h"
+#include "peripheral/dma/plib_dma.h"
 #include "peripheral/spi/plib_spi.h"
+#include "scheduler.h"
 #include "syslog.h"
 
-// TODO(simon): move these into the config (and set with RDM?)
-static const uint8_t LPD8806_PIXEL_BYTE = 0x80u;
-
-enum { LATCH_BYTES = 1u };
-enum { PIXEL_COUNT = 2u };
+enum { DEFAULT_PIXEL_COUNT = 2u };
 enum { SLOTS_PER_PIXEL = 3u };
+// The source size register is 8 bits on the PIC32MX, so larger frames are
+// sent as several blocks.
+enum { DMA_MAX_BLOCK_SIZE = 256u };
+
+/*
+ * @brief The position of each color, for each PixelOrder.
+ */
+static const uint8_t COLOR_POSITIONS[][SLOTS_PER_PIXEL] = {
+  {0u, 1u, 2u},  // RGB
+  {1u, 0u, 2u},  // GRB
+  {2u, 1u, 0u},  // BGR
+};
+
+/*
+ * @brief A frame of encoded pixel data, including the header & latch.
+ */
+typedef struct {
+  uint16_t pixel_count;
+  uint16_t size;  //!< The number of bytes to send.
+  uint8_t data[PIXEL_ENCODER_MAX_FRAME_SIZE(SPIRGB_MAX_PIXELS)];
+} PixelFrame;
 
 typedef struct {
   SPI_MODULE_ID module_id;
+  const PixelEncoder *encoder;
+  uint32_t baud_rate;  //!< The configured baud rate.
+  uint32_t active_baud_rate;  //!< The baud rate the SPI module is using.
+  /**
+   * @brief The clock polarity the SPI module is using.
+   */
+  SPI_CLOCK_POLARITY active_clock_polarity;
   bool use_enhanced_buffering;
+  bool use_dma;
+  DMA_CHANNEL dma_channel;
   bool in_update;
-  uint32_t tx_index;
-  uint8_t pixels[SLOTS_PER_PIXEL * PIXEL_COUNT + LATCH_BYTES];
+  bool frame_pending;  //!< The back frame is complete & waiting to be sent.
+  bool back_is_stale;  //!< The back frame is older than the front frame.
+  bool tx_active;  //!< The front frame is being sent.
+  bool dma_active;  //!< A DMA block transfer is in progress.
+  uint8_t back;  //!< The index of the back frame.
+  uint32_t tx_index;  //!< The next byte of the front frame to send.
+  /**
+   * @brief The latch time of the front frame's encoder, in microseconds. This
+   *   is cleared once the latch time has passed.
+   */
+  uint16_t latch_time;
+  bool latch_started;  //!< The SPI module is idle after the front frame.
+  uint32_t latch_start;  //!< When the SPI module went idle, in microseconds.
+  /**
+   * @brief The front frame is sent while the back frame is updated.
+   */
+  PixelFrame frames[2];
+  /**
+   * @brief The color values of the last update, in the encoder's order.
+   */
+  uint8_t values[SLOTS_PER_PIXEL * SPIRGB_MAX_PIXELS];
 } SPIState;
 
 static SPIState g_spi;
 
+static inline PixelFrame *BackFrame() {
+  return &g_spi.frames[g_spi.back];
+}
+
+static inline PixelFrame *FrontFrame() {
+  return &g_spi.frames[g_spi.back ^ 1u];
+}
+
+/*
+ * @brief Encode a frame from the color values.
+ */
+static inline void EncodeFrame(PixelFrame *frame, uint16_t pixel_count) {
+  frame->pixel_count = pixel_count;
+  frame->size = PixelEncoder_Encode(g_spi.encoder, frame->data, g_spi.values,
+                                    pixel_count);
+}
+
+static DMA_TRIGGER_SOURCE TransmitTrigger(SPI_MODULE_ID module_id) {
+  switch (module_id) {
+    case SPI_ID_2:
+      return DMA_TRIGGER_SPI_2_TRANSMIT;
+    case SPI_ID_3:
+      return DMA_TRIGGER_SPI_3_TRANSMIT;
+    case SPI_ID_4:
+      return DMA_TRIGGER_SPI_4_TRANSMIT;
+    default:
+      return DMA_TRIGGER_SPI_1_TRANSMIT;
+  }
+}
+
+/*
+ * @brief Configure the DMA channel to move bytes to the SPI transmit buffer.
+ *
+ * A cell is transferred each time the SPI transmit interrupt flag is set.
+ */
+static void InitDMA() {
+  PLIB_DMA_Enable(DMA_ID_0);
+  PLIB_DMA_ChannelXTriggerEnable(DMA_ID_0, g_spi.dma_channel,
+                                 DMA_CHANNEL_TRIGGER_TRANSFER_START);
+  PLIB_DMA_ChannelXStartIRQSet(DMA_ID_0, g_spi.dma_channel,
+                               TransmitTrigger(g_spi.module_id));
+  PLIB_DMA_ChannelXDestinationStartAddressSet(
+      DMA_ID_0, g_spi.dma_channel,
+      (uint32_t) (uintptr_t) PLIB_SPI_BufferAddressGet(g_spi.module_id));
+  PLIB_DMA_ChannelXDestinationSizeSet(DMA_ID_0, g_spi.dma_channel, 1u);
+  PLIB_DMA_ChannelXCellSizeSet(DMA_ID_0, g_spi.dma_channel, 1u);
+}
+
+/*
+ * @brief Start a DMA transfer of the next block of the front frame.
+ */
+static void StartDMABlock() {
+  const PixelFrame *frame = FrontFrame();
+  uint16_t size = frame->size - g_spi.tx_index;
+  if (size > DMA_MAX_BLOCK_SIZE) {
+    size = DMA_MAX_BLOCK_SIZE;
+  }
+  PLIB_DMA_ChannelXSourceStartAddressSet(
+      DMA_ID_0, g_spi.dma_channel,
+      (uint32_t) (uintptr_t) (frame->data + g_spi.tx_index));
+  PLIB_DMA_ChannelXSourceSizeSet(DMA_ID_0, g_spi.dma_channel, size);
+  PLIB_DMA_ChannelXEnable(DMA_ID_0, g_spi.dma_channel);
+  // The transmit buffer has space, so force the first cell.
+  PLIB_DMA_StartTransferSet(DMA_ID_0, g_spi.dma_channel);
+  g_spi.tx_index += size;
+  g_spi.dma_active = true;
+}
+
+/*
+ * @brief Write the front frame to the SPI transmit buffer.
+ * @returns true if the frame has been written, false if the buffer is full.
+ */
+static bool WriteFrame() {
+  const PixelFrame *frame = FrontFrame();
+  while (g_spi.tx_index < frame->size) {
+    if (g_spi.use_enhanced_buffering) {
+      if (PLIB_SPI_TransmitBufferIsFull(g_spi.module_id)) {
+        return false;
+      }
+    } else if (PLIB_SPI_IsBusy(g_spi.module_id)) {
+      return false;
+    }
+    PLIB_SPI_BufferWrite(g_spi.module_id, frame->data[g_spi.tx_index]);
+    g_spi.tx_index++;
+  }
+  return true;
+}
+
+/*
+ * @brief Returns true once the front frame has been sent.
+ */
+static bool TransmitComplete() {
+  if (!g_spi.tx_active) {
+    return true;
+  }
+
+  if (g_spi.use_dma) {
+    if (g_spi.dma_active) {
+      if (!PLIB_DMA_ChannelXINTSourceFlagGet(
+              DMA_ID_0, g_spi.dma_channel, DMA_INT_BLOCK_TRANSFER_COMPLETE)) {
+        return false;
+      }
+      PLIB_DMA_ChannelXINTSourceFlagClear(DMA_ID_0, g_spi.dma_channel,
+                                          DMA_INT_BLOCK_TRANSFER_COMPLETE);
+      g_spi.dma_active = false;
+    }
+    if (g_spi.tx_index < FrontFrame()->size) {
+      if (!PLIB_SPI_TransmitBufferIsFull(g_spi.module_id)) {
+        StartDMABlock();
+      }
+      return false;
+    }
+  } else if (!WriteFrame()) {
+    return false;
+  }
+  g_spi.tx_active = false;
+  return true;
+}
+
+/*
+ * @brief Returns true once the front frame has been latched.
+ * @pre The front frame has been written to the transmit buffer.
+ *
+ * Some pixels latch once the clock has been idle for a period of time, the
+ * next frame can't be started until then.
+ */
+static bool LatchComplete() {
+  if (!g_spi.latch_time) {
+    return true;
+  }
+
+  // The last bytes may still be in the transmit buffer & shift register.
+  if (!g_spi.latch_started) {
+    if (PLIB_SPI_IsBusy(g_spi.module_id)) {
+      return false;
+    }
+    g_spi.latch_start = CoarseTimer_GetMicroseconds();
+    g_spi.latch_started = true;
+  }
+  if (CoarseTimer_GetMicroseconds() - g_spi.latch_start < g_spi.latch_time) {
+    return false;
+  }
+  g_spi.latch_time = 0u;
+  return true;
+}
+
+/*
+ * @brief The baud rate the current encoder needs.
+ */
+static inline uint32_t EncoderBaudRate() {
+  return g_spi.encoder->baud_rate ? g_spi.encoder->baud_rate : g_spi.baud_rate;
+}
+
+/*
+ * @brief Returns true if the current encoder needs different SPI settings.
+ */
+static inline bool SettingsChanged() {
+  return EncoderBaudRate() != g_spi.active_baud_rate ||
+         g_spi.encoder->clock_polarity != g_spi.active_clock_polarity;
+}
+
+/*
+ * @brief Swap the front & back frames and start sending the new front frame.
+ * @pre If the SPI settings change, the SPI module is idle.
+ */
+static void SendNextFrame() {
+  g_spi.back ^= 1u;
+  g_spi.frame_pending = false;
+  g_spi.back_is_stale = true;
+  g_spi.tx_active = true;
+  g_spi.latch_time = g_spi.encoder->latch_time;
+  g_spi.latch_started = false;
+
+  if (SettingsChanged()) {
+    const uint32_t baud_rate = EncoderBaudRate();
+    PLIB_SPI_Disable(g_spi.module_id);
+    if (baud_rate != g_spi.active_baud_rate) {
+      PLIB_SPI_BaudRateSet(g_spi.module_id, SYS_CLK_FREQ, baud_rate);
+      g_spi.active_baud_rate = baud_rate;
+    }
+    if (g_spi.encoder->clock_polarity != g_spi.active_clock_polarity) {
+      PLIB_SPI_ClockPolaritySelect(g_spi.module_id,
+                                   g_spi.encoder->clock_polarity);
+      g_spi.active_clock_polarity = g_spi.encoder->clock_polarity;
+    }
+    PLIB_SPI_Enable(g_spi.module_id);
+  }
+
+  g_spi.tx_index = 0u;
+  TransmitComplete();
+}
+
+// Public Functions
+// ----------------------------------------------------------------------------
 void SPIRGB_Init(const SPIRGBConfiguration *config) {
   g_spi.module_id = config->module_id;
+  g_spi.encoder = PixelEncoder_Get(PIXEL_TYPE_LPD8806);
+  g_spi.baud_rate = config->baud_rate;
+  g_spi.active_baud_rate = config->baud_rate;
+  g_spi.active_clock_polarity = g_spi.encoder->clock_polarity;
   g_spi.use_enhanced_buffering = config->use_enhanced_buffering;
+  g_spi.use_dma = config->use_dma;
+  g_spi.dma_channel = config->dma_channel;
   g_spi.in_update = false;
+  g_spi.frame_pending = false;
+  g_spi.back_is_stale = false;
+  g_spi.tx_active = false;
+  g_spi.dma_active = false;
+  g_spi.back = 0u;
   g_spi.tx_index = 0u;
-
-  memset(g_spi.pixels, LPD8806_PIXEL_BYTE, SLOTS_PER_PIXEL * PIXEL_COUNT);
-  memset(&g_spi.pixels[SLOTS_PER_PIXEL * PIXEL_COUNT], 0, LATCH_BYTES);
+  g_spi.latch_time = 0u;
+  g_spi.latch_started = false;
+  memset(g_spi.values, 0, sizeof(g_spi.values));
+  EncodeFrame(&g_spi.frames[0], DEFAULT_PIXEL_COUNT);
+  EncodeFrame(&g_spi.frames[1], DEFAULT_PIXEL_COUNT);
 
   // Init the SPI hardware.
   PLIB_SPI_BaudRateSet(g_spi.module_id, SYS_CLK_FREQ, config->baud_rate);
   PLIB_SPI_CommunicationWidthSelect(g_spi.module_id,
                                     SPI_COMMUNICATION_WIDTH_8BITS);
-  PLIB_SPI_ClockPolaritySelect(g_spi.module_id, SPI_CLOCK_POLARITY_IDLE_HIGH);
+  PLIB_SPI_ClockPolaritySelect(g_spi.module_id, g_spi.active_clock_polarity);
   if (g_spi.use_enhanced_buffering) {
     PLIB_SPI_FIFOEnable(g_spi.module_id);
+    if (g_spi.use_dma) {
+      PLIB_SPI_FIFOInterruptModeSelect(
+          g_spi.module_id, SPI_FIFO_INTERRUPT_WHEN_TRANSMIT_BUFFER_IS_NOT_FULL);
+    }
   }
   PLIB_SPI_SlaveSelectDisable(g_spi.module_id);
   PLIB_SPI_PinDisable(g_spi.module_id, SPI_PIN_SLAVE_SELECT);
   PLIB_SPI_MasterEnable(g_spi.module_id);
   PLIB_SPI_Enable(g_spi.module_id);
+
+  if (g_spi.use_dma) {
+    InitDMA();
+  }
 }
 
 void SPIRGB_BeginUpdate() {
+  if (g_spi.back_is_stale) {
+    // Individual pixels may be updated, so start from the last frame.
+    const PixelFrame *front = FrontFrame();
+    PixelFrame *back = BackFrame();
+    back->pixel_count = front->pixel_count;
+    back->size = front->size;
+    memcpy(back->data, front->data, front->size);
+    g_spi.back_is_stale = false;
+  }
   g_spi.in_update = true;
 }
 
+bool SPIRGB_SetPixelType(PixelType type) {
+  const PixelEncoder *encoder = PixelEncoder_Get(type);
+  if (!encoder) {
+    return false;
+  }
+  if (encoder == g_spi.encoder) {
+    return true;
+  }
+
+  // Re-encode the last update.
+  g_spi.encoder = encoder;
+  PixelFrame *frame = BackFrame();
+  EncodeFrame(frame, g_spi.back_is_stale ? FrontFrame()->pixel_count :
+                                           frame->pixel_count);
+  g_spi.back_is_stale = false;
+  g_spi.frame_pending = true;
+  return true;
+}
+
 void SPIRGB_SetPixel(uint16_t index, RGB_Color color, uint8_t value) {
-  if (index >= PIXEL_COUNT || !g_spi.in_update) {
+  PixelFrame *frame = BackFrame();
+  if (index >= frame->pixel_count || !g_spi.in_update) {
     return;
   }
-  // Map RGB to GRB
-  uint8_t color_offset = 0u;
-  switch (color) {
-    case RED:
-      color_offset = 1u;
-      break;
-    case GREEN:
-      color_offset = 0u;
-      break;
-    case BLUE:
-      color_offset = 2u;
-      break;
-    }
-  g_spi.pixels[index * SLOTS_PER_PIXEL + color_offset] =
-      LPD8806_PIXEL_BYTE | value >> 1;
+
+  uint8_t *values = &g_spi.values[index * SLOTS_PER_PIXEL];
+  values[COLOR_POSITIONS[g_spi.encoder->order][color]] = value;
+  g_spi.encoder->encode(
+      &frame->data[g_spi.encoder->header_size +
+                   index * g_spi.encoder->pixel_size],
+      values, 1u);
+}
+
+void SPIRGB_SetPixels(const uint8_t *data, uint16_t pixel_count) {
+  if (!g_spi.in_update) {
+    return;
+  }
+  if (pixel_count > SPIRGB_MAX_PIXELS) {
+    pixel_count = SPIRGB_MAX_PIXELS;
+  }
+  memcpy(g_spi.values, data, SLOTS_PER_PIXEL * pixel_count);
+  EncodeFrame(BackFrame(), pixel_count);
 }
 
 void SPIRGB_CompleteUpdate() {
   g_spi.in_update = false;
-  g_spi.tx_index = 0u;
+  g_spi.frame_pending = true;
+  Scheduler_DeadlineChanged();
+}
+
+bool SPIRGB_NextDeadline(uint32_t *delay) {
+  if (!g_spi.tx_active && !g_spi.latch_time &&
+      (!g_spi.frame_pending || g_spi.in_update)) {
+    return false;
+  }
+  // Once the module is idle, the latch time is checked on each tick.
+  *delay = !g_spi.tx_active && g_spi.latch_started ? 1u : 0u;
+  return true;
 }
 
 void SPIRGB_Tasks() {
-  if (g_spi.in_update) {
+  if (!TransmitComplete()) {
     return;
   }
 
-  while (g_spi.tx_index < PIXEL_COUNT * SLOTS_PER_PIXEL + LATCH_BYTES) {
-    if (g_spi.use_enhanced_buffering) {
-      if (PLIB_SPI_TransmitBufferIsFull(g_spi.module_id)) {
-        return;
-      }
-    } else if (PLIB_SPI_IsBusy(g_spi.module_id)) {
-      return;
-    }
-    PLIB_SPI_BufferWrite(g_spi.module_id, g_spi.pixels[g_spi.tx_index]);
-    g_spi.tx_index++;
+  if (!LatchComplete()) {
+    return;
+  }
+
+  // Frames that arrive while the last one is being sent are coalesced.
+  if (!g_spi.frame_pending || g_spi.in_update) {
+    return;
+  }
+
+  // The last bytes of the previous frame may still be in the transmit buffer
+  // & shift register. The baud rate & clock polarity can only be changed once
+  // they've been sent.
+  if (SettingsChanged() && PLIB_SPI_IsBusy(g_spi.module_id)) {
+    return;
   }
+  SendNextFrame();
 }
@@ -21,8 +21,23 @@
  * @defgroup spi_dmx SPI Pixel Controller
  * @brief Control RGB Pixels using SPI
  *
- * This only supports the LPD8806 chip for now. We're happy to accept pull
- * requests adding support for different pixel types.
+ * The pixel data is encoded for the wire using a PixelEncoder, see
+ * PixelEncoder_Get() for the supported pixel types. The default is the
+ * LPD8806.
+ *
+ * There are two frame buffers. Updates are written to the back frame, while
+ * the front frame is sent. Once an update completes and the front frame has
+ * been sent, the frames are swapped. Frames which complete while the front
+ * frame is being sent are coalesced, so only the latest one is sent.
+ *
+ * If DMA is enabled, the DMA controller moves the front frame to the SPI
+ * transmit buffer in blocks of up to 256 bytes, and SPIRGB_Tasks() only has
+ * to start each block. Otherwise SPIRGB_Tasks() writes to the transmit buffer
+ * until it's full.
+ *
+ * The SPI clock polarity follows the pixel type. For pixels which latch when
+ * the clock has been idle, like the WS2801, the next frame isn't started until
+ * the latch time has passed.
  *
  * @addtogroup spi_dmx
  * @{
@@ -39,7 +54,14 @@ extern "C" {
 #endif
 
 #include "system_config.h"
+#include "peripheral/dma/plib_dma.h"
 #include "peripheral/spi/plib_spi.h"
+#include "pixel_encoder.h"
+
+/**
+ * @brief The maximum number of pixels.
+ */
+enum { SPIRGB_MAX_PIXELS = 170u };
 
 /**
  * @brief RGB color values.
@@ -64,6 +86,16 @@ typedef struct {
    * normal mode there may be delays between bytes.
    */
   bool use_enhanced_buffering;
+
+  /**
+   * @brief Use DMA to move the pixel data to the SPI transmit buffer.
+   */
+  bool use_dma;
+
+  /**
+   * @brief The DMA channel to use, if use_dma is true.
+   */
+  DMA_CHANNEL dma_channel;
 } SPIRGBConfiguration;
 
 /**
@@ -72,10 +104,22 @@ typedef struct {
  */
 void SPIRGB_Init(const SPIRGBConfiguration *config);
 
+/**
+ * @brief Set the type of pixels attached.
+ * @param type The PixelType.
+ * @returns false if the pixel type isn't supported.
+ *
+ * The last update is re-encoded for the new pixel type and sent. If the pixel
+ * type requires a specific baud rate, the SPI module is switched to it before
+ * the next frame is sent.
+ */
+bool SPIRGB_SetPixelType(PixelType type);
+
 /**
  * @brief Begin a frame update.
  *
- * This pauses the SPI sending task.
+ * The update starts from the last frame that was sent. The frame being sent
+ * isn't affected.
  */
 void SPIRGB_BeginUpdate();
 
@@ -87,11 +131,23 @@ void SPIRGB_BeginUpdate();
  */
 void SPIRGB_SetPixel(uint16_t index, RGB_Color color, uint8_t value);
 
+/**
+ * @brief Set the values of all pixels.
+ * @param data The pixel data, 3 bytes per pixel in the order of the
+ *   PixelEncoder for the current pixel type. No color mapping is performed.
+ * @param pixel_count The number of pixels, this also changes the number of
+ *   pixels sent. Values greater than SPIRGB_MAX_PIXELS are truncated.
+ *
+ * This must be called between SPIRGB_BeginUpdate() and
+ * SPIRGB_CompleteUpdate().
+ */
+void SPIRGB_SetPixels(const uint8_t *data, uint16_t pixel_count);
+
 /**
  * @brief Complete a frame update.
  *
- * This unpauses the SPI sending task. The frame will be sent on the next call
- * to SPIRGB_Tasks().
+ * The frame will be sent by SPIRGB_Tasks() once the previous frame has been
+ * sent.
  */
 void SPIRGB_CompleteUpdate();
 
@@ -102,6 +158,18 @@ void SPIRGB_CompleteUpdate();
  */
 void SPIRGB_Tasks();
 
+/**
+ * @brief Get the time until SPIRGB_Tasks() next needs to run.
+ * @param[out] delay The time until the next run, in 10ths of a millisecond.
+ * @returns false if there is no frame to send.
+ *
+ * While a frame is being sent, SPIRGB_Tasks() polls the SPI module and
+ * the DMA controller, and the gap between bytes must stay short for the
+ * WS2812, so the delay is 0. While waiting for a frame to latch, the delay is
+ * a single tick.
+ */
+bool SPIRGB_NextDeadline(uint32_t *delay);
+
 #ifdef __cplusplus
 }
 #endif
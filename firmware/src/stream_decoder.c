@@ -80,6 +80,10 @@ void StreamDecoder_ClearFragmentedFrameFlag() {
   g_stream_data.fragmented_frame = false;
 }
 
+unsigned int StreamDecoder_FreeSpace() {
+  return PAYLOAD_SIZE - g_stream_data.fragment_offset;
+}
+
 void StreamDecoder_Process(const uint8_t* data, unsigned int size) {
 #ifndef PIPELINE_HANDLE_MESSAGE
   if (!g_stream_data.handler) {
@@ -77,6 +77,13 @@ bool StreamDecoder_GetFragmentedFrameFlag();
  */
 void StreamDecoder_ClearFragmentedFrameFlag();
 
+/**
+ * @brief The space remaining in the reassembly buffer.
+ * @returns The number of payload bytes that can be accepted before the
+ *   current frame fills the reassembly buffer.
+ */
+unsigned int StreamDecoder_FreeSpace();
+
 /**
  * @brief Decode data from an input stream.
  * @param data A pointer to the incoming data.
@@ -24,6 +24,7 @@
 #include "sys/attribs.h"
 
 #include "coarse_timer.h"
+#include "scheduler.h"
 
 #include "app_settings.h"
 
@@ -54,6 +55,7 @@ static uint8_t g_sample_count = 0;
 struct {
   uint16_t offset;  //!< The calibration offset
   bool new_sample;  //!< true if there is a new sample
+  bool converting;  //!< true if a conversion has been started
   uint16_t sample_value;  //!< The raw sampled value
   uint16_t temperature;  //!< The temperature in 10ths of a degree.
 } g_adc_data;
@@ -71,6 +73,7 @@ void Temperature_Init() {
 #ifdef RDM_RESPONDER_TEMPERATURE_SENSOR
   g_timer = CoarseTimer_GetTime();
   g_adc_data.new_sample = false;
+  g_adc_data.converting = false;
   g_adc_data.sample_value = 0;
   g_adc_data.temperature = 0;
 
@@ -127,12 +130,15 @@ void Temperature_Tasks() {
 
     // AD1CON1bits.ASAM = 1;
     PLIB_ADC_SampleAutoStartEnable(ADC_ID_1);
+    g_adc_data.converting = true;
+    Scheduler_DeadlineChanged();
     g_timer = CoarseTimer_GetTime();
   }
 
   if (g_adc_data.new_sample) {
     PLIB_ADC_Disable(ADC_ID_1);
     g_adc_data.new_sample = false;
+    g_adc_data.converting = false;
 
     if (g_sample_count == 0) {
       g_adc_data.offset = g_adc_data.sample_value;
@@ -149,3 +155,17 @@ void Temperature_Tasks() {
   }
 #endif
 }
+
+bool Temperature_NextDeadline(uint32_t *delay) {
+#ifdef RDM_RESPONDER_TEMPERATURE_SENSOR
+  if (g_adc_data.converting) {
+    // The ADC ISR doesn't post work, so check for the sample on each tick.
+    *delay = 1u;
+  } else {
+    *delay = CoarseTimer_Remaining(g_timer, SAMPLING_PERIOD);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
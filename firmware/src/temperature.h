@@ -30,6 +30,7 @@
 #ifndef FIRMWARE_SRC_TEMPERATURE_H_
 #define FIRMWARE_SRC_TEMPERATURE_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -62,6 +63,14 @@ uint16_t Temperature_GetValue(TemperatureSensor sensor);
  */
 void Temperature_Tasks();
 
+/**
+ * @brief Get the time until Temperature_Tasks() next needs to run.
+ * @param[out] delay The time until the next sample, or the next check for a
+ *   completed conversion, in 10ths of a millisecond.
+ * @returns false if there is no temperature sensor.
+ */
+bool Temperature_NextDeadline(uint32_t *delay);
+
 #ifdef __cplusplus
 }
 #endif
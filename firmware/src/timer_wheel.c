@@ -0,0 +1,189 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * timer_wheel.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "timer_wheel.h"
+
+#include <stdlib.h>
+
+#include "coarse_timer.h"
+#include "scheduler.h"
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1u)
+
+typedef struct {
+  TimerWheel_Timer *slots[TIMER_WHEEL_SLOTS];
+  CoarseTimer_Value tick_start;  //!< The time the current tick started.
+  uint32_t tick;  //!< The current tick.
+  unsigned int count;  //!< The number of timers in the wheel.
+  uint32_t earliest;  //!< The expiry of the next timer, if earliest_valid.
+  bool earliest_valid;  //!< False if earliest needs to be recalculated.
+} TimerWheel;
+
+static TimerWheel g_wheel;
+
+static void Insert(TimerWheel_Timer *timer) {
+  TimerWheel_Timer **head = &g_wheel.slots[timer->expiry & SLOT_MASK];
+  timer->prev = NULL;
+  timer->next = *head;
+  if (*head) {
+    (*head)->prev = timer;
+  }
+  *head = timer;
+  timer->active = true;
+  if (!g_wheel.count) {
+    g_wheel.earliest = timer->expiry;
+    g_wheel.earliest_valid = true;
+    Scheduler_DeadlineChanged();
+  } else if (!g_wheel.earliest_valid) {
+    Scheduler_DeadlineChanged();
+  } else if (timer->expiry - g_wheel.tick < g_wheel.earliest - g_wheel.tick) {
+    g_wheel.earliest = timer->expiry;
+    Scheduler_DeadlineChanged();
+  }
+  g_wheel.count++;
+}
+
+/*
+ * @brief Advance the wheel a single tick.
+ */
+static void RunTick() {
+  g_wheel.tick++;
+  TimerWheel_Timer **head = &g_wheel.slots[g_wheel.tick & SLOT_MASK];
+  TimerWheel_Timer *timer = *head;
+  while (timer) {
+    if (timer->expiry != g_wheel.tick) {
+      // This timer is for a later revolution of the wheel.
+      timer = timer->next;
+      continue;
+    }
+
+    TimerWheel_Callback callback = timer->callback;
+    TimerWheel_Cancel(timer);
+    if (timer->period) {
+      timer->expiry += timer->period;
+      Insert(timer);
+    }
+    callback();
+    // The callback may have added or cancelled timers in this slot.
+    timer = *head;
+  }
+}
+
+void TimerWheel_Initialize() {
+  unsigned int i = 0u;
+  for (; i < TIMER_WHEEL_SLOTS; i++) {
+    TimerWheel_Timer *timer = g_wheel.slots[i];
+    for (; timer; timer = timer->next) {
+      timer->active = false;
+    }
+    g_wheel.slots[i] = NULL;
+  }
+  g_wheel.tick_start = CoarseTimer_GetTime();
+  g_wheel.tick = 0u;
+  g_wheel.count = 0u;
+  g_wheel.earliest_valid = false;
+}
+
+void TimerWheel_Add(TimerWheel_Timer *timer, uint32_t delay, uint32_t period,
+                    TimerWheel_Callback callback) {
+  TimerWheel_Cancel(timer);
+
+  // The time since the current tick started. This can be more than a tick if
+  // TimerWheel_Tasks() hasn't caught up yet.
+  const uint32_t offset = CoarseTimer_GetTime() - g_wheel.tick_start;
+  // Round up, so the timer never fires early.
+  timer->expiry = g_wheel.tick + (offset + delay) / TIMER_WHEEL_RESOLUTION +
+                  1u;
+  timer->period = (period + TIMER_WHEEL_RESOLUTION - 1u) /
+                  TIMER_WHEEL_RESOLUTION;
+  timer->callback = callback;
+  Insert(timer);
+}
+
+void TimerWheel_Cancel(TimerWheel_Timer *timer) {
+  if (!timer->active) {
+    return;
+  }
+
+  if (timer->prev) {
+    timer->prev->next = timer->next;
+  } else {
+    g_wheel.slots[timer->expiry & SLOT_MASK] = timer->next;
+  }
+  if (timer->next) {
+    timer->next->prev = timer->prev;
+  }
+  if (timer->expiry == g_wheel.earliest) {
+    // This also covers timers removed from the wheel as they fire.
+    g_wheel.earliest_valid = false;
+  }
+  timer->active = false;
+  g_wheel.count--;
+}
+
+bool TimerWheel_NextDeadline(uint32_t *delay) {
+  if (!g_wheel.count) {
+    return false;
+  }
+
+  // Timers in the wheel always expire after the current tick. Only walk the
+  // wheel if the earliest timer has been cancelled or has fired.
+  if (!g_wheel.earliest_valid) {
+    uint32_t ticks = UINT32_MAX;
+    unsigned int i = 0u;
+    for (; i < TIMER_WHEEL_SLOTS; i++) {
+      const TimerWheel_Timer *timer = g_wheel.slots[i];
+      for (; timer; timer = timer->next) {
+        const uint32_t timer_ticks = timer->expiry - g_wheel.tick;
+        if (timer_ticks < ticks) {
+          ticks = timer_ticks;
+        }
+      }
+    }
+    g_wheel.earliest = g_wheel.tick + ticks;
+    g_wheel.earliest_valid = true;
+  }
+
+  const uint32_t ticks = g_wheel.earliest - g_wheel.tick;
+
+  const uint32_t elapsed = CoarseTimer_GetTime() - g_wheel.tick_start;
+  const uint32_t deadline = ticks * TIMER_WHEEL_RESOLUTION;
+  *delay = deadline > elapsed ? deadline - elapsed : 0u;
+  return true;
+}
+
+void TimerWheel_Tasks() {
+  const uint32_t elapsed = CoarseTimer_GetTime() - g_wheel.tick_start;
+  if (elapsed < TIMER_WHEEL_RESOLUTION) {
+    return;
+  }
+
+  uint32_t ticks = elapsed / TIMER_WHEEL_RESOLUTION;
+  if (!g_wheel.count) {
+    // Nothing to run, so skip straight to the current tick.
+    g_wheel.tick += ticks;
+    g_wheel.tick_start += ticks * TIMER_WHEEL_RESOLUTION;
+    return;
+  }
+
+  while (ticks--) {
+    g_wheel.tick_start += TIMER_WHEEL_RESOLUTION;
+    RunTick();
+  }
+}
@@ -0,0 +1,152 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * timer_wheel.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup timer_wheel Timer Wheel
+ * @brief Run callbacks after a delay, or periodically.
+ *
+ * Rather than each module polling CoarseTimer_HasElapsed() on every pass of
+ * the main loop, modules add a timer to the wheel, and the callback is run
+ * from TimerWheel_Tasks() once the timer expires.
+ *
+ * The wheel has TIMER_WHEEL_SLOTS slots, each covering
+ * TIMER_WHEEL_RESOLUTION of time. Timers are placed in the slot for their
+ * expiry time, so each tick of the wheel only needs to look at a single
+ * slot. Timers more than one revolution in the future stay in their slot
+ * until the wheel reaches them again.
+ *
+ * Like CoarseTimer_HasElapsed(), timers never fire early. Since the wheel
+ * advances a tick at a time, a timer may fire up to TIMER_WHEEL_RESOLUTION
+ * late.
+ *
+ * The timers are owned by the caller, typically as part of the module's
+ * static state. A timer must not be modified while it's in the wheel.
+ *
+ * @addtogroup timer_wheel
+ * @{
+ * @file timer_wheel.h
+ * @brief Run callbacks after a delay, or periodically.
+ */
+
+#ifndef FIRMWARE_SRC_TIMER_WHEEL_H_
+#define FIRMWARE_SRC_TIMER_WHEEL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The time covered by each slot, in 10ths of a millisecond.
+ */
+#define TIMER_WHEEL_RESOLUTION 10u
+
+/**
+ * @brief The number of slots in the wheel, this must be a power of 2.
+ */
+#define TIMER_WHEEL_SLOTS 128u
+
+/**
+ * @brief The function called when a timer expires.
+ */
+typedef void (*TimerWheel_Callback)();
+
+/**
+ * @brief A timer.
+ *
+ * The members are private to the timer wheel.
+ */
+typedef struct TimerWheel_Timer_s {
+  struct TimerWheel_Timer_s *next;
+  struct TimerWheel_Timer_s *prev;
+  TimerWheel_Callback callback;
+  uint32_t expiry;  //!< The wheel tick the timer expires on.
+  uint32_t period;  //!< The period in wheel ticks, or 0 for a one-shot timer.
+  bool active;  //!< True if the timer is in the wheel.
+} TimerWheel_Timer;
+
+/**
+ * @brief Initialize the timer wheel.
+ *
+ * Any timers in the wheel are removed.
+ */
+void TimerWheel_Initialize();
+
+/**
+ * @brief Add a timer to the wheel.
+ * @param timer The timer to add. If the timer is already in the wheel, it's
+ *   restarted.
+ * @param delay The time until the timer expires, in 10ths of a millisecond.
+ * @param period The period to run the timer at, in 10ths of a millisecond,
+ *   or 0 for a one-shot timer. This is rounded up to a multiple of
+ *   TIMER_WHEEL_RESOLUTION.
+ * @param callback The function to call when the timer expires.
+ */
+void TimerWheel_Add(TimerWheel_Timer *timer, uint32_t delay, uint32_t period,
+                    TimerWheel_Callback callback);
+
+/**
+ * @brief Remove a timer from the wheel.
+ * @param timer The timer to remove. It's safe to cancel a timer which isn't
+ *   in the wheel.
+ *
+ * This can be called from a timer callback, including to cancel the timer
+ * which is running.
+ */
+void TimerWheel_Cancel(TimerWheel_Timer *timer);
+
+/**
+ * @brief Check if a timer is in the wheel.
+ * @param timer The timer to check.
+ * @returns true if the timer is in the wheel.
+ */
+static inline bool TimerWheel_IsActive(const TimerWheel_Timer *timer) {
+  return timer->active;
+}
+
+/**
+ * @brief Get the time until the next timer expires.
+ * @param[out] delay The time until the next timer expires, in 10ths of a
+ *   millisecond. This is 0 if a timer has already expired.
+ * @returns false if there are no timers in the wheel.
+ *
+ * The main loop can use this to idle until there is work to do. This walks
+ * the wheel, so it should only be called before idling.
+ */
+bool TimerWheel_NextDeadline(uint32_t *delay);
+
+/**
+ * @brief Advance the wheel and run the callbacks of any expired timers.
+ *
+ * This should be called in the main event loop. If the loop is delayed, the
+ * wheel catches up a tick at a time, so no timers are missed.
+ */
+void TimerWheel_Tasks();
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif  // FIRMWARE_SRC_TIMER_WHEEL_H_
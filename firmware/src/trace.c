@@ -0,0 +1,79 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * trace.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "trace.h"
+
+#include <string.h>
+
+#include "coarse_timer.h"
+
+/*
+ * @brief Records closer than this to being overwritten are skipped by
+ * Trace_Read().
+ *
+ * The ISRs may add records while we're copying, this stops them from
+ * overwriting the records being read.
+ */
+enum { TRACE_READ_MARGIN = 16u };
+
+typedef struct {
+  TraceRecord records[TRACE_BUFFER_SIZE];
+  uint32_t write_count;  //!< The total number of records written.
+  uint32_t read_count;  //!< The total number of records read or lost.
+} TraceData;
+
+static TraceData g_trace;
+
+void Trace_Initialize() {
+  g_trace.write_count = 0u;
+  g_trace.read_count = 0u;
+}
+
+void Trace_Record(uint8_t state, TraceEvent event, uint16_t data_index) {
+  // Reserve the slot before filling it in. A higher priority ISR may record
+  // an event while we're in the middle of this, it must get its own slot.
+  uint32_t index = __sync_fetch_and_add(&g_trace.write_count, 1u);
+  TraceRecord *record = &g_trace.records[index & (TRACE_BUFFER_SIZE - 1u)];
+  record->timestamp = CoarseTimer_GetMicroseconds();
+  record->state = state;
+  record->event = event;
+  record->data_index = data_index;
+}
+
+unsigned int Trace_Read(TraceRecord *records, unsigned int max_records,
+                        uint32_t *lost) {
+  uint32_t write_count = g_trace.write_count;
+  uint32_t unread = write_count - g_trace.read_count;
+
+  *lost = 0u;
+  if (unread > TRACE_BUFFER_SIZE - TRACE_READ_MARGIN) {
+    *lost = unread - (TRACE_BUFFER_SIZE - TRACE_READ_MARGIN);
+    g_trace.read_count += *lost;
+    unread -= *lost;
+  }
+
+  unsigned int count = unread < max_records ? unread : max_records;
+  unsigned int i = 0u;
+  for (; i < count; i++) {
+    records[i] = g_trace.records[
+        (g_trace.read_count + i) & (TRACE_BUFFER_SIZE - 1u)];
+  }
+  g_trace.read_count += count;
+  return count;
+}
@@ -0,0 +1,121 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * trace.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup trace Trace
+ * @brief A low overhead trace of the transceiver state machine.
+ *
+ * The transceiver records each state change and each time one of its ISRs
+ * runs. A record holds a microsecond timestamp, the transceiver state, the
+ * event and the data index, which is enough to reconstruct the break, mark
+ * & turnaround timing of each frame.
+ *
+ * Records are stored in a ring buffer; once it's full the oldest records are
+ * overwritten. The Host drains the buffer with the GET_TRACE command, see
+ * @ref message-commands-gettrace. tools/trace2json converts the records to
+ * the Chrome trace format, which can be loaded into Perfetto.
+ *
+ * Recording is cheap enough to leave on all the time, it's an atomic
+ * increment and a handful of stores. Records are added from the main loop and
+ * from ISRs of different priorities, which can nest, so each record reserves
+ * its slot before it's filled in. Trace_Read() must only be called from the
+ * main loop.
+ *
+ * @addtogroup trace
+ * @{
+ * @file trace.h
+ * @brief The trace recorder.
+ */
+
+#ifndef FIRMWARE_SRC_TRACE_H_
+#define FIRMWARE_SRC_TRACE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The number of records in the ring buffer, must be a power of 2.
+ */
+enum { TRACE_BUFFER_SIZE = 512u };
+
+/**
+ * @brief The events that generate a trace record.
+ */
+typedef enum {
+  TRACE_EVENT_STATE_CHANGE = 0,  //!< The transceiver changed state.
+  TRACE_EVENT_INPUT_CAPTURE = 1,  //!< The input capture ISR ran.
+  TRACE_EVENT_TIMER = 2,  //!< The timer ISR ran.
+  TRACE_EVENT_UART = 3,  //!< The UART ISR ran.
+} TraceEvent;
+
+/**
+ * @brief A trace record.
+ *
+ * This is sent to the Host as is, in little endian byte order.
+ */
+typedef struct {
+  uint32_t timestamp;  //!< The time in microseconds, this wraps.
+  uint8_t state;  //!< The transceiver state after the event.
+  uint8_t event;  //!< The TraceEvent.
+  uint16_t data_index;  //!< The index into the TX / RX buffer.
+} TraceRecord;
+
+/**
+ * @brief The maximum number of records in a GET_TRACE response.
+ */
+enum { TRACE_RECORDS_PER_RESPONSE = 63u };
+
+/**
+ * @brief Initialize the trace buffer, this discards any records.
+ */
+void Trace_Initialize();
+
+/**
+ * @brief Record an event.
+ * @param state The current state.
+ * @param event The TraceEvent.
+ * @param data_index The current data index.
+ */
+void Trace_Record(uint8_t state, TraceEvent event, uint16_t data_index);
+
+/**
+ * @brief Read the oldest records from the buffer.
+ * @param records The array to copy the records to.
+ * @param max_records The size of the records array.
+ * @param[out] lost The number of records that were overwritten before they
+ *   could be read.
+ * @returns The number of records copied.
+ *
+ * The records are removed from the buffer.
+ */
+unsigned int Trace_Read(TraceRecord *records, unsigned int max_records,
+                        uint32_t *lost);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif  // FIRMWARE_SRC_TRACE_H_
@@ -29,15 +29,20 @@
 #include "app_pipeline.h"
 #include "coarse_timer.h"
 #include "constants.h"
+#include "dmx_rle.h"
 #include "dmx_spec.h"
+#include "events.h"
 #include "peripheral/ic/plib_ic.h"
 #include "peripheral/tmr/plib_tmr.h"
 #include "peripheral/usart/plib_usart.h"
 #include "setting_macros.h"
 #include "syslog.h"
 #include "system_definitions.h"
+#include "trace.h"
+#include "transceiver_state.h"
 #include "transceiver_timing.h"
 #include "random.h"
+#include "scheduler.h"
 
 #include "app_settings.h"
 
@@ -58,49 +63,6 @@ static const uint16_t RESPONSE_TIME_RX_FUDGE_FACTOR = 13u;
 static const uint8_t SELF_TEST_VALUE = 0xa5;
 static const uint32_t SELF_TEST_TIMEOUT = 100;  // 10ms
 
-typedef enum {
-  // Controller states
-  STATE_C_INITIALIZE = 0,  //!< Initialize controller state.
-  STATE_C_TX_READY = 1,  //!< Wait for a pending frame
-  STATE_C_IN_BREAK = 2,  //!< In the Break
-  STATE_C_IN_MARK = 3,  //!< In the Mark-after-break
-  STATE_C_TX_DATA = 4,  //!< Transmitting data
-  STATE_C_TX_DRAIN = 5,  //!< Wait for last byte to be sent
-  STATE_C_RX_WAIT_FOR_BREAK = 6,  //!< Waiting for RX break
-  STATE_C_RX_IN_BREAK = 7,  //!< In break
-  STATE_C_RX_IN_MARK = 8,  //!< In mark
-  STATE_C_RX_DATA = 9,  //!< Receiving data.
-  STATE_C_RX_WAIT_FOR_DUB = 10,  //!< Waiting for DUB response
-  STATE_C_RX_IN_DUB = 11,  //!< In DUB response
-  STATE_C_RX_TIMEOUT = 12,  //!< A RX timeout occured.
-  STATE_C_COMPLETE = 13,  //!< Running the completion handler.
-  STATE_C_BACKOFF = 14,  //!< Waiting until we can send the next break
-
-  // Responder states.
-  STATE_R_INITIALIZE = 20,  //!< Initialze responder state
-  STATE_R_RX_PREPARE = 21,  //!< Prepare to receive frame
-  STATE_R_RX_MBB = 22,  //!< In mark before break
-  STATE_R_RX_BREAK = 23,  //!< In break
-  STATE_R_RX_MARK = 24,  //!< In mark after break
-  STATE_R_RX_DATA = 25,  //!< Receiving data
-  STATE_R_TX_WAITING = 26,  //!< Delay before response
-  STATE_R_TX_BREAK = 27,  //!< In TX Break
-  STATE_R_TX_MARK = 28,  //!< In TX Mark
-  STATE_R_TX_DATA = 29,  //!< Transmitting data.
-  STATE_R_TX_DRAIN = 30,  //!< Wait for last byte to be sent.
-  STATE_R_TX_COMPLETE = 31,  //!< Response complete
-
-  // Self test states
-  STATE_T_INITIALIZE = 40,  //!< Init self test
-  STATE_T_TX_READY = 41,  //!< Wait for send operation
-  STATE_T_RX_WAIT = 42,  //!< Wait for response
-  STATE_T_VERIFY = 43,  //!< Check response
-
-  // Common states
-  STATE_RESET = 99,
-  STATE_ERROR = 100
-} TransceiverState;
-
 typedef enum {
   OP_TX_ONLY = T_OP_TX_ONLY,
   OP_RDM_DUB = T_OP_RDM_DUB,
@@ -108,6 +70,7 @@ typedef enum {
   OP_RDM_WITH_RESPONSE = T_OP_RDM_WITH_RESPONSE,
   OP_RX = T_OP_RX,
   OP_SELF_TEST = T_OP_SELF_TEST,
+  OP_TX_DMX_RLE = T_OP_TX_DMX_RLE,
   OP_RDM_DUB_RESPONSE,  //!< No break
   OP_RDM_RESEPONSE  //!< With a break
 } InternalOperation;
@@ -220,6 +183,40 @@ TransceiverData g_transceiver;
 // The hardware settings
 static TransceiverHardwareSettings g_hw_settings;
 
+/*
+ * The peripherals used by the transceiver. If the board defines
+ * TRANSCEIVER_STATIC_HARDWARE these are compile time constants, which allows
+ * the PLIB calls to inline to direct register accesses. Otherwise they come
+ * from the TransceiverHardwareSettings passed to Transceiver_Initialize().
+ */
+#ifdef TRANSCEIVER_STATIC_HARDWARE
+#define HW_USART AS_USART_ID(TRANSCEIVER_UART)
+#define HW_USART_VECTOR AS_USART_INTERRUPT_VECTOR(TRANSCEIVER_UART)
+#define HW_USART_TX_SOURCE AS_USART_INTERRUPT_TX_SOURCE(TRANSCEIVER_UART)
+#define HW_USART_RX_SOURCE AS_USART_INTERRUPT_RX_SOURCE(TRANSCEIVER_UART)
+#define HW_USART_ERROR_SOURCE AS_USART_INTERRUPT_ERROR_SOURCE(TRANSCEIVER_UART)
+#define HW_IC AS_IC_ID(TRANSCEIVER_IC)
+#define HW_IC_VECTOR AS_IC_INTERRUPT_VECTOR(TRANSCEIVER_IC)
+#define HW_IC_SOURCE AS_IC_INTERRUPT_SOURCE(TRANSCEIVER_IC)
+#define HW_IC_TIMER AS_IC_TMR_ID(TRANSCEIVER_TIMER)
+#define HW_TIMER AS_TIMER_ID(TRANSCEIVER_TIMER)
+#define HW_TIMER_VECTOR AS_TIMER_INTERRUPT_VECTOR(TRANSCEIVER_TIMER)
+#define HW_TIMER_SOURCE AS_TIMER_INTERRUPT_SOURCE(TRANSCEIVER_TIMER)
+#else
+#define HW_USART g_hw_settings.usart
+#define HW_USART_VECTOR g_hw_settings.usart_vector
+#define HW_USART_TX_SOURCE g_hw_settings.usart_tx_source
+#define HW_USART_RX_SOURCE g_hw_settings.usart_rx_source
+#define HW_USART_ERROR_SOURCE g_hw_settings.usart_error_source
+#define HW_IC g_hw_settings.input_capture_module
+#define HW_IC_VECTOR g_hw_settings.input_capture_vector
+#define HW_IC_SOURCE g_hw_settings.input_capture_source
+#define HW_IC_TIMER g_hw_settings.input_capture_timer
+#define HW_TIMER g_hw_settings.timer_module_id
+#define HW_TIMER_VECTOR g_hw_settings.timer_vector
+#define HW_TIMER_SOURCE g_hw_settings.timer_source
+#endif
+
 // The timing information for the current operation.
 static TransceiverTiming g_timing;
 
@@ -230,6 +227,39 @@ static TransceiverEventCallback g_rx_callback = NULL;
 // The timing settings
 static TimingSettings g_timing_settings;
 
+// State Functions
+// ----------------------------------------------------------------------------
+/*
+ * @brief Check if a state waits for a timeout, which the tasks poll for.
+ */
+static inline bool HasTimeout(TransceiverState state) {
+  switch (state) {
+    case STATE_C_RX_WAIT_FOR_BREAK:
+    case STATE_C_RX_DATA:
+    case STATE_C_RX_WAIT_FOR_DUB:
+    case STATE_C_BACKOFF:
+    case STATE_R_RX_DATA:
+    case STATE_T_RX_WAIT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/*
+ * @brief Change state, this records the transition in the trace.
+ *
+ * This also posts work, so that Transceiver_Tasks() runs for the new state.
+ */
+static inline void SetState(TransceiverState state) {
+  g_transceiver.state = state;
+  Trace_Record(state, TRACE_EVENT_STATE_CHANGE, g_transceiver.data_index);
+  Scheduler_Post(SCHEDULER_TRANSCEIVER);
+  if (HasTimeout(state)) {
+    Scheduler_DeadlineChanged();
+  }
+}
+
 // Timer Functions
 // ----------------------------------------------------------------------------
 /*
@@ -248,8 +278,8 @@ static inline uint16_t MicroSecondsToTicks(uint16_t micro_seconds) {
  */
 static inline void RebaseTimer(uint16_t last_event) {
   PLIB_TMR_Counter16BitSet(
-      g_hw_settings.timer_module_id,
-      PLIB_TMR_Counter16BitGet(g_hw_settings.timer_module_id) - last_event);
+      HW_TIMER,
+      PLIB_TMR_Counter16BitGet(HW_TIMER) - last_event);
 }
 
 // I/O Functions
@@ -311,18 +341,18 @@ static inline void ResetToMark() {
  * @brief Push data into the UART TX queue.
  */
 static void UART_TXBytes() {
-  while (!PLIB_USART_TransmitterBufferIsFull(g_hw_settings.usart) &&
+  while (!PLIB_USART_TransmitterBufferIsFull(HW_USART) &&
          g_transceiver.data_index != g_transceiver.active->size) {
     PLIB_USART_TransmitterByteSend(
-        g_hw_settings.usart,
+        HW_USART,
         g_transceiver.active->data[g_transceiver.data_index]);
     g_transceiver.data_index++;
   }
 }
 
 void UART_FlushRX() {
-  while (PLIB_USART_ReceiverDataIsAvailable(g_hw_settings.usart)) {
-    PLIB_USART_ReceiverByteReceive(g_hw_settings.usart);
+  while (PLIB_USART_ReceiverDataIsAvailable(HW_USART)) {
+    PLIB_USART_ReceiverByteReceive(HW_USART);
   }
 }
 
@@ -331,10 +361,10 @@ void UART_FlushRX() {
  * @returns true if the RX buffer is now full.
  */
 bool UART_RXBytes() {
-  while (PLIB_USART_ReceiverDataIsAvailable(g_hw_settings.usart) &&
+  while (PLIB_USART_ReceiverDataIsAvailable(HW_USART) &&
          g_transceiver.data_index != BUFFER_SIZE) {
     g_transceiver.active->data[g_transceiver.data_index] =
-        PLIB_USART_ReceiverByteReceive(g_hw_settings.usart);
+        PLIB_USART_ReceiverByteReceive(HW_USART);
     g_transceiver.data_index++;
   }
   if (g_transceiver.active->op == OP_RDM_WITH_RESPONSE ||
@@ -342,9 +372,10 @@ bool UART_RXBytes() {
     if (g_transceiver.found_expected_length) {
       if (g_transceiver.data_index == g_transceiver.expected_length) {
         // We've got enough data to move on
-        PLIB_USART_ReceiverDisable(g_hw_settings.usart);
+        PLIB_TMR_Stop(HW_TIMER);
+        PLIB_USART_ReceiverDisable(HW_USART);
         ResetToMark();
-        g_transceiver.state = STATE_C_COMPLETE;
+        SetState(STATE_C_COMPLETE);
       }
     } else {
       if (g_transceiver.data_index >= 3u) {
@@ -357,8 +388,7 @@ bool UART_RXBytes() {
       }
     }
   }
-  g_transceiver.last_byte = PLIB_TMR_Counter16BitGet(
-      g_hw_settings.timer_module_id);
+  g_transceiver.last_byte = PLIB_TMR_Counter16BitGet(HW_TIMER);
   g_transceiver.last_byte_coarse = CoarseTimer_GetTime();
   return g_transceiver.data_index >= BUFFER_SIZE;
 }
@@ -431,6 +461,12 @@ static inline void RunTXEventHandler(TransceiverEvent *event) {
 }
 
 static inline void RunRXEventHandler(TransceiverEvent *event) {
+#ifdef PIPELINE_TRANSCEIVER_SNIFFER_EVENT
+  if (g_transceiver.mode == T_MODE_SNIFFER) {
+    PIPELINE_TRANSCEIVER_SNIFFER_EVENT(event);
+    return;
+  }
+#endif
 #ifdef PIPELINE_TRANSCEIVER_RX_EVENT
   PIPELINE_TRANSCEIVER_RX_EVENT(event);
 #else
@@ -440,13 +476,20 @@ static inline void RunRXEventHandler(TransceiverEvent *event) {
 #endif
 }
 
+/*
+ * @brief Check if an operation is transmit only.
+ */
+static inline bool IsTXOnly(InternalOperation op) {
+  return op == OP_TX_ONLY || op == OP_TX_DMX_RLE;
+}
+
 /*
  * @brief Run the completion callback.
  */
 static inline void FrameComplete() {
   const uint8_t* data = NULL;
   unsigned int length = 0u;
-  if (g_transceiver.active->op != OP_TX_ONLY &&
+  if (!IsTXOnly(g_transceiver.active->op) &&
       g_transceiver.data_index != 0u) {
     // We actually got some data.
     data = g_transceiver.active->data;
@@ -500,18 +543,25 @@ static inline void RXEndFrameEvent() {
 // ----------------------------------------------------------------------------
 static void SwitchMode() {
   g_transceiver.mode = g_transceiver.desired_mode;
+  // The tasks which run, and so the deadlines, depend on the mode.
+  Scheduler_DeadlineChanged();
   switch (g_transceiver.mode) {
     case T_MODE_CONTROLLER:
       SysLog_Message(SYSLOG_INFO, "Changed to Controller mode");
-      g_transceiver.state = STATE_C_INITIALIZE;
+      SetState(STATE_C_INITIALIZE);
       break;
     case T_MODE_RESPONDER:
       SysLog_Message(SYSLOG_INFO, "Changed to Responder mode");
-      g_transceiver.state = STATE_R_INITIALIZE;
+      SetState(STATE_R_INITIALIZE);
+      break;
+    case T_MODE_SNIFFER:
+      // The sniffer uses the responder RX states, but never transmits.
+      SysLog_Message(SYSLOG_INFO, "Changed to Sniffer mode");
+      SetState(STATE_R_INITIALIZE);
       break;
     case T_MODE_SELF_TEST:
       SysLog_Message(SYSLOG_INFO, "Changed to self-test mode");
-      g_transceiver.state = STATE_T_INITIALIZE;
+      SetState(STATE_T_INITIALIZE);
       break;
     default:
       SysLog_Print(SYSLOG_INFO, "Unknown mode: %d",
@@ -531,6 +581,7 @@ static void SwitchMode() {
     RunTXEventHandler(&event);
   }
   InitializeBuffers();
+  Events_Push(EVENT_MODE_CHANGED, g_transceiver.mode, 0u);
   if (g_transceiver.mode_change_token != TRANSCEIVER_NO_NOTIFICATION) {
     TransceiverEvent event = {
       g_transceiver.mode_change_token,
@@ -548,9 +599,9 @@ static inline void PrepareRDMResponse() {
   // Rebase the timer to when the last byte was received
   RebaseTimer(g_transceiver.last_byte);
 
-  g_transceiver.state = STATE_R_TX_WAITING;
-  PLIB_USART_ReceiverDisable(g_hw_settings.usart);
-  PLIB_USART_TransmitterInterruptModeSelect(g_hw_settings.usart,
+  SetState(STATE_R_TX_WAITING);
+  PLIB_USART_ReceiverDisable(HW_USART);
+  PLIB_USART_TransmitterInterruptModeSelect(HW_USART,
                                             USART_TRANSMIT_FIFO_EMPTY);
 
   TakeNextBuffer();
@@ -561,28 +612,28 @@ static inline void PrepareRDMResponse() {
     jitter = Random_PseudoGet() % g_timing_settings.rdm_responder_jitter;
   }
   // It's important to stop the timer before changing the period, see 14.3.11
-  PLIB_TMR_Stop(g_hw_settings.timer_module_id);
+  PLIB_TMR_Stop(HW_TIMER);
   PLIB_TMR_Period16BitSet(
-      g_hw_settings.timer_module_id,
+      HW_TIMER,
       g_timing_settings.rdm_responder_delay - RESPONSE_FUDGE_FACTOR + jitter);
-  PLIB_TMR_Start(g_hw_settings.timer_module_id);
-  SYS_INT_SourceStatusClear(g_hw_settings.timer_source);
-  SYS_INT_SourceEnable(g_hw_settings.timer_source);
+  PLIB_TMR_Start(HW_TIMER);
+  SYS_INT_SourceStatusClear(HW_TIMER_SOURCE);
+  SYS_INT_SourceEnable(HW_TIMER_SOURCE);
 }
 
 static inline void StartSendingRDMResponse() {
-  PLIB_USART_TransmitterEnable(g_hw_settings.usart);
-  if (!PLIB_USART_TransmitterBufferIsFull(g_hw_settings.usart) &&
+  PLIB_USART_TransmitterEnable(HW_USART);
+  if (!PLIB_USART_TransmitterBufferIsFull(HW_USART) &&
        g_transceiver.data_index != g_transceiver.active->size) {
     PLIB_USART_TransmitterByteSend(
-        g_hw_settings.usart,
+        HW_USART,
         g_transceiver.active->data[g_transceiver.data_index]);
     g_transceiver.data_index++;
   }
-  g_transceiver.state = STATE_R_TX_DATA;
+  SetState(STATE_R_TX_DATA);
 
-  SYS_INT_SourceStatusClear(g_hw_settings.usart_tx_source);
-  SYS_INT_SourceEnable(g_hw_settings.usart_tx_source);
+  SYS_INT_SourceStatusClear(HW_USART_TX_SOURCE);
+  SYS_INT_SourceEnable(HW_USART_TX_SOURCE);
 }
 
 static inline void LogStateChange() {
@@ -614,61 +665,64 @@ static void ResetTimingSettings() {
  */
 void __ISR(AS_IC_ISR_VECTOR(TRANSCEIVER_IC), ipl6AUTO)
     InputCaptureEvent(void) {
-  while (!PLIB_IC_BufferIsEmpty(g_hw_settings.input_capture_module)) {
-    uint16_t value = PLIB_IC_Buffer16BitGet(g_hw_settings.input_capture_module);
+  Trace_Record(g_transceiver.state, TRACE_EVENT_INPUT_CAPTURE,
+               g_transceiver.data_index);
+  Scheduler_Post(SCHEDULER_TRANSCEIVER);
+  while (!PLIB_IC_BufferIsEmpty(HW_IC)) {
+    uint16_t value = PLIB_IC_Buffer16BitGet(HW_IC);
     switch (g_transceiver.state) {
       case STATE_C_RX_WAIT_FOR_DUB:
         g_timing.dub_response.start = value;
-        g_transceiver.state = STATE_C_RX_IN_DUB;
+        SetState(STATE_C_RX_IN_DUB);
         break;
       case STATE_C_RX_IN_DUB:
         g_timing.dub_response.end = value;
         break;
       case STATE_C_RX_WAIT_FOR_BREAK:
         g_timing.get_set_response.break_start = value;
-        g_transceiver.state = STATE_C_RX_IN_BREAK;
+        SetState(STATE_C_RX_IN_BREAK);
         break;
       case STATE_C_RX_IN_BREAK:
         if ((uint16_t) (value - g_timing.get_set_response.break_start) <
             CONTROLLER_RX_BREAK_TIME_MIN) {
           // The break was too short, keep looking for a break
           g_timing.get_set_response.break_start = value;
-          g_transceiver.state = STATE_C_RX_WAIT_FOR_BREAK;
+          SetState(STATE_C_RX_WAIT_FOR_BREAK);
         } else {
           g_timing.get_set_response.mark_start = value;
           // Break was good, enable UART
-          SYS_INT_SourceStatusClear(g_hw_settings.usart_rx_source);
-          SYS_INT_SourceEnable(g_hw_settings.usart_rx_source);
-          SYS_INT_SourceStatusClear(g_hw_settings.usart_error_source);
-          SYS_INT_SourceEnable(g_hw_settings.usart_error_source);
-          PLIB_USART_ReceiverEnable(g_hw_settings.usart);
-          g_transceiver.state = STATE_C_RX_IN_MARK;
+          SYS_INT_SourceStatusClear(HW_USART_RX_SOURCE);
+          SYS_INT_SourceEnable(HW_USART_RX_SOURCE);
+          SYS_INT_SourceStatusClear(HW_USART_ERROR_SOURCE);
+          SYS_INT_SourceEnable(HW_USART_ERROR_SOURCE);
+          PLIB_USART_ReceiverEnable(HW_USART);
+          SetState(STATE_C_RX_IN_MARK);
         }
         break;
       case STATE_C_RX_IN_MARK:
         g_timing.get_set_response.mark_end = value;
-        SYS_INT_SourceDisable(g_hw_settings.input_capture_source);
-        PLIB_IC_Disable(g_hw_settings.input_capture_module);
-        g_transceiver.state = STATE_C_RX_DATA;
+        SYS_INT_SourceDisable(HW_IC_SOURCE);
+        PLIB_IC_Disable(HW_IC);
+        SetState(STATE_C_RX_DATA);
         break;
 
       case STATE_R_RX_MBB:
         // Rebase the timer to when the falling edge occured.
         RebaseTimer(value);
-        g_transceiver.state = STATE_R_RX_BREAK;
+        SetState(STATE_R_RX_BREAK);
         break;
       case STATE_R_RX_BREAK:
         if (value >= RESPONDER_RX_BREAK_TIME_MIN &&
             value <= RESPONDER_RX_BREAK_TIME_MAX) {
           // Break was good, enable UART
           g_timing.request.break_time = value;
-          SYS_INT_SourceStatusClear(g_hw_settings.usart_rx_source);
-          SYS_INT_SourceEnable(g_hw_settings.usart_rx_source);
-          PLIB_USART_ReceiverEnable(g_hw_settings.usart);
-          g_transceiver.state = STATE_R_RX_MARK;
+          SYS_INT_SourceStatusClear(HW_USART_RX_SOURCE);
+          SYS_INT_SourceEnable(HW_USART_RX_SOURCE);
+          PLIB_USART_ReceiverEnable(HW_USART);
+          SetState(STATE_R_RX_MARK);
         } else {
           // Break was out of range.
-          g_transceiver.state = STATE_R_RX_MBB;
+          SetState(STATE_R_RX_MBB);
         }
         break;
       case STATE_R_RX_MARK:
@@ -680,13 +734,13 @@ void __ISR(AS_IC_ISR_VECTOR(TRANSCEIVER_IC), ipl6AUTO)
           RebaseTimer(value);
 
           // Disable UART
-          PLIB_USART_ReceiverDisable(g_hw_settings.usart);
-          SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
-          SYS_INT_SourceStatusClear(g_hw_settings.usart_rx_source);
-          g_transceiver.state = STATE_R_RX_BREAK;
+          PLIB_USART_ReceiverDisable(HW_USART);
+          SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
+          SYS_INT_SourceStatusClear(HW_USART_RX_SOURCE);
+          SetState(STATE_R_RX_BREAK);
         } else {
           g_timing.request.mark_time = value - g_timing.request.break_time;
-          g_transceiver.state = STATE_R_RX_DATA;
+          SetState(STATE_R_RX_DATA);
         }
         g_transceiver.last_change = value;
         break;
@@ -723,7 +777,7 @@ void __ISR(AS_IC_ISR_VECTOR(TRANSCEIVER_IC), ipl6AUTO)
         {};
     }
   }
-  SYS_INT_SourceStatusClear(g_hw_settings.input_capture_source);
+  SYS_INT_SourceStatusClear(HW_IC_SOURCE);
 }
 
 /*
@@ -731,62 +785,61 @@ void __ISR(AS_IC_ISR_VECTOR(TRANSCEIVER_IC), ipl6AUTO)
  */
 void __ISR(AS_TIMER_ISR_VECTOR(TRANSCEIVER_TIMER), ipl6AUTO)
     Transceiver_TimerEvent() {
+  Trace_Record(g_transceiver.state, TRACE_EVENT_TIMER,
+               g_transceiver.data_index);
+  Scheduler_Post(SCHEDULER_TRANSCEIVER);
   switch (g_transceiver.state) {
     case STATE_C_IN_BREAK:
     case STATE_R_TX_BREAK:
       // Transition to MAB.
       SetMark();
-      g_transceiver.state = g_transceiver.state == STATE_C_IN_BREAK ?
-          STATE_C_IN_MARK : STATE_R_TX_MARK;
-      PLIB_TMR_Counter16BitClear(g_hw_settings.timer_module_id);
-      PLIB_TMR_Period16BitSet(g_hw_settings.timer_module_id,
-                              g_timing_settings.mark_ticks);
+      SetState(g_transceiver.state == STATE_C_IN_BREAK ?
+               STATE_C_IN_MARK : STATE_R_TX_MARK);
+      PLIB_TMR_Counter16BitClear(HW_TIMER);
+      PLIB_TMR_Period16BitSet(HW_TIMER, g_timing_settings.mark_ticks);
       break;
     case STATE_C_IN_MARK:
       // Stop the timer.
-      SYS_INT_SourceDisable(g_hw_settings.timer_source);
-      PLIB_TMR_Stop(g_hw_settings.timer_module_id);
+      SYS_INT_SourceDisable(HW_TIMER_SOURCE);
+      PLIB_TMR_Stop(HW_TIMER);
 
       // Transition to sending the data.
       // Only push a single byte into the TX queue at the beginning, otherwise
       // we blow our timing budget.
-      if (!PLIB_USART_TransmitterBufferIsFull(g_hw_settings.usart) &&
+      if (!PLIB_USART_TransmitterBufferIsFull(HW_USART) &&
           g_transceiver.data_index != g_transceiver.active->size) {
         PLIB_USART_TransmitterByteSend(
-            g_hw_settings.usart,
+            HW_USART,
             g_transceiver.active->data[g_transceiver.data_index]);
         g_transceiver.data_index++;
       }
-      PLIB_USART_Enable(g_hw_settings.usart);
-      PLIB_USART_TransmitterEnable(g_hw_settings.usart);
-      g_transceiver.state = STATE_C_TX_DATA;
-      SYS_INT_SourceStatusClear(g_hw_settings.usart_tx_source);
-      SYS_INT_SourceEnable(g_hw_settings.usart_tx_source);
+      PLIB_USART_Enable(HW_USART);
+      PLIB_USART_TransmitterEnable(HW_USART);
+      SetState(STATE_C_TX_DATA);
+      SYS_INT_SourceStatusClear(HW_USART_TX_SOURCE);
+      SYS_INT_SourceEnable(HW_USART_TX_SOURCE);
       break;
     case STATE_R_TX_WAITING:
       EnableTX();
 
       if (g_transceiver.active->op == OP_RDM_WITH_RESPONSE) {
         SetBreak();
-        PLIB_TMR_Stop(g_hw_settings.timer_module_id);
-        PLIB_TMR_PrescaleSelect(g_hw_settings.timer_module_id,
-                                TMR_PRESCALE_VALUE_1);
-        PLIB_TMR_Counter16BitClear(g_hw_settings.timer_module_id);
-        PLIB_TMR_Period16BitSet(g_hw_settings.timer_module_id,
-                                g_timing_settings.break_ticks);
-        PLIB_TMR_Start(g_hw_settings.timer_module_id);
-        g_transceiver.state = STATE_R_TX_BREAK;
+        PLIB_TMR_Stop(HW_TIMER);
+        PLIB_TMR_PrescaleSelect(HW_TIMER, TMR_PRESCALE_VALUE_1);
+        PLIB_TMR_Counter16BitClear(HW_TIMER);
+        PLIB_TMR_Period16BitSet(HW_TIMER, g_timing_settings.break_ticks);
+        PLIB_TMR_Start(HW_TIMER);
+        SetState(STATE_R_TX_BREAK);
       } else {
-        SYS_INT_SourceDisable(g_hw_settings.timer_source);
+        SYS_INT_SourceDisable(HW_TIMER_SOURCE);
         StartSendingRDMResponse();
       }
       break;
     case STATE_R_TX_MARK:
-      SYS_INT_SourceDisable(g_hw_settings.timer_source);
-      PLIB_TMR_Stop(g_hw_settings.timer_module_id);
-      PLIB_TMR_PrescaleSelect(g_hw_settings.timer_module_id,
-                              TMR_PRESCALE_VALUE_8);
-      PLIB_TMR_Start(g_hw_settings.timer_module_id);
+      SYS_INT_SourceDisable(HW_TIMER_SOURCE);
+      PLIB_TMR_Stop(HW_TIMER);
+      PLIB_TMR_PrescaleSelect(HW_TIMER, TMR_PRESCALE_VALUE_8);
+      PLIB_TMR_Start(HW_TIMER);
 
       StartSendingRDMResponse();
       break;
@@ -821,7 +874,7 @@ void __ISR(AS_TIMER_ISR_VECTOR(TRANSCEIVER_TIMER), ipl6AUTO)
       // Should never happen
       {}
   }
-  SYS_INT_SourceStatusClear(g_hw_settings.timer_source);
+  SYS_INT_SourceStatusClear(HW_TIMER_SOURCE);
 }
 
 /*
@@ -834,102 +887,103 @@ void __ISR(AS_TIMER_ISR_VECTOR(TRANSCEIVER_TIMER), ipl6AUTO)
  */
 void __ISR(AS_USART_ISR_VECTOR(TRANSCEIVER_UART), ipl6AUTO)
     Transceiver_UARTEvent() {
+  Trace_Record(g_transceiver.state, TRACE_EVENT_UART,
+               g_transceiver.data_index);
+  // Bytes received in STATE_R_RX_DATA don't change the state, but the tasks
+  // still need to run to pass the data to the responder.
+  Scheduler_Post(SCHEDULER_TRANSCEIVER);
   // TX
-  if (SYS_INT_SourceStatusGet(g_hw_settings.usart_tx_source)) {
+  if (SYS_INT_SourceStatusGet(HW_USART_TX_SOURCE)) {
     if (g_transceiver.state == STATE_C_TX_DATA) {
       UART_TXBytes();
       if (g_transceiver.data_index == g_transceiver.active->size) {
         PLIB_USART_TransmitterInterruptModeSelect(
-            g_hw_settings.usart, USART_TRANSMIT_FIFO_IDLE);
-        g_transceiver.state = STATE_C_TX_DRAIN;
+            HW_USART, USART_TRANSMIT_FIFO_IDLE);
+        SetState(STATE_C_TX_DRAIN);
       }
     } else if (g_transceiver.state == STATE_C_TX_DRAIN) {
       // The last byte has been transmitted. This event occurs around 1.5us
       // after the actual UART event, so we use a fudge factor.
-      PLIB_TMR_Counter16BitSet(g_hw_settings.timer_module_id,
-                               RESPONSE_TIME_RX_FUDGE_FACTOR);
+      PLIB_TMR_Counter16BitSet(HW_TIMER, RESPONSE_TIME_RX_FUDGE_FACTOR);
       // 6.5 ms until overflow.
-      PLIB_TMR_Period16BitSet(g_hw_settings.timer_module_id, 65535u);
-      PLIB_TMR_PrescaleSelect(g_hw_settings.timer_module_id,
-                              TMR_PRESCALE_VALUE_8);
-      PLIB_TMR_Start(g_hw_settings.timer_module_id);
+      PLIB_TMR_Period16BitSet(HW_TIMER, 65535u);
+      PLIB_TMR_PrescaleSelect(HW_TIMER, TMR_PRESCALE_VALUE_8);
+      PLIB_TMR_Start(HW_TIMER);
 
       g_transceiver.tx_frame_end = CoarseTimer_GetTime();
-      SYS_INT_SourceDisable(g_hw_settings.usart_tx_source);
-      PLIB_USART_TransmitterDisable(g_hw_settings.usart);
+      SYS_INT_SourceDisable(HW_USART_TX_SOURCE);
+      PLIB_USART_TransmitterDisable(HW_USART);
 
-      if (g_transceiver.active->op == OP_TX_ONLY) {
-        PLIB_USART_Disable(g_hw_settings.usart);
+      if (IsTXOnly(g_transceiver.active->op)) {
+        PLIB_USART_Disable(HW_USART);
         SetMark();
-        PLIB_TMR_Stop(g_hw_settings.timer_module_id);
-        g_transceiver.state = STATE_C_COMPLETE;
+        PLIB_TMR_Stop(HW_TIMER);
+        SetState(STATE_C_COMPLETE);
       } else {
         // Switch to RX Mode.
         if (g_transceiver.active->op == OP_RDM_DUB) {
-          g_transceiver.state = STATE_C_RX_WAIT_FOR_DUB;
+          SetState(STATE_C_RX_WAIT_FOR_DUB);
           g_transceiver.data_index = 0u;
 
           // Turn around the line
           EnableRX();
           UART_FlushRX();
 
-          PLIB_IC_FirstCaptureEdgeSelect(g_hw_settings.input_capture_module,
-                                         IC_EDGE_FALLING);
-          PLIB_IC_Enable(g_hw_settings.input_capture_module);
-          SYS_INT_SourceStatusClear(g_hw_settings.input_capture_source);
-          SYS_INT_SourceEnable(g_hw_settings.input_capture_source);
+          PLIB_IC_FirstCaptureEdgeSelect(HW_IC, IC_EDGE_FALLING);
+          PLIB_IC_Enable(HW_IC);
+          SYS_INT_SourceStatusClear(HW_IC_SOURCE);
+          SYS_INT_SourceEnable(HW_IC_SOURCE);
 
-          PLIB_USART_ReceiverEnable(g_hw_settings.usart);
-          SYS_INT_SourceStatusClear(g_hw_settings.usart_rx_source);
-          SYS_INT_SourceEnable(g_hw_settings.usart_rx_source);
-          SYS_INT_SourceStatusClear(g_hw_settings.usart_error_source);
-          SYS_INT_SourceEnable(g_hw_settings.usart_error_source);
+          PLIB_USART_ReceiverEnable(HW_USART);
+          SYS_INT_SourceStatusClear(HW_USART_RX_SOURCE);
+          SYS_INT_SourceEnable(HW_USART_RX_SOURCE);
+          SYS_INT_SourceStatusClear(HW_USART_ERROR_SOURCE);
+          SYS_INT_SourceEnable(HW_USART_ERROR_SOURCE);
 
         } else if (g_transceiver.active->op == OP_RDM_BROADCAST &&
                    g_timing_settings.rdm_broadcast_timeout == 0u) {
           // Go directly to the complete state.
-          PLIB_TMR_Stop(g_hw_settings.timer_module_id);
+          PLIB_TMR_Stop(HW_TIMER);
           g_transceiver.data_index = 0u;
-          g_transceiver.state = STATE_C_COMPLETE;
+          SetState(STATE_C_COMPLETE);
         } else {
           // Either T_OP_RDM_WITH_RESPONSE or a non-0 broadcast listen time.
           g_transceiver.rdm_response_timeout = (
               g_transceiver.active->op == OP_RDM_BROADCAST ?
               g_timing_settings.rdm_broadcast_timeout :
               g_timing_settings.rdm_response_timeout);
-          g_transceiver.state = STATE_C_RX_WAIT_FOR_BREAK;
+          SetState(STATE_C_RX_WAIT_FOR_BREAK);
           g_transceiver.data_index = 0u;
 
           EnableRX();
           UART_FlushRX();
 
-          PLIB_IC_FirstCaptureEdgeSelect(g_hw_settings.input_capture_module,
-                                         IC_EDGE_FALLING);
-          PLIB_IC_Enable(g_hw_settings.input_capture_module);
-          SYS_INT_SourceStatusClear(g_hw_settings.input_capture_source);
-          SYS_INT_SourceEnable(g_hw_settings.input_capture_source);
+          PLIB_IC_FirstCaptureEdgeSelect(HW_IC, IC_EDGE_FALLING);
+          PLIB_IC_Enable(HW_IC);
+          SYS_INT_SourceStatusClear(HW_IC_SOURCE);
+          SYS_INT_SourceEnable(HW_IC_SOURCE);
         }
       }
     } else if (g_transceiver.state == STATE_R_TX_DATA) {
       UART_TXBytes();
       if (g_transceiver.data_index == g_transceiver.active->size) {
         PLIB_USART_TransmitterInterruptModeSelect(
-            g_hw_settings.usart, USART_TRANSMIT_FIFO_IDLE);
-        g_transceiver.state = STATE_R_TX_DRAIN;
+            HW_USART, USART_TRANSMIT_FIFO_IDLE);
+        SetState(STATE_R_TX_DRAIN);
       }
     } else if (g_transceiver.state == STATE_R_TX_DRAIN) {
       EnableRX();
-      SYS_INT_SourceDisable(g_hw_settings.usart_tx_source);
-      PLIB_USART_TransmitterDisable(g_hw_settings.usart);
-      g_transceiver.state = STATE_R_TX_COMPLETE;
+      SYS_INT_SourceDisable(HW_USART_TX_SOURCE);
+      PLIB_USART_TransmitterDisable(HW_USART);
+      SetState(STATE_R_TX_COMPLETE);
     } else if (g_transceiver.state == STATE_T_RX_WAIT) {
-      PLIB_USART_TransmitterDisable(g_hw_settings.usart);
+      PLIB_USART_TransmitterDisable(HW_USART);
     }
-    SYS_INT_SourceStatusClear(g_hw_settings.usart_tx_source);
+    SYS_INT_SourceStatusClear(HW_USART_TX_SOURCE);
   }
 
   // RX
-  if (SYS_INT_SourceStatusGet(g_hw_settings.usart_rx_source)) {
+  if (SYS_INT_SourceStatusGet(HW_USART_RX_SOURCE)) {
     if (g_transceiver.state == STATE_C_RX_IN_DUB ||
         g_transceiver.state == STATE_C_RX_DATA) {
       // For the DUB case, It's impossible to overflow the buffer here, because
@@ -941,60 +995,60 @@ void __ISR(AS_USART_ISR_VECTOR(TRANSCEIVER_UART), ipl6AUTO)
      if (UART_RXBytes()) {
        // Protect against a responder sending us more than 512 bytes of data.
        // The maximum RDM frame size is 257 so this *should* never happen.
-       PLIB_TMR_Stop(g_hw_settings.timer_module_id);
-       SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
-       SYS_INT_SourceDisable(g_hw_settings.usart_error_source);
-       PLIB_USART_ReceiverDisable(g_hw_settings.usart);
+       PLIB_TMR_Stop(HW_TIMER);
+       SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
+       SYS_INT_SourceDisable(HW_USART_ERROR_SOURCE);
+       PLIB_USART_ReceiverDisable(HW_USART);
        ResetToMark();
-       g_transceiver.state = STATE_C_COMPLETE;
+       SetState(STATE_C_COMPLETE);
      }
     } else if (g_transceiver.state == STATE_R_RX_DATA) {
-      if (PLIB_USART_ErrorsGet(g_hw_settings.usart) & USART_ERROR_FRAMING) {
+      if (PLIB_USART_ErrorsGet(HW_USART) & USART_ERROR_FRAMING) {
         // A framing error indicates a possible break.
         // Switch out of RX mode and back into the break state.
-        SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
+        SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
         UART_FlushRX();
-        PLIB_USART_ReceiverDisable(g_hw_settings.usart);
+        PLIB_USART_ReceiverDisable(HW_USART);
         RebaseTimer(g_transceiver.last_change);
         g_transceiver.data_index = 0u;
         g_transceiver.event_index = 0u;
-        g_transceiver.state = STATE_R_RX_BREAK;
+        SetState(STATE_R_RX_BREAK);
       } else if (UART_RXBytes()) {
         // RX buffer is full.
-        SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
-        SYS_INT_SourceDisable(g_hw_settings.usart_error_source);
-        PLIB_USART_ReceiverDisable(g_hw_settings.usart);
-        g_transceiver.state = STATE_R_TX_COMPLETE;
+        SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
+        SYS_INT_SourceDisable(HW_USART_ERROR_SOURCE);
+        PLIB_USART_ReceiverDisable(HW_USART);
+        SetState(STATE_R_TX_COMPLETE);
       }
     } else if (g_transceiver.state == STATE_T_RX_WAIT) {
       UART_RXBytes();
-      g_transceiver.state = STATE_T_VERIFY;
+      SetState(STATE_T_VERIFY);
     }
-    SYS_INT_SourceStatusClear(g_hw_settings.usart_rx_source);
+    SYS_INT_SourceStatusClear(HW_USART_RX_SOURCE);
   }
 
   // Error
-  if (SYS_INT_SourceStatusGet(g_hw_settings.usart_error_source)) {
+  if (SYS_INT_SourceStatusGet(HW_USART_ERROR_SOURCE)) {
     switch (g_transceiver.state) {
       case STATE_C_RX_IN_DUB:
-        SYS_INT_SourceDisable(g_hw_settings.input_capture_source);
-        PLIB_IC_Disable(g_hw_settings.input_capture_module);
+        SYS_INT_SourceDisable(HW_IC_SOURCE);
+        PLIB_IC_Disable(HW_IC);
         // Fall through
       case STATE_C_RX_DATA:
-        PLIB_TMR_Stop(g_hw_settings.timer_module_id);
-        SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
-        SYS_INT_SourceDisable(g_hw_settings.usart_error_source);
-        PLIB_USART_ReceiverDisable(g_hw_settings.usart);
+        PLIB_TMR_Stop(HW_TIMER);
+        SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
+        SYS_INT_SourceDisable(HW_USART_ERROR_SOURCE);
+        PLIB_USART_ReceiverDisable(HW_USART);
         ResetToMark();
-        g_transceiver.state = STATE_C_COMPLETE;
+        SetState(STATE_C_COMPLETE);
         break;
       case STATE_R_RX_DATA:
         // This is probably a new break
-        SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
-        SYS_INT_SourceDisable(g_hw_settings.usart_error_source);
-        PLIB_USART_ReceiverDisable(g_hw_settings.usart);
+        SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
+        SYS_INT_SourceDisable(HW_USART_ERROR_SOURCE);
+        PLIB_USART_ReceiverDisable(HW_USART);
         RebaseTimer(g_transceiver.last_change);
-        g_transceiver.state = STATE_R_RX_BREAK;
+        SetState(STATE_R_RX_BREAK);
         break;
 
       case STATE_C_INITIALIZE:
@@ -1030,7 +1084,7 @@ void __ISR(AS_USART_ISR_VECTOR(TRANSCEIVER_UART), ipl6AUTO)
         // Should never happen.
         {}
     }
-    SYS_INT_SourceStatusClear(g_hw_settings.usart_error_source);
+    SYS_INT_SourceStatusClear(HW_USART_ERROR_SOURCE);
   }
 }
 
@@ -1043,7 +1097,7 @@ void Transceiver_Initialize(const TransceiverHardwareSettings* settings,
   g_tx_callback = tx_callback;
   g_rx_callback = rx_callback;
 
-  g_transceiver.state = STATE_R_INITIALIZE;
+  SetState(STATE_R_INITIALIZE);
   g_transceiver.mode = T_MODE_RESPONDER;
   g_transceiver.desired_mode = T_MODE_RESPONDER;
   g_transceiver.data_index = 0u;
@@ -1064,49 +1118,36 @@ void Transceiver_Initialize(const TransceiverHardwareSettings* settings,
                                    g_hw_settings.rx_enable_bit);
 
   // Setup the timer
-  PLIB_TMR_ClockSourceSelect(g_hw_settings.timer_module_id,
-                             TMR_CLOCK_SOURCE_PERIPHERAL_CLOCK);
-  PLIB_TMR_PrescaleSelect(g_hw_settings.timer_module_id, TMR_PRESCALE_VALUE_1);
-  PLIB_TMR_Mode16BitEnable(g_hw_settings.timer_module_id);
-  SYS_INT_VectorPrioritySet(g_hw_settings.timer_vector, INT_PRIORITY_LEVEL1);
-  SYS_INT_VectorSubprioritySet(g_hw_settings.timer_vector,
-                               INT_SUBPRIORITY_LEVEL0);
+  PLIB_TMR_ClockSourceSelect(HW_TIMER, TMR_CLOCK_SOURCE_PERIPHERAL_CLOCK);
+  PLIB_TMR_PrescaleSelect(HW_TIMER, TMR_PRESCALE_VALUE_1);
+  PLIB_TMR_Mode16BitEnable(HW_TIMER);
+  SYS_INT_VectorPrioritySet(HW_TIMER_VECTOR, INT_PRIORITY_LEVEL1);
+  SYS_INT_VectorSubprioritySet(HW_TIMER_VECTOR, INT_SUBPRIORITY_LEVEL0);
 
   // Setup the UART
-  PLIB_USART_BaudRateSet(g_hw_settings.usart,
+  PLIB_USART_BaudRateSet(HW_USART,
                          SYS_CLK_PeripheralFrequencyGet(CLK_BUS_PERIPHERAL_1),
                          DMX_BAUD);
-  PLIB_USART_HandshakeModeSelect(g_hw_settings.usart,
-                                 USART_HANDSHAKE_MODE_SIMPLEX);
-  PLIB_USART_OperationModeSelect(g_hw_settings.usart,
-                                 USART_ENABLE_TX_RX_USED);
-  PLIB_USART_LineControlModeSelect(g_hw_settings.usart, USART_8N2);
-  PLIB_USART_TransmitterInterruptModeSelect(g_hw_settings.usart,
+  PLIB_USART_HandshakeModeSelect(HW_USART, USART_HANDSHAKE_MODE_SIMPLEX);
+  PLIB_USART_OperationModeSelect(HW_USART, USART_ENABLE_TX_RX_USED);
+  PLIB_USART_LineControlModeSelect(HW_USART, USART_8N2);
+  PLIB_USART_TransmitterInterruptModeSelect(HW_USART,
                                             USART_TRANSMIT_FIFO_EMPTY);
 
-  SYS_INT_VectorPrioritySet(g_hw_settings.usart_vector,
-                            INT_PRIORITY_LEVEL6);
-  SYS_INT_VectorSubprioritySet(g_hw_settings.usart_vector,
-                               INT_SUBPRIORITY_LEVEL0);
-  SYS_INT_SourceStatusClear(g_hw_settings.usart_tx_source);
+  SYS_INT_VectorPrioritySet(HW_USART_VECTOR, INT_PRIORITY_LEVEL6);
+  SYS_INT_VectorSubprioritySet(HW_USART_VECTOR, INT_SUBPRIORITY_LEVEL0);
+  SYS_INT_SourceStatusClear(HW_USART_TX_SOURCE);
 
   // Setup input capture
-  PLIB_IC_Disable(g_hw_settings.input_capture_module);
-  PLIB_IC_ModeSelect(g_hw_settings.input_capture_module,
-                     IC_INPUT_CAPTURE_EVERY_EDGE_MODE);
-  PLIB_IC_FirstCaptureEdgeSelect(g_hw_settings.input_capture_module,
-                                 IC_EDGE_RISING);
-  PLIB_IC_TimerSelect(g_hw_settings.input_capture_module,
-                      g_hw_settings.input_capture_timer);
-  PLIB_IC_BufferSizeSelect(g_hw_settings.input_capture_module,
-                           IC_BUFFER_SIZE_16BIT);
-  PLIB_IC_EventsPerInterruptSelect(g_hw_settings.input_capture_module,
-                                   IC_INTERRUPT_ON_EVERY_CAPTURE_EVENT);
-
-  SYS_INT_VectorPrioritySet(g_hw_settings.input_capture_vector,
-                            INT_PRIORITY_LEVEL6);
-  SYS_INT_VectorSubprioritySet(g_hw_settings.input_capture_vector,
-                               INT_SUBPRIORITY_LEVEL0);
+  PLIB_IC_Disable(HW_IC);
+  PLIB_IC_ModeSelect(HW_IC, IC_INPUT_CAPTURE_EVERY_EDGE_MODE);
+  PLIB_IC_FirstCaptureEdgeSelect(HW_IC, IC_EDGE_RISING);
+  PLIB_IC_TimerSelect(HW_IC, HW_IC_TIMER);
+  PLIB_IC_BufferSizeSelect(HW_IC, IC_BUFFER_SIZE_16BIT);
+  PLIB_IC_EventsPerInterruptSelect(HW_IC, IC_INTERRUPT_ON_EVERY_CAPTURE_EVENT);
+
+  SYS_INT_VectorPrioritySet(HW_IC_VECTOR, INT_PRIORITY_LEVEL6);
+  SYS_INT_VectorSubprioritySet(HW_IC_VECTOR, INT_SUBPRIORITY_LEVEL0);
 }
 
 bool Transceiver_SetMode(TransceiverMode mode, int16_t token) {
@@ -1126,6 +1167,9 @@ bool Transceiver_SetMode(TransceiverMode mode, int16_t token) {
     case T_MODE_RESPONDER:
       SysLog_Message(SYSLOG_INFO, "Switching to Responder mode");
       break;
+    case T_MODE_SNIFFER:
+      SysLog_Message(SYSLOG_INFO, "Switching to Sniffer mode");
+      break;
     case T_MODE_SELF_TEST:
       SysLog_Message(SYSLOG_INFO, "Switching to self-test mode");
       break;
@@ -1135,6 +1179,7 @@ bool Transceiver_SetMode(TransceiverMode mode, int16_t token) {
   }
   g_transceiver.desired_mode = mode;
   g_transceiver.mode_change_token = token;
+  Scheduler_Post(SCHEDULER_TRANSCEIVER);
   return true;
 }
 
@@ -1142,20 +1187,47 @@ TransceiverMode Transceiver_GetMode() {
   return g_transceiver.mode;
 }
 
+uint8_t Transceiver_FreeSlots() {
+  // This must match the checks in ReserveNextBuffer().
+  if (g_transceiver.free_size == 0u || g_transceiver.next ||
+      (g_transceiver.mode != T_MODE_CONTROLLER &&
+       g_transceiver.mode != T_MODE_SELF_TEST)) {
+    return 0u;
+  }
+  return 1u;
+}
+
+bool Transceiver_NextDeadline(uint32_t *delay) {
+  if (!HasTimeout(g_transceiver.state)) {
+    return false;
+  }
+  // The timeouts are at most a few ms.
+  *delay = 1u;
+  return true;
+}
+
 void Transceiver_Tasks() {
   bool ok;
   LogStateChange();
 
+  if (g_transceiver.state == STATE_C_RX_IN_BREAK ||
+      g_transceiver.state == STATE_C_RX_IN_MARK ||
+      g_transceiver.state == STATE_C_RX_IN_DUB) {
+    // These states poll the hardware timer for the end of the break, mark or
+    // DUB response, so keep the tasks running until the state changes.
+    Scheduler_Post(SCHEDULER_TRANSCEIVER);
+  }
+
   switch (g_transceiver.state) {
     // Controller States
     case STATE_C_INITIALIZE:
-      PLIB_TMR_Stop(g_hw_settings.timer_module_id);
-      PLIB_USART_ReceiverDisable(g_hw_settings.usart);
-      PLIB_USART_TransmitterDisable(g_hw_settings.usart);
-      PLIB_USART_Disable(g_hw_settings.usart);
-      PLIB_IC_Disable(g_hw_settings.input_capture_module);
+      PLIB_TMR_Stop(HW_TIMER);
+      PLIB_USART_ReceiverDisable(HW_USART);
+      PLIB_USART_TransmitterDisable(HW_USART);
+      PLIB_USART_Disable(HW_USART);
+      PLIB_IC_Disable(HW_IC);
       ResetToMark();
-      g_transceiver.state = STATE_C_TX_READY;
+      SetState(STATE_C_TX_READY);
       // Fall through
     case STATE_C_TX_READY:
       if (g_transceiver.desired_mode != T_MODE_CONTROLLER) {
@@ -1183,21 +1255,19 @@ void Transceiver_Tasks() {
 
       // Prepare the UART
       // Set UART Interrupts when the buffer is empty.
-      PLIB_USART_TransmitterInterruptModeSelect(g_hw_settings.usart,
+      PLIB_USART_TransmitterInterruptModeSelect(HW_USART,
                                                 USART_TRANSMIT_FIFO_EMPTY);
 
       // Set break and start timer.
-      g_transceiver.state = STATE_C_IN_BREAK;
-      PLIB_TMR_PrescaleSelect(g_hw_settings.timer_module_id,
-                              TMR_PRESCALE_VALUE_1);
+      SetState(STATE_C_IN_BREAK);
+      PLIB_TMR_PrescaleSelect(HW_TIMER, TMR_PRESCALE_VALUE_1);
       g_transceiver.tx_frame_start = CoarseTimer_GetTime();
-      PLIB_TMR_Counter16BitClear(g_hw_settings.timer_module_id);
-      PLIB_TMR_Period16BitSet(g_hw_settings.timer_module_id,
-                              g_timing_settings.break_ticks);
-      SYS_INT_SourceStatusClear(g_hw_settings.timer_source);
-      SYS_INT_SourceEnable(g_hw_settings.timer_source);
+      PLIB_TMR_Counter16BitClear(HW_TIMER);
+      PLIB_TMR_Period16BitSet(HW_TIMER, g_timing_settings.break_ticks);
+      SYS_INT_SourceStatusClear(HW_TIMER_SOURCE);
+      SYS_INT_SourceEnable(HW_TIMER_SOURCE);
       SetBreak();
-      PLIB_TMR_Start(g_hw_settings.timer_module_id);
+      PLIB_TMR_Start(HW_TIMER);
 
     case STATE_C_IN_BREAK:
     case STATE_C_IN_MARK:
@@ -1211,50 +1281,50 @@ void Transceiver_Tasks() {
     case STATE_C_RX_WAIT_FOR_BREAK:
       if (CoarseTimer_HasElapsed(g_transceiver.tx_frame_end,
                                  g_transceiver.rdm_response_timeout)) {
-        SYS_INT_SourceDisable(g_hw_settings.input_capture_source);
+        SYS_INT_SourceDisable(HW_IC_SOURCE);
         // Note: the IC ISR may have run between the case check and the
         // SourceDisable and switched us to STATE_C_RX_IN_BREAK.
-        SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
-        SYS_INT_SourceDisable(g_hw_settings.usart_error_source);
-        PLIB_IC_Disable(g_hw_settings.input_capture_module);
-        PLIB_TMR_Stop(g_hw_settings.timer_module_id);
-        PLIB_USART_ReceiverDisable(g_hw_settings.usart);
+        SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
+        SYS_INT_SourceDisable(HW_USART_ERROR_SOURCE);
+        PLIB_IC_Disable(HW_IC);
+        PLIB_TMR_Stop(HW_TIMER);
+        PLIB_USART_ReceiverDisable(HW_USART);
         ResetToMark();
-        g_transceiver.state = STATE_C_RX_TIMEOUT;
+        SetState(STATE_C_RX_TIMEOUT);
       }
       break;
 
     case STATE_C_RX_IN_BREAK:
       // Disable interupts so we don't race
-      SYS_INT_SourceDisable(g_hw_settings.input_capture_source);
+      SYS_INT_SourceDisable(HW_IC_SOURCE);
       if (g_transceiver.state == STATE_C_RX_IN_BREAK &&
-          ((uint16_t) (PLIB_TMR_Counter16BitGet(g_hw_settings.timer_module_id) -
+          ((uint16_t) (PLIB_TMR_Counter16BitGet(HW_TIMER) -
             g_timing.get_set_response.break_start) >
             CONTROLLER_RX_BREAK_TIME_MAX)) {
         // Break was too long
         g_transceiver.result = T_RESULT_RX_INVALID;
-        PLIB_TMR_Stop(g_hw_settings.timer_module_id);
+        PLIB_TMR_Stop(HW_TIMER);
         ResetToMark();
-        g_transceiver.state = STATE_C_COMPLETE;
+        SetState(STATE_C_COMPLETE);
         return;
       }
-      SYS_INT_SourceEnable(g_hw_settings.input_capture_source);
+      SYS_INT_SourceEnable(HW_IC_SOURCE);
       break;
 
     case STATE_C_RX_IN_MARK:
-      SYS_INT_SourceDisable(g_hw_settings.input_capture_source);
+      SYS_INT_SourceDisable(HW_IC_SOURCE);
       if (g_transceiver.state == STATE_C_RX_IN_MARK &&
-          ((uint16_t) (PLIB_TMR_Counter16BitGet(g_hw_settings.timer_module_id) -
+          ((uint16_t) (PLIB_TMR_Counter16BitGet(HW_TIMER) -
             g_timing.get_set_response.mark_start) >
             CONTROLLER_RX_MARK_TIME_MAX)) {
         // Break was too long
         g_transceiver.result = T_RESULT_RX_INVALID;
-        PLIB_TMR_Stop(g_hw_settings.timer_module_id);
+        PLIB_TMR_Stop(HW_TIMER);
         ResetToMark();
-        g_transceiver.state = STATE_C_COMPLETE;
+        SetState(STATE_C_COMPLETE);
         return;
       }
-      SYS_INT_SourceEnable(g_hw_settings.input_capture_source);
+      SYS_INT_SourceEnable(HW_IC_SOURCE);
       break;
 
     case STATE_C_RX_DATA:
@@ -1270,58 +1340,58 @@ void Transceiver_Tasks() {
       //
       // With an inter-slot timeout of 2.1ms and a buffer size of 512, a single
       // responder can block us for up to 1.04s.
-      SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
-      SYS_INT_SourceDisable(g_hw_settings.usart_error_source);
+      SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
+      SYS_INT_SourceDisable(HW_USART_ERROR_SOURCE);
       if (g_transceiver.data_index > 0 &&
           CoarseTimer_HasElapsed(g_transceiver.last_byte_coarse,
                                  CONTROLLER_RECEIVE_RDM_INTERSLOT_TIMEOUT)) {
-        PLIB_TMR_Stop(g_hw_settings.timer_module_id);
-        PLIB_USART_ReceiverDisable(g_hw_settings.usart);
+        PLIB_TMR_Stop(HW_TIMER);
+        PLIB_USART_ReceiverDisable(HW_USART);
         ResetToMark();
-        g_transceiver.state = STATE_C_COMPLETE;
+        SetState(STATE_C_COMPLETE);
         return;
       }
-      SYS_INT_SourceEnable(g_hw_settings.usart_rx_source);
-      SYS_INT_SourceEnable(g_hw_settings.usart_error_source);
+      SYS_INT_SourceEnable(HW_USART_RX_SOURCE);
+      SYS_INT_SourceEnable(HW_USART_ERROR_SOURCE);
       break;
 
     case STATE_C_RX_WAIT_FOR_DUB:
       if (CoarseTimer_HasElapsed(g_transceiver.tx_frame_end,
                                  g_timing_settings.rdm_response_timeout)) {
-        SYS_INT_SourceDisable(g_hw_settings.input_capture_source);
+        SYS_INT_SourceDisable(HW_IC_SOURCE);
         // Note: the IC ISR may have run between the case check and the
         // SourceDisable and switched us to STATE_C_RX_IN_DUB.
-        SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
-        SYS_INT_SourceDisable(g_hw_settings.usart_error_source);
-        PLIB_IC_Disable(g_hw_settings.input_capture_module);
-        PLIB_USART_ReceiverDisable(g_hw_settings.usart);
-        PLIB_TMR_Stop(g_hw_settings.timer_module_id);
+        SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
+        SYS_INT_SourceDisable(HW_USART_ERROR_SOURCE);
+        PLIB_IC_Disable(HW_IC);
+        PLIB_USART_ReceiverDisable(HW_USART);
+        PLIB_TMR_Stop(HW_TIMER);
         ResetToMark();
-        g_transceiver.state = STATE_C_RX_TIMEOUT;
+        SetState(STATE_C_RX_TIMEOUT);
       }
       break;
     case STATE_C_RX_IN_DUB:
-      if ((uint16_t) (PLIB_TMR_Counter16BitGet(g_hw_settings.timer_module_id) -
+      if ((uint16_t) (PLIB_TMR_Counter16BitGet(HW_TIMER) -
                       g_timing.dub_response.start) >
            g_timing_settings.rdm_dub_response_limit) {
         // The UART Error interupt may have fired, putting us into
         // STATE_C_COMPLETE, already.
-        SYS_INT_SourceDisable(g_hw_settings.input_capture_source);
-        SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
-        SYS_INT_SourceDisable(g_hw_settings.usart_error_source);
-        PLIB_IC_Disable(g_hw_settings.input_capture_module);
-        PLIB_USART_ReceiverDisable(g_hw_settings.usart);
-        PLIB_TMR_Stop(g_hw_settings.timer_module_id);
+        SYS_INT_SourceDisable(HW_IC_SOURCE);
+        SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
+        SYS_INT_SourceDisable(HW_USART_ERROR_SOURCE);
+        PLIB_IC_Disable(HW_IC);
+        PLIB_USART_ReceiverDisable(HW_USART);
+        PLIB_TMR_Stop(HW_TIMER);
         ResetToMark();
         // We got at least a falling edge, so this should probably be
         // considered a collision, rather than a timeout.
-        g_transceiver.state = STATE_C_COMPLETE;
+        SetState(STATE_C_COMPLETE);
       }
       break;
 
     case STATE_C_RX_TIMEOUT:
       SysLog_Message(SYSLOG_INFO, "RX timeout");
-      g_transceiver.state = STATE_C_COMPLETE;
+      SetState(STATE_C_COMPLETE);
       g_transceiver.result = T_RESULT_RX_TIMEOUT;
       break;
     case STATE_C_COMPLETE:
@@ -1342,7 +1412,7 @@ void Transceiver_Tasks() {
                       g_timing.get_set_response.mark_start));
       }
       FrameComplete();
-      g_transceiver.state = STATE_C_BACKOFF;
+      SetState(STATE_C_BACKOFF);
       // Fall through
     case STATE_C_BACKOFF:
       // From E1.11, the min break-to-break time is 1.204ms.
@@ -1357,6 +1427,7 @@ void Transceiver_Tasks() {
 
       switch (g_transceiver.active->op) {
         case OP_TX_ONLY:
+        case OP_TX_DMX_RLE:
           // 176uS min, rounds to 0.2ms.
           ok &= CoarseTimer_HasElapsed(g_transceiver.tx_frame_end,
                                        CONTROLLER_NON_RDM_BACKOFF);
@@ -1389,7 +1460,7 @@ void Transceiver_Tasks() {
 
       if (ok) {
         FreeActiveBuffer();
-        g_transceiver.state = STATE_C_TX_READY;
+        SetState(STATE_C_TX_READY);
       }
       break;
 
@@ -1397,21 +1468,20 @@ void Transceiver_Tasks() {
     case STATE_R_INITIALIZE:
       // This is done once when we switch to Responder mode
       // Reset the UART
-      PLIB_USART_ReceiverDisable(g_hw_settings.usart);
-      PLIB_USART_TransmitterDisable(g_hw_settings.usart);
-      PLIB_USART_Enable(g_hw_settings.usart);
+      PLIB_USART_ReceiverDisable(HW_USART);
+      PLIB_USART_TransmitterDisable(HW_USART);
+      PLIB_USART_Enable(HW_USART);
       UART_FlushRX();
 
       // Put us into RX mode
       EnableRX();
 
       // Setup the timer
-      PLIB_TMR_Counter16BitClear(g_hw_settings.timer_module_id);
+      PLIB_TMR_Counter16BitClear(HW_TIMER);
       // 6.5 ms until overflow.
-      PLIB_TMR_Period16BitSet(g_hw_settings.timer_module_id, 65535);
-      PLIB_TMR_PrescaleSelect(g_hw_settings.timer_module_id,
-                              TMR_PRESCALE_VALUE_8);
-      PLIB_TMR_Start(g_hw_settings.timer_module_id);
+      PLIB_TMR_Period16BitSet(HW_TIMER, 65535);
+      PLIB_TMR_PrescaleSelect(HW_TIMER, TMR_PRESCALE_VALUE_8);
+      PLIB_TMR_Start(HW_TIMER);
 
       // Fall through
     case STATE_R_RX_PREPARE:
@@ -1419,7 +1489,7 @@ void Transceiver_Tasks() {
       if (!g_transceiver.active) {
         if (g_transceiver.free_size == 0u) {
           SysLog_Message(SYSLOG_INFO, "Lost buffers!");
-          g_transceiver.state = STATE_ERROR;
+          SetState(STATE_ERROR);
           return;
         }
 
@@ -1434,31 +1504,30 @@ void Transceiver_Tasks() {
       g_transceiver.event_index = 0u;
       g_transceiver.active->op = OP_RX;
 
-      g_transceiver.state = STATE_R_RX_MBB;
+      SetState(STATE_R_RX_MBB);
 
       // Catch the next falling edge.
-      SYS_INT_SourceDisable(g_hw_settings.input_capture_source);
-      SYS_INT_SourceStatusClear(g_hw_settings.input_capture_source);
-      PLIB_IC_Disable(g_hw_settings.input_capture_module);
-      PLIB_IC_FirstCaptureEdgeSelect(g_hw_settings.input_capture_module,
-                                     IC_EDGE_FALLING);
-      PLIB_IC_Enable(g_hw_settings.input_capture_module);
-      SYS_INT_SourceEnable(g_hw_settings.input_capture_source);
+      SYS_INT_SourceDisable(HW_IC_SOURCE);
+      SYS_INT_SourceStatusClear(HW_IC_SOURCE);
+      PLIB_IC_Disable(HW_IC);
+      PLIB_IC_FirstCaptureEdgeSelect(HW_IC, IC_EDGE_FALLING);
+      PLIB_IC_Enable(HW_IC);
+      SYS_INT_SourceEnable(HW_IC_SOURCE);
 
       // Fall through
     case STATE_R_RX_MBB:
       // noop, waiting for IC event
 
-      SYS_INT_SourceDisable(g_hw_settings.input_capture_source);
-      if (g_transceiver.desired_mode != T_MODE_RESPONDER) {
+      SYS_INT_SourceDisable(HW_IC_SOURCE);
+      if (g_transceiver.desired_mode != g_transceiver.mode) {
         g_transceiver.mode = g_transceiver.desired_mode;
-        PLIB_IC_Disable(g_hw_settings.input_capture_module);
-        PLIB_TMR_Stop(g_hw_settings.timer_module_id);
+        PLIB_IC_Disable(HW_IC);
+        PLIB_TMR_Stop(HW_TIMER);
         FreeActiveBuffer();
         SwitchMode();
         break;
       }
-      SYS_INT_SourceEnable(g_hw_settings.input_capture_source);
+      SYS_INT_SourceEnable(HW_IC_SOURCE);
       break;
 
     case STATE_R_RX_BREAK:
@@ -1469,7 +1538,7 @@ void Transceiver_Tasks() {
       break;
 
     case STATE_R_RX_DATA:
-      SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
+      SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
 
       if (g_transceiver.data_index != 0u) {
         // Got at least one byte, so we have the start code.
@@ -1481,8 +1550,8 @@ void Transceiver_Tasks() {
                                    RESPONDER_DMX_INTERSLOT_TIMEOUT)) {
           // RDM inter-slot timeout
           RXEndFrameEvent();
-          PLIB_USART_ReceiverDisable(g_hw_settings.usart);
-          g_transceiver.state = STATE_R_RX_PREPARE;
+          PLIB_USART_ReceiverDisable(HW_USART);
+          SetState(STATE_R_RX_PREPARE);
           break;
         }
       }
@@ -1499,7 +1568,7 @@ void Transceiver_Tasks() {
         PrepareRDMResponse();
       } else {
         // Continue receiving
-        SYS_INT_SourceEnable(g_hw_settings.usart_rx_source);
+        SYS_INT_SourceEnable(HW_USART_RX_SOURCE);
       }
       break;
     case STATE_R_TX_WAITING:
@@ -1514,24 +1583,24 @@ void Transceiver_Tasks() {
       FreeActiveBuffer();
       break;
     case STATE_R_TX_COMPLETE:
-      PLIB_TMR_Stop(g_hw_settings.timer_module_id);
-      PLIB_TMR_Period16BitSet(g_hw_settings.timer_module_id, 65535u);
-      PLIB_TMR_Start(g_hw_settings.timer_module_id);
+      PLIB_TMR_Stop(HW_TIMER);
+      PLIB_TMR_Period16BitSet(HW_TIMER, 65535u);
+      PLIB_TMR_Start(HW_TIMER);
       g_transceiver.data_index = 0u;
-      g_transceiver.state = STATE_R_RX_PREPARE;
+      SetState(STATE_R_RX_PREPARE);
       break;
 
     // Self Test States
     case STATE_T_INITIALIZE:
-      PLIB_USART_TransmitterDisable(g_hw_settings.usart);
+      PLIB_USART_TransmitterDisable(HW_USART);
       UART_FlushRX();
-      SYS_INT_SourceDisable(g_hw_settings.usart_tx_source);
-      SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
-      SYS_INT_SourceStatusClear(g_hw_settings.usart_tx_source);
-      SYS_INT_SourceStatusClear(g_hw_settings.usart_tx_source);
-      PLIB_USART_TransmitterInterruptModeSelect(g_hw_settings.usart,
+      SYS_INT_SourceDisable(HW_USART_TX_SOURCE);
+      SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
+      SYS_INT_SourceStatusClear(HW_USART_TX_SOURCE);
+      SYS_INT_SourceStatusClear(HW_USART_TX_SOURCE);
+      PLIB_USART_TransmitterInterruptModeSelect(HW_USART,
                                                 USART_TRANSMIT_FIFO_EMPTY);
-      PLIB_USART_Enable(g_hw_settings.usart);
+      PLIB_USART_Enable(HW_USART);
 
       // Setup loopback
       PLIB_PORTS_PinClear(PORTS_ID_0,
@@ -1541,7 +1610,7 @@ void Transceiver_Tasks() {
                         g_hw_settings.port,
                         g_hw_settings.tx_enable_bit);
 
-      g_transceiver.state = STATE_T_TX_READY;
+      SetState(STATE_T_TX_READY);
       // Fall through
     case STATE_T_TX_READY:
       if (g_transceiver.desired_mode != T_MODE_SELF_TEST) {
@@ -1554,25 +1623,25 @@ void Transceiver_Tasks() {
       TakeNextBuffer();
       g_transceiver.data_index = 0;
       g_transceiver.tx_frame_start = CoarseTimer_GetTime();
-      g_transceiver.state = STATE_T_RX_WAIT;
+      SetState(STATE_T_RX_WAIT);
 
-      SYS_INT_SourceStatusClear(g_hw_settings.usart_rx_source);
-      SYS_INT_SourceEnable(g_hw_settings.usart_rx_source);
-      PLIB_USART_ReceiverEnable(g_hw_settings.usart);
-      PLIB_USART_TransmitterEnable(g_hw_settings.usart);
-      PLIB_USART_TransmitterByteSend(g_hw_settings.usart, SELF_TEST_VALUE);
+      SYS_INT_SourceStatusClear(HW_USART_RX_SOURCE);
+      SYS_INT_SourceEnable(HW_USART_RX_SOURCE);
+      PLIB_USART_ReceiverEnable(HW_USART);
+      PLIB_USART_TransmitterEnable(HW_USART);
+      PLIB_USART_TransmitterByteSend(HW_USART, SELF_TEST_VALUE);
       // Fall through
     case STATE_T_RX_WAIT:
       if (CoarseTimer_HasElapsed(g_transceiver.tx_frame_start,
                                  SELF_TEST_TIMEOUT)) {
-        SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
-        g_transceiver.state = STATE_T_VERIFY;
+        SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
+        SetState(STATE_T_VERIFY);
       }
       break;
     case STATE_T_VERIFY:
-      SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
-      PLIB_USART_ReceiverDisable(g_hw_settings.usart);
-      PLIB_USART_TransmitterDisable(g_hw_settings.usart);
+      SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
+      PLIB_USART_ReceiverDisable(HW_USART);
+      PLIB_USART_TransmitterDisable(HW_USART);
 
       g_transceiver.result = T_RESULT_SELF_TEST_FAILED;
       if (g_transceiver.data_index > 0 &&
@@ -1582,7 +1651,7 @@ void Transceiver_Tasks() {
       g_transceiver.data_index = 0;
       FrameComplete();
       FreeActiveBuffer();
-      g_transceiver.state = STATE_T_TX_READY;
+      SetState(STATE_T_TX_READY);
       break;
 
     case STATE_RESET:
@@ -1594,42 +1663,63 @@ void Transceiver_Tasks() {
 }
 
 /*
- * Queue an operation.
+ * @brief Take a buffer from the free list and make it the next buffer.
  * @param token The token for this operation.
  * @param start_code The start code for the outgoing frame.
  * @param op The type of operation.
- * @param data The frame's slot data.
- * @param size The number of slots.
- * @returns true if the operation was queued, false if the buffer was full.
+ * @returns The buffer, or NULL if there are no free buffers or the operation
+ *   isn't allowed in the current mode. The caller must fill in the size and
+ *   the slot data.
  */
-bool Transceiver_QueueFrame(int16_t token, uint8_t start_code,
-                            InternalOperation op, const uint8_t* data,
-                            unsigned int size) {
-  if (g_transceiver.free_size == 0u) {
-    return false;
+static TransceiverBuffer* ReserveNextBuffer(int16_t token, uint8_t start_code,
+                                            InternalOperation op) {
+  // A free buffer isn't enough, the active buffer may have been released
+  // before the next buffer has been taken.
+  if (g_transceiver.free_size == 0u || g_transceiver.next) {
+    return NULL;
   }
 
   if (op == OP_SELF_TEST) {
     if (g_transceiver.mode != T_MODE_SELF_TEST) {
-      return false;
+      return NULL;
     }
   } else if (g_transceiver.mode != T_MODE_CONTROLLER) {
-    return false;
+    return NULL;
   }
 
   g_transceiver.free_size--;
   g_transceiver.next = g_transceiver.free_list[g_transceiver.free_size];
-
-  if (size > DMX_FRAME_SIZE) {
-    size = DMX_FRAME_SIZE;
-  }
-  g_transceiver.next->size = size + 1u;  // include start code.
   g_transceiver.next->op = op;
   g_transceiver.next->token = token;
   g_transceiver.next->data[0] = start_code;
   SysLog_Print(SYSLOG_INFO, "Start code %d", start_code);
+  Scheduler_Post(SCHEDULER_TRANSCEIVER);
+  return g_transceiver.next;
+}
+
+/*
+ * Queue an operation.
+ * @param token The token for this operation.
+ * @param start_code The start code for the outgoing frame.
+ * @param op The type of operation.
+ * @param data The frame's slot data.
+ * @param size The number of slots.
+ * @returns true if the operation was queued, false if the buffer was full.
+ */
+bool Transceiver_QueueFrame(int16_t token, uint8_t start_code,
+                            InternalOperation op, const uint8_t* data,
+                            unsigned int size) {
+  TransceiverBuffer *buffer = ReserveNextBuffer(token, start_code, op);
+  if (!buffer) {
+    return false;
+  }
+
+  if (size > DMX_FRAME_SIZE) {
+    size = DMX_FRAME_SIZE;
+  }
+  buffer->size = size + 1u;  // include start code.
   if (size) {
-    memcpy(&g_transceiver.next->data[1], data, size);
+    memcpy(&buffer->data[1], data, size);
   }
   return true;
 }
@@ -1640,6 +1730,18 @@ bool Transceiver_QueueDMX(int16_t token, const uint8_t* data,
       token, NULL_START_CODE, OP_TX_ONLY, data, size);
 }
 
+bool Transceiver_QueueRLEDMX(int16_t token, const uint8_t* data,
+                             unsigned int size) {
+  TransceiverBuffer *buffer = ReserveNextBuffer(token, NULL_START_CODE,
+                                                OP_TX_DMX_RLE);
+  if (!buffer) {
+    return false;
+  }
+  // Decode directly into the buffer, this saves a copy.
+  buffer->size = DMXRLE_Decode(&buffer->data[1], data, size) + 1u;
+  return true;
+}
+
 bool Transceiver_QueueASC(int16_t token, uint8_t start_code,
                           const uint8_t* data, unsigned int size) {
   return Transceiver_QueueFrame(
@@ -1693,6 +1795,7 @@ bool Transceiver_QueueRDMResponse(bool include_break,
   g_transceiver.next->size = offset;
   g_transceiver.next->op = include_break ? OP_RDM_WITH_RESPONSE :
                            OP_RDM_DUB_RESPONSE;
+  Scheduler_Post(SCHEDULER_TRANSCEIVER);
   return true;
 }
 
@@ -1706,27 +1809,27 @@ bool Transceiver_QueueSelfTest(int16_t token) {
  */
 void Transceiver_Reset() {
   // Disable & clear all interrupts.
-  SYS_INT_SourceDisable(g_hw_settings.usart_tx_source);
-  SYS_INT_SourceStatusClear(g_hw_settings.usart_tx_source);
-  SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
-  SYS_INT_SourceStatusClear(g_hw_settings.usart_rx_source);
-  SYS_INT_SourceDisable(g_hw_settings.usart_error_source);
-  SYS_INT_SourceStatusClear(g_hw_settings.usart_error_source);
+  SYS_INT_SourceDisable(HW_USART_TX_SOURCE);
+  SYS_INT_SourceStatusClear(HW_USART_TX_SOURCE);
+  SYS_INT_SourceDisable(HW_USART_RX_SOURCE);
+  SYS_INT_SourceStatusClear(HW_USART_RX_SOURCE);
+  SYS_INT_SourceDisable(HW_USART_ERROR_SOURCE);
+  SYS_INT_SourceStatusClear(HW_USART_ERROR_SOURCE);
 
   // Reset Timer
-  SYS_INT_SourceDisable(g_hw_settings.timer_source);
-  SYS_INT_SourceStatusClear(g_hw_settings.timer_source);
-  PLIB_TMR_Stop(g_hw_settings.timer_module_id);
+  SYS_INT_SourceDisable(HW_TIMER_SOURCE);
+  SYS_INT_SourceStatusClear(HW_TIMER_SOURCE);
+  PLIB_TMR_Stop(HW_TIMER);
 
   // Reset IC
-  SYS_INT_SourceDisable(g_hw_settings.input_capture_source);
-  SYS_INT_SourceStatusClear(g_hw_settings.input_capture_source);
-  PLIB_IC_Disable(g_hw_settings.input_capture_module);
+  SYS_INT_SourceDisable(HW_IC_SOURCE);
+  SYS_INT_SourceStatusClear(HW_IC_SOURCE);
+  PLIB_IC_Disable(HW_IC);
 
   // Reset UART
-  PLIB_USART_ReceiverDisable(g_hw_settings.usart);
-  PLIB_USART_TransmitterDisable(g_hw_settings.usart);
-  PLIB_USART_Disable(g_hw_settings.usart);
+  PLIB_USART_ReceiverDisable(HW_USART);
+  PLIB_USART_TransmitterDisable(HW_USART);
+  PLIB_USART_Disable(HW_USART);
 
   // Reset buffers in case we got into a weird state.
   InitializeBuffers();
@@ -1737,7 +1840,7 @@ void Transceiver_Reset() {
   // Set us back into the TX Mark state.
   ResetToMark();
 
-  g_transceiver.state = STATE_RESET;
+  SetState(STATE_RESET);
 }
 
 bool Transceiver_SetBreakTime(uint16_t break_time_us) {
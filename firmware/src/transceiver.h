@@ -104,6 +104,7 @@ typedef enum {
   T_MODE_CONTROLLER,  //!< An RDM controller and/or source of DMX512
   T_MODE_RESPONDER,  //!< An RDM device and/or receiver of DMX512.
   T_MODE_SELF_TEST,  //!< Self test mode.
+  T_MODE_SNIFFER,  //!< Passively capture the frames on the line.
   T_MODE_LAST  //!< The first 'undefined' mode
 } TransceiverMode;
 
@@ -117,7 +118,8 @@ typedef enum {
   T_OP_RDM_WITH_RESPONSE,  //!< A RDM Get / Set Request.
   T_OP_RX,  //!< Receive mode.
   T_OP_MODE_CHANGE,  //!< Mode change complete
-  T_OP_SELF_TEST  //!< Self test complete
+  T_OP_SELF_TEST,  //!< Self test complete
+  T_OP_TX_DMX_RLE  //!< A run length encoded DMX512 frame, no response.
 } TransceiverOperation;
 
 /**
@@ -246,6 +248,10 @@ typedef bool (*TransceiverEventCallback)(const TransceiverEvent *event);
  * Alas, this doesn't contain all of the settings. The vector numbers used in
  * the ISRs are required at compile time, so we can't control that. We'll need
  * to come up with a better way to make this modular.
+ *
+ * If TRANSCEIVER_STATIC_HARDWARE is defined in app_settings.h, the USART, timer
+ * & input capture settings are taken from TRANSCEIVER_UART, TRANSCEIVER_TIMER
+ * and TRANSCEIVER_IC instead, and the matching fields here are ignored.
  */
 typedef struct {
   USART_MODULE_ID usart;  //!< The USART module to use
@@ -276,6 +282,9 @@ typedef struct {
  * will override the value of tx_callback.
  * If PIPELINE_TRANSCEIVER_RX_EVENT is defined in app_pipeline.h, the macro
  * will override the value of rx_callback.
+ *
+ * In T_MODE_SNIFFER, RX events are passed to PIPELINE_TRANSCEIVER_SNIFFER_EVENT
+ * if it's defined, otherwise they go to the RX handler as usual.
  */
 void Transceiver_Initialize(const TransceiverHardwareSettings *settings,
                             TransceiverEventCallback tx_callback,
@@ -301,6 +310,14 @@ bool Transceiver_SetMode(TransceiverMode mode, int16_t token);
  */
 TransceiverMode Transceiver_GetMode();
 
+/**
+ * @brief The number of operations that can be queued right now.
+ * @returns The number of Transceiver_QueueX() calls that would succeed. This
+ *   is 0 if the transceiver is busy or the current mode doesn't accept
+ *   frames.
+ */
+uint8_t Transceiver_FreeSlots();
+
 /**
  * @brief Perform the periodic transceiver tasks.
  *
@@ -308,6 +325,19 @@ TransceiverMode Transceiver_GetMode();
  */
 void Transceiver_Tasks();
 
+/**
+ * @brief Get the time until Transceiver_Tasks() next needs to check the
+ *   clock.
+ * @param[out] delay The time until the next check, in 10ths of a
+ *   millisecond.
+ * @returns false if the transceiver isn't waiting on the clock. State
+ *   changes post SCHEDULER_TRANSCEIVER, so no check is needed.
+ *
+ * The RDM response timeouts, the inter-slot timeouts and the backoff after a
+ * frame are checked on each tick of the coarse timer.
+ */
+bool Transceiver_NextDeadline(uint32_t *delay);
+
 /**
  * @brief Queue a DMX frame for transmission.
  * @param token The token for this operation.
@@ -319,6 +349,22 @@ void Transceiver_Tasks();
 bool Transceiver_QueueDMX(int16_t token, const uint8_t* data,
                           unsigned int size);
 
+/**
+ * @brief Queue a run length encoded DMX frame for transmission.
+ * @param token The token for this operation.
+ * @param data The encoded DMX data, excluding the start code. See
+ *   @ref dmx_rle for the format.
+ * @param size The size of the encoded data.
+ * @returns true if the frame was accepted and buffered, false if the transmit
+ *   buffer is full.
+ *
+ * The data is decoded directly into the transmit buffer. The caller should
+ * check the data with DMXRLE_DecodedSize() first, decoding stops at the first
+ * malformed segment. The completion event has an op of T_OP_TX_DMX_RLE.
+ */
+bool Transceiver_QueueRLEDMX(int16_t token, const uint8_t* data,
+                             unsigned int size);
+
 /**
  * @brief Queue an alternate start code (ASC) frame for transmission.
  * @param token The token for this operation.
@@ -0,0 +1,91 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * transceiver_state.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#ifndef FIRMWARE_SRC_TRANSCEIVER_STATE_H_
+#define FIRMWARE_SRC_TRANSCEIVER_STATE_H_
+
+/**
+ * @addtogroup transceiver
+ * @{
+ * @file transceiver_state.h
+ * @brief The states of the 485 Transceiver.
+ *
+ * These are internal to the transceiver, they're in a separate header so the
+ * host tools can decode traces, see @ref trace.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The transceiver states.
+ */
+typedef enum {
+  // Controller states
+  STATE_C_INITIALIZE = 0,  //!< Initialize controller state.
+  STATE_C_TX_READY = 1,  //!< Wait for a pending frame
+  STATE_C_IN_BREAK = 2,  //!< In the Break
+  STATE_C_IN_MARK = 3,  //!< In the Mark-after-break
+  STATE_C_TX_DATA = 4,  //!< Transmitting data
+  STATE_C_TX_DRAIN = 5,  //!< Wait for last byte to be sent
+  STATE_C_RX_WAIT_FOR_BREAK = 6,  //!< Waiting for RX break
+  STATE_C_RX_IN_BREAK = 7,  //!< In break
+  STATE_C_RX_IN_MARK = 8,  //!< In mark
+  STATE_C_RX_DATA = 9,  //!< Receiving data.
+  STATE_C_RX_WAIT_FOR_DUB = 10,  //!< Waiting for DUB response
+  STATE_C_RX_IN_DUB = 11,  //!< In DUB response
+  STATE_C_RX_TIMEOUT = 12,  //!< A RX timeout occured.
+  STATE_C_COMPLETE = 13,  //!< Running the completion handler.
+  STATE_C_BACKOFF = 14,  //!< Waiting until we can send the next break
+
+  // Responder states.
+  STATE_R_INITIALIZE = 20,  //!< Initialze responder state
+  STATE_R_RX_PREPARE = 21,  //!< Prepare to receive frame
+  STATE_R_RX_MBB = 22,  //!< In mark before break
+  STATE_R_RX_BREAK = 23,  //!< In break
+  STATE_R_RX_MARK = 24,  //!< In mark after break
+  STATE_R_RX_DATA = 25,  //!< Receiving data
+  STATE_R_TX_WAITING = 26,  //!< Delay before response
+  STATE_R_TX_BREAK = 27,  //!< In TX Break
+  STATE_R_TX_MARK = 28,  //!< In TX Mark
+  STATE_R_TX_DATA = 29,  //!< Transmitting data.
+  STATE_R_TX_DRAIN = 30,  //!< Wait for last byte to be sent.
+  STATE_R_TX_COMPLETE = 31,  //!< Response complete
+
+  // Self test states
+  STATE_T_INITIALIZE = 40,  //!< Init self test
+  STATE_T_TX_READY = 41,  //!< Wait for send operation
+  STATE_T_RX_WAIT = 42,  //!< Wait for response
+  STATE_T_VERIFY = 43,  //!< Check response
+
+  // Common states
+  STATE_RESET = 99,
+  STATE_ERROR = 100
+} TransceiverState;
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif  // FIRMWARE_SRC_TRANSCEIVER_STATE_H_
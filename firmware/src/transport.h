@@ -39,12 +39,39 @@
 
 /**
  * @brief Flags use in a response message.
+ *
+ * The upper bits carry the flow control credits, see
+ * @ref message-format-credits.
  */
 typedef enum {
   TRANSPORT_FLAGS_CHANGED = 0x02,  //!< Flags have changed
-  TRANSPORT_MSG_TRUNCATED = 0x04  //!< The message has been truncated.
+  TRANSPORT_MSG_TRUNCATED = 0x04,  //!< The message has been truncated.
+  /**
+   * @brief The number of operations the transceiver can accept.
+   */
+  TRANSPORT_TX_CREDITS_MASK = 0x18,
+  /**
+   * @brief The free space in the stream decoder, in units of
+   * TRANSPORT_RX_CREDIT_SIZE.
+   */
+  TRANSPORT_RX_CREDITS_MASK = 0xe0
 } TransportFlags;
 
+/**
+ * @brief The bit offset of the transceiver credits in the flags byte.
+ */
+#define TRANSPORT_TX_CREDITS_SHIFT 3u
+
+/**
+ * @brief The bit offset of the stream decoder credits in the flags byte.
+ */
+#define TRANSPORT_RX_CREDITS_SHIFT 5u
+
+/**
+ * @brief The number of bytes represented by a single stream decoder credit.
+ */
+#define TRANSPORT_RX_CREDIT_SIZE USB_MAX_PACKET_SIZE
+
 /**
  * @brief A function pointer to send a message to the host
  * @param token The frame token, this should match the request.
@@ -53,6 +80,9 @@ typedef enum {
  * @param iov A pointer to an array of IOVec structures. The data will be
  *   copied.
  * @param iov_count The number of IOVec structures in the array.
+ *
+ * Payloads larger than PAYLOAD_SIZE are truncated, for both responses and
+ * messages using EVENT_TOKEN.
  */
 typedef bool (*TransportTXFunction)(uint8_t, Command, uint8_t, const IOVec*,
                                     unsigned int);
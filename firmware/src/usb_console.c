@@ -22,7 +22,10 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "events.h"
+#include "flags.h"
 #include "receiver_counters.h"
+#include "scheduler.h"
 #include "syslog.h"
 #include "system_definitions.h"
 #include "transceiver.h"
@@ -136,6 +139,7 @@ USB_DEVICE_CDC_EVENT_RESPONSE USBConsole_CDCEventHandler(
     return USB_DEVICE_CDC_EVENT_RESPONSE_NONE;
   }
 
+  Scheduler_Post(SCHEDULER_HOST);
   USB_CDC_CONTROL_LINE_STATE* line_state;
   switch (event) {
     case USB_DEVICE_CDC_EVENT_GET_LINE_CODING:
@@ -275,6 +279,11 @@ void USBConsole_Log(const char* message) {
   int16_t remaining = SpaceRemaining();
   if (remaining < LOG_TERMINATOR_SIZE) {
     // There isn't enough room for the terminator characters.
+    // Only notify the host once per GET_FLAGS.
+    if (!g_flags.flags.log_overflow) {
+      Events_Push(EVENT_LOG_OVERFLOW, 0u, 0u);
+    }
+    Flags_SetLogOverflow();
     return;
   }
 
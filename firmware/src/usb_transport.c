@@ -29,9 +29,11 @@
 #include "flags.h"
 #include "macros.h"
 #include "reset.h"
+#include "scheduler.h"
 #include "stream_decoder.h"
 #include "system_config.h"
 #include "system_definitions.h"
+#include "transceiver.h"
 #include "transport.h"
 #include "usb/usb_device.h"
 #include "utils.h"
@@ -53,8 +55,11 @@ typedef struct {
   bool is_configured;  //!< Keep track of whether the device is configured.
 
   bool tx_in_progress;  //!< True if there is a TX in progress
+  bool event_in_progress;  //!< True if the TX in progress is unsolicited.
+  uint16_t pending_size;  //!< The size of the deferred response, or 0.
   bool rx_in_progress;  //!< True if there is a RX in progress.
   bool dfu_detach;  //!< True if we've received a DFU detach.
+  uint8_t credits;  //!< The credit bits sent in the last response.
 
   USB_DEVICE_TRANSFER_HANDLE write_transfer;
   USB_DEVICE_TRANSFER_HANDLE read_transfer;
@@ -67,12 +72,20 @@ typedef struct {
 
 static USBTransportData g_usb_transport_data;
 
+// The size of the response header & EOM.
+#define MESSAGE_OVERHEAD 9u
+
 // Receive data buffer
 static uint8_t receivedDataBuffer[USB_READ_BUFFER_SIZE];
 
 // Transmit data buffer
 static uint8_t transmitDataBuffer[USB_READ_BUFFER_SIZE];
 
+// Unsolicited messages use a separate buffer so a response can be built while
+// they're being sent. The sniffer & DMX forwarder send full size payloads, so
+// it's the same size as the transmit buffer.
+static uint8_t eventDataBuffer[USB_READ_BUFFER_SIZE];
+
 // The buffer that holds the DFU Status response.
 static uint8_t g_status_response[GET_STATUS_RESPONSE_SIZE];
 
@@ -108,6 +121,106 @@ static inline void DFUGetStatus() {
                          GET_STATUS_RESPONSE_SIZE);
 }
 
+// Flow control functions
+// ----------------------------------------------------------------------------
+
+/*
+ * @brief Build the credit bits for the flags byte.
+ *
+ * Both credit counts saturate at the width of their bit field.
+ */
+static uint8_t CreditFlags() {
+  uint8_t tx_credits = Transceiver_FreeSlots();
+  if (tx_credits > (TRANSPORT_TX_CREDITS_MASK >> TRANSPORT_TX_CREDITS_SHIFT)) {
+    tx_credits = TRANSPORT_TX_CREDITS_MASK >> TRANSPORT_TX_CREDITS_SHIFT;
+  }
+  unsigned int rx_credits = StreamDecoder_FreeSpace() /
+                            TRANSPORT_RX_CREDIT_SIZE;
+  if (rx_credits > (TRANSPORT_RX_CREDITS_MASK >> TRANSPORT_RX_CREDITS_SHIFT)) {
+    rx_credits = TRANSPORT_RX_CREDITS_MASK >> TRANSPORT_RX_CREDITS_SHIFT;
+  }
+  return (tx_credits << TRANSPORT_TX_CREDITS_SHIFT) |
+         (rx_credits << TRANSPORT_RX_CREDITS_SHIFT);
+}
+
+/*
+ * @brief Check if either credit count has risen from zero since the last
+ *   response was sent.
+ */
+static inline bool CreditsReplenished(uint8_t credits) {
+  uint8_t last = g_usb_transport_data.credits;
+  return (((last & TRANSPORT_TX_CREDITS_MASK) == 0u &&
+           (credits & TRANSPORT_TX_CREDITS_MASK) != 0u) ||
+          ((last & TRANSPORT_RX_CREDITS_MASK) == 0u &&
+           (credits & TRANSPORT_RX_CREDITS_MASK) != 0u));
+}
+
+// Message functions
+// ----------------------------------------------------------------------------
+
+/*
+ * @brief Serialize a message.
+ * @param buffer The buffer to write the message to.
+ * @param max_payload The maximum payload size, larger payloads are truncated.
+ * @returns The size of the message, including the header & EOM.
+ */
+static uint16_t BuildMessage(uint8_t *buffer, uint16_t max_payload,
+                             uint8_t token, Command command, uint8_t rc,
+                             const IOVec* data, unsigned int iov_count) {
+  buffer[0] = START_OF_MESSAGE_ID;
+  buffer[1] = token;
+  buffer[2] = ShortLSB(command);
+  buffer[3] = ShortMSB(command);
+  // 4 & 5 are the length.
+  buffer[6] = rc;
+
+  // Set appropriate flags.
+  buffer[7] = CreditFlags();
+  if (Flags_HasChanged()) {
+    buffer[7] |= TRANSPORT_FLAGS_CHANGED;
+  }
+
+  unsigned int i = 0;
+  uint16_t offset = 0;
+  for (; i != iov_count; i++) {
+    if (offset + data[i].length > max_payload) {
+      memcpy(buffer + offset + 8, data[i].base, max_payload - offset);
+      offset = max_payload;
+      buffer[7] |= TRANSPORT_MSG_TRUNCATED;
+      break;
+    } else {
+      memcpy(buffer + offset + 8, data[i].base, data[i].length);
+      offset += data[i].length;
+    }
+  }
+
+  buffer[4] = ShortLSB(offset);
+  buffer[5] = ShortMSB(offset);
+  buffer[8 + offset] = END_OF_MESSAGE_ID;
+  return offset + MESSAGE_OVERHEAD;
+}
+
+/*
+ * @brief Start writing a message to the host.
+ * @returns true if the write was started.
+ */
+static bool StartWrite(uint8_t *buffer, uint16_t size) {
+  g_usb_transport_data.tx_in_progress = true;
+
+  USB_DEVICE_RESULT result = USB_DEVICE_EndpointWrite(
+      g_usb_transport_data.usb_device,
+      &g_usb_transport_data.write_transfer,
+      g_usb_transport_data.tx_endpoint, buffer, size,
+      USB_DEVICE_TRANSFER_FLAGS_DATA_COMPLETE);
+  if (result == USB_DEVICE_RESULT_OK) {
+    g_usb_transport_data.credits = buffer[7] & (
+        TRANSPORT_TX_CREDITS_MASK | TRANSPORT_RX_CREDITS_MASK);
+  } else {
+    g_usb_transport_data.tx_in_progress = false;
+  }
+  return result == USB_DEVICE_RESULT_OK;
+}
+
 // USB Event Handler
 // ----------------------------------------------------------------------------
 
@@ -121,6 +234,9 @@ void USBTransport_EventHandler(USB_DEVICE_EVENT event, void* event_data,
                                UNUSED uintptr_t context) {
   USB_SETUP_PACKET* setup_packet;
 
+  // Run the host tasks on the next pass of the main loop.
+  Scheduler_Post(SCHEDULER_HOST);
+
   switch (event) {
     case USB_DEVICE_EVENT_POWER_DETECTED:
       // VBUS is detected. Attach the device
@@ -193,6 +309,7 @@ void USBTransport_EventHandler(USB_DEVICE_EVENT event, void* event_data,
     case USB_DEVICE_EVENT_ENDPOINT_WRITE_COMPLETE:
       // Endpoint write is complete
       g_usb_transport_data.tx_in_progress = false;
+      g_usb_transport_data.event_in_progress = false;
       break;
 
     case USB_DEVICE_EVENT_RESUMED:
@@ -212,7 +329,11 @@ void USBTransport_Initialize(TransportRxFunction rx_cb) {
   g_usb_transport_data.tx_endpoint = 0x81;
   g_usb_transport_data.rx_in_progress = false;
   g_usb_transport_data.tx_in_progress = false;
+  g_usb_transport_data.event_in_progress = false;
+  g_usb_transport_data.pending_size = 0u;
   g_usb_transport_data.dfu_detach = false;
+  g_usb_transport_data.credits = (TRANSPORT_TX_CREDITS_MASK |
+                                  TRANSPORT_RX_CREDITS_MASK);
   g_usb_transport_data.alt_setting = 0;
   g_usb_transport_data.rx_data_size = 0;
 }
@@ -288,6 +409,17 @@ void USBTransport_Tasks() {
         Reset_SoftReset();
       }
 
+      if (g_usb_transport_data.tx_in_progress == false &&
+          g_usb_transport_data.pending_size) {
+        // Send the response that was deferred behind an unsolicited message.
+        // If the write can't be started, keep it and try again on the next
+        // pass.
+        if (StartWrite(transmitDataBuffer,
+                       g_usb_transport_data.pending_size)) {
+          g_usb_transport_data.pending_size = 0u;
+        }
+      }
+
       if (g_usb_transport_data.rx_in_progress == false) {
         // We have received data.
         if (g_usb_transport_data.tx_in_progress == false) {
@@ -308,6 +440,14 @@ void USBTransport_Tasks() {
                                   sizeof (receivedDataBuffer));
         }
       }
+
+      // Tell the host once it can send more, rather than leaving it to find
+      // out on the next response.
+      if (g_usb_transport_data.tx_in_progress == false &&
+          CreditsReplenished(CreditFlags())) {
+        USBTransport_SendResponse(EVENT_TOKEN, COMMAND_CREDIT_UPDATE, RC_OK,
+                                  NULL, 0u);
+      }
       break;
     case USB_STATE_LOST_POWER:
     case USB_STATE_UNCONFIGURED:
@@ -324,6 +464,8 @@ void USBTransport_Tasks() {
       }
       g_usb_transport_data.rx_in_progress = false;
       g_usb_transport_data.tx_in_progress = false;
+      g_usb_transport_data.event_in_progress = false;
+      g_usb_transport_data.pending_size = 0u;
 
       g_usb_transport_data.state = (
           g_usb_transport_data.state == USB_STATE_LOST_POWER ?
@@ -336,59 +478,45 @@ void USBTransport_Tasks() {
 
 bool USBTransport_SendResponse(uint8_t token, Command command, uint8_t rc,
                                const IOVec* data, unsigned int iov_count) {
-  if (g_usb_transport_data.tx_in_progress ||
-      g_usb_transport_data.state != USB_STATE_MAIN_TASK) {
+  if (g_usb_transport_data.state != USB_STATE_MAIN_TASK ||
+      g_usb_transport_data.pending_size) {
     return false;
   }
 
-  transmitDataBuffer[0] = START_OF_MESSAGE_ID;
-  transmitDataBuffer[1] = token;
-  transmitDataBuffer[2] = ShortLSB(command);
-  transmitDataBuffer[3] = ShortMSB(command);
-  // 4 & 5 are the length.
-  transmitDataBuffer[6] = rc;
-
-  // Set appropriate flags.
-  transmitDataBuffer[7] = 0;
-  if (Flags_HasChanged()) {
-    transmitDataBuffer[7] |= TRANSPORT_FLAGS_CHANGED;
-  }
-
-  unsigned int i = 0;
-  uint16_t offset = 0;
-  for (; i != iov_count; i++) {
-    if (offset + data[i].length > PAYLOAD_SIZE) {
-      memcpy(transmitDataBuffer + offset + 8, data[i].base,
-             PAYLOAD_SIZE - offset);
-      offset = PAYLOAD_SIZE;
-      transmitDataBuffer[7] |= TRANSPORT_MSG_TRUNCATED;
-      break;
-    } else {
-      memcpy(transmitDataBuffer + offset + 8, data[i].base, data[i].length);
-      offset += data[i].length;
+  if (token == EVENT_TOKEN) {
+    // Unsolicited messages have the lowest priority, they are only sent if
+    // the transport is idle.
+    if (g_usb_transport_data.tx_in_progress) {
+      return false;
+    }
+    uint16_t size = BuildMessage(eventDataBuffer, PAYLOAD_SIZE, token,
+                                 command, rc, data, iov_count);
+    g_usb_transport_data.event_in_progress = true;
+    if (!StartWrite(eventDataBuffer, size)) {
+      g_usb_transport_data.event_in_progress = false;
+      return false;
     }
+    return true;
   }
 
-  transmitDataBuffer[4] = ShortLSB(offset);
-  transmitDataBuffer[5] = ShortMSB(offset);
-  transmitDataBuffer[8 + offset] = END_OF_MESSAGE_ID;
-
-  g_usb_transport_data.tx_in_progress = true;
+  if (g_usb_transport_data.tx_in_progress &&
+      !g_usb_transport_data.event_in_progress) {
+    return false;
+  }
 
-  USB_DEVICE_RESULT result = USB_DEVICE_EndpointWrite(
-      g_usb_transport_data.usb_device,
-      &g_usb_transport_data.write_transfer,
-      g_usb_transport_data.tx_endpoint, transmitDataBuffer,
-      offset + 9,
-      USB_DEVICE_TRANSFER_FLAGS_DATA_COMPLETE);
-  if (result != USB_DEVICE_RESULT_OK) {
-    g_usb_transport_data.tx_in_progress = false;
+  uint16_t size = BuildMessage(transmitDataBuffer, PAYLOAD_SIZE, token,
+                               command, rc, data, iov_count);
+  if (g_usb_transport_data.tx_in_progress) {
+    // Wait for the unsolicited message to complete.
+    g_usb_transport_data.pending_size = size;
+    return true;
   }
-  return result == USB_DEVICE_RESULT_OK;
+  return StartWrite(transmitDataBuffer, size);
 }
 
 bool USBTransport_WritePending() {
-  return g_usb_transport_data.tx_in_progress;
+  return g_usb_transport_data.tx_in_progress ||
+         g_usb_transport_data.pending_size;
 }
 
 USB_DEVICE_HANDLE USBTransport_GetHandle() {
@@ -400,6 +528,7 @@ bool USBTransport_IsConfigured() {
 }
 
 void USBTransport_SoftReset() {
+  g_usb_transport_data.pending_size = 0u;
   if (g_usb_transport_data.tx_in_progress) {
     USB_DEVICE_EndpointTransferCancel(
         g_usb_transport_data.usb_device,
@@ -74,6 +74,15 @@ void USBTransport_Tasks();
  *
  * Only one message can be sent at a time. Until the send completes, any
  * further messages will be dropped.
+ *
+ * Messages using EVENT_TOKEN are only sent if the transport is idle. A
+ * response issued while one is being written is held until it completes.
+ * Both can carry up to PAYLOAD_SIZE bytes.
+ *
+ * The flags byte of each response carries the transceiver & stream decoder
+ * credits. If a response advertised zero credits of either kind, a
+ * COMMAND_CREDIT_UPDATE message is sent from USBTransport_Tasks() once they
+ * become available.
  */
 bool USBTransport_SendResponse(uint8_t token, Command command, uint8_t rc,
                                const IOVec* data, unsigned int iov_count);
@@ -1,4 +1,6 @@
+include tests/benchmarks/Makefile.mk
 include tests/harmony/Makefile.mk
 include tests/mocks/Makefile.mk
 include tests/sim/Makefile.mk
 include tests/tests/Makefile.mk
+include tests/virtual/Makefile.mk
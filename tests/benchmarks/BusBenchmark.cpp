@@ -0,0 +1,534 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * BusBenchmark.cpp
+ * Measures discovery time, RDM throughput & DMX refresh on a RS485 bus.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <arpa/inet.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "coarse_timer.h"
+#include "constants.h"
+#include "dmx_spec.h"
+#include "rdm.h"
+#include "rdm_frame.h"
+#include "rdm_util.h"
+#include "setting_macros.h"
+#include "transceiver.h"
+#include "uid.h"
+#include "utils.h"
+
+#include "tests/sim/InterruptController.h"
+#include "tests/sim/PeripheralInputCapture.h"
+#include "tests/sim/PeripheralPorts.h"
+#include "tests/sim/PeripheralTimer.h"
+#include "tests/sim/PeripheralUART.h"
+#include "tests/sim/RS485Bus.h"
+#include "tests/sim/SignalGenerator.h"
+#include "tests/sim/SimulatedResponder.h"
+#include "tests/sim/Simulator.h"
+
+using std::vector;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Declare the ISR symbols.
+void InputCaptureEvent(void);
+void Transceiver_TimerEvent();
+void Transceiver_UARTEvent();
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace {
+
+const uint32_t kClockSpeed = 80000000;
+const uint32_t kBaudRate = 250000;
+const unsigned int kCyclesPerMicroSecond = kClockSpeed / 1000000;
+const PORTS_CHANNEL kPort = PORT_CHANNEL_F;
+const PORTS_BIT_POS kBreakBit = PORTS_BIT_POS_8;
+const PORTS_BIT_POS kTXEnableBit = PORTS_BIT_POS_1;
+const uint16_t kManufacturerId = 0x7a70;
+const uint8_t kControllerUID[UID_LENGTH] = {0x7a, 0x70, 0xff, 0xff, 0xfe, 0};
+const uint8_t kBroadcastUID[UID_LENGTH] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+
+typedef uint64_t UIDValue;
+const UIDValue kMaxUID = 0xffffffffffffull;
+
+void PackUID(UIDValue value, uint8_t *uid) {
+  for (int i = UID_LENGTH - 1; i >= 0; i--) {
+    uid[i] = value & 0xff;
+    value >>= 8;
+  }
+}
+
+UIDValue UnpackUID(const uint8_t *uid) {
+  UIDValue value = 0;
+  for (unsigned int i = 0; i < UID_LENGTH; i++) {
+    value = (value << 8) | uid[i];
+  }
+  return value;
+}
+
+double ToMilliSeconds(uint64_t cycles) {
+  return static_cast<double>(cycles) / kCyclesPerMicroSecond / 1000.0;
+}
+
+struct DiscoveryResult {
+  unsigned int found;
+  unsigned int dub_count;
+  unsigned int mute_count;
+  unsigned int collisions;
+  uint64_t cycles;
+};
+
+struct Result {
+  unsigned int completed;
+  unsigned int errors;
+  uint64_t cycles;
+};
+
+class BusBenchmark;
+BusBenchmark *g_benchmark = nullptr;
+
+bool HandleTransceiverEvent(const TransceiverEvent *event);
+
+class BusBenchmark {
+ public:
+  BusBenchmark()
+      : m_pin_callback(ola::NewCallback(&m_bus, &RS485Bus::ControllerPinChange)),
+        m_tx_callback(ola::NewCallback(&m_bus, &RS485Bus::ControllerByteSent)),
+        m_transceiver_task(ola::NewCallback(&Transceiver_Tasks)),
+        m_simulator(kClockSpeed),
+        m_timer(&m_simulator, &m_interrupt_controller),
+        m_ic(&m_simulator, &m_interrupt_controller),
+        m_uart(&m_simulator, &m_interrupt_controller, m_tx_callback.get()),
+        m_ports(m_pin_callback.get()),
+        m_generator(&m_simulator, &m_ic, &m_uart, AS_IC_ID(2),
+                    AS_USART_ID(1), kClockSpeed, kBaudRate),
+        m_bus(&m_simulator, &m_generator, kPort, kBreakBit, kTXEnableBit,
+              kClockSpeed, kBaudRate),
+        m_transaction_number(0),
+        m_complete(false),
+        m_result(T_RESULT_OK) {
+  }
+
+  bool Init();
+
+  // Replace the responders on the bus with count new ones.
+  void SetResponders(unsigned int count);
+
+  DiscoveryResult Discover();
+  Result RDMGets(unsigned int count);
+  Result DMX(unsigned int count);
+
+  void Event(const TransceiverEvent *event);
+
+ private:
+  std::unique_ptr<PeripheralPorts::PinChangeCallback> m_pin_callback;
+  std::unique_ptr<PeripheralUART::TXCallback> m_tx_callback;
+  std::unique_ptr<ola::Callback0<void>> m_transceiver_task;
+
+  Simulator m_simulator;
+  InterruptController m_interrupt_controller;
+  PeripheralTimer m_timer;
+  PeripheralInputCapture m_ic;
+  PeripheralUART m_uart;
+  PeripheralPorts m_ports;
+  SignalGenerator m_generator;
+  RS485Bus m_bus;
+
+  vector<std::unique_ptr<SimulatedResponder>> m_responders;
+  uint8_t m_transaction_number;
+
+  // The outcome of the last operation.
+  bool m_complete;
+  TransceiverOperationResult m_result;
+  vector<uint8_t> m_data;
+
+  bool RunOperation();
+  bool SendDUB(UIDValue lower, UIDValue upper);
+  bool SendRequest(const uint8_t *uid, uint8_t command_class, uint16_t pid,
+                   const uint8_t *param_data, uint8_t param_data_length);
+  bool ResponseIsAck() const;
+  bool DecodeDUBResponse(UIDValue *uid) const;
+};
+
+bool BusBenchmark::Init() {
+  PLIB_TMR_SetMock(&m_timer);
+  PLIB_IC_SetMock(&m_ic);
+  PLIB_USART_SetMock(&m_uart);
+  PLIB_PORTS_SetMock(&m_ports);
+  SYS_INT_SetMock(&m_interrupt_controller);
+
+  m_interrupt_controller.RegisterISR(INT_SOURCE_TIMER_1,
+      ola::NewCallback(&CoarseTimer_TimerEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_TIMER_3,
+      ola::NewCallback(&Transceiver_TimerEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_INPUT_CAPTURE_2,
+      ola::NewCallback(&InputCaptureEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_USART_1_ERROR,
+      ola::NewCallback(&Transceiver_UARTEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_USART_1_TRANSMIT,
+      ola::NewCallback(&Transceiver_UARTEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_USART_1_RECEIVE,
+      ola::NewCallback(&Transceiver_UARTEvent));
+
+  TransceiverHardwareSettings settings = {
+    .usart = AS_USART_ID(1),
+    .usart_vector = AS_USART_INTERRUPT_VECTOR(1),
+    .usart_tx_source = AS_USART_INTERRUPT_TX_SOURCE(1),
+    .usart_rx_source = AS_USART_INTERRUPT_RX_SOURCE(1),
+    .usart_error_source = AS_USART_INTERRUPT_ERROR_SOURCE(1),
+    .port = kPort,
+    .break_bit = kBreakBit,
+    .tx_enable_bit = kTXEnableBit,
+    .rx_enable_bit = PORTS_BIT_POS_0,
+    .input_capture_module = AS_IC_ID(2),
+    .input_capture_vector = AS_IC_INTERRUPT_VECTOR(2),
+    .input_capture_source = AS_IC_INTERRUPT_SOURCE(2),
+    .timer_module_id = AS_TIMER_ID(3),
+    .timer_vector = AS_TIMER_INTERRUPT_VECTOR(3),
+    .timer_source = AS_TIMER_INTERRUPT_SOURCE(3),
+    .input_capture_timer = AS_IC_TMR_ID(3),
+  };
+  Transceiver_Initialize(&settings, &HandleTransceiverEvent,
+                         &HandleTransceiverEvent);
+
+  CoarseTimer_Settings timer_settings = {
+    .timer_id = AS_TIMER_ID(1),
+    .interrupt_source = AS_TIMER_INTERRUPT_SOURCE(1)
+  };
+  CoarseTimer_Initialize(&timer_settings);
+
+  m_simulator.AddTask(m_transceiver_task.get());
+  Transceiver_SetMode(T_MODE_CONTROLLER, 0);
+  return RunOperation() && Transceiver_GetMode() == T_MODE_CONTROLLER;
+}
+
+void BusBenchmark::SetResponders(unsigned int count) {
+  for (auto &responder : m_responders) {
+    m_bus.RemoveDevice(responder.get());
+  }
+  m_responders.clear();
+
+  // Spread the UIDs over the device id space, the same seed is used each time
+  // so the results are repeatable.
+  std::mt19937 generator(count);
+  std::set<UIDValue> uids;
+  while (uids.size() < count) {
+    uids.insert((static_cast<UIDValue>(kManufacturerId) << 32) | generator());
+  }
+
+  for (const auto &value : uids) {
+    uint8_t uid[UID_LENGTH];
+    PackUID(value, uid);
+    m_responders.emplace_back(new SimulatedResponder(&m_bus, uid));
+    m_bus.AddDevice(m_responders.back().get());
+  }
+}
+
+/*
+ * The usual binary search discovery, a collision splits the branch in two.
+ */
+DiscoveryResult BusBenchmark::Discover() {
+  DiscoveryResult result = DiscoveryResult();
+  unsigned int initial_collisions = m_bus.Collisions();
+  uint64_t start = m_simulator.Clock();
+
+  SendRequest(kBroadcastUID, DISCOVERY_COMMAND, PID_DISC_UN_MUTE, nullptr, 0);
+
+  vector<std::pair<UIDValue, UIDValue>> branches;
+  branches.push_back(std::make_pair(0, kMaxUID));
+  while (!branches.empty()) {
+    UIDValue lower = branches.back().first;
+    UIDValue upper = branches.back().second;
+    branches.pop_back();
+
+    result.dub_count++;
+    if (!SendDUB(lower, upper)) {
+      continue;
+    }
+
+    UIDValue uid_value;
+    if (DecodeDUBResponse(&uid_value)) {
+      uint8_t uid[UID_LENGTH];
+      PackUID(uid_value, uid);
+      result.mute_count++;
+      if (SendRequest(uid, DISCOVERY_COMMAND, PID_DISC_MUTE, nullptr, 0) &&
+          ResponseIsAck()) {
+        result.found++;
+        // There may be more responders in this branch.
+        branches.push_back(std::make_pair(lower, upper));
+        continue;
+      }
+    }
+
+    if (lower != upper) {
+      UIDValue mid = lower + (upper - lower) / 2;
+      branches.push_back(std::make_pair(mid + 1, upper));
+      branches.push_back(std::make_pair(lower, mid));
+    }
+  }
+
+  result.cycles = m_simulator.Clock() - start;
+  result.collisions = m_bus.Collisions() - initial_collisions;
+  return result;
+}
+
+Result BusBenchmark::RDMGets(unsigned int count) {
+  Result result = Result();
+  uint64_t start = m_simulator.Clock();
+  for (unsigned int i = 0; i < count; i++) {
+    const SimulatedResponder *responder = m_responders[
+        i % m_responders.size()].get();
+    if (!(SendRequest(responder->UID(), GET_COMMAND, PID_DEVICE_INFO,
+                      nullptr, 0) &&
+          ResponseIsAck())) {
+      result.errors++;
+    }
+    result.completed++;
+  }
+  result.cycles = m_simulator.Clock() - start;
+  return result;
+}
+
+Result BusBenchmark::DMX(unsigned int count) {
+  Result result = Result();
+  vector<uint8_t> frame(DMX_FRAME_SIZE);
+  for (unsigned int i = 0; i < frame.size(); i++) {
+    frame[i] = i;
+  }
+
+  vector<unsigned int> frames_before;
+  for (const auto &responder : m_responders) {
+    frames_before.push_back(responder->DMXFrames());
+  }
+
+  uint64_t start = m_simulator.Clock();
+  for (unsigned int i = 0; i < count; i++) {
+    Transceiver_QueueDMX(0, frame.data(), frame.size());
+    if (!(RunOperation() && m_result == T_RESULT_OK)) {
+      result.errors++;
+    }
+    result.completed++;
+  }
+  result.cycles = m_simulator.Clock() - start;
+
+  // Every responder should have seen every frame.
+  for (unsigned int i = 0; i < m_responders.size(); i++) {
+    if (m_responders[i]->DMXFrames() - frames_before[i] != count) {
+      result.errors++;
+    }
+  }
+  return result;
+}
+
+void BusBenchmark::Event(const TransceiverEvent *event) {
+  m_complete = true;
+  m_result = event->result;
+  m_data.assign(event->data, event->data + event->length);
+  m_simulator.Stop();
+}
+
+/*
+ * @brief Run the simulator until the queued operation completes.
+ */
+bool BusBenchmark::RunOperation() {
+  m_complete = false;
+  m_data.clear();
+  // Allow 100ms of simulated time per operation.
+  m_simulator.SetClockLimit(100000, false);
+  m_simulator.Run();
+  return m_complete;
+}
+
+/*
+ * @brief Send a DUB, returns true if there was a response.
+ */
+bool BusBenchmark::SendDUB(UIDValue lower, UIDValue upper) {
+  uint8_t param_data[2 * UID_LENGTH];
+  PackUID(lower, param_data);
+  PackUID(upper, param_data + UID_LENGTH);
+
+  uint8_t frame[RDM_MAX_FRAME_SIZE];
+  RDMHeader *header = reinterpret_cast<RDMHeader*>(frame);
+  memset(frame, 0, sizeof(RDMHeader));
+  header->start_code = RDM_START_CODE;
+  header->sub_start_code = SUB_START_CODE;
+  header->message_length = sizeof(RDMHeader) + sizeof(param_data);
+  memcpy(header->dest_uid, kBroadcastUID, UID_LENGTH);
+  memcpy(header->src_uid, kControllerUID, UID_LENGTH);
+  header->transaction_number = m_transaction_number++;
+  header->port_id = 1;
+  header->command_class = DISCOVERY_COMMAND;
+  header->param_id = htons(PID_DISC_UNIQUE_BRANCH);
+  header->param_data_length = sizeof(param_data);
+  memcpy(frame + sizeof(RDMHeader), param_data, sizeof(param_data));
+  unsigned int size = RDMUtil_AppendChecksum(frame);
+
+  Transceiver_QueueRDMDUB(0, frame + 1, size - 1);
+  return RunOperation() && m_result == T_RESULT_RX_DATA && !m_data.empty();
+}
+
+/*
+ * @brief Send a request, returns true if the operation completed.
+ */
+bool BusBenchmark::SendRequest(const uint8_t *uid, uint8_t command_class,
+                               uint16_t pid, const uint8_t *param_data,
+                               uint8_t param_data_length) {
+  uint8_t frame[RDM_MAX_FRAME_SIZE];
+  RDMHeader *header = reinterpret_cast<RDMHeader*>(frame);
+  memset(frame, 0, sizeof(RDMHeader));
+  header->start_code = RDM_START_CODE;
+  header->sub_start_code = SUB_START_CODE;
+  header->message_length = sizeof(RDMHeader) + param_data_length;
+  memcpy(header->dest_uid, uid, UID_LENGTH);
+  memcpy(header->src_uid, kControllerUID, UID_LENGTH);
+  header->transaction_number = m_transaction_number++;
+  header->port_id = 1;
+  header->command_class = command_class;
+  header->param_id = htons(pid);
+  header->param_data_length = param_data_length;
+  if (param_data_length) {
+    memcpy(frame + sizeof(RDMHeader), param_data, param_data_length);
+  }
+  unsigned int size = RDMUtil_AppendChecksum(frame);
+
+  Transceiver_QueueRDMRequest(0, frame + 1, size - 1,
+                              !RDMUtil_IsUnicast(uid));
+  return RunOperation();
+}
+
+bool BusBenchmark::ResponseIsAck() const {
+  if (m_result != T_RESULT_RX_DATA || m_data.size() < sizeof(RDMHeader) ||
+      m_data[0] != RDM_START_CODE ||
+      !RDMUtil_VerifyChecksum(m_data.data(), m_data.size())) {
+    return false;
+  }
+  const RDMHeader *header = reinterpret_cast<const RDMHeader*>(m_data.data());
+  return header->port_id == ACK;
+}
+
+bool BusBenchmark::DecodeDUBResponse(UIDValue *uid_value) const {
+  unsigned int offset = 0;
+  while (offset < m_data.size() && offset < 7 && m_data[offset] == 0xfe) {
+    offset++;
+  }
+  if (offset >= m_data.size() || m_data[offset] != 0xaa ||
+      m_data.size() - offset - 1 < 16) {
+    return false;
+  }
+  const uint8_t *data = m_data.data() + offset + 1;
+
+  uint8_t uid[UID_LENGTH];
+  uint16_t checksum = 0;
+  for (unsigned int i = 0; i < UID_LENGTH; i++) {
+    uid[i] = data[2 * i] & data[2 * i + 1];
+    checksum += data[2 * i] + data[2 * i + 1];
+  }
+  uint16_t expected = JoinShort(data[12] & data[13], data[14] & data[15]);
+  if (checksum != expected) {
+    return false;
+  }
+  *uid_value = UnpackUID(uid);
+  return true;
+}
+
+bool HandleTransceiverEvent(const TransceiverEvent *event) {
+  if (g_benchmark) {
+    g_benchmark->Event(event);
+  }
+  return true;
+}
+
+void Usage(const char *arg0) {
+  printf("Usage: %s [-n count] [-r responders]...\n\n"
+         "Runs the Transceiver, in controller mode, against a RS485 bus of\n"
+         "simulated responders. Times are in simulated time.\n\n"
+         "  -n count       The number of RDM GETs & DMX frames to send.\n"
+         "  -r responders  The number of responders, may be repeated.\n",
+         arg0);
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  unsigned int count = 100;
+  vector<unsigned int> responder_counts;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      count = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      responder_counts.push_back(atoi(argv[++i]));
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+  if (responder_counts.empty()) {
+    responder_counts = {1, 10, 50, 100, 500};
+  }
+  if (count == 0) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  BusBenchmark benchmark;
+  g_benchmark = &benchmark;
+  if (!benchmark.Init()) {
+    printf("Failed to switch to controller mode\n");
+    return 1;
+  }
+
+  for (const auto responders : responder_counts) {
+    if (responders == 0) {
+      continue;
+    }
+    benchmark.SetResponders(responders);
+    auto start = std::chrono::steady_clock::now();
+
+    DiscoveryResult discovery = benchmark.Discover();
+    Result gets = benchmark.RDMGets(count);
+    Result dmx = benchmark.DMX(count);
+
+    double wall_time_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    printf("%4u responders: discovery %4u found %9.1f ms (%u DUB, %u mute, "
+           "%u collisions)  get %7.1f/s %u err  dmx %6.1f fps %u err  "
+           "(wall %.0f ms)\n",
+           responders, discovery.found, ToMilliSeconds(discovery.cycles),
+           discovery.dub_count, discovery.mute_count, discovery.collisions,
+           gets.completed * 1000.0 / ToMilliSeconds(gets.cycles), gets.errors,
+           dmx.completed * 1000.0 / ToMilliSeconds(dmx.cycles), dmx.errors,
+           wall_time_ms);
+  }
+  g_benchmark = nullptr;
+  return 0;
+}
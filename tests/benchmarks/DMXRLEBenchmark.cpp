@@ -0,0 +1,111 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * DMXRLEBenchmark.cpp
+ * Measures the bytes saved and the decode cost of the DMX RLE encoding.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dmx_rle.h"
+#include "dmx_spec.h"
+
+namespace {
+
+const unsigned int kIterations = 100000;
+
+// Worst case encoded size, see DMXRLE_Encode().
+const unsigned int kMaxEncodedSize =
+    DMX_FRAME_SIZE + DMX_FRAME_SIZE / DMX_RLE_MAX_LITERAL + 1;
+
+uint64_t NowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+void SparseUniverse(uint8_t *data) {
+  // 16 RGBW fixtures, patched every 32 slots.
+  memset(data, 0, DMX_FRAME_SIZE);
+  for (unsigned int i = 0; i < 16; i++) {
+    data[i * 32] = 255;
+    data[i * 32 + 1] = 10 * i;
+    data[i * 32 + 2] = 0;
+    data[i * 32 + 3] = 128;
+  }
+}
+
+void DimmerUniverse(uint8_t *data) {
+  // Dimmer racks tend to have blocks of channels at the same level.
+  for (unsigned int i = 0; i < DMX_FRAME_SIZE; i++) {
+    data[i] = (i / 24) * 12;
+  }
+}
+
+void RandomUniverse(uint8_t *data) {
+  srand(1);
+  for (unsigned int i = 0; i < DMX_FRAME_SIZE; i++) {
+    data[i] = rand() & 0xff;
+  }
+}
+
+void Run(const char *name, void (*generator)(uint8_t*)) {
+  uint8_t data[DMX_FRAME_SIZE];
+  uint8_t encoded[kMaxEncodedSize];
+  uint8_t output[DMX_FRAME_SIZE];
+
+  generator(data);
+  unsigned int encoded_size = DMXRLE_Encode(encoded, sizeof(encoded), data,
+                                            sizeof(data));
+
+  unsigned int slots = 0;
+  uint64_t start = NowNs();
+  for (unsigned int i = 0; i < kIterations; i++) {
+    slots += DMXRLE_Decode(output, encoded, encoded_size);
+  }
+  uint64_t decode_ns = NowNs() - start;
+
+  start = NowNs();
+  for (unsigned int i = 0; i < kIterations; i++) {
+    memcpy(output, data, sizeof(data));
+  }
+  uint64_t copy_ns = NowNs() - start;
+
+  if (slots != kIterations * DMX_FRAME_SIZE ||
+      memcmp(output, data, sizeof(data))) {
+    printf("%s: decode mismatch\n", name);
+    exit(1);
+  }
+
+  printf("%-8s %4u bytes (%3d saved) decode %6.1f ns, memcpy %6.1f ns\n",
+         name, encoded_size,
+         static_cast<int>(DMX_FRAME_SIZE) - static_cast<int>(encoded_size),
+         static_cast<double>(decode_ns) / kIterations,
+         static_cast<double>(copy_ns) / kIterations);
+}
+}  // namespace
+
+int main() {
+  printf("Frame size %u, %u iterations\n", DMX_FRAME_SIZE, kIterations);
+  Run("sparse", SparseUniverse);
+  Run("dimmer", DimmerUniverse);
+  Run("random", RandomUniverse);
+  return 0;
+}
@@ -0,0 +1,162 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ *
+ * DimmerBenchmark.cpp
+ * Measures the per-request cost of the dimmer model with 512 sub-devices.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <arpa/inet.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "constants.h"
+#include "dimmer_model.h"
+#include "dmx_snapshot.h"
+#include "dmx_spec.h"
+#include "rdm.h"
+#include "rdm_frame.h"
+#include "rdm_responder.h"
+#include "rdm_util.h"
+#include "timer_wheel.h"
+
+namespace {
+
+const unsigned int kIterations = 20000;
+
+const uint8_t kUID[UID_LENGTH] = {0x7a, 0x70, 0x12, 0x34, 0x56, 0x78};
+const uint8_t kControllerUID[UID_LENGTH] = {0x7a, 0x70, 0, 0, 0, 1};
+
+uint64_t NowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+/*
+ * @brief An RDM request to the dimmer.
+ */
+class Request {
+ public:
+  Request(RDMCommandClass command_class, uint16_t sub_device, uint16_t pid,
+          const uint8_t *param_data = NULL, uint8_t pdl = 0) {
+    RDMHeader *header = reinterpret_cast<RDMHeader*>(m_frame);
+    header->start_code = RDM_START_CODE;
+    header->sub_start_code = RDM_SUB_START_CODE;
+    header->message_length = sizeof(RDMHeader) + pdl;
+    memcpy(header->dest_uid, kUID, UID_LENGTH);
+    memcpy(header->src_uid, kControllerUID, UID_LENGTH);
+    header->transaction_number = 0;
+    header->port_id = 1;
+    header->message_count = 0;
+    header->sub_device = htons(sub_device);
+    header->command_class = command_class;
+    header->param_id = htons(pid);
+    header->param_data_length = pdl;
+    memcpy(m_frame + sizeof(RDMHeader), param_data, pdl);
+    RDMUtil_AppendChecksum(m_frame);
+  }
+
+  int Send() const {
+    return DIMMER_MODEL_ENTRY.request_fn(
+        reinterpret_cast<const RDMHeader*>(m_frame),
+        m_frame + sizeof(RDMHeader));
+  }
+
+ private:
+  uint8_t m_frame[RDM_MAX_FRAME_SIZE];
+};
+
+void Run(const char *name, const Request &request) {
+  int response_size = 0;
+  uint64_t start = NowNs();
+  for (unsigned int i = 0; i < kIterations; i++) {
+    response_size = request.Send();
+  }
+  uint64_t ns = NowNs() - start;
+
+  if (response_size <= 0) {
+    printf("%-28s no response\n", name);
+    return;
+  }
+  printf("%-28s %8.1f ns\n", name, static_cast<double>(ns) / kIterations);
+}
+
+/*
+ * @brief Time a DMX frame, from the snapshot to the SPI output.
+ */
+void RunFrame() {
+  uint8_t slots[DMX_FRAME_SIZE];
+  uint64_t start = NowNs();
+  for (unsigned int i = 0; i < kIterations; i++) {
+    memset(slots, i, sizeof(slots));
+    DMXSnapshot_Receive(slots, sizeof(slots));
+    DMXSnapshot_FrameComplete();
+    DIMMER_MODEL_ENTRY.tasks_fn();
+  }
+  uint64_t ns = NowNs() - start;
+  printf("%-28s %8.1f ns\n", "DMX frame",
+         static_cast<double>(ns) / kIterations);
+}
+}  // namespace
+
+int main() {
+  TimerWheel_Initialize();
+  DMXSnapshot_Initialize();
+  RDMResponderSettings settings;
+  memset(&settings, 0, sizeof(settings));
+  memcpy(settings.uid, kUID, UID_LENGTH);
+  RDMResponder_Initialize(&settings);
+  DimmerModel_Initialize();
+  DIMMER_MODEL_ENTRY.activate_fn();
+
+  const uint16_t sub_devices = g_responder->sub_device_count;
+  printf("%u sub-devices, %u iterations\n", sub_devices, kIterations);
+
+  Run("GET CURVE first", Request(GET_COMMAND, 1, PID_CURVE));
+  Run("GET CURVE last", Request(GET_COMMAND, sub_devices, PID_CURVE));
+  Run("GET DEVICE_INFO last",
+      Request(GET_COMMAND, sub_devices, PID_DEVICE_INFO));
+
+  const uint8_t curve[] = {2};
+  Run("SET CURVE last",
+      Request(SET_COMMAND, sub_devices, PID_CURVE, curve, sizeof(curve)));
+  Run("SET CURVE all",
+      Request(SET_COMMAND, SUBDEVICE_ALL, PID_CURVE, curve, sizeof(curve)));
+
+  const uint8_t max_level[] = {0x80, 0x00};
+  Run("SET MAXIMUM_LEVEL all",
+      Request(SET_COMMAND, SUBDEVICE_ALL, PID_MAXIMUM_LEVEL, max_level,
+              sizeof(max_level)));
+
+  const uint8_t start_address[] = {0x00, 0x01};
+  Run("SET DMX_BLOCK_ADDRESS",
+      Request(SET_COMMAND, SUBDEVICE_ROOT, PID_DMX_BLOCK_ADDRESS,
+              start_address, sizeof(start_address)));
+  Run("GET DMX_BLOCK_ADDRESS",
+      Request(GET_COMMAND, SUBDEVICE_ROOT, PID_DMX_BLOCK_ADDRESS));
+
+  const uint8_t status_type[] = {STATUS_ERROR};
+  Run("GET STATUS_MESSAGES",
+      Request(GET_COMMAND, SUBDEVICE_ROOT, PID_STATUS_MESSAGES, status_type,
+              sizeof(status_type)));
+
+  RunFrame();
+  DIMMER_MODEL_ENTRY.deactivate_fn();
+  return 0;
+}
@@ -0,0 +1,101 @@
+# Benchmarks
+##################################################
+# These aren't run as part of make check, run them by hand, e.g.
+# ./tests/benchmarks/dmx_rle_benchmark
+noinst_PROGRAMS += tests/benchmarks/bus_benchmark \
+                   tests/benchmarks/dimmer_benchmark \
+                   tests/benchmarks/dmx_rle_benchmark \
+                   tests/benchmarks/micro_benchmark \
+                   tests/benchmarks/pipeline_benchmark
+
+tests_benchmarks_bus_benchmark_SOURCES = \
+    tests/benchmarks/BusBenchmark.cpp
+tests_benchmarks_bus_benchmark_CXXFLAGS = $(TESTING_CXXFLAGS) \
+                                          $(OLA_CFLAGS)
+tests_benchmarks_bus_benchmark_LDADD = \
+    tests/sim/libsim.la \
+    firmware/src/libcoarsetimer.la \
+    firmware/src/librdmutil.la \
+    firmware/src/libtransceiver.la \
+    tests/harmony/mocks/libharmonymock.la \
+    tests/mocks/libappmock.la \
+    tests/mocks/libflagsmock.la \
+    tests/mocks/libsyslogmock.la \
+    $(OLA_LIBS) $(TESTING_LIBS)
+
+# The dimmer model is built with the E1.20 maximum of 512 sub-devices.
+tests_benchmarks_dimmer_benchmark_SOURCES = \
+    tests/benchmarks/DimmerBenchmark.cpp \
+    firmware/src/dimmer_model.c \
+    firmware/src/model_arena.c
+tests_benchmarks_dimmer_benchmark_CFLAGS = $(BUILD_FLAGS) \
+                                           -DDIMMER_MODEL_SUB_DEVICES=512 \
+                                           -DMODEL_ARENA_SIZE=18432u
+tests_benchmarks_dimmer_benchmark_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_benchmarks_dimmer_benchmark_LDADD = \
+    firmware/src/libdimmercurve.la \
+    firmware/src/libdmxsnapshot.la \
+    firmware/src/libfader.la \
+    firmware/src/libpixelmapper.la \
+    firmware/src/librdmresponder.la \
+    firmware/src/libreceivercounters.la \
+    firmware/src/librdmbuffer.la \
+    firmware/src/librdmutil.la \
+    firmware/src/libtimerwheel.la \
+    tests/harmony/mocks/libharmonymock.la \
+    tests/mocks/libcoarsetimermock.la \
+    tests/mocks/libspirgbmock.la \
+    $(TESTING_LIBS)
+
+tests_benchmarks_dmx_rle_benchmark_SOURCES = \
+    tests/benchmarks/DMXRLEBenchmark.cpp
+tests_benchmarks_dmx_rle_benchmark_CXXFLAGS = $(TESTING_CFLAGS) \
+                                              $(WARNING_CXXFLAGS)
+tests_benchmarks_dmx_rle_benchmark_LDADD = firmware/src/libdmxrle.la
+
+# ./tests/benchmarks/micro_benchmark --json=results.json
+tests_benchmarks_micro_benchmark_SOURCES = \
+    tests/benchmarks/MicroBenchmark.cpp
+tests_benchmarks_micro_benchmark_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_benchmarks_micro_benchmark_LDADD = \
+    Bootloader/firmware/src/libbootloader.la \
+    firmware/src/libdimmermodel.la \
+    firmware/src/libledmodel.la \
+    firmware/src/libnetworkmodel.la \
+    firmware/src/libproxymodel.la \
+    firmware/src/libresponder.la \
+    firmware/src/librdmresponder.la \
+    firmware/src/libusbtransport.la \
+    firmware/src/libstreamdecoder.la \
+    firmware/src/libflags.la \
+    firmware/src/libspirgb.la \
+    firmware/src/libreceivercounters.la \
+    firmware/src/librdmbuffer.la \
+    firmware/src/librdmutil.la \
+    firmware/src/librandom.la \
+    firmware/src/libcoarsetimer.la \
+    tests/harmony/mocks/libharmonymock.la \
+    tests/mocks/libbootloaderoptionsmock.la \
+    tests/mocks/librdmhandlermock.la \
+    tests/mocks/libresetmock.la \
+    tests/mocks/libsyslogmock.la \
+    tests/mocks/libtransceivermock.la \
+    $(TESTING_LIBS)
+
+tests_benchmarks_pipeline_benchmark_SOURCES = \
+    tests/benchmarks/PipelineBenchmark.cpp
+tests_benchmarks_pipeline_benchmark_CXXFLAGS = $(TESTING_CXXFLAGS) \
+                                               $(OLA_CFLAGS)
+tests_benchmarks_pipeline_benchmark_LDADD = \
+    tests/sim/libsim.la \
+    firmware/src/libcoarsetimer.la \
+    firmware/src/libdmxrle.la \
+    firmware/src/libmessagehandler.la \
+    firmware/src/libstreamdecoder.la \
+    firmware/src/libtransceiver.la \
+    tests/harmony/mocks/libharmonymock.la \
+    tests/mocks/libappmock.la \
+    tests/mocks/libflagsmock.la \
+    tests/mocks/librdmhandlermock.la \
+    tests/mocks/libsyslogmock.la \
+    $(OLA_LIBS) $(TESTING_LIBS)
@@ -0,0 +1,792 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * MicroBenchmark.cpp
+ * Measures the per-call cost of the firmware hot paths.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <arpa/inet.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "constants.h"
+#include "crc.h"
+#include "dimmer_curve.h"
+#include "dimmer_model.h"
+#include "dmx_snapshot.h"
+#include "dmx_spec.h"
+#include "fader.h"
+#include "iovec.h"
+#include "led_model.h"
+#include "network_model.h"
+#include "pixel_encoder.h"
+#include "pixel_mapper.h"
+#include "proxy_model.h"
+#include "rdm.h"
+#include "rdm_frame.h"
+#include "rdm_model.h"
+#include "rdm_responder.h"
+#include "rdm_util.h"
+#include "responder.h"
+#include "spi_rgb.h"
+#include "stream_decoder.h"
+#include "transceiver.h"
+#include "usb_device_mock.h"
+#include "usb_transport.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+
+const uint8_t kUID[UID_LENGTH] = {0x7a, 0x70, 0x12, 0x34, 0x56, 0x78};
+const uint8_t kControllerUID[UID_LENGTH] = {0x7a, 0x70, 0, 0, 0, 1};
+
+uint64_t NowNs(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+// Stop the compiler from optimizing away a result.
+template <typename T>
+inline void DoNotOptimize(const T &value) {
+  asm volatile("" : : "g"(value) : "memory");
+}
+
+/*
+ * @brief Controls the timing loop of a benchmark.
+ *
+ * Each benchmark does its setup, then runs the code under test while
+ * KeepRunning() returns true.
+ */
+class State {
+ public:
+  explicit State(uint64_t iterations)
+      : m_iterations(iterations),
+        m_remaining(iterations),
+        m_bytes_per_iteration(0) {
+  }
+
+  bool KeepRunning() {
+    if (m_remaining == m_iterations) {
+      m_start_real = NowNs(CLOCK_MONOTONIC);
+      m_start_cpu = NowNs(CLOCK_PROCESS_CPUTIME_ID);
+    }
+    if (m_remaining--) {
+      return true;
+    }
+    m_real_ns = NowNs(CLOCK_MONOTONIC) - m_start_real;
+    m_cpu_ns = NowNs(CLOCK_PROCESS_CPUTIME_ID) - m_start_cpu;
+    return false;
+  }
+
+  // The number of bytes processed by each iteration, if that makes sense.
+  void SetBytesPerIteration(unsigned int bytes) {
+    m_bytes_per_iteration = bytes;
+  }
+
+  uint64_t Iterations() const { return m_iterations; }
+  uint64_t RealNs() const { return m_real_ns; }
+  uint64_t CpuNs() const { return m_cpu_ns; }
+  unsigned int BytesPerIteration() const { return m_bytes_per_iteration; }
+
+ private:
+  const uint64_t m_iterations;
+  uint64_t m_remaining;
+  unsigned int m_bytes_per_iteration;
+  uint64_t m_start_real = 0;
+  uint64_t m_start_cpu = 0;
+  uint64_t m_real_ns = 0;
+  uint64_t m_cpu_ns = 0;
+};
+
+typedef void (*BenchmarkFunction)(State *state);
+
+struct Benchmark {
+  string name;
+  BenchmarkFunction function;
+};
+
+struct Result {
+  string name;
+  uint64_t iterations;
+  double real_ns;  // per iteration
+  double cpu_ns;  // per iteration
+  double bytes_per_second;
+};
+
+// Build an RDM request with a valid checksum, returns the size of the frame.
+unsigned int BuildRequest(uint8_t *frame, const uint8_t *dest,
+                          RDMCommandClass command_class, uint16_t pid,
+                          const uint8_t *param_data, uint8_t pdl) {
+  RDMHeader *header = reinterpret_cast<RDMHeader*>(frame);
+  header->start_code = RDM_START_CODE;
+  header->sub_start_code = RDM_SUB_START_CODE;
+  header->message_length = sizeof(RDMHeader) + pdl;
+  memcpy(header->dest_uid, dest, UID_LENGTH);
+  memcpy(header->src_uid, kControllerUID, UID_LENGTH);
+  header->transaction_number = 0;
+  header->port_id = 1;
+  header->message_count = 0;
+  header->sub_device = 0;
+  header->command_class = command_class;
+  header->param_id = htons(pid);
+  header->param_data_length = pdl;
+  memcpy(frame + sizeof(RDMHeader), param_data, pdl);
+  return RDMUtil_AppendChecksum(frame);
+}
+
+// Stream Decoder
+// ----------------------------------------------------------------------------
+unsigned int g_messages = 0;
+
+void CountMessage(const Message *message) {
+  DoNotOptimize(message->length);
+  g_messages++;
+}
+
+// A TX_DMX message with a full universe, returns the size.
+unsigned int BuildDMXMessage(uint8_t *message) {
+  message[0] = START_OF_MESSAGE_ID;
+  message[1] = 1;
+  message[2] = TX_DMX;
+  message[3] = 0;
+  message[4] = (DMX_FRAME_SIZE & 0xff);
+  message[5] = DMX_FRAME_SIZE >> 8;
+  for (unsigned int i = 0; i < DMX_FRAME_SIZE; i++) {
+    message[6 + i] = i;
+  }
+  message[6 + DMX_FRAME_SIZE] = END_OF_MESSAGE_ID;
+  return DMX_FRAME_SIZE + 7;
+}
+
+void StreamDecoderUnfragmented(State *state) {
+  uint8_t message[DMX_FRAME_SIZE + 7];
+  unsigned int size = BuildDMXMessage(message);
+  StreamDecoder_Initialize(CountMessage);
+
+  while (state->KeepRunning()) {
+    StreamDecoder_Process(message, size);
+  }
+  state->SetBytesPerIteration(size);
+}
+
+void StreamDecoderFragmented(State *state) {
+  // The message is split over USB packets.
+  const unsigned int kPacketSize = 64;
+  uint8_t message[DMX_FRAME_SIZE + 7];
+  unsigned int size = BuildDMXMessage(message);
+  StreamDecoder_Initialize(CountMessage);
+
+  while (state->KeepRunning()) {
+    for (unsigned int offset = 0; offset < size; offset += kPacketSize) {
+      unsigned int chunk = size - offset;
+      StreamDecoder_Process(message + offset,
+                            chunk > kPacketSize ? kPacketSize : chunk);
+    }
+  }
+  state->SetBytesPerIteration(size);
+}
+
+// RDM Util
+// ----------------------------------------------------------------------------
+void VerifyChecksum(State *state, uint8_t pdl) {
+  uint8_t frame[RDM_MAX_FRAME_SIZE];
+  uint8_t param_data[UINT8_MAX];
+  memset(param_data, 0x55, sizeof(param_data));
+  unsigned int size = BuildRequest(frame, kUID, GET_COMMAND, PID_DEVICE_INFO,
+                                   param_data, pdl);
+
+  while (state->KeepRunning()) {
+    DoNotOptimize(RDMUtil_VerifyChecksum(frame, size));
+  }
+  state->SetBytesPerIteration(size);
+}
+
+void VerifyChecksumMin(State *state) {
+  VerifyChecksum(state, 0);
+}
+
+void VerifyChecksumMax(State *state) {
+  VerifyChecksum(state, UINT8_MAX - sizeof(RDMHeader));
+}
+
+// RDM Responder
+// ----------------------------------------------------------------------------
+void InitResponder() {
+  RDMResponderSettings settings;
+  memset(&settings, 0, sizeof(settings));
+  memcpy(settings.uid, kUID, UID_LENGTH);
+  RDMResponder_Initialize(&settings);
+}
+
+// The last GET handler in the table is the most expensive to find.
+uint16_t LastGetPID() {
+  const ResponderDefinition *def = g_responder->def;
+  for (unsigned int i = def->descriptor_count; i > 0; i--) {
+    const PIDDescriptor &descriptor = def->descriptors[i - 1];
+    if (descriptor.get_handler && descriptor.get_param_size == 0) {
+      return descriptor.pid;
+    }
+  }
+  return PID_DEVICE_INFO;
+}
+
+void Dispatch(State *state, const ModelEntry *model, void (*init)(),
+              uint16_t pid) {
+  InitResponder();
+  init();
+  model->activate_fn();
+  if (pid == 0) {
+    pid = LastGetPID();
+  }
+
+  uint8_t frame[RDM_MAX_FRAME_SIZE];
+  BuildRequest(frame, kUID, GET_COMMAND, pid, NULL, 0);
+  const RDMHeader *header = reinterpret_cast<const RDMHeader*>(frame);
+
+  while (state->KeepRunning()) {
+    DoNotOptimize(RDMResponder_DispatchPID(header, NULL));
+  }
+  model->deactivate_fn();
+}
+
+// A PID none of the models support, this scans the entire table.
+const uint16_t kUnknownPID = 0x7fff;
+
+#define DISPATCH_BENCHMARKS(name, entry, init) \
+  void Dispatch ## name ## DeviceInfo(State *state) { \
+    Dispatch(state, &entry, init, PID_DEVICE_INFO); \
+  } \
+  void Dispatch ## name ## LastPID(State *state) { \
+    Dispatch(state, &entry, init, 0); \
+  } \
+  void Dispatch ## name ## UnknownPID(State *state) { \
+    Dispatch(state, &entry, init, kUnknownPID); \
+  }
+
+DISPATCH_BENCHMARKS(LED, LED_MODEL_ENTRY, LEDModel_Initialize)
+DISPATCH_BENCHMARKS(Proxy, PROXY_MODEL_ENTRY, ProxyModel_Initialize)
+DISPATCH_BENCHMARKS(Network, NETWORK_MODEL_ENTRY, NetworkModel_Initialize)
+DISPATCH_BENCHMARKS(Dimmer, DIMMER_MODEL_ENTRY, DimmerModel_Initialize)
+
+void DUB(State *state, const uint8_t *lower, const uint8_t *upper) {
+  InitResponder();
+  uint8_t param_data[2 * UID_LENGTH];
+  memcpy(param_data, lower, UID_LENGTH);
+  memcpy(param_data + UID_LENGTH, upper, UID_LENGTH);
+
+  while (state->KeepRunning()) {
+    DoNotOptimize(RDMResponder_HandleDUBRequest(param_data,
+                                                sizeof(param_data)));
+  }
+}
+
+void DUBInRange(State *state) {
+  const uint8_t lower[UID_LENGTH] = {0, 0, 0, 0, 0, 0};
+  const uint8_t upper[UID_LENGTH] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+  DUB(state, lower, upper);
+}
+
+void DUBOutOfRange(State *state) {
+  const uint8_t lower[UID_LENGTH] = {0, 0, 0, 0, 0, 0};
+  const uint8_t upper[UID_LENGTH] = {0x7a, 0x70, 0, 0, 0, 0};
+  DUB(state, lower, upper);
+}
+
+// Responder
+// ----------------------------------------------------------------------------
+void BuildDMXFrame(uint8_t *frame) {
+  frame[0] = NULL_START_CODE;
+  for (unsigned int i = 0; i < DMX_FRAME_SIZE; i++) {
+    frame[i + 1] = i;
+  }
+}
+
+void ResponderDMXFrame(State *state) {
+  uint8_t frame[DMX_FRAME_SIZE + 1];
+  BuildDMXFrame(frame);
+  TransceiverEvent event = {
+    0, T_OP_RX, T_RESULT_RX_START_FRAME, frame, sizeof(frame), NULL
+  };
+  Responder_Initialize();
+
+  while (state->KeepRunning()) {
+    Responder_Receive(&event);
+  }
+  state->SetBytesPerIteration(sizeof(frame));
+}
+
+void ResponderDMXPerSlot(State *state) {
+  // The transceiver delivers an event as each slot arrives.
+  uint8_t frame[DMX_FRAME_SIZE + 1];
+  BuildDMXFrame(frame);
+  TransceiverEvent event = {
+    0, T_OP_RX, T_RESULT_RX_START_FRAME, frame, 0, NULL
+  };
+  Responder_Initialize();
+
+  while (state->KeepRunning()) {
+    for (unsigned int i = 1; i <= sizeof(frame); i++) {
+      event.result = i == 1 ? T_RESULT_RX_START_FRAME :
+                     T_RESULT_RX_CONTINUE_FRAME;
+      event.length = i;
+      Responder_Receive(&event);
+    }
+  }
+  state->SetBytesPerIteration(sizeof(frame));
+}
+
+void DMXSnapshotRead(State *state) {
+  uint8_t frame[DMX_FRAME_SIZE + 1];
+  BuildDMXFrame(frame);
+  DMXSnapshot_Initialize();
+  DMXSnapshot_Receive(frame + 1, DMX_FRAME_SIZE);
+  DMXSnapshot_FrameComplete();
+
+  uint8_t slots[DMX_FRAME_SIZE];
+  uint16_t slot_count;
+  while (state->KeepRunning()) {
+    DoNotOptimize(DMXSnapshot_Read(slots, 0u, DMX_FRAME_SIZE, &slot_count));
+  }
+  state->SetBytesPerIteration(DMX_FRAME_SIZE);
+}
+
+// USB Transport
+// ----------------------------------------------------------------------------
+
+/*
+ * @brief A USB device which accepts every transfer.
+ *
+ * The gmock version would dominate the timing.
+ */
+class NullUSBDevice : public USBDeviceInterface {
+ public:
+  NullUSBDevice() : m_handler(NULL), m_context(0) {}
+
+  void Configure() {
+    uint8_t configuration = 1;
+    USBTransport_Tasks();
+    m_handler(USB_DEVICE_EVENT_POWER_DETECTED, NULL, m_context);
+    m_handler(USB_DEVICE_EVENT_CONFIGURED, &configuration, m_context);
+    for (unsigned int i = 0; i < 4; i++) {
+      USBTransport_Tasks();
+    }
+  }
+
+  void CompleteWrite() {
+    m_handler(USB_DEVICE_EVENT_ENDPOINT_WRITE_COMPLETE, NULL, m_context);
+  }
+
+  void Attach(USB_DEVICE_HANDLE) {}
+  void Detach(USB_DEVICE_HANDLE) {}
+  USB_DEVICE_HANDLE Open(const uint16_t, const DRV_IO_INTENT) { return 1; }
+  void EventHandlerSet(USB_DEVICE_HANDLE,
+                       const USB_DEVICE_EVENT_HANDLER handler,
+                       uintptr_t context) {
+    m_handler = handler;
+    m_context = context;
+  }
+  USB_DEVICE_CONTROL_TRANSFER_RESULT ControlStatus(
+      USB_DEVICE_HANDLE, USB_DEVICE_CONTROL_STATUS) {
+    return USB_DEVICE_CONTROL_TRANSFER_RESULT_SUCCESS;
+  }
+  USB_DEVICE_CONTROL_TRANSFER_RESULT ControlSend(USB_DEVICE_HANDLE, void*,
+                                                 size_t) {
+    return USB_DEVICE_CONTROL_TRANSFER_RESULT_SUCCESS;
+  }
+  USB_DEVICE_CONTROL_TRANSFER_RESULT ControlReceive(USB_DEVICE_HANDLE, void*,
+                                                    size_t) {
+    return USB_DEVICE_CONTROL_TRANSFER_RESULT_SUCCESS;
+  }
+  USB_SPEED ActiveSpeedGet(USB_DEVICE_HANDLE) { return USB_SPEED_FULL; }
+  bool EndpointIsEnabled(USB_DEVICE_HANDLE, USB_ENDPOINT_ADDRESS) {
+    return true;
+  }
+  USB_DEVICE_RESULT EndpointEnable(USB_DEVICE_HANDLE, uint8_t,
+                                   USB_ENDPOINT_ADDRESS, USB_TRANSFER_TYPE,
+                                   size_t) {
+    return USB_DEVICE_RESULT_OK;
+  }
+  USB_DEVICE_RESULT EndpointDisable(USB_DEVICE_HANDLE, USB_ENDPOINT_ADDRESS) {
+    return USB_DEVICE_RESULT_OK;
+  }
+  void EndpointStall(USB_DEVICE_HANDLE, USB_ENDPOINT_ADDRESS) {}
+  USB_DEVICE_RESULT EndpointRead(USB_DEVICE_HANDLE,
+                                 USB_DEVICE_TRANSFER_HANDLE*,
+                                 USB_ENDPOINT_ADDRESS, void*, size_t) {
+    return USB_DEVICE_RESULT_OK;
+  }
+  USB_DEVICE_RESULT EndpointWrite(USB_DEVICE_HANDLE,
+                                  USB_DEVICE_TRANSFER_HANDLE*,
+                                  USB_ENDPOINT_ADDRESS, const void *data,
+                                  size_t size, USB_DEVICE_TRANSFER_FLAGS) {
+    DoNotOptimize(data);
+    DoNotOptimize(size);
+    return USB_DEVICE_RESULT_OK;
+  }
+  USB_DEVICE_RESULT EndpointTransferCancel(USB_DEVICE_HANDLE,
+                                           USB_ENDPOINT_ADDRESS,
+                                           USB_DEVICE_TRANSFER_HANDLE) {
+    return USB_DEVICE_RESULT_OK;
+  }
+
+ private:
+  USB_DEVICE_EVENT_HANDLER m_handler;
+  uintptr_t m_context;
+};
+
+void SendResponse(State *state, const IOVec *iov, unsigned int iov_count) {
+  NullUSBDevice usb_device;
+  USBDevice_SetMock(&usb_device);
+  USBTransport_Initialize(NULL);
+  usb_device.Configure();
+
+  unsigned int size = 0;
+  for (unsigned int i = 0; i < iov_count; i++) {
+    size += iov[i].length;
+  }
+
+  while (state->KeepRunning()) {
+    if (!USBTransport_SendResponse(1, TX_DMX, RC_OK, iov, iov_count)) {
+      printf("USBTransport_SendResponse failed\n");
+      exit(1);
+    }
+    usb_device.CompleteWrite();
+  }
+  state->SetBytesPerIteration(size);
+  USBDevice_SetMock(NULL);
+}
+
+void SendResponseEmpty(State *state) {
+  SendResponse(state, NULL, 0);
+}
+
+void SendResponseFull(State *state) {
+  // The usual case for a large response, a header & the data.
+  uint8_t data[PAYLOAD_SIZE];
+  memset(data, 0x55, sizeof(data));
+  IOVec iov[] = {{data, 1}, {data + 1, PAYLOAD_SIZE - 1}};
+  SendResponse(state, iov, 2);
+}
+
+// SPI RGB
+// ----------------------------------------------------------------------------
+void SetPixelUniverse(State *state) {
+  SPIRGBConfiguration config;
+  memset(&config, 0, sizeof(config));
+  SPIRGB_Init(&config);
+
+  while (state->KeepRunning()) {
+    SPIRGB_BeginUpdate();
+    for (unsigned int slot = 0; slot < DMX_FRAME_SIZE; slot++) {
+      SPIRGB_SetPixel(slot / 3u, static_cast<RGB_Color>(slot % 3u), slot);
+    }
+    SPIRGB_CompleteUpdate();
+  }
+  state->SetBytesPerIteration(DMX_FRAME_SIZE);
+}
+
+void MapPixelUniverse(State *state) {
+  SPIRGBConfiguration config;
+  memset(&config, 0, sizeof(config));
+  SPIRGB_Init(&config);
+
+  PixelMapperSettings settings;
+  settings.start_address = 1u;
+  settings.pixel_count = PIXEL_MAPPER_MAX_PIXELS;
+  settings.group_size = 1u;
+  settings.order = PIXEL_ORDER_GRB;
+  settings.reverse = true;
+  PixelMapper_Configure(&settings);
+
+  uint8_t frame[DMX_FRAME_SIZE + 1];
+  BuildDMXFrame(frame);
+  uint8_t pixels[PIXEL_MAPPER_MAX_PIXELS * PIXEL_MAPPER_SLOTS_PER_PIXEL];
+
+  while (state->KeepRunning()) {
+    PixelMapper_Map(pixels, frame + 1, DMX_FRAME_SIZE);
+    SPIRGB_BeginUpdate();
+    SPIRGB_SetPixels(pixels, PIXEL_MAPPER_MAX_PIXELS);
+    SPIRGB_CompleteUpdate();
+  }
+  state->SetBytesPerIteration(sizeof(pixels));
+}
+
+void EncodePixels(State *state, PixelType type) {
+  const PixelEncoder *encoder = PixelEncoder_Get(type);
+  uint8_t frame[DMX_FRAME_SIZE + 1];
+  BuildDMXFrame(frame);
+  uint8_t output[PIXEL_ENCODER_MAX_FRAME_SIZE(PIXEL_MAPPER_MAX_PIXELS)];
+
+  while (state->KeepRunning()) {
+    PixelEncoder_Encode(encoder, output, frame + 1, PIXEL_MAPPER_MAX_PIXELS);
+  }
+  state->SetBytesPerIteration(
+      PixelEncoder_FrameSize(encoder, PIXEL_MAPPER_MAX_PIXELS));
+}
+
+#define ENCODE_BENCHMARK(name, type) \
+  void Encode ## name(State *state) { \
+    EncodePixels(state, type); \
+  }
+
+ENCODE_BENCHMARK(LPD8806, PIXEL_TYPE_LPD8806)
+ENCODE_BENCHMARK(WS2801, PIXEL_TYPE_WS2801)
+ENCODE_BENCHMARK(P9813, PIXEL_TYPE_P9813)
+ENCODE_BENCHMARK(APA102, PIXEL_TYPE_APA102)
+ENCODE_BENCHMARK(WS2812, PIXEL_TYPE_WS2812)
+
+// Dimmer Curve
+// ----------------------------------------------------------------------------
+void DimmerCurveUniverse(State *state) {
+  DimmerCurveSettings settings;
+  settings.type = DIMMER_CURVE_MODIFIED_SQUARE;
+  settings.min_level = 0x1000;
+  settings.max_level = 0xfffe;
+  settings.on_below_min = false;
+  DimmerCurve curve;
+  DimmerCurve_Build(&curve, &settings);
+
+  uint8_t frame[DMX_FRAME_SIZE + 1];
+  BuildDMXFrame(frame);
+  uint16_t levels[DMX_FRAME_SIZE];
+
+  while (state->KeepRunning()) {
+    DimmerCurve_Apply(&curve, levels, frame + 1, DMX_FRAME_SIZE);
+  }
+  state->SetBytesPerIteration(DMX_FRAME_SIZE);
+}
+
+// Fader
+// ----------------------------------------------------------------------------
+void FadeUniverse(State *state) {
+  FaderChannel channels[DMX_FRAME_SIZE];
+  uint8_t targets[DMX_FRAME_SIZE];
+  for (unsigned int i = 0; i < DMX_FRAME_SIZE; i++) {
+    targets[i] = i;
+  }
+  Fader_Set(channels, DMX_FRAME_SIZE, 0);
+
+  // A 10 minute fade never completes, so each tick steps every channel.
+  Fader_Start(channels, targets, DMX_FRAME_SIZE, 30000u, 30000u);
+  while (state->KeepRunning()) {
+    Fader_Tick(channels, DMX_FRAME_SIZE);
+  }
+  state->SetBytesPerIteration(DMX_FRAME_SIZE);
+}
+
+// CRC
+// ----------------------------------------------------------------------------
+void CRCFlashPage(State *state) {
+  // The bootloader CRCs the firmware image a page at a time.
+  uint8_t page[4096];
+  for (unsigned int i = 0; i < sizeof(page); i++) {
+    page[i] = i * 7;
+  }
+
+  while (state->KeepRunning()) {
+    DoNotOptimize(CalculateCRC(0xffffffff, page, sizeof(page)));
+  }
+  state->SetBytesPerIteration(sizeof(page));
+}
+
+// Runner
+// ----------------------------------------------------------------------------
+#define BENCHMARK(fn) {#fn, fn}
+
+const Benchmark kBenchmarks[] = {
+  BENCHMARK(StreamDecoderUnfragmented),
+  BENCHMARK(StreamDecoderFragmented),
+  BENCHMARK(VerifyChecksumMin),
+  BENCHMARK(VerifyChecksumMax),
+  BENCHMARK(DispatchLEDDeviceInfo),
+  BENCHMARK(DispatchLEDLastPID),
+  BENCHMARK(DispatchLEDUnknownPID),
+  BENCHMARK(DispatchProxyDeviceInfo),
+  BENCHMARK(DispatchProxyLastPID),
+  BENCHMARK(DispatchProxyUnknownPID),
+  BENCHMARK(DispatchNetworkDeviceInfo),
+  BENCHMARK(DispatchNetworkLastPID),
+  BENCHMARK(DispatchNetworkUnknownPID),
+  BENCHMARK(DispatchDimmerDeviceInfo),
+  BENCHMARK(DispatchDimmerLastPID),
+  BENCHMARK(DispatchDimmerUnknownPID),
+  BENCHMARK(DUBInRange),
+  BENCHMARK(DUBOutOfRange),
+  BENCHMARK(ResponderDMXFrame),
+  BENCHMARK(ResponderDMXPerSlot),
+  BENCHMARK(DMXSnapshotRead),
+  BENCHMARK(SendResponseEmpty),
+  BENCHMARK(SendResponseFull),
+  BENCHMARK(SetPixelUniverse),
+  BENCHMARK(MapPixelUniverse),
+  BENCHMARK(EncodeLPD8806),
+  BENCHMARK(EncodeWS2801),
+  BENCHMARK(EncodeP9813),
+  BENCHMARK(EncodeAPA102),
+  BENCHMARK(EncodeWS2812),
+  BENCHMARK(DimmerCurveUniverse),
+  BENCHMARK(FadeUniverse),
+  BENCHMARK(CRCFlashPage),
+};
+
+/*
+ * @brief Run a benchmark for at least min_time seconds.
+ *
+ * The iteration count grows until a run takes long enough to be measured.
+ */
+Result Run(const Benchmark &benchmark, double min_time) {
+  uint64_t iterations = 1;
+  while (true) {
+    State state(iterations);
+    benchmark.function(&state);
+
+    double seconds = state.RealNs() / 1e9;
+    if (seconds >= min_time || iterations >= 1000000000ull) {
+      Result result;
+      result.name = benchmark.name;
+      result.iterations = iterations;
+      result.real_ns = static_cast<double>(state.RealNs()) / iterations;
+      result.cpu_ns = static_cast<double>(state.CpuNs()) / iterations;
+      result.bytes_per_second = seconds > 0 ?
+          state.BytesPerIteration() * iterations / seconds : 0;
+      return result;
+    }
+
+    // Aim 40% past the target, but don't grow by more than 10x at a time.
+    double multiplier = seconds > 0 ? min_time * 1.4 / seconds : 10;
+    if (multiplier > 10) {
+      multiplier = 10;
+    }
+    uint64_t next = static_cast<uint64_t>(iterations * multiplier);
+    iterations = next > iterations ? next : iterations + 1;
+  }
+}
+
+/*
+ * @brief Write the results as JSON.
+ *
+ * This uses the same layout as Google Benchmark's --benchmark_format=json, so
+ * the results can be compared with its tools/compare.py.
+ */
+void WriteJSON(FILE *out, const char *executable,
+               const vector<Result> &results) {
+  char date[64];
+  time_t now = time(NULL);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+
+  fprintf(out, "{\n");
+  fprintf(out, "  \"context\": {\n");
+  fprintf(out, "    \"date\": \"%s\",\n", date);
+  fprintf(out, "    \"executable\": \"%s\",\n", executable);
+  fprintf(out, "    \"num_cpus\": %ld\n", sysconf(_SC_NPROCESSORS_ONLN));
+  fprintf(out, "  },\n");
+  fprintf(out, "  \"benchmarks\": [\n");
+  for (unsigned int i = 0; i < results.size(); i++) {
+    const Result &result = results[i];
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"name\": \"%s\",\n", result.name.c_str());
+    fprintf(out, "      \"run_name\": \"%s\",\n", result.name.c_str());
+    fprintf(out, "      \"run_type\": \"iteration\",\n");
+    fprintf(out, "      \"iterations\": %llu,\n",
+            static_cast<unsigned long long>(result.iterations));  // NOLINT
+    fprintf(out, "      \"real_time\": %.3f,\n", result.real_ns);
+    fprintf(out, "      \"cpu_time\": %.3f,\n", result.cpu_ns);
+    if (result.bytes_per_second > 0) {
+      fprintf(out, "      \"bytes_per_second\": %.0f,\n",
+              result.bytes_per_second);
+    }
+    fprintf(out, "      \"time_unit\": \"ns\"\n");
+    fprintf(out, "    }%s\n", i + 1 == results.size() ? "" : ",");
+  }
+  fprintf(out, "  ]\n");
+  fprintf(out, "}\n");
+}
+
+void Usage(const char *arg0) {
+  printf("Usage: %s [--filter=substring] [--json=file] [--min_time=s]\n\n"
+         "Times the firmware hot paths on the host. The times are useful for\n"
+         "tracking regressions, not as an estimate of the PIC32 cycle counts.\n"
+         "\n"
+         "  --filter=substring  Only run benchmarks with a matching name.\n"
+         "  --json=file         Write the results as JSON, - for stdout.\n"
+         "  --min_time=s        The minimum time to run each benchmark for.\n",
+         arg0);
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  string filter;
+  string json_file;
+  double min_time = 0.2;
+
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    if (arg.compare(0, 9, "--filter=") == 0) {
+      filter = arg.substr(9);
+    } else if (arg.compare(0, 7, "--json=") == 0) {
+      json_file = arg.substr(7);
+    } else if (arg.compare(0, 11, "--min_time=") == 0) {
+      min_time = atof(arg.substr(11).c_str());
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  // With JSON on stdout, the table goes to stderr.
+  FILE *table = json_file == "-" ? stderr : stdout;
+  fprintf(table, "%-28s %12s %12s %12s %10s\n", "Benchmark", "Time (ns)",
+          "CPU (ns)", "Iterations", "MB/s");
+
+  vector<Result> results;
+  for (const Benchmark &benchmark : kBenchmarks) {
+    if (benchmark.name.find(filter) == string::npos) {
+      continue;
+    }
+    Result result = Run(benchmark, min_time);
+    fprintf(table, "%-28s %12.1f %12.1f %12llu", result.name.c_str(),
+            result.real_ns, result.cpu_ns,
+            static_cast<unsigned long long>(result.iterations));  // NOLINT
+    if (result.bytes_per_second > 0) {
+      fprintf(table, " %10.1f", result.bytes_per_second / 1e6);
+    }
+    fprintf(table, "\n");
+    results.push_back(result);
+  }
+
+  if (!json_file.empty()) {
+    FILE *out = json_file == "-" ? stdout : fopen(json_file.c_str(), "w");
+    if (!out) {
+      perror(json_file.c_str());
+      return 1;
+    }
+    WriteJSON(out, argv[0], results);
+    if (out != stdout) {
+      fclose(out);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,490 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * PipelineBenchmark.cpp
+ * Measures throughput & latency through the full firmware pipeline.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "coarse_timer.h"
+#include "constants.h"
+#include "dmx_rle.h"
+#include "dmx_spec.h"
+#include "message_handler.h"
+#include "setting_macros.h"
+#include "stream_decoder.h"
+#include "transceiver.h"
+
+#include "Array.h"
+#include "tests/sim/InterruptController.h"
+#include "tests/sim/PeripheralInputCapture.h"
+#include "tests/sim/PeripheralTimer.h"
+#include "tests/sim/PeripheralUART.h"
+#include "tests/sim/SignalGenerator.h"
+#include "tests/sim/Simulator.h"
+
+using std::string;
+using std::vector;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Declare the ISR symbols.
+void InputCaptureEvent(void);
+void Transceiver_TimerEvent();
+void Transceiver_UARTEvent();
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace {
+
+const uint32_t kClockSpeed = 80000000;
+const uint32_t kBaudRate = 250000;
+const unsigned int kCyclesPerMicroSecond = kClockSpeed / 1000000;
+
+// Full speed USB bulk transfers move at most 19 64 byte packets per 1ms
+// frame.
+const unsigned int kUSBPacketSize = USB_MAX_PACKET_SIZE;
+const unsigned int kCyclesPerUSBPacket = kClockSpeed / 19000;
+
+// The number of cycles to transfer size bytes over USB.
+uint64_t USBCycles(unsigned int size) {
+  return ((size + kUSBPacketSize - 1) / kUSBPacketSize) * kCyclesPerUSBPacket;
+}
+
+// A RDM GET request (excluding the start code) and the matching response.
+const uint8_t kRDMRequest[] = {
+  0x01, 0x18, 0x7a, 0x70, 0x00, 0x00, 0x00, 0x00, 0x7a, 0x70, 0x00, 0x00,
+  0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0xf0, 0x00, 0x03, 0xca
+};
+
+const uint8_t kRDMResponse[] = {
+  0xcc, 0x01, 0x19, 0x7a, 0x70, 0x00, 0x00, 0x00, 0x00, 0x7a, 0x70, 0x00, 0x00,
+  0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x00, 0xf0, 0x01, 0x01, 0x03,
+  0xce
+};
+
+// A set of identical commands to push through the pipeline.
+struct Workload {
+  string name;
+  Command command;
+  vector<uint8_t> payload;
+  // If true, the simulated responder answers each RDM request.
+  bool rdm_response;
+};
+
+struct Result {
+  unsigned int completed;
+  unsigned int errors;
+  unsigned int retries;  // RC_BUFFER_FULL responses
+  uint64_t cycles;
+  double wall_time_ms;
+  vector<uint64_t> latencies;  // in cycles
+};
+
+class PipelineBenchmark;
+PipelineBenchmark *g_benchmark = nullptr;
+
+bool TransportTX(uint8_t token, Command command, uint8_t rc,
+                 const IOVec* iov, unsigned int iov_count);
+
+unsigned int IOVecLength(const IOVec* iov, unsigned int iov_count) {
+  unsigned int length = 0;
+  for (unsigned int i = 0; i < iov_count; i++) {
+    length += iov[i].length;
+  }
+  return length;
+}
+
+bool TransceiverEvent(const TransceiverEvent *event) {
+  MessageHandler_TransceiverEvent(event);
+  return true;
+}
+
+class PipelineBenchmark {
+ public:
+  PipelineBenchmark(unsigned int count, unsigned int window)
+      : m_count(count),
+        m_window(window),
+        m_tx_callback(ola::NewCallback(this, &PipelineBenchmark::UARTTX)),
+        m_host_task(ola::NewCallback(this, &PipelineBenchmark::HostTask)),
+        m_transceiver_task(ola::NewCallback(&Transceiver_Tasks)),
+        m_simulator(kClockSpeed),
+        m_timer(&m_simulator, &m_interrupt_controller),
+        m_ic(&m_simulator, &m_interrupt_controller),
+        m_uart(&m_simulator, &m_interrupt_controller, m_tx_callback.get()),
+        m_generator(&m_simulator, &m_ic, &m_uart, AS_IC_ID(2),
+                    AS_USART_ID(1), kClockSpeed, kBaudRate),
+        m_workload(nullptr),
+        m_next_token(0),
+        m_out_busy(false),
+        m_deliver_at(0),
+        m_sent(0),
+        m_in_flight(0),
+        m_tx_bytes(0),
+        m_mode_changed(false) {
+  }
+
+  bool Init();
+  Result Run(const Workload &workload);
+
+  void Response(uint8_t token, Command command, uint8_t rc,
+                unsigned int payload_size);
+
+ private:
+  const unsigned int m_count;
+  const unsigned int m_window;
+
+  std::unique_ptr<PeripheralUART::TXCallback> m_tx_callback;
+  std::unique_ptr<ola::Callback0<void>> m_host_task;
+  std::unique_ptr<ola::Callback0<void>> m_transceiver_task;
+
+  Simulator m_simulator;
+  InterruptController m_interrupt_controller;
+  PeripheralTimer m_timer;
+  PeripheralInputCapture m_ic;
+  PeripheralUART m_uart;
+  SignalGenerator m_generator;
+
+  const Workload *m_workload;
+  Result m_result;
+  std::map<uint8_t, uint64_t> m_sent_at;
+  // Commands rejected with RC_BUFFER_FULL, keyed by the original send time.
+  std::deque<uint64_t> m_retries;
+  uint8_t m_next_token;
+  // The frame currently being transferred over USB.
+  bool m_out_busy;
+  vector<uint8_t> m_out_frame;
+  uint64_t m_deliver_at;
+  unsigned int m_sent;
+  unsigned int m_in_flight;
+  unsigned int m_tx_bytes;
+  bool m_mode_changed;
+
+  void HostTask();
+  void UARTTX(USART_MODULE_ID uart_id, uint8_t byte);
+};
+
+bool PipelineBenchmark::Init() {
+  PLIB_TMR_SetMock(&m_timer);
+  PLIB_IC_SetMock(&m_ic);
+  PLIB_USART_SetMock(&m_uart);
+  SYS_INT_SetMock(&m_interrupt_controller);
+
+  m_interrupt_controller.RegisterISR(INT_SOURCE_TIMER_1,
+      ola::NewCallback(&CoarseTimer_TimerEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_TIMER_3,
+      ola::NewCallback(&Transceiver_TimerEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_INPUT_CAPTURE_2,
+      ola::NewCallback(&InputCaptureEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_USART_1_ERROR,
+      ola::NewCallback(&Transceiver_UARTEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_USART_1_TRANSMIT,
+      ola::NewCallback(&Transceiver_UARTEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_USART_1_RECEIVE,
+      ola::NewCallback(&Transceiver_UARTEvent));
+
+  TransceiverHardwareSettings settings = {
+    .usart = AS_USART_ID(1),
+    .usart_vector = AS_USART_INTERRUPT_VECTOR(1),
+    .usart_tx_source = AS_USART_INTERRUPT_TX_SOURCE(1),
+    .usart_rx_source = AS_USART_INTERRUPT_RX_SOURCE(1),
+    .usart_error_source = AS_USART_INTERRUPT_ERROR_SOURCE(1),
+    .port = PORT_CHANNEL_F,
+    .break_bit = PORTS_BIT_POS_8,
+    .tx_enable_bit = PORTS_BIT_POS_1,
+    .rx_enable_bit = PORTS_BIT_POS_0,
+    .input_capture_module = AS_IC_ID(2),
+    .input_capture_vector = AS_IC_INTERRUPT_VECTOR(2),
+    .input_capture_source = AS_IC_INTERRUPT_SOURCE(2),
+    .timer_module_id = AS_TIMER_ID(3),
+    .timer_vector = AS_TIMER_INTERRUPT_VECTOR(3),
+    .timer_source = AS_TIMER_INTERRUPT_SOURCE(3),
+    .input_capture_timer = AS_IC_TMR_ID(3),
+  };
+  Transceiver_Initialize(&settings, &TransceiverEvent, &TransceiverEvent);
+
+  CoarseTimer_Settings timer_settings = {
+    .timer_id = AS_TIMER_ID(1),
+    .interrupt_source = AS_TIMER_INTERRUPT_SOURCE(1)
+  };
+  CoarseTimer_Initialize(&timer_settings);
+
+  MessageHandler_Initialize(&TransportTX);
+  StreamDecoder_Initialize(&MessageHandler_HandleMessage);
+
+  // Switch to controller mode.
+  m_simulator.AddTask(m_transceiver_task.get());
+  const uint8_t mode = T_MODE_CONTROLLER;
+  const uint8_t frame[] = {
+    START_OF_MESSAGE_ID, 0, COMMAND_SET_MODE & 0xff, COMMAND_SET_MODE >> 8,
+    1, 0, mode, END_OF_MESSAGE_ID
+  };
+  StreamDecoder_Process(frame, sizeof(frame));
+  m_simulator.SetClockLimit(10000, false);
+  m_simulator.Run();
+  return m_mode_changed && Transceiver_GetMode() == T_MODE_CONTROLLER;
+}
+
+Result PipelineBenchmark::Run(const Workload &workload) {
+  m_workload = &workload;
+  m_result = Result();
+  m_result.latencies.reserve(m_count);
+  m_sent_at.clear();
+  m_retries.clear();
+  m_out_busy = false;
+  m_sent = 0;
+  m_in_flight = 0;
+  m_tx_bytes = 0;
+
+  // Allow 100ms of simulated time per command. The limit is measured from the
+  // current clock, which carries on from the previous workload.
+  m_simulator.SetClockLimit(100000ull * m_count, false);
+  m_simulator.AddTask(m_host_task.get());
+
+  auto start = std::chrono::steady_clock::now();
+  m_simulator.Run();
+  m_result.wall_time_ms = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+
+  m_simulator.RemoveTask(m_host_task.get());
+  m_workload = nullptr;
+  return m_result;
+}
+
+void PipelineBenchmark::Response(uint8_t token, Command command, uint8_t rc,
+                                 unsigned int payload_size) {
+  if (command == COMMAND_SET_MODE) {
+    m_mode_changed = rc == RC_OK;
+    m_simulator.Stop();
+    return;
+  }
+
+  auto iter = m_sent_at.find(token);
+  if (m_workload == nullptr || iter == m_sent_at.end()) {
+    return;
+  }
+
+  uint64_t sent_at = iter->second;
+  m_sent_at.erase(iter);
+  m_in_flight--;
+
+  if (rc == RC_BUFFER_FULL) {
+    // The Host would resend the command.
+    m_result.retries++;
+    m_retries.push_back(sent_at);
+    return;
+  }
+
+  // Include the time to return the response (+ 9 bytes of framing).
+  uint64_t received_at = m_simulator.Clock() + USBCycles(payload_size + 9);
+  m_result.latencies.push_back(received_at - sent_at);
+  m_result.cycles = std::max(m_result.cycles, received_at);
+  m_result.completed++;
+  if (rc != RC_OK) {
+    m_result.errors++;
+  }
+  if (m_result.completed == m_count) {
+    m_simulator.Stop();
+  }
+}
+
+/*
+ * Acts as the Host, sending a new command whenever the window is open.
+ *
+ * Frames are delivered to the StreamDecoder once the simulated USB transfer
+ * completes, only one transfer is in progress at once.
+ */
+void PipelineBenchmark::HostTask() {
+  if (m_out_busy) {
+    if (m_simulator.Clock() >= m_deliver_at) {
+      m_out_busy = false;
+      StreamDecoder_Process(m_out_frame.data(), m_out_frame.size());
+    }
+    return;
+  }
+
+  bool retry = !m_retries.empty();
+  if ((!retry && m_sent == m_count) || m_in_flight >= m_window) {
+    return;
+  }
+
+  // Skip over tokens that are still in use.
+  while (m_sent_at.find(m_next_token) != m_sent_at.end()) {
+    m_next_token++;
+  }
+
+  const vector<uint8_t> &payload = m_workload->payload;
+  m_out_frame.clear();
+  m_out_frame.push_back(START_OF_MESSAGE_ID);
+  m_out_frame.push_back(m_next_token);
+  m_out_frame.push_back(m_workload->command & 0xff);
+  m_out_frame.push_back(m_workload->command >> 8);
+  m_out_frame.push_back(payload.size() & 0xff);
+  m_out_frame.push_back(payload.size() >> 8);
+  m_out_frame.insert(m_out_frame.end(), payload.begin(), payload.end());
+  m_out_frame.push_back(END_OF_MESSAGE_ID);
+
+  if (retry) {
+    m_sent_at[m_next_token] = m_retries.front();
+    m_retries.pop_front();
+  } else {
+    m_sent_at[m_next_token] = m_simulator.Clock();
+    m_sent++;
+  }
+  m_next_token++;
+  m_in_flight++;
+  m_out_busy = true;
+  m_deliver_at = m_simulator.Clock() + USBCycles(m_out_frame.size());
+}
+
+void PipelineBenchmark::UARTTX(USART_MODULE_ID uart_id, uint8_t byte) {
+  if (uart_id != AS_USART_ID(1) || m_workload == nullptr ||
+      !m_workload->rdm_response) {
+    return;
+  }
+  (void) byte;
+
+  // Once the request (plus start code) has been sent, reply to it.
+  m_tx_bytes++;
+  if (m_tx_bytes == arraysize(kRDMRequest) + 1) {
+    m_tx_bytes = 0;
+    m_generator.AddDelay(176);
+    m_generator.AddBreak(176);
+    m_generator.AddMark(12);
+    m_generator.AddFrame(kRDMResponse, arraysize(kRDMResponse));
+  }
+}
+
+bool TransportTX(uint8_t token, Command command, uint8_t rc,
+                 const IOVec* iov, unsigned int iov_count) {
+  if (g_benchmark) {
+    g_benchmark->Response(token, command, rc, IOVecLength(iov, iov_count));
+  }
+  return true;
+}
+
+double ToMicroSeconds(uint64_t cycles) {
+  return static_cast<double>(cycles) / kCyclesPerMicroSecond;
+}
+
+uint64_t Percentile(const vector<uint64_t> &sorted, unsigned int percentile) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  return sorted[(sorted.size() - 1) * percentile / 100];
+}
+
+void PrintResult(const Workload &workload, Result *result) {
+  std::sort(result->latencies.begin(), result->latencies.end());
+  double seconds = ToMicroSeconds(result->cycles) / 1000000.0;
+  printf("%-10s %5u ok %3u err %4u retry %9.1f ops/s  latency us p50 %8.1f "
+         "p90 %8.1f p99 %8.1f max %8.1f  (wall %.0f ms)\n",
+         workload.name.c_str(), result->completed - result->errors,
+         result->errors, result->retries,
+         seconds > 0 ? result->completed / seconds : 0.0,
+         ToMicroSeconds(Percentile(result->latencies, 50)),
+         ToMicroSeconds(Percentile(result->latencies, 90)),
+         ToMicroSeconds(Percentile(result->latencies, 99)),
+         ToMicroSeconds(Percentile(result->latencies, 100)),
+         result->wall_time_ms);
+}
+
+void Usage(const char *arg0) {
+  printf("Usage: %s [-n count] [-w window]\n\n"
+         "Pushes framed messages through the StreamDecoder, MessageHandler &\n"
+         "Transceiver, with the peripherals simulated at %u MHz. Throughput &\n"
+         "latency are in simulated time and include the USB transfer time.\n"
+         "Commands rejected with RC_BUFFER_FULL are resent.\n\n"
+         "  -n count   The number of commands to send per workload.\n"
+         "  -w window  The number of commands the Host keeps in flight.\n",
+         arg0, kClockSpeed / 1000000);
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  unsigned int count = 100;
+  unsigned int window = 2;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      count = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+      window = atoi(argv[++i]);
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+  if (count == 0 || window == 0) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  vector<uint8_t> full_frame(DMX_FRAME_SIZE);
+  for (unsigned int i = 0; i < full_frame.size(); i++) {
+    full_frame[i] = i;
+  }
+
+  // A sparse universe, sent with RLE encoding.
+  vector<uint8_t> sparse_frame(DMX_FRAME_SIZE, 0);
+  for (unsigned int i = 0; i < sparse_frame.size(); i += 64) {
+    sparse_frame[i] = 255;
+  }
+  vector<uint8_t> rle_frame(DMX_FRAME_SIZE + DMX_FRAME_SIZE);
+  rle_frame.resize(DMXRLE_Encode(rle_frame.data(), rle_frame.size(),
+                                 sparse_frame.data(), sparse_frame.size()));
+
+  const Workload workloads[] = {
+    {"echo", COMMAND_ECHO, vector<uint8_t>(64, 0xaa), false},
+    {"dmx-24", TX_DMX, vector<uint8_t>(24, 0x80), false},
+    {"dmx-512", TX_DMX, full_frame, false},
+    {"dmx-rle", COMMAND_TX_DMX_RLE, rle_frame, false},
+    {"rdm-get", COMMAND_RDM_REQUEST,
+     vector<uint8_t>(kRDMRequest, kRDMRequest + arraysize(kRDMRequest)),
+     true},
+  };
+
+  PipelineBenchmark benchmark(count, window);
+  g_benchmark = &benchmark;
+  if (!benchmark.Init()) {
+    printf("Failed to switch to controller mode\n");
+    return 1;
+  }
+
+  printf("%u commands per workload, window %u\n", count, window);
+  for (const auto &workload : workloads) {
+    Result result = benchmark.Run(workload);
+    PrintResult(workload, &result);
+  }
+  g_benchmark = nullptr;
+  return 0;
+}
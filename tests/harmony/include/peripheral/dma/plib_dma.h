@@ -0,0 +1,100 @@
+/*
+ * This is the stub for plib_dma.h used for the tests. It contains the bare
+ * minimum required to implement the mock DMA symbols.
+ */
+
+#ifndef TESTS_HARMONY_INCLUDE_PERIPHERAL_DMA_PLIB_DMA_H_
+#define TESTS_HARMONY_INCLUDE_PERIPHERAL_DMA_PLIB_DMA_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+  DMA_ID_0 = 0,
+  DMA_NUMBER_OF_MODULES
+} DMA_MODULE_ID;
+
+typedef enum {
+  DMA_CHANNEL_0 = 0,
+  DMA_CHANNEL_1 = 1,
+  DMA_CHANNEL_2 = 2,
+  DMA_CHANNEL_3 = 3,
+  DMA_CHANNEL_4 = 4,
+  DMA_CHANNEL_5 = 5,
+  DMA_CHANNEL_6 = 6,
+  DMA_CHANNEL_7 = 7,
+  DMA_NUMBER_OF_CHANNELS = 8
+} DMA_CHANNEL;
+
+typedef enum {
+  DMA_CHANNEL_TRIGGER_TRANSFER_START = 0,
+  DMA_CHANNEL_TRIGGER_TRANSFER_ABORT = 1,
+  DMA_CHANNEL_TRIGGER_PATTERN_MATCH_ABORT = 2
+} DMA_CHANNEL_TRIGGER_TYPE;
+
+typedef enum {
+  DMA_TRIGGER_SPI_1_TRANSMIT = 0,
+  DMA_TRIGGER_SPI_2_TRANSMIT = 1,
+  DMA_TRIGGER_SPI_3_TRANSMIT = 2,
+  DMA_TRIGGER_SPI_4_TRANSMIT = 3
+} DMA_TRIGGER_SOURCE;
+
+typedef enum {
+  DMA_INT_ADDRESS_ERROR = 0,
+  DMA_INT_TRANSFER_ABORT = 1,
+  DMA_INT_CELL_TRANSFER_COMPLETE = 2,
+  DMA_INT_BLOCK_TRANSFER_COMPLETE = 3,
+  DMA_INT_DESTINATION_HALF_FULL = 4,
+  DMA_INT_DESTINATION_DONE = 5,
+  DMA_INT_SOURCE_HALF_EMPTY = 6,
+  DMA_INT_SOURCE_DONE = 7
+} DMA_INT_TYPE;
+
+void PLIB_DMA_Enable(DMA_MODULE_ID index);
+
+void PLIB_DMA_ChannelXTriggerEnable(DMA_MODULE_ID index,
+                                    DMA_CHANNEL channel,
+                                    DMA_CHANNEL_TRIGGER_TYPE trigger);
+
+void PLIB_DMA_ChannelXStartIRQSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                  DMA_TRIGGER_SOURCE irq);
+
+void PLIB_DMA_ChannelXSourceStartAddressSet(DMA_MODULE_ID index,
+                                            DMA_CHANNEL channel,
+                                            uint32_t address);
+
+void PLIB_DMA_ChannelXSourceSizeSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                    uint16_t size);
+
+void PLIB_DMA_ChannelXDestinationStartAddressSet(DMA_MODULE_ID index,
+                                                 DMA_CHANNEL channel,
+                                                 uint32_t address);
+
+void PLIB_DMA_ChannelXDestinationSizeSet(DMA_MODULE_ID index,
+                                         DMA_CHANNEL channel,
+                                         uint16_t size);
+
+void PLIB_DMA_ChannelXCellSizeSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                  uint16_t size);
+
+void PLIB_DMA_ChannelXEnable(DMA_MODULE_ID index, DMA_CHANNEL channel);
+
+void PLIB_DMA_StartTransferSet(DMA_MODULE_ID index, DMA_CHANNEL channel);
+
+bool PLIB_DMA_ChannelXINTSourceFlagGet(DMA_MODULE_ID index,
+                                       DMA_CHANNEL channel,
+                                       DMA_INT_TYPE source);
+
+void PLIB_DMA_ChannelXINTSourceFlagClear(DMA_MODULE_ID index,
+                                         DMA_CHANNEL channel,
+                                         DMA_INT_TYPE source);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  // TESTS_HARMONY_INCLUDE_PERIPHERAL_DMA_PLIB_DMA_H_
@@ -77,6 +77,8 @@ void PLIB_SPI_BufferWrite(SPI_MODULE_ID index, uint8_t data);
 
 void PLIB_SPI_BufferClear(SPI_MODULE_ID index);
 
+void* PLIB_SPI_BufferAddressGet(SPI_MODULE_ID index);
+
 uint8_t PLIB_SPI_BufferRead(SPI_MODULE_ID index);
 
 void PLIB_SPI_SlaveSelectDisable(SPI_MODULE_ID index);
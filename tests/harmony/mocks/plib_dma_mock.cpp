@@ -0,0 +1,99 @@
+#include <gmock/gmock.h>
+#include "plib_dma_mock.h"
+
+namespace {
+  PeripheralDMAInterface *g_plib_dma_mock = NULL;
+}
+
+void PLIB_DMA_SetMock(PeripheralDMAInterface* dma) {
+  g_plib_dma_mock = dma;
+}
+
+void PLIB_DMA_Enable(DMA_MODULE_ID index) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->Enable(index);
+  }
+}
+
+void PLIB_DMA_ChannelXTriggerEnable(DMA_MODULE_ID index,
+                                    DMA_CHANNEL channel,
+                                    DMA_CHANNEL_TRIGGER_TYPE trigger) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXTriggerEnable(index, channel, trigger);
+  }
+}
+
+void PLIB_DMA_ChannelXStartIRQSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                  DMA_TRIGGER_SOURCE irq) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXStartIRQSet(index, channel, irq);
+  }
+}
+
+void PLIB_DMA_ChannelXSourceStartAddressSet(DMA_MODULE_ID index,
+                                            DMA_CHANNEL channel,
+                                            uint32_t address) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXSourceStartAddressSet(index, channel, address);
+  }
+}
+
+void PLIB_DMA_ChannelXSourceSizeSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                    uint16_t size) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXSourceSizeSet(index, channel, size);
+  }
+}
+
+void PLIB_DMA_ChannelXDestinationStartAddressSet(DMA_MODULE_ID index,
+                                                 DMA_CHANNEL channel,
+                                                 uint32_t address) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXDestinationStartAddressSet(index, channel,
+                                                        address);
+  }
+}
+
+void PLIB_DMA_ChannelXDestinationSizeSet(DMA_MODULE_ID index,
+                                         DMA_CHANNEL channel,
+                                         uint16_t size) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXDestinationSizeSet(index, channel, size);
+  }
+}
+
+void PLIB_DMA_ChannelXCellSizeSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                  uint16_t size) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXCellSizeSet(index, channel, size);
+  }
+}
+
+void PLIB_DMA_ChannelXEnable(DMA_MODULE_ID index, DMA_CHANNEL channel) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXEnable(index, channel);
+  }
+}
+
+void PLIB_DMA_StartTransferSet(DMA_MODULE_ID index, DMA_CHANNEL channel) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->StartTransferSet(index, channel);
+  }
+}
+
+bool PLIB_DMA_ChannelXINTSourceFlagGet(DMA_MODULE_ID index,
+                                       DMA_CHANNEL channel,
+                                       DMA_INT_TYPE source) {
+  if (g_plib_dma_mock) {
+    return g_plib_dma_mock->ChannelXINTSourceFlagGet(index, channel, source);
+  }
+  return false;
+}
+
+void PLIB_DMA_ChannelXINTSourceFlagClear(DMA_MODULE_ID index,
+                                         DMA_CHANNEL channel,
+                                         DMA_INT_TYPE source) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXINTSourceFlagClear(index, channel, source);
+  }
+}
@@ -0,0 +1,73 @@
+#ifndef TESTS_HARMONY_MOCKS_PLIB_DMA_MOCK_H_
+#define TESTS_HARMONY_MOCKS_PLIB_DMA_MOCK_H_
+
+#include <gmock/gmock.h>
+#include "peripheral/dma/plib_dma.h"
+
+class PeripheralDMAInterface {
+ public:
+  virtual ~PeripheralDMAInterface() {}
+
+  virtual void Enable(DMA_MODULE_ID index) = 0;
+  virtual void ChannelXTriggerEnable(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                     DMA_CHANNEL_TRIGGER_TYPE trigger) = 0;
+  virtual void ChannelXStartIRQSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                   DMA_TRIGGER_SOURCE irq) = 0;
+  virtual void ChannelXSourceStartAddressSet(DMA_MODULE_ID index,
+                                             DMA_CHANNEL channel,
+                                             uint32_t address) = 0;
+  virtual void ChannelXSourceSizeSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                     uint16_t size) = 0;
+  virtual void ChannelXDestinationStartAddressSet(DMA_MODULE_ID index,
+                                                  DMA_CHANNEL channel,
+                                                  uint32_t address) = 0;
+  virtual void ChannelXDestinationSizeSet(DMA_MODULE_ID index,
+                                          DMA_CHANNEL channel,
+                                          uint16_t size) = 0;
+  virtual void ChannelXCellSizeSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                   uint16_t size) = 0;
+  virtual void ChannelXEnable(DMA_MODULE_ID index, DMA_CHANNEL channel) = 0;
+  virtual void StartTransferSet(DMA_MODULE_ID index, DMA_CHANNEL channel) = 0;
+  virtual bool ChannelXINTSourceFlagGet(DMA_MODULE_ID index,
+                                        DMA_CHANNEL channel,
+                                        DMA_INT_TYPE source) = 0;
+  virtual void ChannelXINTSourceFlagClear(DMA_MODULE_ID index,
+                                          DMA_CHANNEL channel,
+                                          DMA_INT_TYPE source) = 0;
+};
+
+class MockPeripheralDMA : public PeripheralDMAInterface {
+ public:
+  MOCK_METHOD1(Enable, void(DMA_MODULE_ID index));
+  MOCK_METHOD3(ChannelXTriggerEnable,
+               void(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                    DMA_CHANNEL_TRIGGER_TYPE trigger));
+  MOCK_METHOD3(ChannelXStartIRQSet,
+               void(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                    DMA_TRIGGER_SOURCE irq));
+  MOCK_METHOD3(ChannelXSourceStartAddressSet,
+               void(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                    uint32_t address));
+  MOCK_METHOD3(ChannelXSourceSizeSet,
+               void(DMA_MODULE_ID index, DMA_CHANNEL channel, uint16_t size));
+  MOCK_METHOD3(ChannelXDestinationStartAddressSet,
+               void(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                    uint32_t address));
+  MOCK_METHOD3(ChannelXDestinationSizeSet,
+               void(DMA_MODULE_ID index, DMA_CHANNEL channel, uint16_t size));
+  MOCK_METHOD3(ChannelXCellSizeSet,
+               void(DMA_MODULE_ID index, DMA_CHANNEL channel, uint16_t size));
+  MOCK_METHOD2(ChannelXEnable, void(DMA_MODULE_ID index, DMA_CHANNEL channel));
+  MOCK_METHOD2(StartTransferSet,
+               void(DMA_MODULE_ID index, DMA_CHANNEL channel));
+  MOCK_METHOD3(ChannelXINTSourceFlagGet,
+               bool(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                    DMA_INT_TYPE source));
+  MOCK_METHOD3(ChannelXINTSourceFlagClear,
+               void(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                    DMA_INT_TYPE source));
+};
+
+void PLIB_DMA_SetMock(PeripheralDMAInterface* dma);
+
+#endif  // TESTS_HARMONY_MOCKS_PLIB_DMA_MOCK_H_
@@ -2,10 +2,10 @@
 #include "plib_ports_mock.h"
 
 namespace {
-  MockPeripheralPorts *g_plib_ports_mock = NULL;
+  PeripheralPortsInterface *g_plib_ports_mock = NULL;
 }
 
-void PLIB_PORTS_SetMock(MockPeripheralPorts* mock) {
+void PLIB_PORTS_SetMock(PeripheralPortsInterface* mock) {
   g_plib_ports_mock = mock;
 }
 
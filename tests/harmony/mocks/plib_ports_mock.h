@@ -4,7 +4,31 @@
 #include <gmock/gmock.h>
 #include "peripheral/ports/plib_ports.h"
 
-class MockPeripheralPorts {
+class PeripheralPortsInterface {
+ public:
+  virtual ~PeripheralPortsInterface() {}
+
+  virtual void PinDirectionInputSet(PORTS_MODULE_ID index,
+                                    PORTS_CHANNEL channel,
+                                    PORTS_BIT_POS bitPos) = 0;
+  virtual void PinDirectionOutputSet(PORTS_MODULE_ID index,
+                                     PORTS_CHANNEL channel,
+                                     PORTS_BIT_POS bitPos) = 0;
+  virtual bool PinGet(PORTS_MODULE_ID index,
+                      PORTS_CHANNEL channel,
+                      PORTS_BIT_POS bitPos) = 0;
+  virtual void PinSet(PORTS_MODULE_ID index,
+                      PORTS_CHANNEL channel,
+                      PORTS_BIT_POS bitPos) = 0;
+  virtual void PinClear(PORTS_MODULE_ID index,
+                        PORTS_CHANNEL channel,
+                        PORTS_BIT_POS bitPos) = 0;
+  virtual void PinToggle(PORTS_MODULE_ID index,
+                         PORTS_CHANNEL channel,
+                         PORTS_BIT_POS bitPos) = 0;
+};
+
+class MockPeripheralPorts : public PeripheralPortsInterface {
  public:
   MOCK_METHOD3(PinDirectionInputSet,
                void(PORTS_MODULE_ID index,
@@ -33,6 +57,6 @@ class MockPeripheralPorts {
                     PORTS_BIT_POS bitPos));
 };
 
-void PLIB_PORTS_SetMock(MockPeripheralPorts* mock);
+void PLIB_PORTS_SetMock(PeripheralPortsInterface* mock);
 
 #endif  // TESTS_HARMONY_MOCKS_PLIB_PORTS_MOCK_H_
@@ -107,6 +107,13 @@ void PLIB_SPI_BufferClear(SPI_MODULE_ID index) {
   }
 }
 
+void* PLIB_SPI_BufferAddressGet(SPI_MODULE_ID index) {
+  if (g_plib_spi_mock) {
+    return g_plib_spi_mock->BufferAddressGet(index);
+  }
+  return NULL;
+}
+
 void PLIB_SPI_PinDisable(SPI_MODULE_ID index, SPI_PIN pin) {
   if (g_plib_spi_mock) {
     g_plib_spi_mock->PinDisable(index, pin);
@@ -47,6 +47,13 @@ CoarseTimer_Value CoarseTimer_GetTime() {
   return 0;
 }
 
+uint32_t CoarseTimer_GetMicroseconds() {
+  if (g_coarse_timer_mock) {
+    return g_coarse_timer_mock->GetMicroseconds();
+  }
+  return 0;
+}
+
 uint32_t CoarseTimer_ElapsedTime(CoarseTimer_Value start_time) {
   if (g_coarse_timer_mock) {
     return g_coarse_timer_mock->ElapsedTime(start_time);
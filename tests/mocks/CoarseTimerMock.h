@@ -29,6 +29,7 @@ class MockCoarseTimer {
   MOCK_METHOD1(Initialize, void(const CoarseTimer_Settings *settings));
   MOCK_METHOD0(TimerEvent, void());
   MOCK_METHOD0(GetTime, CoarseTimer_Value());
+  MOCK_METHOD0(GetMicroseconds, uint32_t());
   MOCK_METHOD1(ElapsedTime, uint32_t(CoarseTimer_Value start_time));
   MOCK_METHOD2(Delta,
                uint32_t(CoarseTimer_Value start_time,
@@ -34,6 +34,13 @@ void SPIRGB_Init(const SPIRGBConfiguration *config) {
   }
 }
 
+bool SPIRGB_SetPixelType(PixelType type) {
+  if (g_spirgb_mock) {
+    return g_spirgb_mock->SetPixelType(type);
+  }
+  return true;
+}
+
 void SPIRGB_BeginUpdate() {
   if (g_spirgb_mock) {
     g_spirgb_mock->BeginUpdate();
@@ -46,6 +53,12 @@ void SPIRGB_SetPixel(uint16_t index, RGB_Color color, uint8_t value) {
   }
 }
 
+void SPIRGB_SetPixels(const uint8_t *data, uint16_t pixel_count) {
+  if (g_spirgb_mock) {
+    g_spirgb_mock->SetPixels(data, pixel_count);
+  }
+}
+
 void SPIRGB_CompleteUpdate() {
   if (g_spirgb_mock) {
     g_spirgb_mock->CompleteUpdate();
@@ -27,8 +27,10 @@
 class MockSPIRGB {
  public:
   MOCK_METHOD1(Init, void(const SPIRGBConfiguration *config));
+  MOCK_METHOD1(SetPixelType, bool(PixelType type));
   MOCK_METHOD0(BeginUpdate, void());
   MOCK_METHOD3(SetPixel, void(uint16_t index, RGB_Color color, uint8_t value));
+  MOCK_METHOD2(SetPixels, void(const uint8_t *data, uint16_t pixel_count));
   MOCK_METHOD0(CompleteUpdate, void());
   MOCK_METHOD0(Tasks, void());
 };
@@ -22,6 +22,8 @@
 
 #include <gmock/gmock.h>
 
+#include "constants.h"
+
 namespace {
 MockStreamDecoder *g_stream_decoder_mock = NULL;
 }
@@ -35,3 +37,10 @@ void StreamDecoder_Process(const uint8_t* data, unsigned int size) {
     g_stream_decoder_mock->Process(data, size);
   }
 }
+
+unsigned int StreamDecoder_FreeSpace() {
+  if (g_stream_decoder_mock) {
+    return g_stream_decoder_mock->FreeSpace();
+  }
+  return PAYLOAD_SIZE;
+}
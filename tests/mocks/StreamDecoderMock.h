@@ -24,13 +24,14 @@
 #include <gmock/gmock.h>
 #include <stdint.h>
 
+#include "stream_decoder.h"
+
 class MockStreamDecoder {
  public:
   MOCK_METHOD2(Process, void(const uint8_t* data, unsigned int size));
+  MOCK_METHOD0(FreeSpace, unsigned int());
 };
 
 void StreamDecoder_SetMock(MockStreamDecoder* mock);
 
-void StreamDecoder_Process(const uint8_t* data, unsigned int size);
-
 #endif  // TESTS_MOCKS_STREAMDECODERMOCK_H_
@@ -51,6 +51,13 @@ TransceiverMode Transceiver_GetMode() {
   return T_MODE_RESPONDER;
 }
 
+uint8_t Transceiver_FreeSlots() {
+  if (g_transceiver_mock) {
+    return g_transceiver_mock->FreeSlots();
+  }
+  return 1u;
+}
+
 void Transceiver_Tasks() {
   if (g_transceiver_mock) {
     return g_transceiver_mock->Tasks();
@@ -65,6 +72,14 @@ bool Transceiver_QueueDMX(int16_t token, const uint8_t* data,
   return true;
 }
 
+bool Transceiver_QueueRLEDMX(int16_t token, const uint8_t* data,
+                             unsigned int size) {
+  if (g_transceiver_mock) {
+    return g_transceiver_mock->QueueRLEDMX(token, data, size);
+  }
+  return true;
+}
+
 bool Transceiver_QueueASC(int16_t token, uint8_t start_code,
                           const uint8_t* data, unsigned int size) {
   if (g_transceiver_mock) {
@@ -33,9 +33,12 @@ class MockTransceiver {
                                 TransceiverEventCallback rx_callback));
   MOCK_METHOD2(SetMode, bool(TransceiverMode mode, int16_t token));
   MOCK_METHOD0(GetMode, TransceiverMode());
+  MOCK_METHOD0(FreeSlots, uint8_t());
   MOCK_METHOD0(Tasks, void());
   MOCK_METHOD3(QueueDMX, bool(int16_t token, const uint8_t* data,
                               unsigned int size));
+  MOCK_METHOD3(QueueRLEDMX, bool(int16_t token, const uint8_t* data,
+                                 unsigned int size));
   MOCK_METHOD4(QueueASC, bool(int16_t token, uint8_t start_code,
                               const uint8_t* data, unsigned int size));
   MOCK_METHOD3(QueueRDMDUB, bool(int16_t token, const uint8_t* data,
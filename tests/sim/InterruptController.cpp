@@ -68,6 +68,10 @@ void InterruptController::RaiseInterrupt(INT_SOURCE source) {
   }
 }
 
+bool InterruptController::IsEnabled(INT_SOURCE source) {
+  return GetInterrupt(source)->enabled;
+}
+
 bool InterruptController::SourceStatusGet(INT_SOURCE source) {
   Interrupt *interrupt = GetInterrupt(source);
   return interrupt->active;
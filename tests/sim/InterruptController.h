@@ -36,6 +36,9 @@ class InterruptController : public SysIntInterface {
 
   void RaiseInterrupt(INT_SOURCE source);
 
+  // True if raising the interrupt would run the ISR.
+  bool IsEnabled(INT_SOURCE source);
+
   bool SourceStatusGet(INT_SOURCE source);
   void SourceStatusClear(INT_SOURCE source);
   void SourceEnable(INT_SOURCE source);
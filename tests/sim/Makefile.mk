@@ -7,14 +7,22 @@ tests_sim_libsim_la_SOURCES = tests/sim/InterruptController.cpp \
                               tests/sim/InterruptController.h \
                               tests/sim/PeripheralInputCapture.cpp \
                               tests/sim/PeripheralInputCapture.h \
+                              tests/sim/PeripheralPorts.cpp \
+                              tests/sim/PeripheralPorts.h \
                               tests/sim/PeripheralSPI.cpp \
                               tests/sim/PeripheralSPI.h \
                               tests/sim/PeripheralTimer.cpp \
                               tests/sim/PeripheralTimer.h \
                               tests/sim/PeripheralUART.cpp \
                               tests/sim/PeripheralUART.h \
+                              tests/sim/PeripheralUSBDevice.cpp \
+                              tests/sim/PeripheralUSBDevice.h \
+                              tests/sim/RS485Bus.cpp \
+                              tests/sim/RS485Bus.h \
                               tests/sim/SignalGenerator.cpp \
                               tests/sim/SignalGenerator.h \
+                              tests/sim/SimulatedResponder.cpp \
+                              tests/sim/SimulatedResponder.h \
                               tests/sim/Simulator.cpp \
                               tests/sim/Simulator.h
 tests_sim_libsim_la_CXXFLAGS = $(BUILD_FLAGS) $(GMOCK_INCLUDES) \
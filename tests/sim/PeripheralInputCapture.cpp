@@ -26,7 +26,6 @@
 
 #include "macros.h"
 #include "Simulator.h"
-#include "ola/Callback.h"
 #include "peripheral/tmr/plib_tmr.h"
 
 PeripheralInputCapture::InputCapture::InputCapture(INT_SOURCE source)
@@ -53,9 +52,8 @@ PeripheralInputCapture::PeripheralInputCapture(
     Simulator *simulator,
     InterruptController *interrupt_controller)
     : m_simulator(simulator),
-      m_interrupt_controller(interrupt_controller),
-      m_callback(ola::NewCallback(this, &PeripheralInputCapture::Tick)) {
-  m_simulator->AddTask(m_callback.get());
+      m_interrupt_controller(interrupt_controller) {
+  m_simulator->AddPeripheral(this);
   std::vector<INT_SOURCE> timer_sources = {
     INT_SOURCE_INPUT_CAPTURE_1,
     INT_SOURCE_INPUT_CAPTURE_2,
@@ -69,7 +67,7 @@ PeripheralInputCapture::PeripheralInputCapture(
 }
 
 PeripheralInputCapture::~PeripheralInputCapture() {
-  m_simulator->RemoveTask(m_callback.get());
+  m_simulator->RemovePeripheral(this);
 }
 
 void PeripheralInputCapture::Tick() {
@@ -84,6 +82,18 @@ void PeripheralInputCapture::Tick() {
   }
 }
 
+uint64_t PeripheralInputCapture::NextEvent(uint64_t now) {
+  // Captures are triggered by the SignalGenerator, so the only thing to do is
+  // re-raise the interrupt while there is data in the buffer.
+  for (const auto &ic : m_ic) {
+    if (ic.enabled && ic.buffer.size() > ic.events_per_interrupt &&
+        m_interrupt_controller->IsEnabled(ic.interrupt_source)) {
+      return now + 1;
+    }
+  }
+  return Simulator::kNever;
+}
+
 void PeripheralInputCapture::TriggerEvent(IC_MODULE_ID index,
                                           IC_EDGE_TYPES edge_type) {
   if (index >= m_ic.size()) {
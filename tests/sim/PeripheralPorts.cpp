@@ -0,0 +1,80 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * PeripheralPorts.cpp
+ * The I/O ports used with the simulator.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "PeripheralPorts.h"
+
+PeripheralPorts::PeripheralPorts(PinChangeCallback *callback)
+    : m_callback(callback) {
+}
+
+void PeripheralPorts::PinDirectionInputSet(PORTS_MODULE_ID index,
+                                           PORTS_CHANNEL channel,
+                                           PORTS_BIT_POS bitPos) {
+  (void) index;
+  (void) channel;
+  (void) bitPos;
+}
+
+void PeripheralPorts::PinDirectionOutputSet(PORTS_MODULE_ID index,
+                                            PORTS_CHANNEL channel,
+                                            PORTS_BIT_POS bitPos) {
+  (void) index;
+  (void) channel;
+  (void) bitPos;
+}
+
+bool PeripheralPorts::PinGet(PORTS_MODULE_ID index,
+                             PORTS_CHANNEL channel,
+                             PORTS_BIT_POS bitPos) {
+  (void) index;
+  auto iter = m_pins.find(Pin(channel, bitPos));
+  return iter == m_pins.end() ? false : iter->second;
+}
+
+void PeripheralPorts::PinSet(PORTS_MODULE_ID index,
+                             PORTS_CHANNEL channel,
+                             PORTS_BIT_POS bitPos) {
+  (void) index;
+  SetPinState(channel, bitPos, true);
+}
+
+void PeripheralPorts::PinClear(PORTS_MODULE_ID index,
+                               PORTS_CHANNEL channel,
+                               PORTS_BIT_POS bitPos) {
+  (void) index;
+  SetPinState(channel, bitPos, false);
+}
+
+void PeripheralPorts::PinToggle(PORTS_MODULE_ID index,
+                                PORTS_CHANNEL channel,
+                                PORTS_BIT_POS bitPos) {
+  SetPinState(channel, bitPos, !PinGet(index, channel, bitPos));
+}
+
+void PeripheralPorts::SetPinState(PORTS_CHANNEL channel, PORTS_BIT_POS bit_pos,
+                                  bool state) {
+  bool &pin = m_pins[Pin(channel, bit_pos)];
+  if (pin != state) {
+    pin = state;
+    if (m_callback) {
+      m_callback->Run(channel, bit_pos, state);
+    }
+  }
+}
@@ -0,0 +1,74 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * PeripheralPorts.h
+ * The I/O ports used with the simulator.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#ifndef TESTS_SIM_PERIPHERALPORTS_H_
+#define TESTS_SIM_PERIPHERALPORTS_H_
+
+#include <map>
+#include <utility>
+
+#include "plib_ports_mock.h"
+
+#include "ola/Callback.h"
+
+/*
+ * @brief Tracks the state of the output pins.
+ *
+ * The pins have no timing behaviour, so this isn't a Simulator::Peripheral.
+ * All pins start low.
+ */
+class PeripheralPorts : public PeripheralPortsInterface {
+ public:
+  // Invoked when the state of a pin changes.
+  typedef ola::Callback3<void, PORTS_CHANNEL, PORTS_BIT_POS, bool>
+      PinChangeCallback;
+
+  // Ownership of the callback is not transferred.
+  explicit PeripheralPorts(PinChangeCallback *callback);
+
+  void PinDirectionInputSet(PORTS_MODULE_ID index,
+                            PORTS_CHANNEL channel,
+                            PORTS_BIT_POS bitPos);
+  void PinDirectionOutputSet(PORTS_MODULE_ID index,
+                             PORTS_CHANNEL channel,
+                             PORTS_BIT_POS bitPos);
+  bool PinGet(PORTS_MODULE_ID index,
+              PORTS_CHANNEL channel,
+              PORTS_BIT_POS bitPos);
+  void PinSet(PORTS_MODULE_ID index,
+              PORTS_CHANNEL channel,
+              PORTS_BIT_POS bitPos);
+  void PinClear(PORTS_MODULE_ID index,
+                PORTS_CHANNEL channel,
+                PORTS_BIT_POS bitPos);
+  void PinToggle(PORTS_MODULE_ID index,
+                 PORTS_CHANNEL channel,
+                 PORTS_BIT_POS bitPos);
+
+ private:
+  typedef std::pair<PORTS_CHANNEL, PORTS_BIT_POS> Pin;
+
+  PinChangeCallback *m_callback;
+  std::map<Pin, bool> m_pins;
+
+  void SetPinState(PORTS_CHANNEL channel, PORTS_BIT_POS bit_pos, bool state);
+};
+
+#endif  // TESTS_SIM_PERIPHERALPORTS_H_
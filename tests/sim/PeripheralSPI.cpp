@@ -22,11 +22,11 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <vector>
 
 #include "macros.h"
 #include "Simulator.h"
-#include "ola/Callback.h"
 
 using std::vector;
 
@@ -49,8 +49,8 @@ PeripheralSPI::PeripheralSPI(
     InterruptController *interrupt_controller)
     : m_simulator(simulator),
       m_interrupt_controller(interrupt_controller),
-      m_callback(ola::NewCallback(this, &PeripheralSPI::Tick)) {
-  m_simulator->AddTask(m_callback.get());
+      m_next_cycle(0) {
+  m_simulator->AddPeripheral(this);
   std::vector<INT_SOURCE> spi_sources = {
     INT_SOURCE_SPI_1_ERROR,
     INT_SOURCE_SPI_2_ERROR,
@@ -63,7 +63,7 @@ PeripheralSPI::PeripheralSPI(
 }
 
 PeripheralSPI::~PeripheralSPI() {
-  m_simulator->RemoveTask(m_callback.get());
+  m_simulator->RemovePeripheral(this);
 }
 
 void PeripheralSPI::QueueResponseByte(SPI_MODULE_ID index, uint8_t data) {
@@ -92,6 +92,7 @@ vector<uint8_t> PeripheralSPI::SentBytes(SPI_MODULE_ID index) {
 }
 
 void PeripheralSPI::Tick() {
+  CatchUp();
   for (auto &spi : m_spi) {
     if (!spi.enabled) {
       continue;
@@ -127,58 +128,57 @@ void PeripheralSPI::Tick() {
       }
     }
 
-    if (!spi.in_transfer) {
+    if (!spi.in_transfer && !spi.tx_queue.empty()) {
       // Start the next byte.
       spi.in_transfer = true;
       spi.counter = 0;
     }
 
-    switch (spi.tx_interrupt_mode) {
-      case SPI_FIFO_INTERRUPT_WHEN_TRANSMIT_BUFFER_IS_NOT_FULL:
-        run_tx_isr = spi.tx_queue.size() != spi.fifo_size;
-        break;
-      case SPI_FIFO_INTERRUPT_WHEN_TRANSMIT_BUFFER_IS_1HALF_EMPTY_OR_MORE:
-        run_tx_isr = spi.tx_queue.size() < spi.fifo_size / 2;
-        break;
-      case SPI_FIFO_INTERRUPT_WHEN_TRANSMIT_BUFFER_IS_COMPLETELY_EMPTY:
-        run_tx_isr = spi.tx_queue.empty();
-        break;
-      default:
-        {}
+    if (run_tx_isr || TXInterruptPending(spi)) {
+      m_interrupt_controller->RaiseInterrupt(
+          static_cast<INT_SOURCE>(spi.interrupt_source + 2));
     }
 
-    if (run_tx_isr) {
+    if (RXInterruptPending(spi)) {
       m_interrupt_controller->RaiseInterrupt(
-          static_cast<INT_SOURCE>(spi.interrupt_source + 2));
+          static_cast<INT_SOURCE>(spi.interrupt_source + 1));
+    }
+  }
+  m_next_cycle = m_simulator->Clock() + 1;
+}
+
+uint64_t PeripheralSPI::NextEvent(uint64_t now) {
+  uint64_t next = Simulator::kNever;
+  for (const auto &spi : m_spi) {
+    if (!spi.enabled) {
+      continue;
     }
 
-    bool run_rx_isr = false;
-    switch (spi.rx_interrupt_mode) {
-      case SPI_FIFO_INTERRUPT_WHEN_RECEIVE_BUFFER_IS_FULL:
-        run_rx_isr = spi.rx_queue.size() == spi.fifo_size;
-        break;
-      case SPI_FIFO_INTERRUPT_WHEN_RECEIVE_BUFFER_IS_1HALF_FULL_OR_MORE:
-        run_rx_isr = spi.rx_queue.size() >= spi.fifo_size / 2;
-        break;
-      case SPI_FIFO_INTERRUPT_WHEN_RECEIVE_BUFFER_IS_NOT_EMPTY:
-        run_rx_isr = !spi.rx_queue.empty();
-        break;
-      case SPI_FIFO_INTERRUPT_WHEN_BUFFER_IS_EMPTY:
-        run_rx_isr = spi.rx_queue.empty();
-        break;
-      default:
-        {}
+    // The interrupts are level triggered.
+    if ((TXInterruptPending(spi) &&
+         m_interrupt_controller->IsEnabled(
+           static_cast<INT_SOURCE>(spi.interrupt_source + 2))) ||
+        (RXInterruptPending(spi) &&
+         m_interrupt_controller->IsEnabled(
+           static_cast<INT_SOURCE>(spi.interrupt_source + 1)))) {
+      return now + 1;
     }
 
-    if (run_rx_isr) {
-      m_interrupt_controller->RaiseInterrupt(
-          static_cast<INT_SOURCE>(spi.interrupt_source + 1));
+    if (spi.in_transfer) {
+      if (spi.counter < spi.ticks_per_byte) {
+        next = std::min(
+            next, m_next_cycle + spi.ticks_per_byte - spi.counter - 1);
+      }
+    } else if (!spi.tx_queue.empty()) {
+      return now + 1;
     }
   }
+  return std::max(next, now + 1);
 }
 
 
 void PeripheralSPI::Enable(SPI_MODULE_ID index) {
+  CatchUp();
   if (index >= m_spi.size()) {
     ADD_FAILURE() << "Invalid SPI " << index;
   }
@@ -186,6 +186,7 @@ void PeripheralSPI::Enable(SPI_MODULE_ID index) {
 }
 
 void PeripheralSPI::Disable(SPI_MODULE_ID index) {
+  CatchUp();
   if (index >= m_spi.size()) {
     ADD_FAILURE() << "Invalid SPI " << index;
   }
@@ -239,6 +240,7 @@ void PeripheralSPI::FIFOInterruptModeSelect(SPI_MODULE_ID index,
 void PeripheralSPI::BaudRateSet(SPI_MODULE_ID index,
                                 uint32_t clockFrequency,
                                 uint32_t baudRate) {
+  CatchUp();
   if (index >= m_spi.size()) {
     ADD_FAILURE() << "Invalid SPI " << index;
     return;
@@ -315,3 +317,51 @@ void PeripheralSPI::PinDisable(SPI_MODULE_ID index, UNUSED SPI_PIN pin) {
     ADD_FAILURE() << "Invalid SPI " << index;
   }
 }
+
+/*
+ * @brief Apply the cycles skipped since the last Tick().
+ *
+ * The simulator never skips the end of a byte, so this just advances the
+ * transfer counters.
+ */
+void PeripheralSPI::CatchUp() {
+  uint64_t now = m_simulator->Clock();
+  if (now <= m_next_cycle) {
+    return;
+  }
+
+  for (auto &spi : m_spi) {
+    if (spi.enabled && spi.in_transfer) {
+      spi.counter += now - m_next_cycle;
+    }
+  }
+  m_next_cycle = now;
+}
+
+bool PeripheralSPI::TXInterruptPending(const SPI &spi) const {
+  switch (spi.tx_interrupt_mode) {
+    case SPI_FIFO_INTERRUPT_WHEN_TRANSMIT_BUFFER_IS_NOT_FULL:
+      return spi.tx_queue.size() != spi.fifo_size;
+    case SPI_FIFO_INTERRUPT_WHEN_TRANSMIT_BUFFER_IS_1HALF_EMPTY_OR_MORE:
+      return spi.tx_queue.size() < spi.fifo_size / 2;
+    case SPI_FIFO_INTERRUPT_WHEN_TRANSMIT_BUFFER_IS_COMPLETELY_EMPTY:
+      return spi.tx_queue.empty();
+    default:
+      return false;
+  }
+}
+
+bool PeripheralSPI::RXInterruptPending(const SPI &spi) const {
+  switch (spi.rx_interrupt_mode) {
+    case SPI_FIFO_INTERRUPT_WHEN_RECEIVE_BUFFER_IS_FULL:
+      return spi.rx_queue.size() == spi.fifo_size;
+    case SPI_FIFO_INTERRUPT_WHEN_RECEIVE_BUFFER_IS_1HALF_FULL_OR_MORE:
+      return spi.rx_queue.size() >= spi.fifo_size / 2;
+    case SPI_FIFO_INTERRUPT_WHEN_RECEIVE_BUFFER_IS_NOT_EMPTY:
+      return !spi.rx_queue.empty();
+    case SPI_FIFO_INTERRUPT_WHEN_BUFFER_IS_EMPTY:
+      return spi.rx_queue.empty();
+    default:
+      return false;
+  }
+}
@@ -22,16 +22,15 @@
 #define TESTS_SIM_PERIPHERALSPI_H_
 
 #include <deque>
-#include <memory>
 #include <vector>
 
 #include "plib_spi_mock.h"
 
 #include "InterruptController.h"
 #include "Simulator.h"
-#include "ola/Callback.h"
 
-class PeripheralSPI : public PeripheralSPIInterface {
+class PeripheralSPI : public PeripheralSPIInterface,
+                      public Simulator::Peripheral {
  public:
   // Ownership is not transferred.
   PeripheralSPI(Simulator *simulator,
@@ -44,6 +43,7 @@ class PeripheralSPI : public PeripheralSPIInterface {
   std::vector<uint8_t> SentBytes(SPI_MODULE_ID index);
 
   void Tick();
+  uint64_t NextEvent(uint64_t now);
 
   void Enable(SPI_MODULE_ID index);
   void Disable(SPI_MODULE_ID index);
@@ -71,7 +71,8 @@ class PeripheralSPI : public PeripheralSPIInterface {
 
   Simulator *m_simulator;
   InterruptController *m_interrupt_controller;
-  std::unique_ptr<ola::Callback0<void>> m_callback;
+  // The first clock cycle which hasn't been applied to the SPI modules.
+  uint64_t m_next_cycle;
 
   struct SPI {
    public:
@@ -102,6 +103,10 @@ class PeripheralSPI : public PeripheralSPIInterface {
   };
 
   std::vector<SPI> m_spi;
+
+  void CatchUp();
+  bool TXInterruptPending(const SPI &spi) const;
+  bool RXInterruptPending(const SPI &spi) const;
 };
 
 #endif  // TESTS_SIM_PERIPHERALSPI_H_
@@ -22,11 +22,11 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <vector>
 
 #include "macros.h"
 #include "Simulator.h"
-#include "ola/Callback.h"
 
 PeripheralTimer::Timer::Timer(INT_SOURCE source)
     : enabled(false),
@@ -41,8 +41,8 @@ PeripheralTimer::PeripheralTimer(Simulator *simulator,
                                  InterruptController *interrupt_controller)
     : m_simulator(simulator),
       m_interrupt_controller(interrupt_controller),
-      m_callback(ola::NewCallback(this, &PeripheralTimer::Tick)) {
-  m_simulator->AddTask(m_callback.get());
+      m_next_cycle(0) {
+  m_simulator->AddPeripheral(this);
   std::vector<INT_SOURCE> timer_ids = {
     INT_SOURCE_TIMER_1,
     INT_SOURCE_TIMER_2,
@@ -66,28 +66,40 @@ PeripheralTimer::PeripheralTimer(Simulator *simulator,
 }
 
 PeripheralTimer::~PeripheralTimer() {
-  m_simulator->RemoveTask(m_callback.get());
+  m_simulator->RemovePeripheral(this);
 }
 
 void PeripheralTimer::Tick() {
+  CatchUp();
   uint64_t ticks = m_simulator->Clock();
   for (auto &timer : m_timers) {
     if (timer.enabled && (ticks % m_prescale_values[timer.prescale] == 0)) {
-      if (timer.counter == timer.period) {
-        timer.counter = 0;
-      } else {
-        timer.counter++;
-        if (timer.counter == timer.period) {
-          timer.in_isr = true;
-          m_interrupt_controller->RaiseInterrupt(timer.interrupt_source);
-          timer.in_isr = false;
-        }
-      }
+      AdvanceCounter(&timer, 1);
+    }
+  }
+  m_next_cycle = ticks + 1;
+}
+
+uint64_t PeripheralTimer::NextEvent(uint64_t now) {
+  uint64_t next = Simulator::kNever;
+  for (auto &timer : m_timers) {
+    if (!timer.enabled || (timer.counter == 0 && timer.period == 0)) {
+      continue;
     }
+    // Either the counter resets, or it reaches the period.
+    uint16_t ticks = 1;
+    if (timer.counter != timer.period) {
+      ticks = timer.period - timer.counter;
+    }
+    uint64_t prescale = m_prescale_values[timer.prescale];
+    uint64_t first_tick = (m_next_cycle + prescale - 1) / prescale * prescale;
+    next = std::min(next, first_tick + (ticks - 1) * prescale);
   }
+  return std::max(next, now + 1);
 }
 
 void PeripheralTimer::Counter16BitSet(TMR_MODULE_ID index, uint16_t value) {
+  CatchUp();
   if (index >= m_timers.size()) {
     FAIL() << "Invalid timer " << index;
   }
@@ -96,6 +108,7 @@ void PeripheralTimer::Counter16BitSet(TMR_MODULE_ID index, uint16_t value) {
 }
 
 uint16_t PeripheralTimer::Counter16BitGet(TMR_MODULE_ID index) {
+  CatchUp();
   if (index < m_timers.size()) {
     return m_timers[index].counter;
   }
@@ -107,6 +120,7 @@ void PeripheralTimer::Counter16BitClear(TMR_MODULE_ID index) {
 }
 
 void PeripheralTimer::Period16BitSet(TMR_MODULE_ID index, uint16_t period) {
+  CatchUp();
   if (index >= m_timers.size()) {
     FAIL() << "Invalid timer " << index;
   }
@@ -123,6 +137,7 @@ void PeripheralTimer::Period16BitSet(TMR_MODULE_ID index, uint16_t period) {
 }
 
 void PeripheralTimer::Stop(TMR_MODULE_ID index) {
+  CatchUp();
   if (index < m_timers.size()) {
     // This does not reset the counter to 0
     m_timers[index].enabled = false;
@@ -132,6 +147,7 @@ void PeripheralTimer::Stop(TMR_MODULE_ID index) {
 }
 
 void PeripheralTimer::Start(TMR_MODULE_ID index) {
+  CatchUp();
   if (index < m_timers.size()) {
     m_timers[index].enabled = true;
   } else {
@@ -191,3 +207,51 @@ void PeripheralTimer::Mode16BitEnable(TMR_MODULE_ID index) {
   }
 }
 
+
+/*
+ * @brief Apply the cycles skipped since the last Tick().
+ *
+ * The simulator never skips a cycle where a counter reaches the period, so
+ * this is just a matter of incrementing the counters.
+ */
+void PeripheralTimer::CatchUp() {
+  uint64_t now = m_simulator->Clock();
+  if (now <= m_next_cycle) {
+    return;
+  }
+
+  for (auto &timer : m_timers) {
+    if (timer.enabled) {
+      // The number of prescaled ticks in [m_next_cycle, now)
+      uint64_t prescale = m_prescale_values[timer.prescale];
+      uint64_t ticks = (now + prescale - 1) / prescale -
+                       (m_next_cycle + prescale - 1) / prescale;
+      AdvanceCounter(&timer, ticks);
+    }
+  }
+  m_next_cycle = now;
+}
+
+void PeripheralTimer::AdvanceCounter(Timer *timer, uint64_t ticks) {
+  while (ticks) {
+    if (timer->counter == timer->period) {
+      timer->counter = 0;
+      ticks--;
+      if (timer->period == 0) {
+        return;
+      }
+      continue;
+    }
+
+    uint16_t remaining = timer->period - timer->counter;
+    if (ticks < remaining) {
+      timer->counter += ticks;
+      return;
+    }
+    timer->counter = timer->period;
+    ticks -= remaining;
+    timer->in_isr = true;
+    m_interrupt_controller->RaiseInterrupt(timer->interrupt_source);
+    timer->in_isr = false;
+  }
+}
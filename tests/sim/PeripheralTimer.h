@@ -21,7 +21,6 @@
 #ifndef TESTS_SIM_PERIPHERALTIMER_H_
 #define TESTS_SIM_PERIPHERALTIMER_H_
 
-#include <memory>
 #include <map>
 #include <vector>
 
@@ -29,9 +28,9 @@
 
 #include "InterruptController.h"
 #include "Simulator.h"
-#include "ola/Callback.h"
 
-class PeripheralTimer : public PeripheralTimerInterface {
+class PeripheralTimer : public PeripheralTimerInterface,
+                        public Simulator::Peripheral {
  public:
   // Ownership is not transferred.
   PeripheralTimer(Simulator *simulator,
@@ -39,6 +38,7 @@ class PeripheralTimer : public PeripheralTimerInterface {
   ~PeripheralTimer();
 
   void Tick();
+  uint64_t NextEvent(uint64_t now);
 
   void Counter16BitSet(TMR_MODULE_ID index, uint16_t value);
   uint16_t Counter16BitGet(TMR_MODULE_ID index);
@@ -54,7 +54,8 @@ class PeripheralTimer : public PeripheralTimerInterface {
  private:
   Simulator *m_simulator;
   InterruptController *m_interrupt_controller;
-  std::unique_ptr<ola::Callback0<void>> m_callback;
+  // The first clock cycle which hasn't been applied to the timers.
+  uint64_t m_next_cycle;
 
   struct Timer {
    public:
@@ -70,6 +71,9 @@ class PeripheralTimer : public PeripheralTimerInterface {
 
   std::vector<Timer> m_timers;
   std::map<TMR_PRESCALE, uint16_t> m_prescale_values;
+
+  void CatchUp();
+  void AdvanceCounter(Timer *timer, uint64_t ticks);
 };
 
 #endif  // TESTS_SIM_PERIPHERALTIMER_H_
@@ -21,11 +21,12 @@
 #include "PeripheralUART.h"
 
 #include <gtest/gtest.h>
+
+#include <algorithm>
 #include <vector>
 
 #include "macros.h"
 #include "Simulator.h"
-#include "ola/Callback.h"
 
 using std::vector;
 
@@ -48,8 +49,8 @@ PeripheralUART::PeripheralUART(Simulator *simulator,
     : m_simulator(simulator),
       m_interrupt_controller(interrupt_controller),
       m_tx_callback(tx_callback),
-      m_callback(ola::NewCallback(this, &PeripheralUART::Tick)) {
-  m_simulator->AddTask(m_callback.get());
+      m_next_cycle(0) {
+  m_simulator->AddPeripheral(this);
 
   const vector<INT_SOURCE> sources = {
     INT_SOURCE_USART_1_ERROR,
@@ -65,10 +66,11 @@ PeripheralUART::PeripheralUART(Simulator *simulator,
 }
 
 PeripheralUART::~PeripheralUART() {
-  m_simulator->RemoveTask(m_callback.get());
+  m_simulator->RemovePeripheral(this);
 }
 
 void PeripheralUART::Tick() {
+  CatchUp();
   for (unsigned int i = 0; i < m_uarts.size(); i++) {
     UART &uart = m_uarts[i];
     if (!uart.enabled) {
@@ -96,20 +98,7 @@ void PeripheralUART::Tick() {
           }
         }
 
-        bool trigger_tx_isr = false;
-        switch (uart.int_mode) {
-          case USART_TRANSMIT_FIFO_NOT_FULL:
-            trigger_tx_isr = uart.tx_buffer.size() < TX_FIFO_SIZE;
-            break;
-          case USART_TRANSMIT_FIFO_IDLE:
-            trigger_tx_isr = (uart.tx_state == IDLE && uart.tx_buffer.empty());
-            break;
-          case USART_TRANSMIT_FIFO_EMPTY:
-            trigger_tx_isr = uart.tx_buffer.empty();
-            break;
-        }
-
-        if (trigger_tx_isr) {
+        if (TXInterruptPending(uart)) {
           m_interrupt_controller->RaiseInterrupt(
               static_cast<INT_SOURCE>(uart.interrupt_source + 2));
         }
@@ -122,6 +111,43 @@ void PeripheralUART::Tick() {
           static_cast<INT_SOURCE>(uart.interrupt_source + 1));
     }
   }
+  m_next_cycle = m_simulator->Clock() + 1;
+}
+
+uint64_t PeripheralUART::NextEvent(uint64_t now) {
+  uint64_t next = Simulator::kNever;
+  for (const auto &uart : m_uarts) {
+    if (!uart.enabled) {
+      continue;
+    }
+
+    if (uart.tx_enable) {
+      if (uart.tx_state == IDLE) {
+        if (!uart.tx_buffer.empty()) {
+          return now + 1;
+        }
+      } else {
+        // The TX interrupt is level triggered.
+        if (TXInterruptPending(uart) &&
+            m_interrupt_controller->IsEnabled(
+              static_cast<INT_SOURCE>(uart.interrupt_source + 2))) {
+          return now + 1;
+        }
+        // The end of the current bit.
+        if (uart.tx_counter < uart.ticks_per_bit) {
+          next = std::min(
+              next, m_next_cycle + uart.ticks_per_bit - uart.tx_counter - 1);
+        }
+      }
+    }
+
+    if (uart.rx_enable && !uart.rx_buffer.empty() &&
+        m_interrupt_controller->IsEnabled(
+          static_cast<INT_SOURCE>(uart.interrupt_source + 1))) {
+      return now + 1;
+    }
+  }
+  return std::max(next, now + 1);
 }
 
 void PeripheralUART::ReceiveByte(USART_MODULE_ID index, uint8_t byte) {
@@ -155,6 +181,7 @@ void PeripheralUART::SignalFramingError(USART_MODULE_ID index, uint8_t byte) {
 }
 
 void PeripheralUART::Enable(USART_MODULE_ID index) {
+  CatchUp();
   if (index >= m_uarts.size()) {
     FAIL() << "Invalid UART " << index;
   }
@@ -162,6 +189,7 @@ void PeripheralUART::Enable(USART_MODULE_ID index) {
 }
 
 void PeripheralUART::Disable(USART_MODULE_ID index) {
+  CatchUp();
   if (index >= m_uarts.size()) {
     FAIL() << "Invalid UART " << index;
   }
@@ -182,6 +210,7 @@ void PeripheralUART::Disable(USART_MODULE_ID index) {
 }
 
 void PeripheralUART::TransmitterEnable(USART_MODULE_ID index) {
+  CatchUp();
   if (index >= m_uarts.size()) {
     FAIL() << "Invalid UART " << index;
   }
@@ -189,6 +218,7 @@ void PeripheralUART::TransmitterEnable(USART_MODULE_ID index) {
 }
 
 void PeripheralUART::TransmitterDisable(USART_MODULE_ID index) {
+  CatchUp();
   if (index >= m_uarts.size()) {
     FAIL() << "Invalid UART " << index;
   }
@@ -198,6 +228,7 @@ void PeripheralUART::TransmitterDisable(USART_MODULE_ID index) {
 void PeripheralUART::BaudRateSet(USART_MODULE_ID index,
                                  uint32_t clockFrequency,
                                  uint32_t baudRate) {
+  CatchUp();
   if (index >= m_uarts.size()) {
     FAIL() << "Invalid UART " << index;
   }
@@ -316,3 +347,35 @@ USART_ERROR PeripheralUART::ErrorsGet(USART_MODULE_ID index) {
   // Yuck
   return static_cast<USART_ERROR>(m_uarts[index].errors);
 }
+
+/*
+ * @brief Apply the cycles skipped since the last Tick().
+ *
+ * The simulator never skips the end of a bit, so this just advances the bit
+ * counters.
+ */
+void PeripheralUART::CatchUp() {
+  uint64_t now = m_simulator->Clock();
+  if (now <= m_next_cycle) {
+    return;
+  }
+
+  for (auto &uart : m_uarts) {
+    if (uart.enabled && uart.tx_enable && uart.tx_state != IDLE) {
+      uart.tx_counter += now - m_next_cycle;
+    }
+  }
+  m_next_cycle = now;
+}
+
+bool PeripheralUART::TXInterruptPending(const UART &uart) const {
+  switch (uart.int_mode) {
+    case USART_TRANSMIT_FIFO_NOT_FULL:
+      return uart.tx_buffer.size() < TX_FIFO_SIZE;
+    case USART_TRANSMIT_FIFO_IDLE:
+      return uart.tx_state == IDLE && uart.tx_buffer.empty();
+    case USART_TRANSMIT_FIFO_EMPTY:
+      return uart.tx_buffer.empty();
+  }
+  return false;
+}
@@ -21,7 +21,6 @@
 #ifndef TESTS_SIM_PERIPHERALUART_H_
 #define TESTS_SIM_PERIPHERALUART_H_
 
-#include <memory>
 #include <queue>
 #include <vector>
 
@@ -31,7 +30,8 @@
 #include "Simulator.h"
 #include "ola/Callback.h"
 
-class PeripheralUART : public PeripheralUSARTInterface {
+class PeripheralUART : public PeripheralUSARTInterface,
+                       public Simulator::Peripheral {
  public:
   // Invoked when a byte is transmitted.
   typedef ola::Callback2<void, USART_MODULE_ID, uint8_t> TXCallback;
@@ -43,6 +43,7 @@ class PeripheralUART : public PeripheralUSARTInterface {
   ~PeripheralUART();
 
   void Tick();
+  uint64_t NextEvent(uint64_t now);
 
   // Used to push a byte of data to the receiver.
   void ReceiveByte(USART_MODULE_ID index, uint8_t byte);
@@ -76,7 +77,8 @@ class PeripheralUART : public PeripheralUSARTInterface {
   Simulator *m_simulator;
   InterruptController *m_interrupt_controller;
   TXCallback *m_tx_callback;
-  std::unique_ptr<ola::Callback0<void>> m_callback;
+  // The first clock cycle which hasn't been applied to the UARTs.
+  uint64_t m_next_cycle;
 
   enum UARTState {
     IDLE,
@@ -117,6 +119,10 @@ class PeripheralUART : public PeripheralUSARTInterface {
   };
 
   std::vector<UART> m_uarts;
+
+  void CatchUp();
+  bool TXInterruptPending(const UART &uart) const;
+
   static const uint8_t TX_FIFO_SIZE = 8;
   static const uint8_t RX_FIFO_SIZE = 8;
 };
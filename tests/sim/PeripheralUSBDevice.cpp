@@ -0,0 +1,259 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * PeripheralUSBDevice.cpp
+ * The USB device layer used with the simulator.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "PeripheralUSBDevice.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+
+PeripheralUSBDevice::PeripheralUSBDevice(Simulator *simulator,
+                                         TXCallback *tx_callback,
+                                         uint32_t clock_speed)
+    : m_simulator(simulator),
+      m_tx_callback(tx_callback),
+      m_cycles_per_packet(clock_speed / 19000),
+      m_connect_pending(false),
+      m_event_handler(nullptr),
+      m_context(0),
+      m_next_handle(1),
+      m_read_buffer(nullptr),
+      m_read_size(0),
+      m_next_read_at(0) {
+  m_simulator->AddPeripheral(this);
+}
+
+PeripheralUSBDevice::~PeripheralUSBDevice() {
+  m_simulator->RemovePeripheral(this);
+}
+
+void PeripheralUSBDevice::Tick() {
+  uint64_t clock = m_simulator->Clock();
+  if (m_connect_pending && m_event_handler) {
+    m_connect_pending = false;
+    RaiseEvent(USB_DEVICE_EVENT_POWER_DETECTED, nullptr);
+    uint8_t configuration = 1;
+    RaiseEvent(USB_DEVICE_EVENT_CONFIGURED, &configuration);
+  }
+
+  if (m_write.pending && clock >= m_write.complete_at) {
+    m_write.pending = false;
+    USB_DEVICE_EVENT_DATA_ENDPOINT_WRITE_COMPLETE data = {m_write.handle, 0};
+    RaiseEvent(USB_DEVICE_EVENT_ENDPOINT_WRITE_COMPLETE, &data);
+  }
+
+  if (m_read.pending && !m_host_data.empty() && clock >= m_next_read_at) {
+    size_t length = std::min(m_read_size, m_host_data.size());
+    std::copy(m_host_data.begin(), m_host_data.begin() + length,
+              m_read_buffer);
+    m_host_data.erase(m_host_data.begin(), m_host_data.begin() + length);
+    m_read.pending = false;
+    m_next_read_at = clock + TransferCycles(length);
+
+    USB_DEVICE_EVENT_DATA_ENDPOINT_READ_COMPLETE data = {m_read.handle,
+                                                         length};
+    RaiseEvent(USB_DEVICE_EVENT_ENDPOINT_READ_COMPLETE, &data);
+  }
+}
+
+uint64_t PeripheralUSBDevice::NextEvent(uint64_t now) {
+  uint64_t next = Simulator::kNever;
+  if (m_connect_pending && m_event_handler) {
+    next = now + 1;
+  }
+  if (m_write.pending) {
+    next = std::min(next, std::max(m_write.complete_at, now + 1));
+  }
+  if (m_read.pending && !m_host_data.empty()) {
+    next = std::min(next, std::max(m_next_read_at, now + 1));
+  }
+  return next;
+}
+
+void PeripheralUSBDevice::Connect() {
+  m_connect_pending = true;
+}
+
+void PeripheralUSBDevice::HostWrite(const uint8_t *data, unsigned int size) {
+  m_host_data.insert(m_host_data.end(), data, data + size);
+}
+
+void PeripheralUSBDevice::Attach(USB_DEVICE_HANDLE usbDeviceHandle) {
+  (void) usbDeviceHandle;
+}
+
+void PeripheralUSBDevice::Detach(USB_DEVICE_HANDLE usbDeviceHandle) {
+  (void) usbDeviceHandle;
+}
+
+USB_DEVICE_HANDLE PeripheralUSBDevice::Open(const uint16_t instanceIndex,
+                                            const DRV_IO_INTENT intent) {
+  (void) instanceIndex;
+  (void) intent;
+  return kHandle;
+}
+
+void PeripheralUSBDevice::EventHandlerSet(
+    USB_DEVICE_HANDLE usbDeviceHandle,
+    const USB_DEVICE_EVENT_HANDLER callBackFunc,
+    uintptr_t context) {
+  (void) usbDeviceHandle;
+  m_event_handler = callBackFunc;
+  m_context = context;
+}
+
+USB_DEVICE_CONTROL_TRANSFER_RESULT PeripheralUSBDevice::ControlStatus(
+    USB_DEVICE_HANDLE usbDeviceHandle,
+    USB_DEVICE_CONTROL_STATUS status) {
+  (void) usbDeviceHandle;
+  (void) status;
+  return USB_DEVICE_CONTROL_TRANSFER_RESULT_SUCCESS;
+}
+
+USB_DEVICE_CONTROL_TRANSFER_RESULT PeripheralUSBDevice::ControlSend(
+    USB_DEVICE_HANDLE usbDeviceHandle,
+    void *data,
+    size_t length) {
+  (void) usbDeviceHandle;
+  (void) data;
+  (void) length;
+  return USB_DEVICE_CONTROL_TRANSFER_RESULT_SUCCESS;
+}
+
+USB_DEVICE_CONTROL_TRANSFER_RESULT PeripheralUSBDevice::ControlReceive(
+    USB_DEVICE_HANDLE usbDeviceHandle,
+    void* data,
+    size_t length) {
+  (void) usbDeviceHandle;
+  (void) data;
+  (void) length;
+  return USB_DEVICE_CONTROL_TRANSFER_RESULT_SUCCESS;
+}
+
+USB_SPEED PeripheralUSBDevice::ActiveSpeedGet(
+    USB_DEVICE_HANDLE usbDeviceHandle) {
+  (void) usbDeviceHandle;
+  return USB_SPEED_FULL;
+}
+
+bool PeripheralUSBDevice::EndpointIsEnabled(USB_DEVICE_HANDLE usbDeviceHandle,
+                                            USB_ENDPOINT_ADDRESS endpoint) {
+  (void) usbDeviceHandle;
+  return m_enabled_endpoints.find(endpoint) != m_enabled_endpoints.end();
+}
+
+USB_DEVICE_RESULT PeripheralUSBDevice::EndpointEnable(
+    USB_DEVICE_HANDLE usbDeviceHandle,
+    uint8_t interface,
+    USB_ENDPOINT_ADDRESS endpoint,
+    USB_TRANSFER_TYPE transferType,
+    size_t size) {
+  (void) usbDeviceHandle;
+  (void) interface;
+  (void) transferType;
+  (void) size;
+  m_enabled_endpoints.insert(endpoint);
+  return USB_DEVICE_RESULT_OK;
+}
+
+USB_DEVICE_RESULT PeripheralUSBDevice::EndpointDisable(
+    USB_DEVICE_HANDLE usbDeviceHandle,
+    USB_ENDPOINT_ADDRESS endpoint) {
+  (void) usbDeviceHandle;
+  m_enabled_endpoints.erase(endpoint);
+  return USB_DEVICE_RESULT_OK;
+}
+
+void PeripheralUSBDevice::EndpointStall(USB_DEVICE_HANDLE usbDeviceHandle,
+                                        USB_ENDPOINT_ADDRESS endpoint) {
+  (void) usbDeviceHandle;
+  (void) endpoint;
+}
+
+USB_DEVICE_RESULT PeripheralUSBDevice::EndpointRead(
+    USB_DEVICE_HANDLE usbDeviceHandle,
+    USB_DEVICE_TRANSFER_HANDLE *transferHandle,
+    USB_ENDPOINT_ADDRESS endpoint,
+    void* buffer,
+    size_t bufferSize) {
+  (void) usbDeviceHandle;
+  if (!EndpointIsEnabled(kHandle, endpoint)) {
+    return USB_DEVICE_RESULT_ERROR_ENDPOINT_NOT_CONFIGURED;
+  }
+  if (m_read.pending) {
+    return USB_DEVICE_RESULT_ERROR_TRANSFER_QUEUE_FULL;
+  }
+
+  m_read.pending = true;
+  m_read.handle = m_next_handle++;
+  m_read_buffer = reinterpret_cast<uint8_t*>(buffer);
+  m_read_size = bufferSize;
+  *transferHandle = m_read.handle;
+  return USB_DEVICE_RESULT_OK;
+}
+
+USB_DEVICE_RESULT PeripheralUSBDevice::EndpointWrite(
+    USB_DEVICE_HANDLE usbDeviceHandle,
+    USB_DEVICE_TRANSFER_HANDLE *transferHandle,
+    USB_ENDPOINT_ADDRESS endpoint,
+    const void* data,
+    size_t size,
+    USB_DEVICE_TRANSFER_FLAGS flags) {
+  (void) usbDeviceHandle;
+  (void) flags;
+  if (!EndpointIsEnabled(kHandle, endpoint)) {
+    return USB_DEVICE_RESULT_ERROR_ENDPOINT_NOT_CONFIGURED;
+  }
+  if (m_write.pending) {
+    return USB_DEVICE_RESULT_ERROR_TRANSFER_QUEUE_FULL;
+  }
+
+  m_write.pending = true;
+  m_write.handle = m_next_handle++;
+  m_write.complete_at = m_simulator->Clock() + TransferCycles(size);
+  *transferHandle = m_write.handle;
+  if (m_tx_callback) {
+    m_tx_callback->Run(reinterpret_cast<const uint8_t*>(data), size);
+  }
+  return USB_DEVICE_RESULT_OK;
+}
+
+USB_DEVICE_RESULT PeripheralUSBDevice::EndpointTransferCancel(
+    USB_DEVICE_HANDLE usbDeviceHandle,
+    USB_ENDPOINT_ADDRESS endpoint,
+    USB_DEVICE_TRANSFER_HANDLE transferHandle) {
+  (void) usbDeviceHandle;
+  (void) endpoint;
+  if (m_write.pending && m_write.handle == transferHandle) {
+    m_write.complete_at = m_simulator->Clock();
+  }
+  return USB_DEVICE_RESULT_OK;
+}
+
+uint64_t PeripheralUSBDevice::TransferCycles(unsigned int size) const {
+  unsigned int packets = std::max((size + kPacketSize - 1) / kPacketSize, 1u);
+  return packets * m_cycles_per_packet;
+}
+
+void PeripheralUSBDevice::RaiseEvent(USB_DEVICE_EVENT event, void *data) {
+  if (m_event_handler) {
+    m_event_handler(event, data, m_context);
+  }
+}
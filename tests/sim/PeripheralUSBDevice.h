@@ -0,0 +1,143 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * PeripheralUSBDevice.h
+ * The USB device layer used with the simulator.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#ifndef TESTS_SIM_PERIPHERALUSBDEVICE_H_
+#define TESTS_SIM_PERIPHERALUSBDEVICE_H_
+
+#include <stdint.h>
+#include <deque>
+#include <set>
+#include <vector>
+
+#include "usb_device_mock.h"
+
+#include "Simulator.h"
+#include "ola/Callback.h"
+
+/*
+ * @brief A full speed USB device with a single pair of bulk endpoints.
+ *
+ * Data written by the Host with HostWrite() is returned by the next endpoint
+ * read, data written to the IN endpoint is passed to the TX callback. A
+ * transfer completes once the packets would have been sent over the bus; a
+ * full speed device moves at most 19 64 byte bulk packets per 1ms frame.
+ */
+class PeripheralUSBDevice : public USBDeviceInterface,
+                            public Simulator::Peripheral {
+ public:
+  // Invoked when the device sends data to the Host.
+  typedef ola::Callback2<void, const uint8_t*, unsigned int> TXCallback;
+
+  // Ownership of arguments is not transferred.
+  PeripheralUSBDevice(Simulator *simulator, TXCallback *tx_callback,
+                      uint32_t clock_speed);
+  ~PeripheralUSBDevice();
+
+  void Tick();
+  uint64_t NextEvent(uint64_t now);
+
+  // Apply VBUS & configure the device, once the device layer is open.
+  void Connect();
+
+  // Queue data from the Host.
+  void HostWrite(const uint8_t *data, unsigned int size);
+
+  void Attach(USB_DEVICE_HANDLE usbDeviceHandle);
+  void Detach(USB_DEVICE_HANDLE usbDeviceHandle);
+  USB_DEVICE_HANDLE Open(const uint16_t instanceIndex,
+                         const DRV_IO_INTENT intent);
+  void EventHandlerSet(USB_DEVICE_HANDLE usbDeviceHandle,
+                       const USB_DEVICE_EVENT_HANDLER callBackFunc,
+                       uintptr_t context);
+  USB_DEVICE_CONTROL_TRANSFER_RESULT ControlStatus(
+      USB_DEVICE_HANDLE usbDeviceHandle,
+      USB_DEVICE_CONTROL_STATUS status);
+  USB_DEVICE_CONTROL_TRANSFER_RESULT ControlSend(
+      USB_DEVICE_HANDLE usbDeviceHandle,
+      void *data,
+      size_t length);
+  USB_DEVICE_CONTROL_TRANSFER_RESULT ControlReceive(
+      USB_DEVICE_HANDLE usbDeviceHandle,
+      void* data,
+      size_t length);
+  USB_SPEED ActiveSpeedGet(USB_DEVICE_HANDLE usbDeviceHandle);
+  bool EndpointIsEnabled(USB_DEVICE_HANDLE usbDeviceHandle,
+                         USB_ENDPOINT_ADDRESS endpoint);
+  USB_DEVICE_RESULT EndpointEnable(USB_DEVICE_HANDLE usbDeviceHandle,
+                                   uint8_t interface,
+                                   USB_ENDPOINT_ADDRESS endpoint,
+                                   USB_TRANSFER_TYPE transferType,
+                                   size_t size);
+  USB_DEVICE_RESULT EndpointDisable(USB_DEVICE_HANDLE usbDeviceHandle,
+                                    USB_ENDPOINT_ADDRESS endpoint);
+  void EndpointStall(USB_DEVICE_HANDLE usbDeviceHandle,
+                     USB_ENDPOINT_ADDRESS endpoint);
+  USB_DEVICE_RESULT EndpointRead(USB_DEVICE_HANDLE usbDeviceHandle,
+                                 USB_DEVICE_TRANSFER_HANDLE *transferHandle,
+                                 USB_ENDPOINT_ADDRESS endpoint,
+                                 void* buffer,
+                                 size_t bufferSize);
+  USB_DEVICE_RESULT EndpointWrite(USB_DEVICE_HANDLE usbDeviceHandle,
+                                  USB_DEVICE_TRANSFER_HANDLE *transferHandle,
+                                  USB_ENDPOINT_ADDRESS endpoint,
+                                  const void* data,
+                                  size_t size,
+                                  USB_DEVICE_TRANSFER_FLAGS flags);
+  USB_DEVICE_RESULT EndpointTransferCancel(
+      USB_DEVICE_HANDLE usbDeviceHandle,
+      USB_ENDPOINT_ADDRESS endpoint,
+      USB_DEVICE_TRANSFER_HANDLE transferHandle);
+
+ private:
+  struct Transfer {
+   public:
+    Transfer() : pending(false), handle(0), complete_at(0) {}
+
+    bool pending;
+    USB_DEVICE_TRANSFER_HANDLE handle;
+    uint64_t complete_at;
+  };
+
+  Simulator *m_simulator;
+  TXCallback *m_tx_callback;
+  const uint32_t m_cycles_per_packet;
+
+  bool m_connect_pending;
+  USB_DEVICE_EVENT_HANDLER m_event_handler;
+  uintptr_t m_context;
+  std::set<USB_ENDPOINT_ADDRESS> m_enabled_endpoints;
+  USB_DEVICE_TRANSFER_HANDLE m_next_handle;
+
+  Transfer m_read;
+  uint8_t *m_read_buffer;
+  size_t m_read_size;
+  // The earliest cycle the next read may complete.
+  uint64_t m_next_read_at;
+  Transfer m_write;
+  std::deque<uint8_t> m_host_data;
+
+  uint64_t TransferCycles(unsigned int size) const;
+  void RaiseEvent(USB_DEVICE_EVENT event, void *data);
+
+  static const USB_DEVICE_HANDLE kHandle = 1;
+  static const unsigned int kPacketSize = 64;
+};
+
+#endif  // TESTS_SIM_PERIPHERALUSBDEVICE_H_
@@ -0,0 +1,157 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * RS485Bus.cpp
+ * Connects the simulated controller to a number of simulated devices.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "RS485Bus.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+RS485Bus::RS485Bus(Simulator *simulator,
+                   SignalGenerator *controller_rx,
+                   PORTS_CHANNEL port,
+                   PORTS_BIT_POS break_bit,
+                   PORTS_BIT_POS tx_enable_bit,
+                   uint32_t clock_speed,
+                   uint32_t baud_rate)
+    : m_simulator(simulator),
+      m_controller_rx(controller_rx),
+      m_port(port),
+      m_break_bit(break_bit),
+      m_tx_enable_bit(tx_enable_bit),
+      m_cycles_per_usecond(clock_speed / 1000000),
+      // 8N2 plus the start bit.
+      m_cycles_per_byte(11 * (clock_speed / baud_rate)),
+      m_controller_driving(false),
+      m_collisions(0) {
+  m_simulator->AddPeripheral(this);
+}
+
+RS485Bus::~RS485Bus() {
+  m_simulator->RemovePeripheral(this);
+}
+
+void RS485Bus::Tick() {
+  uint64_t clock = m_simulator->Clock();
+  if (m_pending.empty() || FirstPendingStart() > clock) {
+    return;
+  }
+
+  // Sort by start time, then gather everything that overlaps the first
+  // transmission.
+  std::sort(m_pending.begin(), m_pending.end(),
+            [](const Transmission &a, const Transmission &b) {
+              return a.start < b.start;
+            });
+  uint64_t end = m_pending.front().end;
+  unsigned int count = 1;
+  while (count < m_pending.size() && m_pending[count].start < end) {
+    end = std::max(end, m_pending[count].end);
+    count++;
+  }
+
+  bool include_break = false;
+  std::vector<uint8_t> line;
+  for (unsigned int i = 0; i < count; i++) {
+    const Transmission &transmission = m_pending[i];
+    include_break |= transmission.include_break;
+    for (unsigned int j = 0; j < transmission.data.size(); j++) {
+      if (j < line.size()) {
+        line[j] &= transmission.data[j];
+      } else {
+        line.push_back(transmission.data[j]);
+      }
+    }
+  }
+  if (count > 1) {
+    m_collisions += count;
+  }
+  m_pending.erase(m_pending.begin(), m_pending.begin() + count);
+
+  if (include_break) {
+    m_controller_rx->AddBreak(kBreakTime);
+    m_controller_rx->AddMark(kMarkTime);
+  }
+  m_controller_rx->AddFrame(line.data(), line.size());
+}
+
+uint64_t RS485Bus::NextEvent(uint64_t now) {
+  if (m_pending.empty()) {
+    return Simulator::kNever;
+  }
+  return std::max(FirstPendingStart(), now + 1);
+}
+
+void RS485Bus::AddDevice(Device *device) {
+  m_devices.push_back(device);
+}
+
+void RS485Bus::RemoveDevice(Device *device) {
+  m_devices.erase(std::remove(m_devices.begin(), m_devices.end(), device),
+                  m_devices.end());
+}
+
+void RS485Bus::ControllerPinChange(PORTS_CHANNEL channel,
+                                   PORTS_BIT_POS bit_pos,
+                                   bool state) {
+  if (channel != m_port) {
+    return;
+  }
+
+  if (bit_pos == m_tx_enable_bit) {
+    m_controller_driving = state;
+  } else if (bit_pos == m_break_bit && !state && m_controller_driving) {
+    for (auto &device : m_devices) {
+      device->BreakReceived();
+    }
+  }
+}
+
+void RS485Bus::ControllerByteSent(USART_MODULE_ID uart_id, uint8_t byte) {
+  (void) uart_id;
+  if (!m_controller_driving) {
+    return;
+  }
+  for (auto &device : m_devices) {
+    device->ByteReceived(byte);
+  }
+}
+
+void RS485Bus::Transmit(uint32_t delay, bool include_break,
+                        const uint8_t *data, unsigned int size) {
+  Transmission transmission;
+  transmission.start = m_simulator->Clock() + delay * m_cycles_per_usecond;
+  transmission.end = transmission.start + size * m_cycles_per_byte;
+  if (include_break) {
+    transmission.end += (kBreakTime + kMarkTime) * m_cycles_per_usecond;
+  }
+  transmission.include_break = include_break;
+  transmission.data.assign(data, data + size);
+  m_pending.push_back(transmission);
+}
+
+uint64_t RS485Bus::FirstPendingStart() const {
+  uint64_t start = Simulator::kNever;
+  for (const auto &transmission : m_pending) {
+    start = std::min(start, transmission.start);
+  }
+  return start;
+}
@@ -0,0 +1,123 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * RS485Bus.h
+ * Connects the simulated controller to a number of simulated devices.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#ifndef TESTS_SIM_RS485BUS_H_
+#define TESTS_SIM_RS485BUS_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "plib_ports_mock.h"
+#include "plib_usart_mock.h"
+
+#include "SignalGenerator.h"
+#include "Simulator.h"
+
+/*
+ * @brief A half duplex RS485 line shared by the controller & N devices.
+ *
+ * The controller's output is taken from the break pin, the TX enable pin and
+ * the bytes the UART transmits; connect ControllerPinChange() and
+ * ControllerByteSent() to the PeripheralPorts & PeripheralUART callbacks.
+ * Each byte is delivered to every device once it's completely on the line.
+ *
+ * Devices transmit by calling Transmit(). The data is returned to the
+ * controller using a SignalGenerator. Transmissions which overlap on the line
+ * are combined, byte by byte, as a wired AND of the drivers, which is
+ * what a DUB collision usually looks like to the controller. Devices don't
+ * hear each other.
+ */
+class RS485Bus : public Simulator::Peripheral {
+ public:
+  // A device on the bus.
+  class Device {
+   public:
+    virtual ~Device() {}
+
+    // The controller sent a break.
+    virtual void BreakReceived() = 0;
+
+    // The controller sent a byte.
+    virtual void ByteReceived(uint8_t byte) = 0;
+  };
+
+  // Ownership is not transferred.
+  RS485Bus(Simulator *simulator,
+           SignalGenerator *controller_rx,
+           PORTS_CHANNEL port,
+           PORTS_BIT_POS break_bit,
+           PORTS_BIT_POS tx_enable_bit,
+           uint32_t clock_speed,
+           uint32_t baud_rate);
+  ~RS485Bus();
+
+  void Tick();
+  uint64_t NextEvent(uint64_t now);
+
+  // Ownership is not transferred.
+  void AddDevice(Device *device);
+  void RemoveDevice(Device *device);
+
+  void ControllerPinChange(PORTS_CHANNEL channel, PORTS_BIT_POS bit_pos,
+                           bool state);
+  void ControllerByteSent(USART_MODULE_ID uart_id, uint8_t byte);
+
+  /*
+   * @brief Transmit data from a device.
+   * @param delay The time in uS until the device starts driving the line.
+   * @param include_break true to send a break & mark before the data.
+   * @param data The data to send.
+   * @param size The size of the data.
+   */
+  void Transmit(uint32_t delay, bool include_break, const uint8_t *data,
+                unsigned int size);
+
+  // The number of transmissions which collided with another.
+  unsigned int Collisions() const { return m_collisions; }
+
+ private:
+  struct Transmission {
+   public:
+    uint64_t start;
+    uint64_t end;
+    bool include_break;
+    std::vector<uint8_t> data;
+  };
+
+  Simulator *m_simulator;
+  SignalGenerator *m_controller_rx;
+  const PORTS_CHANNEL m_port;
+  const PORTS_BIT_POS m_break_bit;
+  const PORTS_BIT_POS m_tx_enable_bit;
+  const uint32_t m_cycles_per_usecond;
+  const uint32_t m_cycles_per_byte;
+
+  bool m_controller_driving;
+  unsigned int m_collisions;
+  std::vector<Device*> m_devices;
+  std::vector<Transmission> m_pending;
+
+  uint64_t FirstPendingStart() const;
+
+  static const uint32_t kBreakTime = 176;
+  static const uint32_t kMarkTime = 12;
+};
+
+#endif  // TESTS_SIM_RS485BUS_H_
@@ -21,6 +21,8 @@
 #include "SignalGenerator.h"
 
 #include <stdint.h>
+
+#include <algorithm>
 #include <queue>
 
 #include "PeripheralInputCapture.h"
@@ -46,13 +48,12 @@ SignalGenerator::SignalGenerator(Simulator *simulator,
       m_framing_error_at(0),
       m_line_state(HIGH),
       m_tx_byte(0),
-      m_state(IDLE),
-      m_callback(ola::NewCallback(this, &SignalGenerator::Tick)) {
-  m_simulator->AddTask(m_callback.get());
+      m_state(IDLE) {
+  m_simulator->AddPeripheral(this);
 }
 
 SignalGenerator::~SignalGenerator() {
-  m_simulator->RemoveTask(m_callback.get());
+  m_simulator->RemovePeripheral(this);
 }
 
 void SignalGenerator::Tick() {
@@ -97,10 +98,23 @@ void SignalGenerator::Tick() {
       return;
     case HALTING:
       m_simulator->Stop();
+      m_stop_on_complete = false;
+      m_state = IDLE;
       break;
   }
 }
 
+uint64_t SignalGenerator::NextEvent(uint64_t now) {
+  uint64_t next = Simulator::kNever;
+  if (m_framing_error_at > now) {
+    next = m_framing_error_at;
+  }
+  if (m_state != IDLE || !m_events.empty() || m_stop_on_complete) {
+    next = std::min(next, std::max(m_next_event_at, now + 1));
+  }
+  return next;
+}
+
 void SignalGenerator::Reset() {
   m_next_event_at = 0;
   m_framing_error_at = 0;
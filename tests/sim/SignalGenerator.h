@@ -50,7 +50,7 @@
  *  signal_generator.AddByte(0);
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  */
-class SignalGenerator {
+class SignalGenerator : public Simulator::Peripheral {
  public:
   SignalGenerator(Simulator *simulator,
                   PeripheralInputCapture *input_capture,
@@ -62,6 +62,7 @@ class SignalGenerator {
   ~SignalGenerator();
 
   void Tick();
+  uint64_t NextEvent(uint64_t now);
 
   /*
    * @brief Reset the generator.
@@ -71,7 +72,8 @@ class SignalGenerator {
   /*
    * @brief Controls if we stop the simulator when we run out of events.
    *
-   * If true, we'll run for an extra 10us to let the system settle.
+   * If true, we'll run for an extra 10us to let the system settle. This is
+   * cleared once the simulator has been stopped.
    */
   void SetStopOnComplete(bool stop_on_complete);
 
@@ -166,7 +168,6 @@ class SignalGenerator {
   LineState m_line_state;
   uint8_t m_tx_byte;
   State m_state;
-  std::unique_ptr<ola::Callback0<void>> m_callback;
   std::queue<Event> m_events;
 
   void ProcessNextEvent();
@@ -0,0 +1,193 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * SimulatedResponder.cpp
+ * A behavioural model of an RDM responder.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "SimulatedResponder.h"
+
+#include <arpa/inet.h>
+#include <string.h>
+
+#include <vector>
+
+#include "constants.h"
+#include "dmx_spec.h"
+#include "rdm_frame.h"
+#include "rdm_util.h"
+#include "utils.h"
+
+namespace {
+
+const uint8_t kDeviceInfo[] = {
+  0x01, 0x00,  // RDM version
+  0x01, 0x02,  // model
+  0x01, 0x01,  // product category
+  0x00, 0x00, 0x00, 0x01,  // software version
+  0x00, 0x03,  // footprint
+  0x01, 0x01,  // personality
+  0x00, 0x01,  // start address
+  0x00, 0x00,  // sub device count
+  0x00  // sensor count
+};
+
+}  // namespace
+
+SimulatedResponder::SimulatedResponder(RS485Bus *bus,
+                                       const uint8_t uid[UID_LENGTH])
+    : m_bus(bus),
+      m_response_delay(kDefaultResponseDelay),
+      m_muted(false),
+      m_in_frame(false),
+      m_dmx_frames(0),
+      m_rdm_requests(0) {
+  memcpy(m_uid, uid, UID_LENGTH);
+  m_frame.reserve(RDM_MAX_FRAME_SIZE);
+}
+
+void SimulatedResponder::BreakReceived() {
+  m_in_frame = true;
+  m_frame.clear();
+}
+
+void SimulatedResponder::ByteReceived(uint8_t byte) {
+  if (!m_in_frame) {
+    return;
+  }
+
+  m_frame.push_back(byte);
+  if (m_frame.size() == 1) {
+    if (byte == NULL_START_CODE) {
+      m_dmx_frames++;
+      m_in_frame = false;
+    } else if (byte != RDM_START_CODE) {
+      m_in_frame = false;
+    }
+    return;
+  }
+
+  // The message length doesn't include the checksum.
+  if (m_frame.size() > MESSAGE_LENGTH_OFFSET &&
+      m_frame.size() == static_cast<unsigned int>(
+          m_frame[MESSAGE_LENGTH_OFFSET] + RDM_CHECKSUM_LENGTH)) {
+    m_in_frame = false;
+    HandleRequest();
+  }
+}
+
+void SimulatedResponder::HandleRequest() {
+  const uint8_t *frame = m_frame.data();
+  const RDMHeader *header = reinterpret_cast<const RDMHeader*>(frame);
+  if (!RDMUtil_VerifyChecksum(frame, m_frame.size()) ||
+      header->sub_start_code != SUB_START_CODE ||
+      m_frame.size() != sizeof(RDMHeader) + header->param_data_length +
+                        RDM_CHECKSUM_LENGTH ||
+      !RDMUtil_RequiresAction(m_uid, header->dest_uid)) {
+    return;
+  }
+
+  m_rdm_requests++;
+  const uint8_t *param_data = frame + sizeof(RDMHeader);
+  bool unicast = RDMUtil_IsUnicast(header->dest_uid);
+  uint16_t pid = ntohs(header->param_id);
+
+  if (header->command_class == DISCOVERY_COMMAND) {
+    const uint8_t control_field[] = {0, 0};
+    switch (pid) {
+      case PID_DISC_UNIQUE_BRANCH:
+        if (!m_muted && header->param_data_length == 2 * UID_LENGTH &&
+            RDMUtil_UIDCompare(param_data, m_uid) <= 0 &&
+            RDMUtil_UIDCompare(m_uid, param_data + UID_LENGTH) <= 0) {
+          SendDUBResponse();
+        }
+        break;
+      case PID_DISC_MUTE:
+        m_muted = true;
+        if (unicast) {
+          SendResponse(frame, ACK, control_field, sizeof(control_field));
+        }
+        break;
+      case PID_DISC_UN_MUTE:
+        m_muted = false;
+        if (unicast) {
+          SendResponse(frame, ACK, control_field, sizeof(control_field));
+        }
+        break;
+      default:
+        {}
+    }
+    return;
+  }
+
+  if (!unicast) {
+    return;
+  }
+
+  if (header->command_class == GET_COMMAND && pid == PID_DEVICE_INFO) {
+    SendResponse(frame, ACK, kDeviceInfo, sizeof(kDeviceInfo));
+  } else {
+    const uint8_t nack_reason[] = {
+      ShortMSB(NR_UNKNOWN_PID), ShortLSB(NR_UNKNOWN_PID)
+    };
+    SendResponse(frame, NACK_REASON, nack_reason, sizeof(nack_reason));
+  }
+}
+
+void SimulatedResponder::SendDUBResponse() {
+  uint8_t response[DUB_RESPONSE_LENGTH];
+  memset(response, 0xfe, 7);
+  response[7] = 0xaa;
+
+  uint16_t checksum = 0;
+  for (unsigned int i = 0; i < UID_LENGTH; i++) {
+    response[8 + 2 * i] = m_uid[i] | 0xaa;
+    response[9 + 2 * i] = m_uid[i] | 0x55;
+    checksum += response[8 + 2 * i] + response[9 + 2 * i];
+  }
+  response[20] = ShortMSB(checksum) | 0xaa;
+  response[21] = ShortMSB(checksum) | 0x55;
+  response[22] = ShortLSB(checksum) | 0xaa;
+  response[23] = ShortLSB(checksum) | 0x55;
+  m_bus->Transmit(m_response_delay, false, response, sizeof(response));
+}
+
+void SimulatedResponder::SendResponse(const uint8_t *request,
+                                      uint8_t response_type,
+                                      const uint8_t *param_data,
+                                      uint8_t param_data_length) {
+  const RDMHeader *request_header = reinterpret_cast<const RDMHeader*>(
+      request);
+  uint8_t response[RDM_MAX_FRAME_SIZE];
+  RDMHeader *header = reinterpret_cast<RDMHeader*>(response);
+
+  header->start_code = RDM_START_CODE;
+  header->sub_start_code = SUB_START_CODE;
+  header->message_length = sizeof(RDMHeader) + param_data_length;
+  memcpy(header->dest_uid, request_header->src_uid, UID_LENGTH);
+  memcpy(header->src_uid, m_uid, UID_LENGTH);
+  header->transaction_number = request_header->transaction_number;
+  header->port_id = response_type;
+  header->message_count = 0;
+  header->sub_device = request_header->sub_device;
+  header->command_class = request_header->command_class + 1;
+  header->param_id = request_header->param_id;
+  header->param_data_length = param_data_length;
+  memcpy(response + sizeof(RDMHeader), param_data, param_data_length);
+
+  unsigned int size = RDMUtil_AppendChecksum(response);
+  m_bus->Transmit(m_response_delay, true, response, size);
+}
@@ -0,0 +1,76 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * SimulatedResponder.h
+ * A behavioural model of an RDM responder.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#ifndef TESTS_SIM_SIMULATEDRESPONDER_H_
+#define TESTS_SIM_SIMULATEDRESPONDER_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "rdm.h"
+#include "uid.h"
+
+#include "RS485Bus.h"
+
+/*
+ * @brief A lightweight RDM responder which sits on a RS485Bus.
+ *
+ * The firmware's responder code uses global state, so only one instance can
+ * exist in a process. This implements just enough behaviour to benchmark a
+ * controller against many devices:
+ *  - DUB, mute & un-mute
+ *  - GET DEVICE_INFO, all other PIDs are NACKed with NR_UNKNOWN_PID
+ *  - DMX512 frames are counted.
+ */
+class SimulatedResponder : public RS485Bus::Device {
+ public:
+  // Ownership is not transferred.
+  SimulatedResponder(RS485Bus *bus, const uint8_t uid[UID_LENGTH]);
+
+  void BreakReceived();
+  void ByteReceived(uint8_t byte);
+
+  // Set the delay in uS between the end of a request & the response.
+  void SetResponseDelay(uint32_t delay) { m_response_delay = delay; }
+
+  const uint8_t *UID() const { return m_uid; }
+  bool IsMuted() const { return m_muted; }
+  unsigned int DMXFrames() const { return m_dmx_frames; }
+  unsigned int RDMRequests() const { return m_rdm_requests; }
+
+ private:
+  RS485Bus *m_bus;
+  uint8_t m_uid[UID_LENGTH];
+  uint32_t m_response_delay;
+  bool m_muted;
+  bool m_in_frame;
+  unsigned int m_dmx_frames;
+  unsigned int m_rdm_requests;
+  std::vector<uint8_t> m_frame;
+
+  void HandleRequest();
+  void SendDUBResponse();
+  void SendResponse(const uint8_t *request, uint8_t response_type,
+                    const uint8_t *param_data, uint8_t param_data_length);
+
+  static const uint32_t kDefaultResponseDelay = 176;
+};
+
+#endif  // TESTS_SIM_SIMULATEDRESPONDER_H_
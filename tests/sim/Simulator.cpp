@@ -22,12 +22,18 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <limits>
+
+const uint64_t Simulator::kNever = std::numeric_limits<uint64_t>::max();
+
 Simulator::Simulator(uint32_t clock_speed)
     : m_clock_speed(clock_speed),
       m_run(true),
       m_clock_limit(0),
       m_clock_limit_fatal(false),
-      m_clock(0) {
+      m_clock(0),
+      m_task_interval(std::max(clock_speed / 1000000, 1u)) {
 }
 
 void Simulator::SetClockLimit(uint64_t duration, bool fatal) {
@@ -35,6 +41,10 @@ void Simulator::SetClockLimit(uint64_t duration, bool fatal) {
   m_clock_limit_fatal = fatal;
 }
 
+void Simulator::SetTaskInterval(uint32_t cycles) {
+  m_task_interval = std::max(cycles, 1u);
+}
+
 void Simulator::AddTask(TaskFn *fn) {
   m_tasks.insert(fn);
 }
@@ -43,18 +53,31 @@ void Simulator::RemoveTask(TaskFn *fn) {
   m_tasks.erase(fn);
 }
 
+void Simulator::AddPeripheral(Peripheral *peripheral) {
+  m_peripherals.push_back(peripheral);
+}
+
+void Simulator::RemovePeripheral(Peripheral *peripheral) {
+  m_peripherals.erase(
+      std::remove(m_peripherals.begin(), m_peripherals.end(), peripheral),
+      m_peripherals.end());
+}
+
 uint64_t Simulator::Clock() const {
   return m_clock;
 }
 
 void Simulator::Run() {
   m_run = true;
-  m_clock = 0;
   while (m_run) {
+    for (auto &peripheral : m_peripherals) {
+      peripheral->Tick();
+    }
     for (const auto &task : m_tasks) {
       task->Run();
     }
-    m_clock++;
+
+    m_clock = m_run ? NextCycle() : m_clock + 1;
     if (m_clock_limit && m_clock >= m_clock_limit) {
       if (m_clock_limit_fatal) {
         FAIL() << "Clock limit exceeded: " << m_clock_limit;
@@ -67,3 +90,20 @@ void Simulator::Run() {
 void Simulator::Stop() {
   m_run = false;
 }
+
+/*
+ * @brief Find the next cycle where something may happen.
+ *
+ * The peripherals are queried after the tasks have run, since the tasks may
+ * have changed the peripheral state.
+ */
+uint64_t Simulator::NextCycle() {
+  uint64_t next = m_clock + m_task_interval;
+  for (auto &peripheral : m_peripherals) {
+    next = std::min(next, peripheral->NextEvent(m_clock));
+  }
+  if (m_clock_limit) {
+    next = std::min(next, m_clock_limit);
+  }
+  return std::max(next, m_clock + 1);
+}
@@ -23,22 +23,57 @@
 
 #include <stdint.h>
 #include <set>
+#include <vector>
 
 #include "ola/Callback.h"
 
+/*
+ * @brief Simulates the passage of time.
+ *
+ * Rather than stepping through every clock cycle, the simulator asks each
+ * peripheral for the next cycle on which its state changes, and jumps the
+ * clock straight to the earliest one. Tasks, which model the main loop, are
+ * run on every step and at least once every task interval.
+ */
 class Simulator {
  public:
   typedef ola::Callback0<void> TaskFn;
 
+  // A peripheral which is only run on the cycles where something happens.
+  class Peripheral {
+   public:
+    virtual ~Peripheral() {}
+
+    // Run the peripheral for the current clock cycle. The peripheral is
+    // responsible for accounting for any cycles skipped since the last call.
+    virtual void Tick() = 0;
+
+    // Return the next clock cycle, after now, on which Tick() must be called,
+    // or kNever if the peripheral is idle.
+    virtual uint64_t NextEvent(uint64_t now) = 0;
+  };
+
+  static const uint64_t kNever;
+
   explicit Simulator(uint32_t clock_speed);
 
-  // Stop the simulator after a certain duration.
+  // Stop the simulator once duration microseconds have passed, measured from
+  // the current clock. The clock is monotonic, so each call to Run() needs a
+  // new limit.
   // This can be made fatal to guard against tests that never complete.
   void SetClockLimit(uint64_t duration, bool fatal);
 
+  // Set the maximum number of clock cycles between runs of the tasks.
+  // Defaults to 1uS.
+  void SetTaskInterval(uint32_t cycles);
+
   void AddTask(TaskFn *fn);
   void RemoveTask(TaskFn *fn);
 
+  // Ownership is not transferred.
+  void AddPeripheral(Peripheral *peripheral);
+  void RemovePeripheral(Peripheral *peripheral);
+
   // Monotomic clock
   uint64_t Clock() const;
 
@@ -47,6 +82,7 @@ class Simulator {
 
  private:
   typedef std::set<TaskFn*> Tasks;
+  typedef std::vector<Peripheral*> Peripherals;
 
   const uint32_t m_clock_speed;
 
@@ -54,7 +90,11 @@ class Simulator {
   uint64_t m_clock_limit;
   bool m_clock_limit_fatal;
   uint64_t m_clock;
+  uint32_t m_task_interval;
   Tasks m_tasks;
+  Peripherals m_peripherals;
+
+  uint64_t NextCycle();
 };
 
 #endif  // TESTS_SIM_SIMULATOR_H_
@@ -0,0 +1,300 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * ClientTest.cpp
+ * Tests for the Host side client library.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "Array.h"
+#include "Matchers.h"
+#include "client/Client.h"
+#include "client/DescriptorTransport.h"
+#include "constants.h"
+#include "transport.h"
+
+using ja_rule::ByteTransport;
+using ja_rule::COMMAND_CANCELLED;
+using ja_rule::COMMAND_COMPLETED;
+using ja_rule::COMMAND_TIMEOUT;
+using ja_rule::Client;
+using ja_rule::CommandResult;
+using ja_rule::DescriptorTransport;
+using ja_rule::Event;
+using ja_rule::Response;
+using std::vector;
+
+namespace {
+
+// Records written frames & returns queued data from Read().
+class FakeTransport : public ByteTransport {
+ public:
+  FakeTransport() : failed(false) {}
+
+  bool Write(const uint8_t *data, unsigned int size) {
+    if (failed) {
+      return false;
+    }
+    frames.push_back(vector<uint8_t>(data, data + size));
+    return true;
+  }
+
+  int Read(uint8_t *data, unsigned int size, int) {
+    if (failed) {
+      return -1;
+    }
+    unsigned int length = std::min(size,
+                                   static_cast<unsigned int>(rx_data.size()));
+    std::copy(rx_data.begin(), rx_data.begin() + length, data);
+    rx_data.erase(rx_data.begin(), rx_data.begin() + length);
+    return length;
+  }
+
+  void AddResponse(uint8_t token, uint16_t command, uint8_t rc, uint8_t flags,
+                   const uint8_t *payload = NULL, unsigned int size = 0) {
+    rx_data.push_back(START_OF_MESSAGE_ID);
+    rx_data.push_back(token);
+    rx_data.push_back(command & 0xff);
+    rx_data.push_back(command >> 8);
+    rx_data.push_back(size & 0xff);
+    rx_data.push_back(size >> 8);
+    rx_data.push_back(rc);
+    rx_data.push_back(flags);
+    rx_data.insert(rx_data.end(), payload, payload + size);
+    rx_data.push_back(END_OF_MESSAGE_ID);
+  }
+
+  bool failed;
+  vector<vector<uint8_t> > frames;
+  vector<uint8_t> rx_data;
+};
+
+struct Completion {
+  CommandResult result;
+  Response response;
+};
+}  // namespace
+
+class ClientTest : public testing::Test {
+ public:
+  Client::CompletionCallback Recorder() {
+    return [this](CommandResult result, const Response &response) {
+      Completion completion = {result, response};
+      m_completions.push_back(completion);
+    };
+  }
+
+ protected:
+  FakeTransport m_transport;
+  vector<Completion> m_completions;
+};
+
+TEST_F(ClientTest, sendFrame) {
+  Client client(&m_transport, Client::Options());
+  const uint8_t payload[] = {1, 2, 3};
+  EXPECT_TRUE(client.SendCommand(COMMAND_ECHO, payload, arraysize(payload),
+                                 Recorder()));
+
+  ASSERT_EQ(1u, m_transport.frames.size());
+  const uint8_t expected[] = {
+    START_OF_MESSAGE_ID, 0, 0xf0, 0, 3, 0, 1, 2, 3, END_OF_MESSAGE_ID
+  };
+  EXPECT_THAT(ArrayTuple(m_transport.frames[0].data(),
+                         m_transport.frames[0].size()),
+              DataIs(expected, arraysize(expected)));
+
+  m_transport.AddResponse(0, COMMAND_ECHO, RC_OK, TRANSPORT_FLAGS_CHANGED,
+                          payload, arraysize(payload));
+  bool flags_changed = false;
+  client.SetFlagsChangedCallback([&flags_changed]() { flags_changed = true; });
+  EXPECT_TRUE(client.Poll(0));
+
+  ASSERT_EQ(1u, m_completions.size());
+  EXPECT_EQ(COMMAND_COMPLETED, m_completions[0].result);
+  EXPECT_EQ(RC_OK, m_completions[0].response.rc);
+  EXPECT_TRUE(m_completions[0].response.FlagsChanged());
+  EXPECT_FALSE(m_completions[0].response.Truncated());
+  EXPECT_THAT(ArrayTuple(m_completions[0].response.payload.data(),
+                         m_completions[0].response.payload.size()),
+              DataIs(payload, arraysize(payload)));
+  EXPECT_TRUE(flags_changed);
+  EXPECT_EQ(0u, client.InFlight());
+}
+
+TEST_F(ClientTest, window) {
+  Client::Options options;
+  options.window_size = 2;
+  Client client(&m_transport, options);
+
+  for (unsigned int i = 0; i < 5; i++) {
+    EXPECT_TRUE(client.SendCommand(TX_DMX, NULL, 0, Recorder()));
+  }
+  EXPECT_EQ(2u, m_transport.frames.size());
+  EXPECT_EQ(2u, client.InFlight());
+  EXPECT_EQ(3u, client.Queued());
+
+  // Responses can arrive out of order.
+  m_transport.AddResponse(1, TX_DMX, RC_OK, 0);
+  EXPECT_TRUE(client.Poll(0));
+  ASSERT_EQ(1u, m_completions.size());
+  EXPECT_EQ(1u, m_completions[0].response.token);
+  EXPECT_EQ(3u, m_transport.frames.size());
+  EXPECT_EQ(2, m_transport.frames[2][1]);
+
+  m_transport.AddResponse(0, TX_DMX, RC_OK, 0);
+  m_transport.AddResponse(2, TX_DMX, RC_BUFFER_FULL, 0);
+  EXPECT_TRUE(client.Poll(0));
+  ASSERT_EQ(3u, m_completions.size());
+  EXPECT_EQ(RC_BUFFER_FULL, m_completions[2].response.rc);
+  EXPECT_EQ(5u, m_transport.frames.size());
+  EXPECT_EQ(0u, client.Queued());
+}
+
+TEST_F(ClientTest, unmatchedAndMalformed) {
+  Client client(&m_transport, Client::Options());
+  EXPECT_TRUE(client.SendCommand(TX_DMX, NULL, 0, Recorder()));
+
+  // Wrong token, then the wrong command.
+  m_transport.AddResponse(7, TX_DMX, RC_OK, 0);
+  m_transport.AddResponse(0, COMMAND_ECHO, RC_OK, 0);
+  // Missing EOM.
+  m_transport.AddResponse(0, TX_DMX, RC_OK, 0);
+  m_transport.rx_data.back() = 0;
+  EXPECT_TRUE(client.Poll(0));
+
+  EXPECT_EQ(0u, m_completions.size());
+  EXPECT_EQ(2u, client.UnmatchedResponses());
+  EXPECT_EQ(1u, client.MalformedFrames());
+  EXPECT_EQ(1u, client.InFlight());
+}
+
+TEST_F(ClientTest, credits) {
+  Client client(&m_transport, Client::Options());
+  EXPECT_TRUE(client.SendCommand(TX_DMX, NULL, 0, Recorder()));
+
+  m_transport.AddResponse(0, TX_DMX, RC_BUFFER_FULL,
+                          3 << TRANSPORT_RX_CREDITS_SHIFT);
+  EXPECT_TRUE(client.Poll(0));
+  ASSERT_EQ(1u, m_completions.size());
+  EXPECT_EQ(0u, m_completions[0].response.TransceiverCredits());
+  EXPECT_EQ(3u * TRANSPORT_RX_CREDIT_SIZE,
+            m_completions[0].response.DecoderSpace());
+  EXPECT_EQ(0u, client.TransceiverCredits());
+
+  // Credit updates aren't matched against commands.
+  m_transport.AddResponse(EVENT_TOKEN, COMMAND_CREDIT_UPDATE, RC_OK,
+                          1 << TRANSPORT_TX_CREDITS_SHIFT);
+  EXPECT_TRUE(client.Poll(0));
+  EXPECT_EQ(1u, m_completions.size());
+  EXPECT_EQ(1u, client.TransceiverCredits());
+  EXPECT_EQ(0u, client.UnmatchedResponses());
+}
+
+TEST_F(ClientTest, events) {
+  vector<Event> events;
+  Client client(&m_transport, Client::Options());
+  client.SetEventCallback([&events](const Event &event) {
+    events.push_back(event);
+  });
+
+  const uint8_t payload[] = {
+    EVENT_MODE_CHANGED, 1, 0, 0, 0, 0,
+    EVENT_RECEIVER_COUNTER, 5, 4, 3, 2, 1
+  };
+  m_transport.AddResponse(EVENT_TOKEN, COMMAND_EVENT, RC_OK, 0, payload,
+                          arraysize(payload));
+  EXPECT_TRUE(client.Poll(0));
+
+  ASSERT_EQ(2u, events.size());
+  EXPECT_EQ(EVENT_MODE_CHANGED, events[0].type);
+  EXPECT_EQ(1u, events[0].arg);
+  EXPECT_EQ(0u, events[0].value);
+  EXPECT_EQ(EVENT_RECEIVER_COUNTER, events[1].type);
+  EXPECT_EQ(5u, events[1].arg);
+  EXPECT_EQ(0x01020304u, events[1].value);
+  EXPECT_EQ(0u, client.UnmatchedResponses());
+
+  // The reserved token is never used for commands.
+  for (unsigned int i = 0; i < 256; i++) {
+    EXPECT_TRUE(client.SendCommand(TX_DMX, NULL, 0, Recorder()));
+    uint8_t token = m_transport.frames.back()[1];
+    EXPECT_NE(EVENT_TOKEN, token);
+    m_transport.AddResponse(token, TX_DMX, RC_OK, 0);
+    EXPECT_TRUE(client.Poll(0));
+  }
+  EXPECT_EQ(256u, m_completions.size());
+}
+
+TEST_F(ClientTest, timeout) {
+  Client::Options options;
+  options.timeout_ms = 0;
+  Client client(&m_transport, options);
+  EXPECT_TRUE(client.SendCommand(TX_DMX, NULL, 0, Recorder()));
+  usleep(1000);
+  EXPECT_TRUE(client.Poll(0));
+  ASSERT_EQ(1u, m_completions.size());
+  EXPECT_EQ(COMMAND_TIMEOUT, m_completions[0].result);
+  EXPECT_EQ(TX_DMX, m_completions[0].response.command);
+}
+
+TEST_F(ClientTest, transportFailure) {
+  {
+    Client::Options options;
+    options.window_size = 1;
+    Client client(&m_transport, options);
+    EXPECT_TRUE(client.SendCommand(TX_DMX, NULL, 0, Recorder()));
+    EXPECT_TRUE(client.SendCommand(TX_DMX, NULL, 0, Recorder()));
+
+    m_transport.failed = true;
+    EXPECT_FALSE(client.Poll(0));
+    ASSERT_EQ(2u, m_completions.size());
+    EXPECT_EQ(COMMAND_CANCELLED, m_completions[0].result);
+    EXPECT_EQ(COMMAND_CANCELLED, m_completions[1].result);
+    EXPECT_FALSE(client.SendCommand(TX_DMX, NULL, 0, Recorder()));
+  }
+
+  // Commands outstanding when the client is destroyed are cancelled.
+  m_transport.failed = false;
+  m_completions.clear();
+  {
+    Client client(&m_transport, Client::Options());
+    EXPECT_TRUE(client.SendCommand(TX_DMX, NULL, 0, Recorder()));
+  }
+  ASSERT_EQ(1u, m_completions.size());
+  EXPECT_EQ(COMMAND_CANCELLED, m_completions[0].result);
+}
+
+TEST_F(ClientTest, descriptorTransport) {
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  DescriptorTransport transport(fds[0], fds[1]);
+
+  const uint8_t data[] = {1, 2, 3, 4};
+  EXPECT_TRUE(transport.Write(data, arraysize(data)));
+
+  uint8_t output[10];
+  EXPECT_EQ(4, transport.Read(output, arraysize(output), 0));
+  EXPECT_THAT(ArrayTuple(output, 4), DataIs(data, arraysize(data)));
+  EXPECT_EQ(0, transport.Read(output, arraysize(output), 0));
+
+  close(fds[1]);
+  EXPECT_EQ(-1, transport.Read(output, arraysize(output), 0));
+  close(fds[0]);
+}
@@ -21,8 +21,67 @@
 #include <gtest/gtest.h>
 
 #include "coarse_timer.h"
+#include "plib_tmr_mock.h"
 #include "sys_int_mock.h"
 
+using ::testing::Invoke;
+using ::testing::InvokeWithoutArgs;
+using ::testing::Return;
+using ::testing::_;
+
+/*
+ * A model of the hardware timer & the timer interrupt.
+ *
+ * The counter advances by step cycles each time it's read, and the ISR runs
+ * isr_delay reads after the counter rolls over. This lets us check the reads
+ * are consistent no matter where the ISR lands.
+ */
+class FakeTimer {
+ public:
+  FakeTimer(unsigned int step, unsigned int isr_delay)
+      : m_step(step),
+        m_isr_delay(isr_delay),
+        m_cycles(0),
+        m_counter(0),
+        m_reads(0),
+        m_pending(false) {
+  }
+
+  uint16_t Counter16BitGet(TMR_MODULE_ID) {
+    uint16_t value = m_counter;
+    Advance();
+    return value;
+  }
+
+  bool SourceStatusGet(INT_SOURCE) { return m_pending; }
+  void SourceStatusClear(INT_SOURCE) { m_pending = false; }
+
+  uint64_t Cycles() const { return m_cycles; }
+
+  static const unsigned int PERIOD = 8000u;  // 100uS
+
+ private:
+  const unsigned int m_step;
+  const unsigned int m_isr_delay;
+  uint64_t m_cycles;
+  uint16_t m_counter;
+  unsigned int m_reads;
+  bool m_pending;
+
+  void Advance() {
+    m_cycles += m_step;
+    m_counter += m_step;
+    if (m_counter >= PERIOD) {
+      m_counter -= PERIOD;
+      m_pending = true;
+      m_reads = 0;
+    }
+    if (m_pending && m_reads++ >= m_isr_delay) {
+      CoarseTimer_TimerEvent();
+    }
+  }
+};
+
 class CoarseTimerTest : public ::testing::TestWithParam<uint32_t> {
  public:
   void SetUp() {
@@ -87,3 +146,88 @@ TEST_F(CoarseTimerTest, interruptClear) {
   EXPECT_CALL(m_sys_int_mock, SourceStatusClear(INT_SOURCE_TIMER_2));
   CoarseTimer_TimerEvent();
 }
+
+TEST_F(CoarseTimerTest, microseconds) {
+  testing::StrictMock<MockPeripheralTimer> timer_mock;
+  PLIB_TMR_SetMock(&timer_mock);
+
+  CoarseTimer_SetCounter(10);
+  // 80 ticks per microsecond.
+  EXPECT_CALL(timer_mock, Counter16BitGet(TMR_ID_2))
+      .WillOnce(Return(4000));
+  EXPECT_EQ(1050u, CoarseTimer_GetMicroseconds());
+
+  // The timer rolled over, but the ISR hasn't run yet.
+  EXPECT_CALL(m_sys_int_mock, SourceStatusGet(INT_SOURCE_TIMER_2))
+      .WillOnce(Return(true));
+  EXPECT_CALL(timer_mock, Counter16BitGet(TMR_ID_2))
+      .WillOnce(Return(7999))
+      .WillOnce(Return(8));
+  EXPECT_EQ(1100u, CoarseTimer_GetMicroseconds());
+
+  PLIB_TMR_SetMock(NULL);
+}
+
+TEST_F(CoarseTimerTest, microsecondsPreemptingTimerEvent) {
+  testing::StrictMock<MockPeripheralTimer> timer_mock;
+  PLIB_TMR_SetMock(&timer_mock);
+  CoarseTimer_SetCounter(10);
+
+  // A higher priority ISR runs after TimerEvent() has incremented the count,
+  // but before it clears the interrupt. The rollover is only counted once.
+  uint32_t us = 0u;
+  EXPECT_CALL(m_sys_int_mock, SourceStatusGet(INT_SOURCE_TIMER_2))
+      .WillRepeatedly(Return(true));
+  EXPECT_CALL(timer_mock, Counter16BitGet(TMR_ID_2))
+      .WillRepeatedly(Return(80));
+  EXPECT_CALL(m_sys_int_mock, SourceStatusClear(INT_SOURCE_TIMER_2))
+      .WillOnce(InvokeWithoutArgs([&us]() {
+        us = CoarseTimer_GetMicroseconds();
+      }));
+  CoarseTimer_TimerEvent();
+  EXPECT_EQ(1101u, us);
+
+  PLIB_TMR_SetMock(NULL);
+}
+
+TEST_F(CoarseTimerTest, getTimeDoesntMaskInterrupts) {
+  CoarseTimer_SetCounter(52);
+  EXPECT_CALL(m_sys_int_mock, SourceDisable(_)).Times(0);
+  EXPECT_CALL(m_sys_int_mock, SourceEnable(_)).Times(0);
+  EXPECT_EQ(52u, CoarseTimer_GetTime());
+}
+
+TEST_F(CoarseTimerTest, microsecondsWithInterrupts) {
+  const unsigned int steps[] = {1, 37, 799};
+  const unsigned int isr_delays[] = {0, 1, 2, 3};
+
+  for (unsigned int step : steps) {
+    for (unsigned int isr_delay : isr_delays) {
+      FakeTimer fake_timer(step, isr_delay);
+      testing::NiceMock<MockPeripheralTimer> timer_mock;
+      PLIB_TMR_SetMock(&timer_mock);
+      ON_CALL(timer_mock, Counter16BitGet(TMR_ID_2))
+          .WillByDefault(Invoke(&fake_timer, &FakeTimer::Counter16BitGet));
+      ON_CALL(m_sys_int_mock, SourceStatusGet(INT_SOURCE_TIMER_2))
+          .WillByDefault(Invoke(&fake_timer, &FakeTimer::SourceStatusGet));
+      ON_CALL(m_sys_int_mock, SourceStatusClear(INT_SOURCE_TIMER_2))
+          .WillByDefault(Invoke(&fake_timer, &FakeTimer::SourceStatusClear));
+      CoarseTimer_SetCounter(0);
+
+      // The timestamp must fall within the call, and never go backwards.
+      uint32_t last = 0;
+      for (unsigned int i = 0; i < 20000; i++) {
+        const uint64_t before = fake_timer.Cycles();
+        const uint32_t us = CoarseTimer_GetMicroseconds();
+        const uint64_t after = fake_timer.Cycles();
+        ASSERT_LE(before / 80, us) << "step " << step << ", delay "
+                                   << isr_delay;
+        ASSERT_GE(after / 80, us) << "step " << step << ", delay "
+                                  << isr_delay;
+        ASSERT_LE(last, us);
+        last = us;
+      }
+      PLIB_TMR_SetMock(NULL);
+    }
+  }
+}
@@ -0,0 +1,364 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * DMXForwarderTest.cpp
+ * Tests for the DMX Forwarder code.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <vector>
+
+#include "Array.h"
+#include "CoarseTimerMock.h"
+#include "Matchers.h"
+#include "TransportMock.h"
+#include "constants.h"
+#include "dmx_forwarder.h"
+#include "dmx_snapshot.h"
+#include "dmx_spec.h"
+
+using ::testing::Args;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::StrictMock;
+using ::testing::_;
+using std::vector;
+
+class DMXForwarderTest : public testing::Test {
+ public:
+  void SetUp() {
+    Transport_SetMock(&m_transport_mock);
+    CoarseTimer_SetMock(&m_timer_mock);
+    ON_CALL(m_timer_mock, HasElapsed(_, _)).WillByDefault(Return(true));
+    DMXSnapshot_Initialize();
+    DMXForwarder_Initialize(Transport_Send);
+
+    for (unsigned int i = 0; i < arraysize(m_frame); i++) {
+      m_frame[i] = i;
+    }
+  }
+
+  void TearDown() {
+    CoarseTimer_SetMock(nullptr);
+    Transport_SetMock(nullptr);
+  }
+
+ protected:
+  StrictMock<MockTransport> m_transport_mock;
+  NiceMock<MockCoarseTimer> m_timer_mock;
+  uint8_t m_frame[DMX_FRAME_SIZE];
+  vector<vector<uint8_t> > m_messages;
+
+  // Receive a complete frame, in two parts.
+  void ReceiveFrame(unsigned int length) {
+    DMXSnapshot_Receive(m_frame, length / 2);
+    DMXSnapshot_Receive(m_frame, length);
+    DMXSnapshot_FrameComplete();
+  }
+
+  // Like the transport, payloads over PAYLOAD_SIZE are truncated.
+  bool SaveMessage(uint8_t, Command, uint8_t, const IOVec* iov,
+                   unsigned int iov_count) {
+    vector<uint8_t> message;
+    for (unsigned int i = 0; i < iov_count; i++) {
+      const uint8_t *base = reinterpret_cast<const uint8_t*>(iov[i].base);
+      message.insert(message.end(), base, base + iov[i].length);
+    }
+    EXPECT_LE(message.size(), static_cast<size_t>(PAYLOAD_SIZE));
+    if (message.size() > PAYLOAD_SIZE) {
+      message.resize(PAYLOAD_SIZE);
+    }
+    m_messages.push_back(message);
+    return true;
+  }
+
+  void CaptureMessages() {
+    EXPECT_CALL(m_transport_mock,
+                Send(EVENT_TOKEN, COMMAND_DMX_DATA, RC_OK, _, 1))
+        .WillRepeatedly(testing::Invoke(this, &DMXForwarderTest::SaveMessage));
+  }
+
+  // Apply the messages to a copy of the data.
+  static void ApplyMessages(const vector<vector<uint8_t> > &messages,
+                            vector<uint8_t> *data) {
+    for (const vector<uint8_t> &message : messages) {
+      data->resize(ReadUInt16(message, 0));
+      unsigned int i = DMX_FORWARDER_HEADER_SIZE;
+      while (i < message.size()) {
+        uint16_t start = ReadUInt16(message, i);
+        uint16_t size = ReadUInt16(message, i + 2);
+        i += DMX_FORWARDER_RANGE_HEADER_SIZE;
+        ASSERT_LE(i + size, message.size());
+        ASSERT_LE(start + size, data->size());
+        memcpy(data->data() + start, &message[i], size);
+        i += size;
+      }
+    }
+  }
+
+  static uint16_t ReadUInt16(const vector<uint8_t> &data, unsigned int i) {
+    return data[i] | (data[i + 1] << 8);
+  }
+};
+
+TEST_F(DMXForwarderTest, disabled) {
+  EXPECT_EQ(0u, DMXForwarder_GetInterval());
+  ReceiveFrame(DMX_FRAME_SIZE);
+  DMXForwarder_Tasks();
+}
+
+TEST_F(DMXForwarderTest, smallFrame) {
+  DMXForwarder_SetInterval(250);
+  EXPECT_EQ(250u, DMXForwarder_GetInterval());
+
+  // Nothing is sent until a frame completes.
+  DMXSnapshot_Receive(m_frame, 4);
+  DMXForwarder_Tasks();
+
+  DMXSnapshot_FrameComplete();
+  const uint8_t payload[] = {
+    4, 0,  // slot count
+    0, 0,  // start
+    4, 0,  // size
+    0, 1, 2, 3
+  };
+  EXPECT_CALL(m_transport_mock,
+              Send(EVENT_TOKEN, COMMAND_DMX_DATA, RC_OK, _, 1))
+      .With(Args<3, 4>(PayloadIs(payload, arraysize(payload))))
+      .WillOnce(Return(true));
+  DMXForwarder_Tasks();
+
+  // The same data again isn't sent.
+  ReceiveFrame(4);
+  DMXForwarder_Tasks();
+}
+
+TEST_F(DMXForwarderTest, nextDeadline) {
+  uint32_t delay = 0u;
+  ReceiveFrame(4);
+  EXPECT_FALSE(DMXForwarder_NextDeadline(&delay));
+
+  DMXForwarder_SetInterval(250);
+  EXPECT_CALL(m_timer_mock, HasElapsed(_, 250))
+      .WillRepeatedly(Return(false));
+  EXPECT_CALL(m_timer_mock, ElapsedTime(_))
+      .WillRepeatedly(Return(100u));
+  EXPECT_FALSE(DMXForwarder_NextDeadline(&delay));
+
+  // A new frame is sent once the interval passes.
+  ReceiveFrame(4);
+  DMXForwarder_Tasks();
+  EXPECT_TRUE(DMXForwarder_NextDeadline(&delay));
+  EXPECT_EQ(151u, delay);
+
+  EXPECT_CALL(m_timer_mock, HasElapsed(_, 250))
+      .WillRepeatedly(Return(true));
+  CaptureMessages();
+  DMXForwarder_Tasks();
+  EXPECT_EQ(1u, m_messages.size());
+  EXPECT_FALSE(DMXForwarder_NextDeadline(&delay));
+
+  // A full frame takes two messages, the rest is due on the next tick.
+  ReceiveFrame(DMX_FRAME_SIZE);
+  DMXForwarder_Tasks();
+  EXPECT_TRUE(DMXForwarder_NextDeadline(&delay));
+  EXPECT_EQ(1u, delay);
+  DMXForwarder_Tasks();
+  EXPECT_EQ(3u, m_messages.size());
+  EXPECT_FALSE(DMXForwarder_NextDeadline(&delay));
+}
+
+TEST_F(DMXForwarderTest, fullFrame) {
+  DMXForwarder_SetInterval(250);
+  EXPECT_CALL(m_timer_mock, HasElapsed(_, 250))
+      .WillOnce(Return(true))
+      .WillRepeatedly(Return(false));
+  ReceiveFrame(DMX_FRAME_SIZE);
+
+  // A full frame doesn't fit in one message, the rest is sent without
+  // waiting for the interval.
+  CaptureMessages();
+  DMXForwarder_Tasks();
+  DMXForwarder_Tasks();
+  DMXForwarder_Tasks();
+
+  ASSERT_EQ(2u, m_messages.size());
+  EXPECT_EQ(static_cast<size_t>(PAYLOAD_SIZE), m_messages[0].size());
+
+  vector<uint8_t> data;
+  ApplyMessages(m_messages, &data);
+  EXPECT_THAT(ArrayTuple(data.data(), data.size()),
+              DataIs(m_frame, arraysize(m_frame)));
+}
+
+TEST_F(DMXForwarderTest, onlyChanges) {
+  DMXForwarder_SetInterval(250);
+  ReceiveFrame(DMX_FRAME_SIZE);
+  CaptureMessages();
+  DMXForwarder_Tasks();
+  DMXForwarder_Tasks();
+  m_messages.clear();
+
+  // Two slots with a small gap are merged, the one further away is a new
+  // range.
+  m_frame[10] = 0;
+  m_frame[12] = 0;
+  m_frame[100] = 0;
+  ReceiveFrame(DMX_FRAME_SIZE);
+  DMXForwarder_Tasks();
+
+  const uint8_t payload[] = {
+    0, 2,  // slot count
+    10, 0,  // start
+    3, 0,  // size
+    0, 11, 0,
+    100, 0,  // start
+    1, 0,  // size
+    0
+  };
+  ASSERT_EQ(1u, m_messages.size());
+  EXPECT_THAT(ArrayTuple(m_messages[0].data(), m_messages[0].size()),
+              DataIs(payload, arraysize(payload)));
+}
+
+TEST_F(DMXForwarderTest, slotCountChange) {
+  DMXForwarder_SetInterval(250);
+  ReceiveFrame(24);
+  CaptureMessages();
+  DMXForwarder_Tasks();
+
+  // A shorter frame only updates the slot count.
+  ReceiveFrame(12);
+  DMXForwarder_Tasks();
+
+  // A longer frame sends the new slots.
+  ReceiveFrame(30);
+  DMXForwarder_Tasks();
+
+  ASSERT_EQ(3u, m_messages.size());
+  EXPECT_EQ(static_cast<size_t>(DMX_FORWARDER_HEADER_SIZE),
+            m_messages[1].size());
+  EXPECT_EQ(12u, ReadUInt16(m_messages[1], 0));
+  EXPECT_EQ(30u, ReadUInt16(m_messages[2], 0));
+  EXPECT_EQ(12u, ReadUInt16(m_messages[2], 2));
+  EXPECT_EQ(18u, ReadUInt16(m_messages[2], 4));
+
+  vector<uint8_t> data;
+  ApplyMessages(m_messages, &data);
+  EXPECT_THAT(ArrayTuple(data.data(), data.size()), DataIs(m_frame, 30));
+}
+
+TEST_F(DMXForwarderTest, rateLimit) {
+  DMXForwarder_SetInterval(250);
+  EXPECT_CALL(m_timer_mock, HasElapsed(_, 250))
+      .WillRepeatedly(Return(false));
+
+  // Frames within the interval are coalesced.
+  ReceiveFrame(4);
+  DMXForwarder_Tasks();
+  m_frame[0] = 10;
+  ReceiveFrame(4);
+  DMXForwarder_Tasks();
+
+  testing::Mock::VerifyAndClearExpectations(&m_timer_mock);
+  CaptureMessages();
+  DMXForwarder_Tasks();
+
+  ASSERT_EQ(1u, m_messages.size());
+  vector<uint8_t> data;
+  ApplyMessages(m_messages, &data);
+  EXPECT_THAT(ArrayTuple(data.data(), data.size()), DataIs(m_frame, 4));
+}
+
+TEST_F(DMXForwarderTest, sendFailure) {
+  DMXForwarder_SetInterval(250);
+  ReceiveFrame(4);
+
+  EXPECT_CALL(m_transport_mock,
+              Send(EVENT_TOKEN, COMMAND_DMX_DATA, RC_OK, _, 1))
+      .WillOnce(Return(false));
+  DMXForwarder_Tasks();
+
+  // The changes are sent on the next attempt.
+  CaptureMessages();
+  DMXForwarder_Tasks();
+  ASSERT_EQ(1u, m_messages.size());
+  EXPECT_EQ(DMX_FORWARDER_HEADER_SIZE + DMX_FORWARDER_RANGE_HEADER_SIZE + 4u,
+            m_messages[0].size());
+}
+
+TEST_F(DMXForwarderTest, disableResets) {
+  DMXForwarder_SetInterval(250);
+  ReceiveFrame(4);
+  CaptureMessages();
+  DMXForwarder_Tasks();
+
+  // Re-enabling sends all the slots again.
+  DMXForwarder_SetInterval(0);
+  ReceiveFrame(4);
+  DMXForwarder_Tasks();
+  DMXForwarder_SetInterval(100);
+  ReceiveFrame(4);
+  DMXForwarder_Tasks();
+
+  ASSERT_EQ(2u, m_messages.size());
+  EXPECT_EQ(m_messages[0], m_messages[1]);
+}
+
+TEST_F(DMXForwarderTest, hostCopyInSync) {
+  DMXForwarder_SetInterval(250);
+  CaptureMessages();
+  ReceiveFrame(DMX_FRAME_SIZE);
+  DMXForwarder_Tasks();
+  DMXForwarder_Tasks();
+
+  // Re-enabling means the Host needs the whole frame again. The first
+  // message can't hold it, so the slots it didn't carry must still be sent
+  // even though they match the earlier frame.
+  DMXForwarder_SetInterval(250);
+  m_messages.clear();
+  ReceiveFrame(DMX_FRAME_SIZE);
+  DMXForwarder_Tasks();
+  DMXForwarder_Tasks();
+  DMXForwarder_Tasks();
+
+  ASSERT_EQ(2u, m_messages.size());
+  vector<uint8_t> data;
+  ApplyMessages(m_messages, &data);
+  EXPECT_THAT(ArrayTuple(data.data(), data.size()),
+              DataIs(m_frame, arraysize(m_frame)));
+
+  // Changes spread across the frame also take more than one message.
+  for (unsigned int i = 0; i < arraysize(m_frame); i += 2) {
+    m_frame[i] = ~m_frame[i];
+  }
+  ReceiveFrame(DMX_FRAME_SIZE);
+  DMXForwarder_Tasks();
+  DMXForwarder_Tasks();
+  DMXForwarder_Tasks();
+
+  ApplyMessages(m_messages, &data);
+  EXPECT_THAT(ArrayTuple(data.data(), data.size()),
+              DataIs(m_frame, arraysize(m_frame)));
+
+  // Nothing is left to send.
+  size_t message_count = m_messages.size();
+  DMXForwarder_Tasks();
+  EXPECT_EQ(message_count, m_messages.size());
+}
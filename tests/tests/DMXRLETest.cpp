@@ -0,0 +1,151 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * DMXRLETest.cpp
+ * Tests for the DMX run length encoding code.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include "Array.h"
+#include "Matchers.h"
+#include "dmx_rle.h"
+#include "dmx_spec.h"
+
+class DMXRLETest : public testing::Test {
+ public:
+  void SetUp() {
+    memset(m_output, 0xff, arraysize(m_output));
+  }
+
+ protected:
+  uint8_t m_output[DMX_FRAME_SIZE];
+
+  // Encode & decode the data and check it round trips. Returns the encoded
+  // size.
+  unsigned int RoundTrip(const uint8_t *data, unsigned int size) {
+    uint8_t encoded[DMX_FRAME_SIZE + 4];
+    unsigned int encoded_size = DMXRLE_Encode(
+        encoded, arraysize(encoded), data, size);
+    EXPECT_NE(0u, encoded_size);
+    EXPECT_EQ(static_cast<int>(size),
+              DMXRLE_DecodedSize(encoded, encoded_size));
+    EXPECT_EQ(size, DMXRLE_Decode(m_output, encoded, encoded_size));
+    EXPECT_THAT(ArrayTuple(m_output, size), DataIs(data, size));
+    return encoded_size;
+  }
+};
+
+TEST_F(DMXRLETest, decodeSegments) {
+  const uint8_t encoded[] = {
+    0x02, 1, 2, 3,  // literal
+    0x83,  // 4 zeros
+    0xc2, 0x7f,  // 3 x 127
+    0x00, 0xaa  // literal
+  };
+  const uint8_t expected[] = {1, 2, 3, 0, 0, 0, 0, 0x7f, 0x7f, 0x7f, 0xaa};
+
+  EXPECT_EQ(static_cast<int>(arraysize(expected)),
+            DMXRLE_DecodedSize(encoded, arraysize(encoded)));
+  EXPECT_EQ(arraysize(expected),
+            DMXRLE_Decode(m_output, encoded, arraysize(encoded)));
+  EXPECT_THAT(ArrayTuple(m_output, arraysize(expected)),
+              DataIs(expected, arraysize(expected)));
+  // Check we didn't overrun.
+  EXPECT_EQ(0xff, m_output[arraysize(expected)]);
+}
+
+TEST_F(DMXRLETest, decodeEmpty) {
+  EXPECT_EQ(0, DMXRLE_DecodedSize(NULL, 0u));
+  EXPECT_EQ(0u, DMXRLE_Decode(m_output, NULL, 0u));
+}
+
+TEST_F(DMXRLETest, malformed) {
+  // Literal missing data.
+  const uint8_t short_literal[] = {0x03, 1, 2};
+  EXPECT_EQ(-1, DMXRLE_DecodedSize(short_literal, arraysize(short_literal)));
+  EXPECT_EQ(0u, DMXRLE_Decode(m_output, short_literal,
+                              arraysize(short_literal)));
+
+  // Value run missing the value.
+  const uint8_t short_run[] = {0x00, 5, 0xc4};
+  EXPECT_EQ(-1, DMXRLE_DecodedSize(short_run, arraysize(short_run)));
+  EXPECT_EQ(1u, DMXRLE_Decode(m_output, short_run, arraysize(short_run)));
+  EXPECT_EQ(5, m_output[0]);
+
+  // 9 x 64 slots is more than a frame.
+  const uint8_t too_long[] = {
+    0xbf, 0xbf, 0xbf, 0xbf, 0xbf, 0xbf, 0xbf, 0xbf, 0xbf
+  };
+  EXPECT_EQ(-1, DMXRLE_DecodedSize(too_long, arraysize(too_long)));
+  EXPECT_EQ(DMX_FRAME_SIZE,
+            DMXRLE_Decode(m_output, too_long, arraysize(too_long)));
+}
+
+TEST_F(DMXRLETest, encodeSmallRuns) {
+  // A single zero & a pair of non-zero values are cheaper as a literal.
+  const uint8_t data[] = {1, 0, 2, 2, 3, 0, 0};
+  const uint8_t expected[] = {0x04, 1, 0, 2, 2, 3, 0x81};
+
+  uint8_t encoded[16];
+  unsigned int encoded_size = DMXRLE_Encode(
+      encoded, arraysize(encoded), data, arraysize(data));
+  EXPECT_THAT(ArrayTuple(encoded, encoded_size),
+              DataIs(expected, arraysize(expected)));
+  RoundTrip(data, arraysize(data));
+}
+
+TEST_F(DMXRLETest, encodeOutputTooSmall) {
+  const uint8_t data[] = {1, 2, 3, 4};
+  uint8_t encoded[4];
+  EXPECT_EQ(0u, DMXRLE_Encode(encoded, arraysize(encoded), data,
+                              arraysize(data)));
+
+  uint8_t large_encoded[5];
+  EXPECT_EQ(5u, DMXRLE_Encode(large_encoded, arraysize(large_encoded), data,
+                              arraysize(data)));
+}
+
+TEST_F(DMXRLETest, sparseUniverse) {
+  // 8 RGB fixtures, spread across the universe.
+  uint8_t data[DMX_FRAME_SIZE];
+  memset(data, 0, arraysize(data));
+  for (unsigned int i = 0; i < 8; i++) {
+    data[i * 64] = 255;
+    data[i * 64 + 1] = 128;
+    data[i * 64 + 2] = i + 1;
+  }
+  unsigned int encoded_size = RoundTrip(data, arraysize(data));
+  // Each fixture is a 4 byte literal & a 61 slot zero run.
+  EXPECT_EQ(8u * 5u, encoded_size);
+}
+
+TEST_F(DMXRLETest, fullUniverse) {
+  uint8_t data[DMX_FRAME_SIZE];
+  memset(data, 200, arraysize(data));
+  EXPECT_EQ(8u * 2u, RoundTrip(data, arraysize(data)));
+}
+
+TEST_F(DMXRLETest, denseUniverse) {
+  // The worst case, no runs at all.
+  uint8_t data[DMX_FRAME_SIZE];
+  for (unsigned int i = 0; i < arraysize(data); i++) {
+    data[i] = i & 1 ? i : 0;
+  }
+  EXPECT_EQ(DMX_FRAME_SIZE + DMX_FRAME_SIZE / DMX_RLE_MAX_LITERAL,
+            RoundTrip(data, arraysize(data)));
+}
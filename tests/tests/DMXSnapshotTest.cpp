@@ -0,0 +1,142 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * DMXSnapshotTest.cpp
+ * Tests for the DMX Snapshot code.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include "Array.h"
+#include "Matchers.h"
+#include "dmx_snapshot.h"
+#include "dmx_spec.h"
+
+class DMXSnapshotTest : public testing::Test {
+ public:
+  void SetUp() {
+    DMXSnapshot_Initialize();
+    for (unsigned int i = 0; i < arraysize(m_frame); i++) {
+      m_frame[i] = i;
+    }
+    memset(m_output, 0xff, arraysize(m_output));
+  }
+
+ protected:
+  uint8_t m_frame[DMX_FRAME_SIZE + 1];
+  uint8_t m_output[DMX_FRAME_SIZE];
+};
+
+TEST_F(DMXSnapshotTest, noFrames) {
+  uint16_t slot_count = 0xffff;
+  EXPECT_EQ(0u, DMXSnapshot_Generation());
+  EXPECT_EQ(0u, DMXSnapshot_Read(m_output, 0u, arraysize(m_output),
+                                 &slot_count));
+  EXPECT_EQ(0u, slot_count);
+  EXPECT_EQ(0xff, m_output[0]);
+
+  // Completing a frame without any data does nothing.
+  DMXSnapshot_FrameComplete();
+  EXPECT_EQ(0u, DMXSnapshot_Generation());
+}
+
+TEST_F(DMXSnapshotTest, completeFrame) {
+  uint16_t slot_count;
+
+  // Partial frames aren't visible.
+  DMXSnapshot_Receive(m_frame, 1u);
+  DMXSnapshot_Receive(m_frame, 10u);
+  EXPECT_EQ(0u, DMXSnapshot_Generation());
+
+  DMXSnapshot_Receive(m_frame, 20u);
+  DMXSnapshot_FrameComplete();
+  EXPECT_EQ(1u, DMXSnapshot_Generation());
+  EXPECT_EQ(1u, DMXSnapshot_Read(m_output, 0u, arraysize(m_output),
+                                 &slot_count));
+  EXPECT_EQ(20u, slot_count);
+  EXPECT_THAT(ArrayTuple(m_output, slot_count), DataIs(m_frame, 20u));
+  EXPECT_EQ(0xff, m_output[20]);
+
+  // A frame of 0 slots.
+  DMXSnapshot_Receive(m_frame, 0u);
+  DMXSnapshot_FrameComplete();
+  EXPECT_EQ(2u, DMXSnapshot_Read(m_output, 0u, arraysize(m_output),
+                                 &slot_count));
+  EXPECT_EQ(0u, slot_count);
+}
+
+TEST_F(DMXSnapshotTest, partialRead) {
+  DMXSnapshot_Receive(m_frame, 20u);
+  DMXSnapshot_FrameComplete();
+
+  uint16_t slot_count;
+  DMXSnapshot_Read(m_output, 5u, 3u, &slot_count);
+  EXPECT_EQ(20u, slot_count);
+  EXPECT_THAT(ArrayTuple(m_output, 3u), DataIs(m_frame + 5, 3u));
+  EXPECT_EQ(0xff, m_output[3]);
+
+  // Reads past the end of the frame are truncated.
+  memset(m_output, 0xff, arraysize(m_output));
+  DMXSnapshot_Read(m_output, 18u, 10u, &slot_count);
+  EXPECT_THAT(ArrayTuple(m_output, 2u), DataIs(m_frame + 18, 2u));
+  EXPECT_EQ(0xff, m_output[2]);
+
+  memset(m_output, 0xff, arraysize(m_output));
+  DMXSnapshot_Read(m_output, 25u, 10u, &slot_count);
+  EXPECT_EQ(0xff, m_output[0]);
+}
+
+TEST_F(DMXSnapshotTest, longFrame) {
+  DMXSnapshot_Receive(m_frame, arraysize(m_frame));
+  DMXSnapshot_FrameComplete();
+
+  uint16_t slot_count;
+  DMXSnapshot_Read(m_output, 0u, arraysize(m_output), &slot_count);
+  EXPECT_EQ(DMX_FRAME_SIZE, slot_count);
+  EXPECT_THAT(ArrayTuple(m_output, slot_count),
+              DataIs(m_frame, DMX_FRAME_SIZE));
+}
+
+TEST_F(DMXSnapshotTest, doubleBuffered) {
+  uint16_t slot_count;
+  DMXSnapshot_Receive(m_frame, 10u);
+  DMXSnapshot_FrameComplete();
+
+  // While the next frame is received, reads return the last complete frame.
+  uint8_t next_frame[10];
+  memset(next_frame, 0, arraysize(next_frame));
+  DMXSnapshot_Receive(next_frame, 5u);
+
+  EXPECT_EQ(1u, DMXSnapshot_Read(m_output, 0u, arraysize(m_output),
+                                 &slot_count));
+  EXPECT_EQ(10u, slot_count);
+  EXPECT_THAT(ArrayTuple(m_output, slot_count), DataIs(m_frame, 10u));
+
+  DMXSnapshot_Receive(next_frame, arraysize(next_frame));
+  DMXSnapshot_FrameComplete();
+  EXPECT_EQ(2u, DMXSnapshot_Read(m_output, 0u, arraysize(m_output),
+                                 &slot_count));
+  EXPECT_THAT(ArrayTuple(m_output, slot_count),
+              DataIs(next_frame, arraysize(next_frame)));
+
+  // And the first buffer is reused.
+  DMXSnapshot_Receive(m_frame, 4u);
+  DMXSnapshot_FrameComplete();
+  EXPECT_EQ(3u, DMXSnapshot_Read(m_output, 0u, arraysize(m_output),
+                                 &slot_count));
+  EXPECT_THAT(ArrayTuple(m_output, slot_count), DataIs(m_frame, 4u));
+}
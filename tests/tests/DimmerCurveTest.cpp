@@ -0,0 +1,143 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * DimmerCurveTest.cpp
+ * Tests for the dimmer curve code.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include "Array.h"
+#include "Matchers.h"
+#include "dimmer_curve.h"
+#include "dmx_spec.h"
+
+class DimmerCurveTest : public testing::Test {
+ protected:
+  DimmerCurve m_curve;
+
+  void Build(DimmerCurveType type, uint16_t min_level, uint16_t max_level,
+             bool on_below_min) {
+    DimmerCurveSettings settings;
+    settings.type = type;
+    settings.min_level = min_level;
+    settings.max_level = max_level;
+    settings.on_below_min = on_below_min;
+    DimmerCurve_Build(&m_curve, &settings);
+  }
+
+  // Check the levels never decrease as the slot value increases.
+  void ExpectMonotonic() {
+    for (unsigned int i = 1; i < arraysize(m_curve.levels); i++) {
+      EXPECT_LE(m_curve.levels[i - 1], m_curve.levels[i]) << "value " << i;
+    }
+  }
+};
+
+TEST_F(DimmerCurveTest, linear) {
+  Build(DIMMER_CURVE_LINEAR, 0, 0xffff, false);
+  EXPECT_EQ(0, m_curve.levels[0]);
+  EXPECT_EQ(257, m_curve.levels[1]);
+  EXPECT_EQ(32896, m_curve.levels[128]);
+  EXPECT_EQ(0xffff, m_curve.levels[255]);
+  ExpectMonotonic();
+}
+
+TEST_F(DimmerCurveTest, modifiedLinear) {
+  Build(DIMMER_CURVE_MODIFIED_LINEAR, 0, 0xffff, false);
+  EXPECT_EQ(0, m_curve.levels[0]);
+  EXPECT_EQ(41088, m_curve.levels[128]);
+  EXPECT_EQ(0xffff, m_curve.levels[255]);
+  ExpectMonotonic();
+}
+
+TEST_F(DimmerCurveTest, square) {
+  Build(DIMMER_CURVE_SQUARE, 0, 0xffff, false);
+  EXPECT_EQ(0, m_curve.levels[0]);
+  EXPECT_EQ(1, m_curve.levels[1]);
+  EXPECT_EQ(16512, m_curve.levels[128]);
+  EXPECT_EQ(0xffff, m_curve.levels[255]);
+  ExpectMonotonic();
+}
+
+TEST_F(DimmerCurveTest, modifiedSquare) {
+  Build(DIMMER_CURVE_MODIFIED_SQUARE, 0, 0xffff, false);
+  EXPECT_EQ(0, m_curve.levels[0]);
+  EXPECT_EQ(24704, m_curve.levels[128]);
+  EXPECT_EQ(0xffff, m_curve.levels[255]);
+  ExpectMonotonic();
+}
+
+TEST_F(DimmerCurveTest, unknownCurve) {
+  Build(static_cast<DimmerCurveType>(0), 0, 0xffff, false);
+  EXPECT_EQ(32896, m_curve.levels[128]);
+}
+
+TEST_F(DimmerCurveTest, minMaxLevels) {
+  Build(DIMMER_CURVE_LINEAR, 0x1000, 0x8000, false);
+  EXPECT_EQ(0, m_curve.levels[0]);
+  EXPECT_EQ(0x1070, m_curve.levels[1]);
+  EXPECT_EQ(0x8000, m_curve.levels[255]);
+  ExpectMonotonic();
+
+  // On below min.
+  Build(DIMMER_CURVE_SQUARE, 0x1000, 0x8000, true);
+  EXPECT_EQ(0x1000, m_curve.levels[0]);
+  EXPECT_EQ(0x1000, m_curve.levels[1]);
+  EXPECT_EQ(0x8000, m_curve.levels[255]);
+  ExpectMonotonic();
+
+  // A maximum less than the minimum is clamped.
+  Build(DIMMER_CURVE_LINEAR, 0x4000, 0x1000, false);
+  EXPECT_EQ(0, m_curve.levels[0]);
+  EXPECT_EQ(0x4000, m_curve.levels[1]);
+  EXPECT_EQ(0x4000, m_curve.levels[255]);
+}
+
+TEST_F(DimmerCurveTest, apply) {
+  Build(DIMMER_CURVE_LINEAR, 0, 0xffff, false);
+
+  uint8_t slots[DMX_FRAME_SIZE];
+  for (unsigned int i = 0; i < arraysize(slots); i++) {
+    slots[i] = i;
+  }
+  uint16_t levels[DMX_FRAME_SIZE + 1];
+  levels[DMX_FRAME_SIZE] = 0x1234;
+
+  DimmerCurve_Apply(&m_curve, levels, slots, DMX_FRAME_SIZE);
+  for (unsigned int i = 0; i < DMX_FRAME_SIZE; i++) {
+    EXPECT_EQ((i & 0xff) * 257u, levels[i]);
+  }
+  // Check we didn't overrun.
+  EXPECT_EQ(0x1234, levels[DMX_FRAME_SIZE]);
+}
+
+TEST_F(DimmerCurveTest, level) {
+  // A single level matches the table.
+  DimmerCurveSettings settings;
+  settings.type = DIMMER_CURVE_MODIFIED_SQUARE;
+  settings.min_level = 0x1000;
+  settings.max_level = 0xf000;
+  settings.on_below_min = true;
+  DimmerCurve_Build(&m_curve, &settings);
+  for (unsigned int i = 0; i < arraysize(m_curve.levels); i++) {
+    EXPECT_EQ(m_curve.levels[i], DimmerCurve_Level(&settings, i));
+  }
+
+  settings.on_below_min = false;
+  EXPECT_EQ(0, DimmerCurve_Level(&settings, 0));
+}
@@ -27,15 +27,19 @@
 #include <ola/network/NetworkUtils.h>
 #include <string.h>
 #include <memory>
+#include <vector>
 
 #include "dimmer_model.h"
+#include "dmx_snapshot.h"
 #include "rdm.h"
 #include "rdm_buffer.h"
 #include "rdm_responder.h"
+#include "timer_wheel.h"
 #include "Array.h"
 #include "CoarseTimerMock.h"
 #include "Matchers.h"
 #include "ModelTest.h"
+#include "SPIRGBMock.h"
 #include "TestHelpers.h"
 
 using ola::network::HostToNetwork;
@@ -46,7 +50,11 @@ using ola::rdm::RDMRequest;
 using ola::rdm::RDMResponse;
 using ola::rdm::RDMSetRequest;
 using std::unique_ptr;
-using testing::Return;
+using testing::ElementsAreArray;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::ReturnPointee;
+using testing::StrictMock;
 using testing::_;
 
 class DimmerModelTest : public ModelTest {
@@ -54,7 +62,10 @@ class DimmerModelTest : public ModelTest {
   DimmerModelTest() : ModelTest(&DIMMER_MODEL_ENTRY) {}
 
   void SetUp() {
+    m_time = 0u;
+    ON_CALL(m_timer, GetTime()).WillByDefault(ReturnPointee(&m_time));
     CoarseTimer_SetMock(&m_timer);
+    TimerWheel_Initialize();
 
     RDMResponderSettings settings;
     memcpy(settings.uid, TEST_UID, UID_LENGTH);
@@ -65,10 +76,26 @@ class DimmerModelTest : public ModelTest {
 
   void TearDown() {
     CoarseTimer_SetMock(nullptr);
+    SPIRGB_SetMock(nullptr);
+  }
+
+  void SetPixels(const uint8_t *data, uint16_t pixel_count) {
+    m_pixels.assign(data, data + pixel_count * 3u);
+  }
+
+  // Advance the clock, running the timers & the tasks function as we go.
+  void AdvanceTime(uint32_t interval) {
+    for (uint32_t i = 0; i < interval; i += TIMER_WHEEL_RESOLUTION) {
+      m_time += TIMER_WHEEL_RESOLUTION;
+      TimerWheel_Tasks();
+      DIMMER_MODEL_ENTRY.tasks_fn();
+    }
   }
 
  protected:
   ::testing::NiceMock<MockCoarseTimer> m_timer;
+  CoarseTimer_Value m_time;
+  std::vector<uint8_t> m_pixels;
 };
 
 TEST_F(DimmerModelTest, testLifecycle) {
@@ -207,11 +234,12 @@ TEST_F(DimmerModelTest, selfTest) {
   size = InvokeRDMHandler(get_request.get());
   EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
 
-  // Run Tasks
-  testing::InSequence seq;
-  EXPECT_CALL(m_timer, HasElapsed(_, 50000)).WillOnce(Return(true));
-  EXPECT_CALL(m_timer, HasElapsed(_, _)).WillRepeatedly(Return(false));
-  DIMMER_MODEL_ENTRY.tasks_fn();
+  // The self test takes 5s.
+  AdvanceTime(49990);
+  size = InvokeRDMHandler(get_request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  AdvanceTime(20);
 
   // Confirm self test is complete
   selftest = 0;
@@ -615,7 +643,7 @@ TEST_F(DimmerModelTest, maximumLevel) {
   unique_ptr<RDMRequest> request = BuildSubDeviceGetRequest(
       PID_MAXIMUM_LEVEL, 1);
 
-  const uint8_t expected_response[] = { 0, 0 };
+  const uint8_t expected_response[] = { 0xff, 0xfe };
   unique_ptr<RDMResponse> response(GetResponseFromData(
         request.get(),
         reinterpret_cast<const uint8_t*>(&expected_response),
@@ -753,9 +781,86 @@ TEST_F(DimmerModelTest, modulationFrequencyDescription) {
   EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
 }
 
+TEST_F(DimmerModelTest, missingSubDevice) {
+  // Sub-device 2 is skipped.
+  unique_ptr<RDMRequest> request = BuildSubDeviceGetRequest(PID_CURVE, 2);
+  unique_ptr<RDMResponse> response(
+      NackWithReason(request.get(), ola::rdm::NR_SUB_DEVICE_OUT_OF_RANGE));
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  request = BuildSubDeviceGetRequest(PID_CURVE, 6);
+  response.reset(
+      NackWithReason(request.get(), ola::rdm::NR_SUB_DEVICE_OUT_OF_RANGE));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  // GETs to all sub-devices are invalid.
+  request = BuildSubDeviceGetRequest(PID_CURVE, SUBDEVICE_ALL);
+  response.reset(
+      NackWithReason(request.get(), ola::rdm::NR_SUB_DEVICE_OUT_OF_RANGE));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+}
+
+TEST_F(DimmerModelTest, allSubDevices) {
+  // The square curve is only supported by the odd sub-devices.
+  const uint8_t curve_data[] = { 3 };
+  unique_ptr<RDMRequest> request = BuildSubDeviceSetRequest(
+      PID_CURVE, SUBDEVICE_ALL, curve_data, arraysize(curve_data));
+  unique_ptr<RDMResponse> response(GetResponseFromData(request.get()));
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  const uint16_t start_address = HostToNetwork(static_cast<uint16_t>(10));
+  request = BuildSubDeviceSetRequest(
+      PID_DMX_START_ADDRESS, SUBDEVICE_ALL,
+      reinterpret_cast<const uint8_t*>(&start_address),
+      sizeof(start_address));
+  response.reset(GetResponseFromData(request.get()));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  const uint16_t sub_devices[] = { 1, 3, 4, 5 };
+  for (unsigned int i = 0; i < arraysize(sub_devices); i++) {
+    request = BuildSubDeviceGetRequest(PID_CURVE, sub_devices[i]);
+    const uint8_t expected_curve[] = {
+      static_cast<uint8_t>(sub_devices[i] % 2 ? 3 : 1), 4
+    };
+    response.reset(GetResponseFromData(
+        request.get(), expected_curve, arraysize(expected_curve)));
+    size = InvokeRDMHandler(request.get());
+    EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+    request = BuildSubDeviceGetRequest(PID_DMX_START_ADDRESS,
+                                       sub_devices[i]);
+    response.reset(GetResponseFromData(
+        request.get(), reinterpret_cast<const uint8_t*>(&start_address),
+        sizeof(start_address)));
+    size = InvokeRDMHandler(request.get());
+    EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+  }
+
+  // Invalid data is NACKed once, without changing any of the sub-devices.
+  const uint8_t mode_data[] = { 2 };
+  request = BuildSubDeviceSetRequest(
+      PID_IDENTIFY_MODE, SUBDEVICE_ALL, mode_data, arraysize(mode_data));
+  response.reset(NackWithReason(request.get(),
+                                ola::rdm::NR_DATA_OUT_OF_RANGE));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  request = BuildSubDeviceGetRequest(PID_IDENTIFY_MODE, 5);
+  const uint8_t expected_mode[] = { IDENTIFY_MODE_QUIET };
+  response.reset(GetResponseFromData(
+      request.get(), expected_mode, arraysize(expected_mode)));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+}
+
 TEST_F(DimmerModelTest, queuedMessages) {
-  EXPECT_CALL(m_timer, HasElapsed(_, _)).WillOnce(Return(true));
-  DIMMER_MODEL_ENTRY.tasks_fn();
+  // Status messages are generated every 30s.
+  AdvanceTime(300010);
 
   uint8_t status_type = 0x02;
   unique_ptr<RDMRequest> request = BuildGetRequest(
@@ -780,3 +885,246 @@ TEST_F(DimmerModelTest, queuedMessages) {
   size = InvokeRDMHandler(request.get());
   EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
 }
+
+TEST_F(DimmerModelTest, output) {
+  StrictMock<MockSPIRGB> spi_mock;
+  SPIRGB_SetMock(&spi_mock);
+  DMXSnapshot_Initialize();
+
+  EXPECT_CALL(spi_mock, BeginUpdate())
+    .Times(3);
+  EXPECT_CALL(spi_mock, SetPixels(_, 4))
+    .Times(3)
+    .WillRepeatedly(Invoke(this, &DimmerModelTest::SetPixels));
+  EXPECT_CALL(spi_mock, CompleteUpdate())
+    .Times(3);
+
+  // The output is sent once the model is activated.
+  DIMMER_MODEL_ENTRY.tasks_fn();
+  const uint8_t off[] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+  EXPECT_THAT(m_pixels, ElementsAreArray(off));
+  DIMMER_MODEL_ENTRY.tasks_fn();
+
+  const uint8_t slots[] = { 255, 128, 0, 64 };
+  DMXSnapshot_Receive(slots, arraysize(slots));
+  DMXSnapshot_FrameComplete();
+  DIMMER_MODEL_ENTRY.tasks_fn();
+
+  // The default is a linear curve.
+  const uint8_t linear[] = {
+    255, 255, 255, 128, 128, 128, 0, 0, 0, 64, 64, 64
+  };
+  EXPECT_THAT(m_pixels, ElementsAreArray(linear));
+
+  // Changing the curve re-sends the frame.
+  const uint8_t set_data[] = { 3 };
+  unique_ptr<RDMRequest> request = BuildSubDeviceSetRequest(
+      PID_CURVE, 3,
+      reinterpret_cast<const uint8_t*>(&set_data),
+      sizeof(set_data));
+  unique_ptr<RDMResponse> response(GetResponseFromData(request.get()));
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+  DIMMER_MODEL_ENTRY.tasks_fn();
+  DIMMER_MODEL_ENTRY.tasks_fn();
+
+  const uint8_t square[] = {
+    255, 255, 255, 64, 64, 64, 0, 0, 0, 64, 64, 64
+  };
+  EXPECT_THAT(m_pixels, ElementsAreArray(square));
+}
+
+TEST_F(DimmerModelTest, scenePlayback) {
+  NiceMock<MockSPIRGB> spi_mock;
+  SPIRGB_SetMock(&spi_mock);
+  ON_CALL(spi_mock, SetPixels(_, 4))
+    .WillByDefault(Invoke(this, &DimmerModelTest::SetPixels));
+  DMXSnapshot_Initialize();
+
+  const uint8_t slots[] = { 10, 20, 30, 40 };
+  DMXSnapshot_Receive(slots, arraysize(slots));
+  DMXSnapshot_FrameComplete();
+  DIMMER_MODEL_ENTRY.tasks_fn();
+
+  const uint8_t dmx[] = {
+    10, 10, 10, 20, 20, 20, 30, 30, 30, 40, 40, 40
+  };
+  EXPECT_THAT(m_pixels, ElementsAreArray(dmx));
+
+  // Capture the DMX levels into scene 2.
+  const uint8_t capture_data[] = { 0, 2, 0, 0, 0, 0, 0, 0 };
+  unique_ptr<RDMRequest> request = BuildSetRequest(
+      PID_CAPTURE_PRESET, capture_data, arraysize(capture_data));
+  unique_ptr<RDMResponse> response(GetResponseFromData(request.get()));
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  // The factory scene overrides DMX.
+  const uint8_t scene1_data[] = { 0, 1, 0xff };
+  request = BuildSetRequest(
+      PID_PRESET_PLAYBACK, scene1_data, arraysize(scene1_data));
+  response.reset(GetResponseFromData(request.get()));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+  DIMMER_MODEL_ENTRY.tasks_fn();
+
+  const uint8_t full[] = {
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255
+  };
+  EXPECT_THAT(m_pixels, ElementsAreArray(full));
+
+  // With HTP, the highest of scene 2 & DMX is used.
+  const uint8_t merge_data[] = { MERGE_MODE_HTP };
+  request = BuildSetRequest(
+      PID_PRESET_MERGEMODE, merge_data, arraysize(merge_data));
+  response.reset(GetResponseFromData(request.get()));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  const uint8_t scene2_data[] = { 0, 2, 0xff };
+  request = BuildSetRequest(
+      PID_PRESET_PLAYBACK, scene2_data, arraysize(scene2_data));
+  response.reset(GetResponseFromData(request.get()));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  const uint8_t slots2[] = { 0, 50, 0, 0 };
+  DMXSnapshot_Receive(slots2, arraysize(slots2));
+  DMXSnapshot_FrameComplete();
+  DIMMER_MODEL_ENTRY.tasks_fn();
+
+  const uint8_t htp[] = {
+    10, 10, 10, 50, 50, 50, 30, 30, 30, 40, 40, 40
+  };
+  EXPECT_THAT(m_pixels, ElementsAreArray(htp));
+
+  // Turning playback off returns to DMX.
+  const uint8_t off_data[] = { 0, 0, 0xff };
+  request = BuildSetRequest(
+      PID_PRESET_PLAYBACK, off_data, arraysize(off_data));
+  response.reset(GetResponseFromData(request.get()));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+  DIMMER_MODEL_ENTRY.tasks_fn();
+
+  const uint8_t dmx2[] = { 0, 0, 0, 50, 50, 50, 0, 0, 0, 0, 0, 0 };
+  EXPECT_THAT(m_pixels, ElementsAreArray(dmx2));
+}
+
+TEST_F(DimmerModelTest, lossOfSignal) {
+  NiceMock<MockSPIRGB> spi_mock;
+  SPIRGB_SetMock(&spi_mock);
+  ON_CALL(spi_mock, SetPixels(_, 4))
+    .WillByDefault(Invoke(this, &DimmerModelTest::SetPixels));
+  DMXSnapshot_Initialize();
+
+  // Play scene 1 at half level, 2s after the signal is lost, for 1s.
+  const uint8_t fail_data[] = { 0, 1, 0, 20, 0, 10, 128 };
+  unique_ptr<RDMRequest> request = BuildSetRequest(
+      PID_DMX_FAIL_MODE, fail_data, arraysize(fail_data));
+  unique_ptr<RDMResponse> response(GetResponseFromData(request.get()));
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  const uint8_t slots[] = { 10, 20, 30, 40 };
+  DMXSnapshot_Receive(slots, arraysize(slots));
+  DMXSnapshot_FrameComplete();
+  DIMMER_MODEL_ENTRY.tasks_fn();
+
+  const uint8_t dmx[] = {
+    10, 10, 10, 20, 20, 20, 30, 30, 30, 40, 40, 40
+  };
+  EXPECT_THAT(m_pixels, ElementsAreArray(dmx));
+
+  AdvanceTime(19800);
+  EXPECT_THAT(m_pixels, ElementsAreArray(dmx));
+
+  // The signal is lost.
+  AdvanceTime(600);
+  const uint8_t fail[] = {
+    128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128
+  };
+  EXPECT_THAT(m_pixels, ElementsAreArray(fail));
+
+  AdvanceTime(9500);
+  EXPECT_THAT(m_pixels, ElementsAreArray(fail));
+
+  // Once the hold time expires, the output is off.
+  AdvanceTime(600);
+  const uint8_t off[] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+  EXPECT_THAT(m_pixels, ElementsAreArray(off));
+
+  // DMX returns.
+  DMXSnapshot_Receive(slots, arraysize(slots));
+  DMXSnapshot_FrameComplete();
+  DIMMER_MODEL_ENTRY.tasks_fn();
+  EXPECT_THAT(m_pixels, ElementsAreArray(dmx));
+}
+
+TEST_F(DimmerModelTest, startupScene) {
+  NiceMock<MockSPIRGB> spi_mock;
+  SPIRGB_SetMock(&spi_mock);
+  ON_CALL(spi_mock, SetPixels(_, 4))
+    .WillByDefault(Invoke(this, &DimmerModelTest::SetPixels));
+  DMXSnapshot_Initialize();
+
+  // Play scene 1 after 1s, forever.
+  const uint8_t startup_data[] = { 0, 1, 0, 10, 0xff, 0xff, 0xff };
+  unique_ptr<RDMRequest> request = BuildSetRequest(
+      PID_DMX_STARTUP_MODE, startup_data, arraysize(startup_data));
+  unique_ptr<RDMResponse> response(GetResponseFromData(request.get()));
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  DIMMER_MODEL_ENTRY.deactivate_fn();
+  DIMMER_MODEL_ENTRY.activate_fn();
+
+  AdvanceTime(9700);
+  const uint8_t off[] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+  EXPECT_THAT(m_pixels, ElementsAreArray(off));
+
+  AdvanceTime(600);
+  const uint8_t full[] = {
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255
+  };
+  EXPECT_THAT(m_pixels, ElementsAreArray(full));
+
+  // The first DMX frame ends the startup scene.
+  const uint8_t slots[] = { 0, 50, 0, 0 };
+  DMXSnapshot_Receive(slots, arraysize(slots));
+  DMXSnapshot_FrameComplete();
+  DIMMER_MODEL_ENTRY.tasks_fn();
+
+  const uint8_t dmx[] = { 0, 0, 0, 50, 50, 50, 0, 0, 0, 0, 0, 0 };
+  EXPECT_THAT(m_pixels, ElementsAreArray(dmx));
+}
+
+TEST_F(DimmerModelTest, staleFrameOnActivate) {
+  NiceMock<MockSPIRGB> spi_mock;
+  SPIRGB_SetMock(&spi_mock);
+  ON_CALL(spi_mock, SetPixels(_, 4))
+    .WillByDefault(Invoke(this, &DimmerModelTest::SetPixels));
+  DMXSnapshot_Initialize();
+
+  // Play scene 1 after 1s, forever.
+  const uint8_t startup_data[] = { 0, 1, 0, 10, 0xff, 0xff, 0xff };
+  unique_ptr<RDMRequest> request = BuildSetRequest(
+      PID_DMX_STARTUP_MODE, startup_data, arraysize(startup_data));
+  unique_ptr<RDMResponse> response(GetResponseFromData(request.get()));
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  // A frame received before the model was activated isn't a signal.
+  const uint8_t slots[] = { 0, 50, 0, 0 };
+  DMXSnapshot_Receive(slots, arraysize(slots));
+  DMXSnapshot_FrameComplete();
+
+  DIMMER_MODEL_ENTRY.deactivate_fn();
+  DIMMER_MODEL_ENTRY.activate_fn();
+
+  AdvanceTime(10300);
+  const uint8_t full[] = {
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255
+  };
+  EXPECT_THAT(m_pixels, ElementsAreArray(full));
+}
@@ -0,0 +1,120 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * EventsTest.cpp
+ * Tests for the Events code.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include "events.h"
+#include "Array.h"
+#include "Matchers.h"
+#include "TransportMock.h"
+
+using ::testing::Args;
+using ::testing::InSequence;
+using ::testing::StrictMock;
+using ::testing::Return;
+using ::testing::_;
+
+class EventsTest : public testing::Test {
+ public:
+  void SetUp() {
+    Transport_SetMock(&transport_mock);
+    Events_Initialize(Transport_Send);
+  }
+
+  void TearDown() {
+    Transport_SetMock(nullptr);
+  }
+
+  StrictMock<MockTransport> transport_mock;
+};
+
+TEST_F(EventsTest, noEvents) {
+  // Nothing is sent if the queue is empty.
+  Events_Tasks();
+  EXPECT_EQ(0u, Events_PendingCount());
+}
+
+TEST_F(EventsTest, sendEvents) {
+  Events_Push(EVENT_MODE_CHANGED, 1u, 0u);
+  Events_Push(EVENT_RECEIVER_COUNTER, 5u, 0x01020304);
+  EXPECT_EQ(2u, Events_PendingCount());
+
+  const uint8_t payload[] = {
+    EVENT_MODE_CHANGED, 1, 0, 0, 0, 0,
+    EVENT_RECEIVER_COUNTER, 5, 4, 3, 2, 1
+  };
+
+  EXPECT_CALL(transport_mock, Send(EVENT_TOKEN, COMMAND_EVENT, RC_OK, _, 1))
+      .With(Args<3, 4>(PayloadIs(payload, arraysize(payload))))
+      .WillOnce(Return(true));
+
+  Events_Tasks();
+  EXPECT_EQ(0u, Events_PendingCount());
+
+  // The queue is now empty.
+  Events_Tasks();
+}
+
+TEST_F(EventsTest, sendFailure) {
+  Events_Push(EVENT_LOG_OVERFLOW, 0u, 0u);
+
+  const uint8_t payload[] = {EVENT_LOG_OVERFLOW, 0, 0, 0, 0, 0};
+
+  // The first send fails, so the event remains queued.
+  InSequence seq;
+  EXPECT_CALL(transport_mock, Send(EVENT_TOKEN, COMMAND_EVENT, RC_OK, _, 1))
+      .With(Args<3, 4>(PayloadIs(payload, arraysize(payload))))
+      .WillOnce(Return(false));
+  EXPECT_CALL(transport_mock, Send(EVENT_TOKEN, COMMAND_EVENT, RC_OK, _, 1))
+      .With(Args<3, 4>(PayloadIs(payload, arraysize(payload))))
+      .WillOnce(Return(true));
+
+  Events_Tasks();
+  EXPECT_EQ(1u, Events_PendingCount());
+  Events_Tasks();
+  EXPECT_EQ(0u, Events_PendingCount());
+}
+
+TEST_F(EventsTest, queueOverflow) {
+  for (unsigned int i = 0; i < EVENT_QUEUE_SIZE + 3; i++) {
+    Events_Push(EVENT_TOD_CHANGED, 0u, i);
+  }
+  EXPECT_EQ(EVENT_QUEUE_SIZE, Events_PendingCount());
+
+  uint8_t payload[(EVENT_QUEUE_SIZE + 1) * EVENT_SIZE];
+  uint8_t *ptr = payload;
+  for (unsigned int i = 0; i < EVENT_QUEUE_SIZE; i++) {
+    const uint8_t event[] = {EVENT_TOD_CHANGED, 0, static_cast<uint8_t>(i),
+                             0, 0, 0};
+    memcpy(ptr, event, EVENT_SIZE);
+    ptr += EVENT_SIZE;
+  }
+  // The overflow event records the 3 dropped events.
+  const uint8_t overflow[] = {EVENT_QUEUE_OVERFLOW, 0, 3, 0, 0, 0};
+  memcpy(ptr, overflow, EVENT_SIZE);
+
+  EXPECT_CALL(transport_mock, Send(EVENT_TOKEN, COMMAND_EVENT, RC_OK, _, 1))
+      .With(Args<3, 4>(PayloadIs(payload, arraysize(payload))))
+      .WillOnce(Return(true));
+
+  Events_Tasks();
+  EXPECT_EQ(0u, Events_PendingCount());
+}
@@ -0,0 +1,134 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * FaderTest.cpp
+ * Tests for the fader code.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+
+#include "Array.h"
+#include "fader.h"
+
+class FaderTest : public testing::Test {
+ public:
+  void SetUp() {
+    Fader_Set(m_channels, arraysize(m_channels), 0);
+  }
+
+ protected:
+  FaderChannel m_channels[3];
+};
+
+TEST_F(FaderTest, set) {
+  Fader_Set(m_channels, arraysize(m_channels), 100);
+  for (unsigned int i = 0; i < arraysize(m_channels); i++) {
+    EXPECT_EQ(100, Fader_Level(&m_channels[i]));
+  }
+  EXPECT_FALSE(Fader_Tick(m_channels, arraysize(m_channels)));
+}
+
+TEST_F(FaderTest, immediate) {
+  const uint8_t targets[] = {255, 0, 128};
+  Fader_Start(m_channels, targets, arraysize(targets), 0, 0);
+  EXPECT_EQ(255, Fader_Level(&m_channels[0]));
+  EXPECT_EQ(0, Fader_Level(&m_channels[1]));
+  EXPECT_EQ(128, Fader_Level(&m_channels[2]));
+  EXPECT_FALSE(Fader_Tick(m_channels, arraysize(m_channels)));
+}
+
+TEST_F(FaderTest, fadeUp) {
+  const uint8_t targets[] = {100, 255, 1};
+  Fader_Start(m_channels, targets, arraysize(targets), 4, 0);
+
+  EXPECT_TRUE(Fader_Tick(m_channels, arraysize(m_channels)));
+  EXPECT_EQ(25, Fader_Level(&m_channels[0]));
+  EXPECT_EQ(64, Fader_Level(&m_channels[1]));
+  EXPECT_EQ(0, Fader_Level(&m_channels[2]));
+
+  EXPECT_TRUE(Fader_Tick(m_channels, arraysize(m_channels)));
+  EXPECT_EQ(50, Fader_Level(&m_channels[0]));
+  EXPECT_EQ(128, Fader_Level(&m_channels[1]));
+  EXPECT_EQ(1, Fader_Level(&m_channels[2]));
+
+  EXPECT_TRUE(Fader_Tick(m_channels, arraysize(m_channels)));
+  EXPECT_EQ(75, Fader_Level(&m_channels[0]));
+  EXPECT_EQ(191, Fader_Level(&m_channels[1]));
+
+  // The last tick lands on the target.
+  EXPECT_FALSE(Fader_Tick(m_channels, arraysize(m_channels)));
+  EXPECT_EQ(100, Fader_Level(&m_channels[0]));
+  EXPECT_EQ(255, Fader_Level(&m_channels[1]));
+  EXPECT_EQ(1, Fader_Level(&m_channels[2]));
+
+  EXPECT_FALSE(Fader_Tick(m_channels, arraysize(m_channels)));
+  EXPECT_EQ(100, Fader_Level(&m_channels[0]));
+}
+
+TEST_F(FaderTest, upAndDownTimes) {
+  Fader_Set(m_channels, arraysize(m_channels), 100);
+
+  // Channel 0 goes up over 2 ticks, channel 1 down over 4 ticks and channel 2
+  // doesn't change.
+  const uint8_t targets[] = {200, 0, 100};
+  Fader_Start(m_channels, targets, arraysize(targets), 2, 4);
+
+  EXPECT_TRUE(Fader_Tick(m_channels, arraysize(m_channels)));
+  EXPECT_EQ(150, Fader_Level(&m_channels[0]));
+  EXPECT_EQ(75, Fader_Level(&m_channels[1]));
+  EXPECT_EQ(100, Fader_Level(&m_channels[2]));
+
+  EXPECT_TRUE(Fader_Tick(m_channels, arraysize(m_channels)));
+  EXPECT_EQ(200, Fader_Level(&m_channels[0]));
+  EXPECT_EQ(50, Fader_Level(&m_channels[1]));
+
+  EXPECT_TRUE(Fader_Tick(m_channels, arraysize(m_channels)));
+  EXPECT_EQ(25, Fader_Level(&m_channels[1]));
+  EXPECT_FALSE(Fader_Tick(m_channels, arraysize(m_channels)));
+  EXPECT_EQ(0, Fader_Level(&m_channels[1]));
+  EXPECT_EQ(100, Fader_Level(&m_channels[2]));
+}
+
+TEST_F(FaderTest, restartMidFade) {
+  const uint8_t up[] = {200, 200, 200};
+  Fader_Start(m_channels, up, arraysize(up), 4, 4);
+  EXPECT_TRUE(Fader_Tick(m_channels, arraysize(m_channels)));
+  EXPECT_EQ(50, Fader_Level(&m_channels[0]));
+
+  // Fade back down from the current level.
+  const uint8_t down[] = {0, 0, 0};
+  Fader_Start(m_channels, down, arraysize(down), 4, 2);
+  EXPECT_TRUE(Fader_Tick(m_channels, arraysize(m_channels)));
+  EXPECT_EQ(25, Fader_Level(&m_channels[0]));
+  EXPECT_FALSE(Fader_Tick(m_channels, arraysize(m_channels)));
+  EXPECT_EQ(0, Fader_Level(&m_channels[0]));
+}
+
+TEST_F(FaderTest, longFade) {
+  // A 10 minute fade, at 50 ticks per second.
+  const unsigned int ticks = 10 * 60 * 50;
+  const uint8_t targets[] = {255, 255, 255};
+  Fader_Start(m_channels, targets, arraysize(targets), ticks, 0);
+
+  uint8_t last_level = 0;
+  for (unsigned int i = 1; i < ticks; i++) {
+    EXPECT_TRUE(Fader_Tick(m_channels, arraysize(m_channels)));
+    EXPECT_LE(last_level, Fader_Level(&m_channels[0]));
+    last_level = Fader_Level(&m_channels[0]);
+  }
+  EXPECT_FALSE(Fader_Tick(m_channels, arraysize(m_channels)));
+  EXPECT_EQ(255, Fader_Level(&m_channels[0]));
+}
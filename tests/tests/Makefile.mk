@@ -29,22 +29,37 @@ TESTING_LIBS = $(GMOCK_LIBS) $(GTEST_LIBS)
 
 TESTS += tests/tests/bootloader_test \
          tests/tests/bootloader_transfer_test \
+         tests/tests/client_test \
          tests/tests/coarse_timer_test \
+         tests/tests/dimmer_curve_test \
          tests/tests/dimmer_model_test \
+         tests/tests/dmx_forwarder_test \
+         tests/tests/dmx_rle_test \
+         tests/tests/dmx_snapshot_test \
+         tests/tests/events_test \
+         tests/tests/fader_test \
          tests/tests/flags_test \
          tests/tests/led_model_test \
          tests/tests/message_handler_test \
+         tests/tests/model_arena_test \
          tests/tests/network_model_test \
+         tests/tests/pixel_encoder_test \
+         tests/tests/pixel_mapper_test \
          tests/tests/proxy_model_test \
          tests/tests/rdm_handler_test \
          tests/tests/rdm_responder_test \
          tests/tests/rdm_util_test \
          tests/tests/responder_test \
+         tests/tests/scheduler_test \
+         tests/tests/sniffer_test \
          tests/tests/spirgb_test \
          tests/tests/stream_decoder_test \
          tests/tests/simulated_transceiver_test \
          tests/tests/spi_test \
+         tests/tests/timer_wheel_test \
+         tests/tests/trace_test \
          tests/tests/transceiver_test \
+         tests/tests/transceiver_static_test \
          tests/tests/usb_transport_test \
          tests/tests/utils_test
 
@@ -74,12 +89,24 @@ tests_tests_bootloader_transfer_test_LDADD = \
     tests/mocks/libresetmock.la \
     tests/tests/libbootloaderhelper.la
 
+tests_tests_client_test_SOURCES = tests/tests/ClientTest.cpp
+tests_tests_client_test_CXXFLAGS = $(TESTING_CXXFLAGS) -I tools
+tests_tests_client_test_LDADD = $(TESTING_LIBS) \
+                                tools/client/libjaruleclient.la \
+                                tests/mocks/libmatchers.la
+
 tests_tests_coarse_timer_test_SOURCES = tests/tests/CoarseTimerTest.cpp
 tests_tests_coarse_timer_test_CXXFLAGS = $(TESTING_CXXFLAGS)
 tests_tests_coarse_timer_test_LDADD = $(TESTING_LIBS) \
                                       firmware/src/libcoarsetimer.la \
                                       tests/harmony/mocks/libharmonymock.la
 
+tests_tests_dimmer_curve_test_SOURCES = tests/tests/DimmerCurveTest.cpp
+tests_tests_dimmer_curve_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_dimmer_curve_test_LDADD = $(TESTING_LIBS) \
+                                      firmware/src/libdimmercurve.la \
+                                      tests/mocks/libmatchers.la
+
 tests_tests_dimmer_model_test_SOURCES = tests/tests/DimmerModelTest.cpp
 tests_tests_dimmer_model_test_CXXFLAGS = $(TESTING_CXXFLAGS) $(OLA_CFLAGS)
 tests_tests_dimmer_model_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
@@ -90,9 +117,42 @@ tests_tests_dimmer_model_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
                                       firmware/src/librdmutil.la \
                                       tests/harmony/mocks/libharmonymock.la \
                                       tests/mocks/libcoarsetimermock.la \
+                                      tests/mocks/libspirgbmock.la \
                                       tests/tests/libmodeltest.la \
                                       tests/mocks/libmatchers.la
 
+tests_tests_dmx_forwarder_test_SOURCES = tests/tests/DMXForwarderTest.cpp
+tests_tests_dmx_forwarder_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_dmx_forwarder_test_LDADD = $(TESTING_LIBS) \
+                                       firmware/src/libdmxforwarder.la \
+                                       tests/mocks/libcoarsetimermock.la \
+                                       tests/mocks/libmatchers.la \
+                                       tests/mocks/libtransportmock.la
+
+tests_tests_dmx_rle_test_SOURCES = tests/tests/DMXRLETest.cpp
+tests_tests_dmx_rle_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_dmx_rle_test_LDADD = $(TESTING_LIBS) \
+                                 firmware/src/libdmxrle.la \
+                                 tests/mocks/libmatchers.la
+
+tests_tests_dmx_snapshot_test_SOURCES = tests/tests/DMXSnapshotTest.cpp
+tests_tests_dmx_snapshot_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_dmx_snapshot_test_LDADD = $(TESTING_LIBS) \
+                                      firmware/src/libdmxsnapshot.la \
+                                      tests/mocks/libmatchers.la
+
+tests_tests_events_test_SOURCES = tests/tests/EventsTest.cpp
+tests_tests_events_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_events_test_LDADD = $(TESTING_LIBS) \
+                                firmware/src/libevents.la \
+                                tests/mocks/libmatchers.la \
+                                tests/mocks/libtransportmock.la
+
+tests_tests_fader_test_SOURCES = tests/tests/FaderTest.cpp
+tests_tests_fader_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_fader_test_LDADD = $(TESTING_LIBS) \
+                               firmware/src/libfader.la
+
 tests_tests_flags_test_SOURCES = tests/tests/FlagsTest.cpp
 tests_tests_flags_test_CXXFLAGS = $(TESTING_CXXFLAGS)
 tests_tests_flags_test_LDADD = $(TESTING_LIBS) \
@@ -112,13 +172,15 @@ tests_tests_led_model_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
                                    firmware/src/librdmutil.la \
                                    tests/tests/libmodeltest.la \
                                    tests/harmony/mocks/libharmonymock.la \
-                                   tests/mocks/libmatchers.la
+                                   tests/mocks/libmatchers.la \
+                                   tests/mocks/libspirgbmock.la
 
 tests_tests_message_handler_test_SOURCES = tests/tests/MessageHandlerTest.cpp
 tests_tests_message_handler_test_CXXFLAGS = $(TESTING_CXXFLAGS)
 tests_tests_message_handler_test_LDADD = $(GMOCK_LIBS) $(GTEST_LIBS) \
                                          firmware/src/libmessagehandler.la \
                                          tests/mocks/libappmock.la \
+                                         tests/mocks/libcoarsetimermock.la \
                                          tests/mocks/libflagsmock.la \
                                          tests/mocks/libmatchers.la \
                                          tests/mocks/librdmhandlermock.la \
@@ -141,6 +203,18 @@ tests_tests_network_model_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
                                        tests/harmony/mocks/libharmonymock.la \
                                        tests/mocks/libmatchers.la
 
+tests_tests_pixel_encoder_test_SOURCES = tests/tests/PixelEncoderTest.cpp
+tests_tests_pixel_encoder_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_pixel_encoder_test_LDADD = $(TESTING_LIBS) \
+                                       firmware/src/libpixelencoder.la \
+                                       tests/mocks/libmatchers.la
+
+tests_tests_pixel_mapper_test_SOURCES = tests/tests/PixelMapperTest.cpp
+tests_tests_pixel_mapper_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_pixel_mapper_test_LDADD = $(TESTING_LIBS) \
+                                      firmware/src/libpixelmapper.la \
+                                      tests/mocks/libmatchers.la
+
 tests_tests_proxy_model_test_SOURCES = tests/tests/ProxyModelTest.cpp
 tests_tests_proxy_model_test_CXXFLAGS = $(TESTING_CXXFLAGS) $(OLA_CFLAGS)
 tests_tests_proxy_model_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
@@ -179,6 +253,11 @@ tests_tests_rdm_responder_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
                                        tests/mocks/libmatchers.la \
                                        tests/mocks/libmessagehandlermock.la
 
+tests_tests_model_arena_test_SOURCES = tests/tests/ModelArenaTest.cpp
+tests_tests_model_arena_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_model_arena_test_LDADD = $(TESTING_LIBS) \
+                                     firmware/src/libmodelarena.la
+
 tests_tests_rdm_util_test_SOURCES = tests/tests/RDMUtilTest.cpp
 tests_tests_rdm_util_test_CXXFLAGS = $(TESTING_CXXFLAGS)
 tests_tests_rdm_util_test_LDADD = $(TESTING_LIBS) \
@@ -202,6 +281,7 @@ tests_tests_spirgb_test_CXXFLAGS = $(TESTING_CXXFLAGS)
 tests_tests_spirgb_test_LDADD = $(TESTING_LIBS) \
                                 firmware/src/libspirgb.la \
                                 tests/harmony/mocks/libharmonymock.la \
+                                tests/mocks/libcoarsetimermock.la \
                                 tests/mocks/libmatchers.la
 
 tests_tests_stream_decoder_test_SOURCES = tests/tests/StreamDecoderTest.cpp
@@ -219,6 +299,7 @@ tests_tests_usb_transport_test_LDADD = $(TESTING_LIBS) \
                                        tests/mocks/libmatchers.la \
                                        tests/mocks/libresetmock.la \
                                        tests/mocks/libstreamdecodermock.la \
+                                       tests/mocks/libtransceivermock.la \
                                        firmware/src/libflags.la
 
 tests_tests_spi_test_SOURCES = tests/tests/SPITest.cpp
@@ -238,6 +319,49 @@ tests_tests_transceiver_test_LDADD = $(GMOCK_LIBS) $(GTEST_LIBS) \
                                      tests/mocks/libcoarsetimermock.la \
                                      tests/mocks/libsyslogmock.la
 
+# The same tests, with the transceiver hardware set at compile time.
+tests_tests_transceiver_static_test_SOURCES = tests/tests/TransceiverTest.cpp \
+                                              firmware/src/transceiver.c
+tests_tests_transceiver_static_test_CFLAGS = $(TESTING_CFLAGS) \
+                                             -DTRANSCEIVER_STATIC_HARDWARE
+tests_tests_transceiver_static_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_transceiver_static_test_LDADD = \
+    $(GMOCK_LIBS) $(GTEST_LIBS) \
+    firmware/src/libdmxrle.la \
+    firmware/src/libevents.la \
+    firmware/src/librandom.la \
+    firmware/src/libscheduler.la \
+    firmware/src/libtrace.la \
+    tests/harmony/mocks/libharmonymock.la \
+    tests/mocks/libcoarsetimermock.la \
+    tests/mocks/libsyslogmock.la
+
+tests_tests_scheduler_test_SOURCES = tests/tests/SchedulerTest.cpp
+tests_tests_scheduler_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_scheduler_test_LDADD = $(TESTING_LIBS) \
+                                   firmware/src/libscheduler.la
+
+tests_tests_sniffer_test_SOURCES = tests/tests/SnifferTest.cpp
+tests_tests_sniffer_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_sniffer_test_LDADD = $(TESTING_LIBS) \
+                                 firmware/src/libsniffer.la \
+                                 tests/mocks/libcoarsetimermock.la \
+                                 tests/mocks/libmatchers.la \
+                                 tests/mocks/libtransportmock.la
+
+tests_tests_timer_wheel_test_SOURCES = tests/tests/TimerWheelTest.cpp
+tests_tests_timer_wheel_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_timer_wheel_test_LDADD = $(TESTING_LIBS) \
+                                     firmware/src/libtimerwheel.la \
+                                     firmware/src/libcoarsetimer.la \
+                                     tests/harmony/mocks/libharmonymock.la
+
+tests_tests_trace_test_SOURCES = tests/tests/TraceTest.cpp
+tests_tests_trace_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_trace_test_LDADD = $(TESTING_LIBS) \
+                               firmware/src/libtrace.la \
+                               tests/mocks/libcoarsetimermock.la
+
 tests_tests_simulated_transceiver_test_SOURCES = \
     tests/tests/SimulatedTransceiverTest.cpp
 tests_tests_simulated_transceiver_test_CXXFLAGS = \
@@ -29,6 +29,7 @@
 #include "TransportMock.h"
 #include "constants.h"
 #include "message_handler.h"
+#include "trace.h"
 
 using ::testing::Args;
 using ::testing::Return;
@@ -319,6 +320,35 @@ TEST_F(MessageHandlerTest, testDMX) {
   MessageHandler_HandleMessage(&message);
 }
 
+TEST_F(MessageHandlerTest, testRLEDMX) {
+  const uint8_t rle_data[] = {0x01, 1, 3, 0x89, 0xc3, 4};
+  const uint8_t bad_rle_data[] = {0x04, 1, 3};
+
+  testing::InSequence seq;
+  EXPECT_CALL(m_transceiver_mock, QueueRLEDMX(kToken, _, _))
+      .With(Args<1, 2>(DataIs(rle_data, arraysize(rle_data))))
+      .WillOnce(Return(true));
+  EXPECT_CALL(m_transceiver_mock, QueueRLEDMX(kToken, _, _))
+      .WillOnce(Return(false));
+  EXPECT_CALL(m_transport_mock,
+              Send(kToken, COMMAND_TX_DMX_RLE, RC_BUFFER_FULL, NULL, 0))
+      .WillOnce(Return(true));
+  EXPECT_CALL(m_transport_mock,
+              Send(kToken, COMMAND_TX_DMX_RLE, RC_BAD_PARAM, NULL, 0))
+      .WillOnce(Return(true));
+
+  Message message = {
+    kToken, COMMAND_TX_DMX_RLE, arraysize(rle_data), &rle_data[0]
+  };
+  MessageHandler_HandleMessage(&message);
+  MessageHandler_HandleMessage(&message);
+
+  Message bad_message = {
+    kToken, COMMAND_TX_DMX_RLE, arraysize(bad_rle_data), &bad_rle_data[0]
+  };
+  MessageHandler_HandleMessage(&bad_message);
+}
+
 TEST_F(MessageHandlerTest, testFlags) {
   MockFlags flags_mock;
   Flags_SetMock(&flags_mock);
@@ -329,6 +359,61 @@ TEST_F(MessageHandlerTest, testFlags) {
   MessageHandler_HandleMessage(&message);
 }
 
+TEST_F(MessageHandlerTest, testTrace) {
+  Trace_Initialize();
+  Trace_Record(5, TRACE_EVENT_TIMER, 0x0102);
+
+  const uint8_t expected_payload[] = {
+    0, 0, 0, 0,  // lost
+    0, 0, 0, 0, 5, TRACE_EVENT_TIMER, 0x02, 0x01
+  };
+  EXPECT_CALL(m_transport_mock, Send(kToken, COMMAND_GET_TRACE, RC_OK, _, 2))
+      .With(Args<3, 4>(PayloadIs(expected_payload,
+                                 arraysize(expected_payload))))
+      .WillOnce(Return(true));
+
+  Message message = { kToken, COMMAND_GET_TRACE, 0, NULL };
+  MessageHandler_HandleMessage(&message);
+
+  // The trace is now empty.
+  const uint8_t empty_payload[] = {0, 0, 0, 0};
+  EXPECT_CALL(m_transport_mock, Send(kToken, COMMAND_GET_TRACE, RC_OK, _, 2))
+      .With(Args<3, 4>(PayloadIs(empty_payload, arraysize(empty_payload))))
+      .WillOnce(Return(true));
+  MessageHandler_HandleMessage(&message);
+
+  uint8_t payload = 0;
+  Message bad_message = { kToken, COMMAND_GET_TRACE, sizeof(payload),
+                          &payload };
+  EXPECT_CALL(m_transport_mock,
+              Send(kToken, COMMAND_GET_TRACE, RC_BAD_PARAM, NULL, 0))
+      .WillOnce(Return(true));
+  MessageHandler_HandleMessage(&bad_message);
+}
+
+TEST_F(MessageHandlerTest, testDMXForwarding) {
+  const uint8_t interval[] = {0xfa, 0};
+  Message message = { kToken, COMMAND_SET_DMX_FORWARDING,
+                      arraysize(interval), interval };
+  EXPECT_CALL(m_transport_mock,
+              Send(kToken, COMMAND_SET_DMX_FORWARDING, RC_OK, NULL, 0))
+      .WillOnce(Return(true));
+  MessageHandler_HandleMessage(&message);
+
+  Message get_message = { kToken, COMMAND_GET_DMX_FORWARDING, 0, NULL };
+  EXPECT_CALL(m_transport_mock,
+              Send(kToken, COMMAND_GET_DMX_FORWARDING, RC_OK, _, 1))
+      .With(Args<3, 4>(PayloadIs(interval, arraysize(interval))))
+      .WillOnce(Return(true));
+  MessageHandler_HandleMessage(&get_message);
+
+  Message bad_message = { kToken, COMMAND_SET_DMX_FORWARDING, 1u, interval };
+  EXPECT_CALL(m_transport_mock,
+              Send(kToken, COMMAND_SET_DMX_FORWARDING, RC_BAD_PARAM, NULL, 0))
+      .WillOnce(Return(true));
+  MessageHandler_HandleMessage(&bad_message);
+}
+
 TEST_F(MessageHandlerTest, testReset) {
   MockApp app_mock;
   APP_SetMock(&app_mock);
@@ -363,6 +448,14 @@ TEST_F(MessageHandlerTest, transceiverDMXEvent) {
   SendEvent(kToken + 1, T_OP_TX_ONLY, T_RESULT_TX_ERROR, NULL, 0);
 }
 
+TEST_F(MessageHandlerTest, transceiverRLEDMXEvent) {
+  EXPECT_CALL(m_transport_mock, Send(kToken, COMMAND_TX_DMX_RLE, RC_OK, _, _))
+      .With(Args<3, 4>(EmptyPayload()))
+      .WillOnce(Return(true));
+
+  SendEvent(kToken, T_OP_TX_DMX_RLE, T_RESULT_OK, NULL, 0);
+}
+
 TEST_F(MessageHandlerTest, transceiverRDMDiscoveryRequest) {
   // Any data, doesn't have to be valid RDM
   const uint8_t rdm_reply[] = {1, 3, 4, 4, 5};
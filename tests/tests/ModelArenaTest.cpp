@@ -0,0 +1,46 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * ModelArenaTest.cpp
+ * Tests for the shared model state arena.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "model_arena.h"
+
+class ModelArenaTest : public testing::Test {};
+
+TEST_F(ModelArenaTest, claimClearsTheArena) {
+  uint8_t *arena = reinterpret_cast<uint8_t*>(ModelArena_Claim());
+  ASSERT_NE(nullptr, arena);
+  memset(arena, 0xaa, MODEL_ARENA_SIZE);
+
+  // The next model gets the same memory, cleared.
+  uint8_t *next = reinterpret_cast<uint8_t*>(ModelArena_Claim());
+  EXPECT_EQ(arena, next);
+  for (unsigned int i = 0; i < MODEL_ARENA_SIZE; i++) {
+    EXPECT_EQ(0u, next[i]) << "at offset " << i;
+  }
+}
+
+TEST_F(ModelArenaTest, alignment) {
+  uintptr_t arena = reinterpret_cast<uintptr_t>(ModelArena_Claim());
+  EXPECT_EQ(0u, arena % sizeof(uint64_t));
+  EXPECT_EQ(0u, arena % sizeof(void*));
+}
@@ -0,0 +1,155 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * PixelEncoderTest.cpp
+ * Tests for the pixel protocol encoders.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include "Array.h"
+#include "Matchers.h"
+#include "pixel_encoder.h"
+
+class PixelEncoderTest : public testing::Test {
+ protected:
+  uint8_t m_output[PIXEL_ENCODER_MAX_FRAME_SIZE(4) + 1];
+
+  unsigned int Encode(PixelType type, const uint8_t *data,
+                      uint16_t pixel_count) {
+    const PixelEncoder *encoder = PixelEncoder_Get(type);
+    EXPECT_TRUE(encoder);
+    memset(m_output, 0xaa, arraysize(m_output));
+    unsigned int size = PixelEncoder_Encode(encoder, m_output, data,
+                                            pixel_count);
+    EXPECT_EQ(PixelEncoder_FrameSize(encoder, pixel_count), size);
+    // Check we didn't overrun.
+    EXPECT_EQ(0xaa, m_output[size]);
+    return size;
+  }
+};
+
+TEST_F(PixelEncoderTest, unknownType) {
+  EXPECT_EQ(NULL, PixelEncoder_Get(static_cast<PixelType>(0)));
+  EXPECT_EQ(NULL, PixelEncoder_Get(static_cast<PixelType>(6)));
+}
+
+TEST_F(PixelEncoderTest, lpd8806) {
+  const PixelEncoder *encoder = PixelEncoder_Get(PIXEL_TYPE_LPD8806);
+  EXPECT_EQ(PIXEL_ORDER_GRB, encoder->order);
+  EXPECT_EQ(0u, encoder->baud_rate);
+
+  const uint8_t data[] = {0, 1, 2, 128, 254, 255};
+  const uint8_t expected[] = {0x80, 0x80, 0x81, 0xc0, 0xff, 0xff, 0};
+
+  unsigned int size = Encode(PIXEL_TYPE_LPD8806, data, 2);
+  EXPECT_THAT(ArrayTuple(m_output, size),
+              DataIs(expected, arraysize(expected)));
+
+  // One latch byte per 32 pixels.
+  EXPECT_EQ(3u * 32u + 1u, PixelEncoder_FrameSize(encoder, 32));
+  EXPECT_EQ(3u * 33u + 2u, PixelEncoder_FrameSize(encoder, 33));
+}
+
+TEST_F(PixelEncoderTest, ws2801) {
+  const PixelEncoder *encoder = PixelEncoder_Get(PIXEL_TYPE_WS2801);
+  EXPECT_EQ(PIXEL_ORDER_RGB, encoder->order);
+  // Latched by holding the clock low for 500us.
+  EXPECT_EQ(SPI_CLOCK_POLARITY_IDLE_LOW, encoder->clock_polarity);
+  EXPECT_EQ(500u, encoder->latch_time);
+
+  const uint8_t data[] = {0, 1, 2, 128, 254, 255};
+  unsigned int size = Encode(PIXEL_TYPE_WS2801, data, 2);
+  EXPECT_THAT(ArrayTuple(m_output, size), DataIs(data, arraysize(data)));
+}
+
+TEST_F(PixelEncoderTest, p9813) {
+  const PixelEncoder *encoder = PixelEncoder_Get(PIXEL_TYPE_P9813);
+  EXPECT_EQ(PIXEL_ORDER_BGR, encoder->order);
+
+  const uint8_t data[] = {0, 0, 0, 0xff, 0x80, 0x40};
+  const uint8_t expected[] = {
+    0, 0, 0, 0,  // start
+    0xff, 0, 0, 0,
+    // B = 11, G = 10, R = 01, inverted = 00 01 10
+    0xc6, 0xff, 0x80, 0x40,
+    0, 0, 0, 0  // end
+  };
+
+  unsigned int size = Encode(PIXEL_TYPE_P9813, data, 2);
+  EXPECT_THAT(ArrayTuple(m_output, size),
+              DataIs(expected, arraysize(expected)));
+}
+
+TEST_F(PixelEncoderTest, apa102) {
+  const PixelEncoder *encoder = PixelEncoder_Get(PIXEL_TYPE_APA102);
+  EXPECT_EQ(PIXEL_ORDER_BGR, encoder->order);
+
+  const uint8_t data[] = {1, 2, 3, 4, 5, 6};
+  const uint8_t expected[] = {
+    0, 0, 0, 0,  // start
+    0xff, 1, 2, 3,
+    0xff, 4, 5, 6,
+    0  // end
+  };
+
+  unsigned int size = Encode(PIXEL_TYPE_APA102, data, 2);
+  EXPECT_THAT(ArrayTuple(m_output, size),
+              DataIs(expected, arraysize(expected)));
+
+  // One end byte per 16 pixels.
+  EXPECT_EQ(4u + 4u * 16u + 1u, PixelEncoder_FrameSize(encoder, 16));
+  EXPECT_EQ(4u + 4u * 17u + 2u, PixelEncoder_FrameSize(encoder, 17));
+}
+
+TEST_F(PixelEncoderTest, ws2812) {
+  const PixelEncoder *encoder = PixelEncoder_Get(PIXEL_TYPE_WS2812);
+  EXPECT_EQ(PIXEL_ORDER_GRB, encoder->order);
+  EXPECT_EQ(2400000u, encoder->baud_rate);
+
+  const uint8_t data[] = {0x00, 0xff, 0xa5};
+  unsigned int size = Encode(PIXEL_TYPE_WS2812, data, 1);
+  EXPECT_EQ(9u + 24u, size);
+
+  // Build the expected bits, 110 for a 1 and 100 for a 0.
+  uint8_t expected[9];
+  memset(expected, 0, arraysize(expected));
+  unsigned int bit = 0;
+  for (unsigned int i = 0; i < arraysize(data); i++) {
+    for (int j = 7; j >= 0; j--) {
+      const uint8_t symbol = (data[i] >> j) & 1 ? 6 : 4;
+      for (int k = 2; k >= 0; k--, bit++) {
+        if ((symbol >> k) & 1) {
+          expected[bit / 8] |= 0x80 >> (bit % 8);
+        }
+      }
+    }
+  }
+  EXPECT_THAT(ArrayTuple(m_output, 9u), DataIs(expected, arraysize(expected)));
+
+  // The reset is all zeros.
+  uint8_t reset[24];
+  memset(reset, 0, arraysize(reset));
+  EXPECT_THAT(ArrayTuple(m_output + 9u, 24u),
+              DataIs(reset, arraysize(reset)));
+}
+
+TEST_F(PixelEncoderTest, noPixels) {
+  EXPECT_EQ(0u, Encode(PIXEL_TYPE_LPD8806, NULL, 0));
+  EXPECT_EQ(8u, Encode(PIXEL_TYPE_P9813, NULL, 0));
+  EXPECT_EQ(4u, Encode(PIXEL_TYPE_APA102, NULL, 0));
+}
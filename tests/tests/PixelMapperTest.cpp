@@ -0,0 +1,145 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * PixelMapperTest.cpp
+ * Tests for the pixel mapping code.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include "Array.h"
+#include "Matchers.h"
+#include "dmx_spec.h"
+#include "pixel_mapper.h"
+
+class PixelMapperTest : public testing::Test {
+ public:
+  void SetUp() {
+    PixelMapper_Initialize();
+    for (unsigned int i = 0; i < arraysize(m_slots); i++) {
+      m_slots[i] = i + 1;
+    }
+    memset(m_output, 0xff, arraysize(m_output));
+  }
+
+ protected:
+  uint8_t m_slots[DMX_FRAME_SIZE];
+  uint8_t m_output[PIXEL_MAPPER_MAX_PIXELS * PIXEL_MAPPER_SLOTS_PER_PIXEL + 1];
+
+  void Configure(uint16_t start_address, uint16_t pixel_count,
+                 uint16_t group_size, PixelOrder order, bool reverse) {
+    PixelMapperSettings settings;
+    settings.start_address = start_address;
+    settings.pixel_count = pixel_count;
+    settings.group_size = group_size;
+    settings.order = order;
+    settings.reverse = reverse;
+    PixelMapper_Configure(&settings);
+  }
+};
+
+TEST_F(PixelMapperTest, defaults) {
+  EXPECT_EQ(1u, PixelMapper_StartAddress());
+  EXPECT_EQ(2u, PixelMapper_PixelCount());
+  EXPECT_EQ(6u, PixelMapper_Footprint());
+
+  const uint8_t expected[] = {2, 1, 3, 5, 4, 6};
+  EXPECT_EQ(arraysize(expected), PixelMapper_Map(m_output, m_slots, 6u));
+  EXPECT_THAT(ArrayTuple(m_output, arraysize(expected)),
+              DataIs(expected, arraysize(expected)));
+  EXPECT_EQ(0xff, m_output[arraysize(expected)]);
+}
+
+TEST_F(PixelMapperTest, rgbOrder) {
+  Configure(10u, 3u, 1u, PIXEL_ORDER_RGB, false);
+  EXPECT_EQ(10u, PixelMapper_StartAddress());
+  EXPECT_EQ(9u, PixelMapper_Footprint());
+
+  const uint8_t expected[] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  EXPECT_EQ(arraysize(expected), PixelMapper_Map(m_output, m_slots, 9u));
+  EXPECT_THAT(ArrayTuple(m_output, arraysize(expected)),
+              DataIs(expected, arraysize(expected)));
+}
+
+TEST_F(PixelMapperTest, reverse) {
+  Configure(1u, 3u, 1u, PIXEL_ORDER_GRB, true);
+  EXPECT_EQ(9u, PixelMapper_Footprint());
+
+  const uint8_t expected[] = {8, 7, 9, 5, 4, 6, 2, 1, 3};
+  EXPECT_EQ(arraysize(expected), PixelMapper_Map(m_output, m_slots, 9u));
+  EXPECT_THAT(ArrayTuple(m_output, arraysize(expected)),
+              DataIs(expected, arraysize(expected)));
+}
+
+TEST_F(PixelMapperTest, grouping) {
+  // 5 pixels in groups of 2 needs 3 groups.
+  Configure(1u, 5u, 2u, PIXEL_ORDER_RGB, false);
+  EXPECT_EQ(9u, PixelMapper_Footprint());
+
+  const uint8_t expected[] = {
+    1, 2, 3, 1, 2, 3, 4, 5, 6, 4, 5, 6, 7, 8, 9
+  };
+  EXPECT_EQ(arraysize(expected), PixelMapper_Map(m_output, m_slots, 9u));
+  EXPECT_THAT(ArrayTuple(m_output, arraysize(expected)),
+              DataIs(expected, arraysize(expected)));
+
+  // Grouping is applied before reversal.
+  Configure(1u, 5u, 2u, PIXEL_ORDER_RGB, true);
+  const uint8_t reversed[] = {
+    7, 8, 9, 4, 5, 6, 4, 5, 6, 1, 2, 3, 1, 2, 3
+  };
+  EXPECT_EQ(arraysize(reversed), PixelMapper_Map(m_output, m_slots, 9u));
+  EXPECT_THAT(ArrayTuple(m_output, arraysize(reversed)),
+              DataIs(reversed, arraysize(reversed)));
+}
+
+TEST_F(PixelMapperTest, shortFrame) {
+  // Pixels without slot data are set to 0.
+  Configure(1u, 3u, 1u, PIXEL_ORDER_RGB, false);
+  const uint8_t expected[] = {1, 2, 3, 4, 0, 0, 0, 0, 0};
+  EXPECT_EQ(arraysize(expected), PixelMapper_Map(m_output, m_slots, 4u));
+  EXPECT_THAT(ArrayTuple(m_output, arraysize(expected)),
+              DataIs(expected, arraysize(expected)));
+}
+
+TEST_F(PixelMapperTest, fullUniverse) {
+  Configure(1u, PIXEL_MAPPER_MAX_PIXELS, 1u, PIXEL_ORDER_RGB, false);
+  EXPECT_EQ(510u, PixelMapper_Footprint());
+  EXPECT_EQ(510u, PixelMapper_Map(m_output, m_slots, DMX_FRAME_SIZE));
+  EXPECT_THAT(ArrayTuple(m_output, 510u), DataIs(m_slots, 510u));
+  EXPECT_EQ(0xff, m_output[510]);
+}
+
+TEST_F(PixelMapperTest, outOfRange) {
+  Configure(0u, PIXEL_MAPPER_MAX_PIXELS + 1u, 0u, PIXEL_ORDER_RGB, false);
+  EXPECT_EQ(1u, PixelMapper_StartAddress());
+  EXPECT_EQ(PIXEL_MAPPER_MAX_PIXELS, PixelMapper_PixelCount());
+  EXPECT_EQ(510u, PixelMapper_Footprint());
+
+  Configure(DMX_FRAME_SIZE + 1u, 0u, 1u, PIXEL_ORDER_RGB, false);
+  EXPECT_EQ(1u, PixelMapper_StartAddress());
+  EXPECT_EQ(0u, PixelMapper_Footprint());
+  EXPECT_EQ(0u, PixelMapper_Map(m_output, m_slots, DMX_FRAME_SIZE));
+}
+
+TEST_F(PixelMapperTest, bgrOrder) {
+  Configure(1u, 2u, 1u, PIXEL_ORDER_BGR, false);
+  const uint8_t expected[] = {3, 2, 1, 6, 5, 4};
+  EXPECT_EQ(arraysize(expected), PixelMapper_Map(m_output, m_slots, 6u));
+  EXPECT_THAT(ArrayTuple(m_output, arraysize(expected)),
+              DataIs(expected, arraysize(expected)));
+}
@@ -22,6 +22,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "responder.h"
 #include "receiver_counters.h"
@@ -29,8 +30,13 @@
 #include "Matchers.h"
 #include "RDMHandlerMock.h"
 #include "SPIRGBMock.h"
+#include "dmx_snapshot.h"
+#include "dmx_spec.h"
+#include "pixel_mapper.h"
 
+using ::testing::ElementsAreArray;
 using ::testing::IgnoreResult;
+using ::testing::Invoke;
 using ::testing::Return;
 using ::testing::StrictMock;
 using ::testing::WithArgs;
@@ -67,9 +73,14 @@ class ResponderTest : public testing::Test {
     }
   }
 
+  void SetPixels(const uint8_t *data, uint16_t pixel_count) {
+    m_pixels.assign(data, data + pixel_count * PIXEL_MAPPER_SLOTS_PER_PIXEL);
+  }
+
  protected:
   StrictMock<MockRDMHandler> handler_mock;
   MockSPIRGB spi_mock;
+  std::vector<uint8_t> m_pixels;
 
   static const uint8_t TEST_UID[];
   static const uint8_t ASC_FRAME[];
@@ -287,18 +298,90 @@ TEST_F(ResponderTest, SPIOutput) {
   spi_config.module_id = SPI_ID_1;
   spi_config.baud_rate = 2000000;
   spi_config.use_enhanced_buffering = false;
+  spi_config.use_dma = false;
   SPIRGB_Init(&spi_config);
 
   EXPECT_CALL(spi_mock, BeginUpdate())
     .Times(1);
-  EXPECT_CALL(spi_mock, SetPixel(0, RED, 1)).Times(1);
-  EXPECT_CALL(spi_mock, SetPixel(0, GREEN, 2)).Times(1);
-  EXPECT_CALL(spi_mock, SetPixel(0, BLUE, 3)).Times(1);
-  EXPECT_CALL(spi_mock, SetPixel(1, RED, 4)).Times(1);
-  EXPECT_CALL(spi_mock, SetPixel(1, GREEN, 5)).Times(1);
-  EXPECT_CALL(spi_mock, SetPixel(1, BLUE, 6)).Times(1);
+  EXPECT_CALL(spi_mock, SetPixels(_, 2))
+    .WillOnce(Invoke(this, &ResponderTest::SetPixels));
   EXPECT_CALL(spi_mock, CompleteUpdate())
     .Times(1);
 
+  // The SPI output is updated from task context, once the frame completes.
   SendFrame(DMX_FRAME, arraysize(DMX_FRAME));
+  Responder_Tasks();
+  SendFrame(RDM_FRAME, 1);
+  Responder_Tasks();
+  Responder_Tasks();
+
+  // The default mapping is 2 GRB pixels.
+  const uint8_t expected[] = {2, 1, 3, 5, 4, 6};
+  EXPECT_THAT(m_pixels, ElementsAreArray(expected));
+}
+
+TEST_F(ResponderTest, SPIOutputStartAddress) {
+  PixelMapperSettings settings;
+  settings.start_address = 40;
+  settings.pixel_count = 3;
+  settings.group_size = 1;
+  settings.order = PIXEL_ORDER_RGB;
+  settings.reverse = false;
+  PixelMapper_Configure(&settings);
+
+  EXPECT_CALL(spi_mock, BeginUpdate())
+    .Times(2);
+  EXPECT_CALL(spi_mock, SetPixels(_, 3))
+    .Times(2)
+    .WillRepeatedly(Invoke(this, &ResponderTest::SetPixels));
+  EXPECT_CALL(spi_mock, CompleteUpdate())
+    .Times(2);
+
+  // The frame ends part way through the 2nd pixel.
+  SendFrame(LONG_DMX_FRAME, arraysize(LONG_DMX_FRAME));
+  SendFrame(RDM_FRAME, 1);
+  Responder_Tasks();
+
+  const uint8_t expected[] = {40, 41, 42, 43, 44, 45, 0, 0, 0};
+  EXPECT_THAT(m_pixels, ElementsAreArray(expected));
+
+  // A frame which ends before the start address.
+  SendFrame(DMX_FRAME, arraysize(DMX_FRAME));
+  SendFrame(RDM_FRAME, 1);
+  Responder_Tasks();
+
+  const uint8_t expected2[] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+  EXPECT_THAT(m_pixels, ElementsAreArray(expected2));
 }
+
+TEST_F(ResponderTest, dmxSnapshot) {
+  uint8_t slots[DMX_FRAME_SIZE];
+  uint16_t slot_count;
+
+  // The frame is complete when the next frame starts.
+  SendFrame(DMX_FRAME, arraysize(DMX_FRAME), 4);
+  EXPECT_EQ(0u, DMXSnapshot_Generation());
+
+  SendFrame(ASC_FRAME, arraysize(ASC_FRAME));
+  EXPECT_EQ(1u, DMXSnapshot_Read(slots, 0u, arraysize(slots), &slot_count));
+  EXPECT_THAT(ArrayTuple(slots, slot_count),
+              DataIs(DMX_FRAME + 1, arraysize(DMX_FRAME) - 1));
+
+  // Or when it times out.
+  SendFrame(SHORT_DMX_FRAME, arraysize(SHORT_DMX_FRAME));
+  TransceiverEvent event = {
+    0, T_OP_RX, T_RESULT_RX_FRAME_TIMEOUT, SHORT_DMX_FRAME,
+    arraysize(SHORT_DMX_FRAME), NULL
+  };
+  Responder_Receive(&event);
+  EXPECT_EQ(2u, DMXSnapshot_Read(slots, 0u, arraysize(slots), &slot_count));
+  EXPECT_THAT(ArrayTuple(slots, slot_count),
+              DataIs(SHORT_DMX_FRAME + 1, arraysize(SHORT_DMX_FRAME) - 1));
+
+  // RDM frames don't change the snapshot.
+  EXPECT_CALL(handler_mock, HandleRequest(_, NULL)).Times(2);
+  SendFrame(RDM_FRAME, arraysize(RDM_FRAME));
+  SendFrame(RDM_FRAME, arraysize(RDM_FRAME));
+  EXPECT_EQ(2u, DMXSnapshot_Generation());
+}
+
@@ -19,37 +19,89 @@
  */
 
 #include <gtest/gtest.h>
+#include <string.h>
 #include <vector>
 
 #include "spi_rgb.h"
 #include "Array.h"
+#include "CoarseTimerMock.h"
 #include "Matchers.h"
+#include "plib_dma_mock.h"
 #include "plib_spi_mock.h"
 
 using ::testing::ElementsAreArray;
 using ::testing::Invoke;
+using ::testing::IsEmpty;
+using ::testing::Mock;
+using ::testing::NiceMock;
 using ::testing::Return;
+using ::testing::SaveArg;
 using ::testing::StrictMock;
 using ::testing::WithArgs;
 using ::testing::_;
 
 class SPIRGBTest : public testing::Test {
  public:
+  SPIRGBTest() : m_tx_budget(0), m_now(1000u) {}
+
   void SetUp() {
     PLIB_SPI_SetMock(&spi_mock);
+    PLIB_DMA_SetMock(&dma_mock);
+    CoarseTimer_SetMock(&m_timer);
+    ON_CALL(m_timer, GetMicroseconds())
+      .WillByDefault(Invoke(this, &SPIRGBTest::Now));
   }
 
   void TearDown() {
     PLIB_SPI_SetMock(NULL);
+    PLIB_DMA_SetMock(NULL);
+    CoarseTimer_SetMock(NULL);
+  }
+
+  uint32_t Now() {
+    return m_now;
   }
 
   void AppendByte(uint8_t byte) {
     m_spi_data.push_back(byte);
   }
 
+  // The SPI module is busy once m_tx_budget bytes have been written.
+  bool IsBusy() {
+    if (m_tx_budget == 0) {
+      return true;
+    }
+    m_tx_budget--;
+    return false;
+  }
+
+  void ExpectSPIInit(uint32_t baud_rate) {
+    EXPECT_CALL(spi_mock, BaudRateSet(SPI_ID_1, _, baud_rate))
+      .Times(1);
+    EXPECT_CALL(spi_mock,
+                CommunicationWidthSelect(SPI_ID_1,
+                                         SPI_COMMUNICATION_WIDTH_8BITS))
+      .Times(1);
+    EXPECT_CALL(spi_mock,
+                ClockPolaritySelect(SPI_ID_1, SPI_CLOCK_POLARITY_IDLE_HIGH))
+      .Times(1);
+    EXPECT_CALL(spi_mock, SlaveSelectDisable(SPI_ID_1))
+      .Times(1);
+    EXPECT_CALL(spi_mock, PinDisable(SPI_ID_1, SPI_PIN_SLAVE_SELECT))
+      .Times(1);
+    EXPECT_CALL(spi_mock, Enable(SPI_ID_1))
+      .Times(1);
+    EXPECT_CALL(spi_mock, MasterEnable(SPI_ID_1))
+      .Times(1);
+  }
+
  protected:
   StrictMock<MockPeripheralSPI> spi_mock;
+  StrictMock<MockPeripheralDMA> dma_mock;
+  NiceMock<MockCoarseTimer> m_timer;
   std::vector<uint8_t> m_spi_data;
+  unsigned int m_tx_budget;
+  uint32_t m_now;
 };
 
 TEST_F(SPIRGBTest, testSimpleMode) {
@@ -57,6 +109,7 @@ TEST_F(SPIRGBTest, testSimpleMode) {
   config.module_id = SPI_ID_1;
   config.baud_rate = 2000000;
   config.use_enhanced_buffering = false;
+  config.use_dma = false;
 
   EXPECT_CALL(spi_mock, BaudRateSet(SPI_ID_1, _, 2000000))
     .Times(1);
@@ -116,6 +169,7 @@ TEST_F(SPIRGBTest, testEnhancedMode) {
   config.module_id = SPI_ID_1;
   config.baud_rate = 4000000;
   config.use_enhanced_buffering = true;
+  config.use_dma = false;
 
   EXPECT_CALL(spi_mock, BaudRateSet(SPI_ID_1, _, 4000000))
     .Times(1);
@@ -171,3 +225,472 @@ TEST_F(SPIRGBTest, testEnhancedMode) {
   };
   EXPECT_THAT(m_spi_data, ElementsAreArray(expected2));
 }
+
+TEST_F(SPIRGBTest, testSetPixels) {
+  SPIRGBConfiguration config;
+  config.module_id = SPI_ID_1;
+  config.baud_rate = 2000000;
+  config.use_enhanced_buffering = false;
+  config.use_dma = false;
+
+  EXPECT_CALL(spi_mock, BaudRateSet(SPI_ID_1, _, 2000000))
+    .Times(1);
+  EXPECT_CALL(spi_mock,
+              CommunicationWidthSelect(SPI_ID_1, SPI_COMMUNICATION_WIDTH_8BITS))
+    .Times(1);
+  EXPECT_CALL(spi_mock,
+              ClockPolaritySelect(SPI_ID_1, SPI_CLOCK_POLARITY_IDLE_HIGH))
+    .Times(1);
+  EXPECT_CALL(spi_mock, SlaveSelectDisable(SPI_ID_1))
+    .Times(1);
+  EXPECT_CALL(spi_mock, PinDisable(SPI_ID_1, SPI_PIN_SLAVE_SELECT))
+    .Times(1);
+  EXPECT_CALL(spi_mock, Enable(SPI_ID_1))
+    .Times(1);
+  EXPECT_CALL(spi_mock, MasterEnable(SPI_ID_1))
+    .Times(1);
+  EXPECT_CALL(spi_mock, IsBusy(SPI_ID_1))
+    .WillRepeatedly(Return(false));
+  EXPECT_CALL(spi_mock, BufferWrite(SPI_ID_1, _))
+    .WillRepeatedly(WithArgs<1>(Invoke(this, &SPIRGBTest::AppendByte)));
+
+  SPIRGB_Init(&config);
+
+  // Pixels can't be set outside of an update.
+  const uint8_t data[] = {255, 128, 0};
+  SPIRGB_SetPixels(data, 1);
+
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixels(data, 1);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  const uint8_t expected[] = {0xff, 0xc0, 0x80, 0};
+  EXPECT_THAT(m_spi_data, ElementsAreArray(expected));
+  m_spi_data.clear();
+
+  // 33 pixels need 2 latch bytes.
+  uint8_t long_data[33 * 3];
+  memset(long_data, 2, sizeof(long_data));
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixels(long_data, 33);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  std::vector<uint8_t> expected2(33 * 3, 0x81);
+  expected2.push_back(0);
+  expected2.push_back(0);
+  EXPECT_THAT(m_spi_data, ElementsAreArray(expected2));
+}
+
+TEST_F(SPIRGBTest, testDoubleBuffering) {
+  SPIRGBConfiguration config;
+  config.module_id = SPI_ID_1;
+  config.baud_rate = 2000000;
+  config.use_enhanced_buffering = false;
+  config.use_dma = false;
+
+  ExpectSPIInit(2000000);
+  EXPECT_CALL(spi_mock, IsBusy(SPI_ID_1))
+    .WillRepeatedly(Invoke(this, &SPIRGBTest::IsBusy));
+  EXPECT_CALL(spi_mock, BufferWrite(SPI_ID_1, _))
+    .WillRepeatedly(WithArgs<1>(Invoke(this, &SPIRGBTest::AppendByte)));
+
+  SPIRGB_Init(&config);
+
+  // The SPI module can only accept 2 bytes of the frame.
+  const uint8_t first[] = {2, 4, 6};
+  m_tx_budget = 2;
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixels(first, 1);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  const uint8_t expected[] = {0x81, 0x82};
+  EXPECT_THAT(m_spi_data, ElementsAreArray(expected));
+  m_spi_data.clear();
+
+  // Updates while the frame is being sent don't change it, and only the last
+  // one is sent.
+  const uint8_t second[] = {8, 10, 12};
+  const uint8_t third[] = {14, 16, 18};
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixels(second, 1);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixels(third, 1);
+  SPIRGB_CompleteUpdate();
+  EXPECT_TRUE(m_spi_data.empty());
+
+  m_tx_budget = 100;
+  SPIRGB_Tasks();
+  const uint8_t expected2[] = {0x83, 0, 0x87, 0x88, 0x89, 0};
+  EXPECT_THAT(m_spi_data, ElementsAreArray(expected2));
+  m_spi_data.clear();
+
+  // The frame isn't sent until the update completes.
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixel(0, RED, 0xff);
+  SPIRGB_Tasks();
+  EXPECT_TRUE(m_spi_data.empty());
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  // The update starts from the last frame sent.
+  const uint8_t expected3[] = {0x87, 0xff, 0x89, 0};
+  EXPECT_THAT(m_spi_data, ElementsAreArray(expected3));
+}
+
+TEST_F(SPIRGBTest, testDMA) {
+  SPIRGBConfiguration config;
+  config.module_id = SPI_ID_1;
+  config.baud_rate = 4000000;
+  config.use_enhanced_buffering = true;
+  config.use_dma = true;
+  config.dma_channel = DMA_CHANNEL_3;
+
+  uint32_t spi_buffer = 0;
+  ExpectSPIInit(4000000);
+  EXPECT_CALL(spi_mock, FIFOEnable(SPI_ID_1))
+    .Times(1);
+  EXPECT_CALL(spi_mock,
+              FIFOInterruptModeSelect(
+                  SPI_ID_1,
+                  SPI_FIFO_INTERRUPT_WHEN_TRANSMIT_BUFFER_IS_NOT_FULL))
+    .Times(1);
+  EXPECT_CALL(spi_mock, BufferAddressGet(SPI_ID_1))
+    .WillOnce(Return(&spi_buffer));
+
+  EXPECT_CALL(dma_mock, Enable(DMA_ID_0))
+    .Times(1);
+  EXPECT_CALL(dma_mock,
+              ChannelXTriggerEnable(DMA_ID_0, DMA_CHANNEL_3,
+                                    DMA_CHANNEL_TRIGGER_TRANSFER_START))
+    .Times(1);
+  EXPECT_CALL(dma_mock,
+              ChannelXStartIRQSet(DMA_ID_0, DMA_CHANNEL_3,
+                                  DMA_TRIGGER_SPI_1_TRANSMIT))
+    .Times(1);
+  EXPECT_CALL(dma_mock,
+              ChannelXDestinationStartAddressSet(
+                  DMA_ID_0, DMA_CHANNEL_3,
+                  static_cast<uint32_t>(
+                      reinterpret_cast<uintptr_t>(&spi_buffer))))
+    .Times(1);
+  EXPECT_CALL(dma_mock, ChannelXDestinationSizeSet(DMA_ID_0, DMA_CHANNEL_3, 1))
+    .Times(1);
+  EXPECT_CALL(dma_mock, ChannelXCellSizeSet(DMA_ID_0, DMA_CHANNEL_3, 1))
+    .Times(1);
+
+  SPIRGB_Init(&config);
+  Mock::VerifyAndClearExpectations(&dma_mock);
+  EXPECT_CALL(spi_mock, TransmitBufferIsFull(SPI_ID_1))
+    .WillRepeatedly(Return(false));
+
+  // The first frame starts immediately.
+  uint32_t first_address = 0;
+  EXPECT_CALL(dma_mock,
+              ChannelXSourceStartAddressSet(DMA_ID_0, DMA_CHANNEL_3, _))
+    .WillOnce(SaveArg<2>(&first_address));
+  EXPECT_CALL(dma_mock, ChannelXSourceSizeSet(DMA_ID_0, DMA_CHANNEL_3, 4))
+    .Times(1);
+  EXPECT_CALL(dma_mock, ChannelXEnable(DMA_ID_0, DMA_CHANNEL_3))
+    .Times(1);
+  EXPECT_CALL(dma_mock, StartTransferSet(DMA_ID_0, DMA_CHANNEL_3))
+    .Times(1);
+
+  const uint8_t data[] = {255, 128, 0};
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixels(data, 1);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+  Mock::VerifyAndClearExpectations(&dma_mock);
+
+  // The next frame waits for the transfer to complete.
+  uint8_t long_data[33 * 3];
+  memset(long_data, 2, sizeof(long_data));
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixels(long_data, 33);
+  SPIRGB_CompleteUpdate();
+
+  EXPECT_CALL(dma_mock,
+              ChannelXINTSourceFlagGet(DMA_ID_0, DMA_CHANNEL_3,
+                                       DMA_INT_BLOCK_TRANSFER_COMPLETE))
+    .WillOnce(Return(false));
+  SPIRGB_Tasks();
+  Mock::VerifyAndClearExpectations(&dma_mock);
+
+  uint32_t second_address = 0;
+  EXPECT_CALL(dma_mock,
+              ChannelXINTSourceFlagGet(DMA_ID_0, DMA_CHANNEL_3,
+                                       DMA_INT_BLOCK_TRANSFER_COMPLETE))
+    .WillOnce(Return(true));
+  EXPECT_CALL(dma_mock,
+              ChannelXINTSourceFlagClear(DMA_ID_0, DMA_CHANNEL_3,
+                                         DMA_INT_BLOCK_TRANSFER_COMPLETE))
+    .Times(1);
+  EXPECT_CALL(dma_mock,
+              ChannelXSourceStartAddressSet(DMA_ID_0, DMA_CHANNEL_3, _))
+    .WillOnce(SaveArg<2>(&second_address));
+  EXPECT_CALL(dma_mock,
+              ChannelXSourceSizeSet(DMA_ID_0, DMA_CHANNEL_3, 33 * 3 + 2))
+    .Times(1);
+  EXPECT_CALL(dma_mock, ChannelXEnable(DMA_ID_0, DMA_CHANNEL_3))
+    .Times(1);
+  EXPECT_CALL(dma_mock, StartTransferSet(DMA_ID_0, DMA_CHANNEL_3))
+    .Times(1);
+  SPIRGB_Tasks();
+  Mock::VerifyAndClearExpectations(&dma_mock);
+
+  // The frames are sent from different buffers.
+  EXPECT_NE(first_address, second_address);
+
+  // Nothing more to send once the transfer completes.
+  EXPECT_CALL(dma_mock,
+              ChannelXINTSourceFlagGet(DMA_ID_0, DMA_CHANNEL_3,
+                                       DMA_INT_BLOCK_TRANSFER_COMPLETE))
+    .WillOnce(Return(true));
+  EXPECT_CALL(dma_mock,
+              ChannelXINTSourceFlagClear(DMA_ID_0, DMA_CHANNEL_3,
+                                         DMA_INT_BLOCK_TRANSFER_COMPLETE))
+    .Times(1);
+  SPIRGB_Tasks();
+  SPIRGB_Tasks();
+}
+
+TEST_F(SPIRGBTest, testDMABlocks) {
+  SPIRGBConfiguration config;
+  config.module_id = SPI_ID_1;
+  config.baud_rate = 4000000;
+  config.use_enhanced_buffering = true;
+  config.use_dma = true;
+  config.dma_channel = DMA_CHANNEL_3;
+
+  uint32_t spi_buffer = 0;
+  ExpectSPIInit(4000000);
+  EXPECT_CALL(spi_mock, FIFOEnable(SPI_ID_1))
+    .Times(1);
+  EXPECT_CALL(spi_mock, FIFOInterruptModeSelect(SPI_ID_1, _))
+    .Times(1);
+  EXPECT_CALL(spi_mock, BufferAddressGet(SPI_ID_1))
+    .WillOnce(Return(&spi_buffer));
+  EXPECT_CALL(dma_mock, Enable(DMA_ID_0));
+  EXPECT_CALL(dma_mock, ChannelXTriggerEnable(DMA_ID_0, DMA_CHANNEL_3, _));
+  EXPECT_CALL(dma_mock, ChannelXStartIRQSet(DMA_ID_0, DMA_CHANNEL_3, _));
+  EXPECT_CALL(dma_mock,
+              ChannelXDestinationStartAddressSet(DMA_ID_0, DMA_CHANNEL_3, _));
+  EXPECT_CALL(dma_mock, ChannelXDestinationSizeSet(DMA_ID_0, DMA_CHANNEL_3, 1));
+  EXPECT_CALL(dma_mock, ChannelXCellSizeSet(DMA_ID_0, DMA_CHANNEL_3, 1));
+  SPIRGB_Init(&config);
+  Mock::VerifyAndClearExpectations(&dma_mock);
+  Mock::VerifyAndClearExpectations(&spi_mock);
+
+  // 170 LPD8806 pixels is 510 bytes of pixel data & a 6 byte latch. The DMA
+  // source size is limited to 256 bytes, so the frame is sent in 3 blocks.
+  uint8_t data[SPIRGB_MAX_PIXELS * 3];
+  memset(data, 1, sizeof(data));
+
+  // Each block waits until the transmit buffer has space.
+  EXPECT_CALL(spi_mock, TransmitBufferIsFull(SPI_ID_1))
+    .WillOnce(Return(true));
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixels(data, SPIRGB_MAX_PIXELS);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+  Mock::VerifyAndClearExpectations(&spi_mock);
+
+  const uint16_t block_sizes[] = {256, 256, 4};
+  uint32_t addresses[arraysize(block_sizes)];
+  for (unsigned int i = 0; i < arraysize(block_sizes); i++) {
+    if (i) {
+      EXPECT_CALL(dma_mock,
+                  ChannelXINTSourceFlagGet(DMA_ID_0, DMA_CHANNEL_3,
+                                           DMA_INT_BLOCK_TRANSFER_COMPLETE))
+        .WillOnce(Return(true));
+      EXPECT_CALL(dma_mock,
+                  ChannelXINTSourceFlagClear(DMA_ID_0, DMA_CHANNEL_3,
+                                             DMA_INT_BLOCK_TRANSFER_COMPLETE))
+        .Times(1);
+    }
+    EXPECT_CALL(spi_mock, TransmitBufferIsFull(SPI_ID_1))
+      .WillOnce(Return(false));
+    EXPECT_CALL(dma_mock,
+                ChannelXSourceStartAddressSet(DMA_ID_0, DMA_CHANNEL_3, _))
+      .WillOnce(SaveArg<2>(&addresses[i]));
+    EXPECT_CALL(dma_mock,
+                ChannelXSourceSizeSet(DMA_ID_0, DMA_CHANNEL_3, block_sizes[i]))
+      .Times(1);
+    EXPECT_CALL(dma_mock, ChannelXEnable(DMA_ID_0, DMA_CHANNEL_3))
+      .Times(1);
+    EXPECT_CALL(dma_mock, StartTransferSet(DMA_ID_0, DMA_CHANNEL_3))
+      .Times(1);
+    SPIRGB_Tasks();
+    Mock::VerifyAndClearExpectations(&dma_mock);
+    Mock::VerifyAndClearExpectations(&spi_mock);
+  }
+  EXPECT_EQ(addresses[0] + 256u, addresses[1]);
+  EXPECT_EQ(addresses[1] + 256u, addresses[2]);
+
+  // The frame is complete after the last block.
+  EXPECT_CALL(dma_mock,
+              ChannelXINTSourceFlagGet(DMA_ID_0, DMA_CHANNEL_3,
+                                       DMA_INT_BLOCK_TRANSFER_COMPLETE))
+    .WillOnce(Return(true));
+  EXPECT_CALL(dma_mock,
+              ChannelXINTSourceFlagClear(DMA_ID_0, DMA_CHANNEL_3,
+                                         DMA_INT_BLOCK_TRANSFER_COMPLETE))
+    .Times(1);
+  SPIRGB_Tasks();
+  SPIRGB_Tasks();
+}
+
+TEST_F(SPIRGBTest, testPixelType) {
+  SPIRGBConfiguration config;
+  config.module_id = SPI_ID_1;
+  config.baud_rate = 2000000;
+  config.use_enhanced_buffering = false;
+  config.use_dma = false;
+
+  ExpectSPIInit(2000000);
+  EXPECT_CALL(spi_mock, IsBusy(SPI_ID_1))
+    .WillRepeatedly(Invoke(this, &SPIRGBTest::IsBusy));
+  EXPECT_CALL(spi_mock, BufferWrite(SPI_ID_1, _))
+    .WillRepeatedly(WithArgs<1>(Invoke(this, &SPIRGBTest::AppendByte)));
+
+  SPIRGB_Init(&config);
+  Mock::VerifyAndClearExpectations(&spi_mock);
+  EXPECT_CALL(spi_mock, IsBusy(SPI_ID_1))
+    .WillRepeatedly(Invoke(this, &SPIRGBTest::IsBusy));
+  EXPECT_CALL(spi_mock, BufferWrite(SPI_ID_1, _))
+    .WillRepeatedly(WithArgs<1>(Invoke(this, &SPIRGBTest::AppendByte)));
+
+  EXPECT_FALSE(SPIRGB_SetPixelType(static_cast<PixelType>(0)));
+
+  m_tx_budget = 100;
+  const uint8_t data[] = {0x80, 0x00, 0xff};
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixels(data, 1);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  const uint8_t lpd8806[] = {0xc0, 0x80, 0xff, 0};
+  EXPECT_THAT(m_spi_data, ElementsAreArray(lpd8806));
+  m_spi_data.clear();
+
+  // Changing the type re-sends the last update.
+  EXPECT_TRUE(SPIRGB_SetPixelType(PIXEL_TYPE_APA102));
+  SPIRGB_Tasks();
+  const uint8_t apa102[] = {0, 0, 0, 0, 0xff, 0x80, 0x00, 0xff, 0};
+  EXPECT_THAT(m_spi_data, ElementsAreArray(apa102));
+  m_spi_data.clear();
+
+  // SetPixel uses the color order of the pixel type.
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixel(0, RED, 0x12);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+  const uint8_t apa102_red[] = {0, 0, 0, 0, 0xff, 0x80, 0x00, 0x12, 0};
+  EXPECT_THAT(m_spi_data, ElementsAreArray(apa102_red));
+  m_spi_data.clear();
+
+  // The WS2812 needs a 2.4MHz clock, the baud rate is changed before the
+  // frame is sent, once the SPI module is idle.
+  m_tx_budget = 0;
+  EXPECT_TRUE(SPIRGB_SetPixelType(PIXEL_TYPE_WS2812));
+  SPIRGB_Tasks();
+  EXPECT_THAT(m_spi_data, IsEmpty());
+
+  EXPECT_CALL(spi_mock, Disable(SPI_ID_1))
+    .Times(1);
+  EXPECT_CALL(spi_mock, BaudRateSet(SPI_ID_1, _, 2400000))
+    .Times(1);
+  EXPECT_CALL(spi_mock, Enable(SPI_ID_1))
+    .Times(1);
+  m_tx_budget = 100;
+  SPIRGB_Tasks();
+  EXPECT_EQ(9u + 24u, m_spi_data.size());
+  m_spi_data.clear();
+  Mock::VerifyAndClearExpectations(&spi_mock);
+
+  // And restored for the other types.
+  EXPECT_CALL(spi_mock, IsBusy(SPI_ID_1))
+    .WillRepeatedly(Invoke(this, &SPIRGBTest::IsBusy));
+  EXPECT_CALL(spi_mock, BufferWrite(SPI_ID_1, _))
+    .WillRepeatedly(WithArgs<1>(Invoke(this, &SPIRGBTest::AppendByte)));
+  EXPECT_CALL(spi_mock, Disable(SPI_ID_1))
+    .Times(1);
+  EXPECT_CALL(spi_mock, BaudRateSet(SPI_ID_1, _, 2000000))
+    .Times(1);
+  EXPECT_CALL(spi_mock,
+              ClockPolaritySelect(SPI_ID_1, SPI_CLOCK_POLARITY_IDLE_LOW))
+    .Times(1);
+  EXPECT_CALL(spi_mock, Enable(SPI_ID_1))
+    .Times(1);
+  m_tx_budget = 100;
+  EXPECT_TRUE(SPIRGB_SetPixelType(PIXEL_TYPE_WS2801));
+  SPIRGB_Tasks();
+  const uint8_t ws2801[] = {0x80, 0x00, 0x12};
+  EXPECT_THAT(m_spi_data, ElementsAreArray(ws2801));
+}
+
+TEST_F(SPIRGBTest, testWS2801Latch) {
+  SPIRGBConfiguration config;
+  config.module_id = SPI_ID_1;
+  config.baud_rate = 2000000;
+  config.use_enhanced_buffering = false;
+  config.use_dma = false;
+
+  ExpectSPIInit(2000000);
+  SPIRGB_Init(&config);
+  Mock::VerifyAndClearExpectations(&spi_mock);
+  EXPECT_CALL(spi_mock, IsBusy(SPI_ID_1))
+    .WillRepeatedly(Invoke(this, &SPIRGBTest::IsBusy));
+  EXPECT_CALL(spi_mock, BufferWrite(SPI_ID_1, _))
+    .WillRepeatedly(WithArgs<1>(Invoke(this, &SPIRGBTest::AppendByte)));
+
+  // The WS2801 clock idles low.
+  EXPECT_CALL(spi_mock, Disable(SPI_ID_1))
+    .Times(1);
+  EXPECT_CALL(spi_mock,
+              ClockPolaritySelect(SPI_ID_1, SPI_CLOCK_POLARITY_IDLE_LOW))
+    .Times(1);
+  EXPECT_CALL(spi_mock, Enable(SPI_ID_1))
+    .Times(1);
+  m_tx_budget = 100;
+  const uint8_t data[] = {0x80, 0x00, 0x12};
+  EXPECT_TRUE(SPIRGB_SetPixelType(PIXEL_TYPE_WS2801));
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixels(data, 1);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+  EXPECT_THAT(m_spi_data, ElementsAreArray(data));
+  m_spi_data.clear();
+
+  const uint8_t data2[] = {0x01, 0x02, 0x03};
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixels(data2, 1);
+  SPIRGB_CompleteUpdate();
+
+  // The latch time starts once the last byte has been sent.
+  m_tx_budget = 0;
+  m_now += 1000u;
+  SPIRGB_Tasks();
+  EXPECT_THAT(m_spi_data, IsEmpty());
+
+  m_tx_budget = 100;
+  SPIRGB_Tasks();
+  EXPECT_THAT(m_spi_data, IsEmpty());
+
+  // The clock must stay low for 500us.
+  uint32_t delay = 0u;
+  EXPECT_TRUE(SPIRGB_NextDeadline(&delay));
+  EXPECT_EQ(1u, delay);
+  m_now += 499u;
+  SPIRGB_Tasks();
+  EXPECT_THAT(m_spi_data, IsEmpty());
+
+  m_now++;
+  SPIRGB_Tasks();
+  EXPECT_THAT(m_spi_data, ElementsAreArray(data2));
+}
@@ -0,0 +1,127 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * SchedulerTest.cpp
+ * Tests for the main loop scheduler.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+
+#include "scheduler.h"
+
+class SchedulerTest : public testing::Test {
+ public:
+  void SetUp() {
+    Scheduler_Initialize();
+  }
+};
+
+TEST_F(SchedulerTest, noWork) {
+  EXPECT_FALSE(Scheduler_HasWork());
+  EXPECT_FALSE(Scheduler_Take(SCHEDULER_TICK));
+  EXPECT_FALSE(Scheduler_Take(SCHEDULER_TRANSCEIVER));
+  EXPECT_FALSE(Scheduler_Take(SCHEDULER_HOST));
+}
+
+TEST_F(SchedulerTest, postAndTake) {
+  Scheduler_Post(SCHEDULER_TRANSCEIVER);
+  EXPECT_TRUE(Scheduler_HasWork());
+  EXPECT_FALSE(Scheduler_Take(SCHEDULER_TICK));
+  EXPECT_FALSE(Scheduler_Take(SCHEDULER_HOST));
+  EXPECT_TRUE(Scheduler_Take(SCHEDULER_TRANSCEIVER));
+
+  // Taking the work clears it.
+  EXPECT_FALSE(Scheduler_HasWork());
+  EXPECT_FALSE(Scheduler_Take(SCHEDULER_TRANSCEIVER));
+}
+
+TEST_F(SchedulerTest, postsCoalesce) {
+  Scheduler_Post(SCHEDULER_HOST);
+  Scheduler_Post(SCHEDULER_HOST);
+  Scheduler_Post(SCHEDULER_TICK);
+  EXPECT_TRUE(Scheduler_Take(SCHEDULER_HOST));
+  EXPECT_FALSE(Scheduler_Take(SCHEDULER_HOST));
+  EXPECT_TRUE(Scheduler_HasWork());
+  EXPECT_TRUE(Scheduler_Take(SCHEDULER_TICK));
+  EXPECT_FALSE(Scheduler_HasWork());
+}
+
+TEST_F(SchedulerTest, postAfterTake) {
+  // Work posted while the tasks run is picked up on the next pass.
+  Scheduler_Post(SCHEDULER_TICK);
+  EXPECT_TRUE(Scheduler_Take(SCHEDULER_TICK));
+  Scheduler_Post(SCHEDULER_TICK);
+  EXPECT_TRUE(Scheduler_HasWork());
+  EXPECT_TRUE(Scheduler_Take(SCHEDULER_TICK));
+}
+
+TEST_F(SchedulerTest, initializeClears) {
+  Scheduler_Post(SCHEDULER_TICK);
+  Scheduler_Post(SCHEDULER_HOST);
+  Scheduler_Initialize();
+  EXPECT_FALSE(Scheduler_HasWork());
+}
+
+TEST_F(SchedulerTest, wakeTime) {
+  // The tick isn't posted until a wake time is set.
+  Scheduler_TimerEvent(10u);
+  EXPECT_FALSE(Scheduler_HasWork());
+
+  Scheduler_SetWakeTime(12u);
+  Scheduler_TimerEvent(11u);
+  EXPECT_FALSE(Scheduler_HasWork());
+  Scheduler_TimerEvent(12u);
+  EXPECT_TRUE(Scheduler_Take(SCHEDULER_TICK));
+
+  // The wake time is cleared once it's reached.
+  Scheduler_TimerEvent(13u);
+  EXPECT_FALSE(Scheduler_HasWork());
+
+  // A wake time in the past posts the tick on the next timer event.
+  Scheduler_SetWakeTime(5u);
+  Scheduler_TimerEvent(14u);
+  EXPECT_TRUE(Scheduler_Take(SCHEDULER_TICK));
+
+  Scheduler_SetWakeTime(20u);
+  Scheduler_ClearWakeTime();
+  Scheduler_TimerEvent(20u);
+  EXPECT_FALSE(Scheduler_HasWork());
+}
+
+TEST_F(SchedulerTest, wakeTimeWraps) {
+  Scheduler_SetWakeTime(2u);
+  Scheduler_TimerEvent(UINT32_MAX);
+  EXPECT_FALSE(Scheduler_HasWork());
+  Scheduler_TimerEvent(1u);
+  EXPECT_FALSE(Scheduler_HasWork());
+  Scheduler_TimerEvent(2u);
+  EXPECT_TRUE(Scheduler_Take(SCHEDULER_TICK));
+}
+
+TEST_F(SchedulerTest, deadlineChanged) {
+  // The first pass always sets the wake time.
+  EXPECT_TRUE(Scheduler_TakeDeadlineChanged());
+  EXPECT_FALSE(Scheduler_TakeDeadlineChanged());
+
+  Scheduler_DeadlineChanged();
+  Scheduler_DeadlineChanged();
+  EXPECT_TRUE(Scheduler_TakeDeadlineChanged());
+  EXPECT_FALSE(Scheduler_TakeDeadlineChanged());
+
+  // A changed deadline isn't work, the tasks that changed it are running.
+  Scheduler_DeadlineChanged();
+  EXPECT_FALSE(Scheduler_HasWork());
+}
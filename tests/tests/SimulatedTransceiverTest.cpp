@@ -33,6 +33,7 @@
 #include "dmx_spec.h"
 #include "setting_macros.h"
 #include "transceiver.h"
+#include "transceiver_timing.h"
 
 #include "tests/sim/InterruptController.h"
 #include "tests/sim/PeripheralInputCapture.h"
@@ -238,9 +239,10 @@ class TransceiverTest : public testing::Test {
       // Run for another 6ms to allow any final states to timeout
       m_simulator.SetClockLimit(6000, false);
       m_simulator.Run();
-      // if we're in responder mode, then one buffer is used for the incoming
-      // frame.
-      if (Transceiver_GetMode() == T_MODE_RESPONDER) {
+      // if we're in responder or sniffer mode, then one buffer is used for
+      // the incoming frame.
+      if (Transceiver_GetMode() == T_MODE_RESPONDER ||
+          Transceiver_GetMode() == T_MODE_SNIFFER) {
         EXPECT_EQ(1, Transceiver_FreeBufferCount());
       } else {
         EXPECT_EQ(2, Transceiver_FreeBufferCount());
@@ -303,6 +305,7 @@ class TransceiverTest : public testing::Test {
 
   void SwitchToControllerMode();
   void SwitchToSelfTestMode();
+  void SwitchToSnifferMode();
 
   static const uint32_t kClockSpeed = 80000000;
   static const uint32_t kBaudRate = 250000;
@@ -362,6 +365,17 @@ void TransceiverTest::SwitchToSelfTestMode() {
   m_simulator.Run();
 }
 
+void TransceiverTest::SwitchToSnifferMode() {
+  uint8_t token = 1;
+  EXPECT_CALL(m_event_handler,
+              Run(EventIs(token, T_OP_MODE_CHANGE, T_RESULT_OK, 0)))
+    .WillOnce(DoAll(InvokeWithoutArgs(&m_simulator, &Simulator::Stop),
+                    Return(true)));
+
+  EXPECT_TRUE(Transceiver_SetMode(T_MODE_SNIFFER, token));
+  m_simulator.Run();
+}
+
 TEST_F(TransceiverTest, controllerTxDMX) {
   SwitchToControllerMode();
 
@@ -895,6 +909,8 @@ TEST_F(TransceiverTest, responderRxInterSlotDelay) {
 
   // we need more than 1s of runtime
   m_simulator.SetClockLimit(3000000, true);
+  // The timeouts here are long, so there's no need to poll every uS.
+  m_simulator.SetTaskInterval(kClockSpeed / 100000);
   m_generator.SetStopOnComplete(true);
   m_generator.AddDelay(100);
   m_generator.AddBreak(176);
@@ -1251,6 +1267,49 @@ TEST_F(TransceiverTest, responderRDMDUBWithJitter) {
   EXPECT_THAT(m_tx_bytes, MatchesFrame(kDUBResponse, arraysize(kDUBResponse)));
 }
 
+TEST_F(TransceiverTest, snifferRxRDMRequest) {
+  SwitchToSnifferMode();
+  EXPECT_EQ(T_MODE_SNIFFER, Transceiver_GetMode());
+
+  vector<uint8_t> rx_data;
+  EXPECT_CALL(m_event_handler,
+              Run(EventIs(0, T_OP_RX, _, Lt(arraysize(kRDMRequest)))))
+    .WillRepeatedly(Return(true));
+  EXPECT_CALL(
+      m_event_handler,
+      Run(AllOf(EventIs(0, T_OP_RX, T_RESULT_RX_CONTINUE_FRAME,
+                        arraysize(kRDMRequest)),
+                RequestTimingIs(1760, 120))))
+    .WillOnce(AppendTo(&rx_data));
+
+  m_generator.SetStopOnComplete(true);
+  m_generator.AddDelay(100);
+  m_generator.AddBreak(176);
+  m_generator.AddMark(12);
+  m_generator.AddFrame(kRDMRequest, arraysize(kRDMRequest));
+
+  m_simulator.Run();
+  EXPECT_THAT(rx_data, ElementsAreArray(kRDMRequest, arraysize(kRDMRequest)));
+
+  // The sniffer never transmits.
+  IOVec iovec = {
+    .base = kRDMResponse,
+    .length = arraysize(kRDMResponse)
+  };
+  EXPECT_FALSE(Transceiver_QueueRDMResponse(true, &iovec, 1));
+  EXPECT_CALL(m_event_handler,
+              Run(EventIs(0, T_OP_RX, T_RESULT_RX_FRAME_TIMEOUT,
+                          arraysize(kRDMRequest))))
+    .WillOnce(Return(true));
+  m_generator.Reset();
+  m_generator.SetStopOnComplete(false);
+  // kRDMRequest doesn't include the start code, so the DMX timeout applies.
+  m_simulator.SetClockLimit(RESPONDER_DMX_INTERSLOT_TIMEOUT * 100 + 1000,
+                            false);
+  m_simulator.Run();
+  EXPECT_THAT(m_tx_bytes, IsEmpty());
+}
+
 TEST_F(TransceiverTest, selfTestPass) {
   SwitchToSelfTestMode();
   uint8_t token = 2;
@@ -0,0 +1,261 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * SnifferTest.cpp
+ * Tests for the Sniffer code.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <vector>
+
+#include "Array.h"
+#include "CoarseTimerMock.h"
+#include "Matchers.h"
+#include "TransportMock.h"
+#include "constants.h"
+#include "dmx_spec.h"
+#include "sniffer.h"
+
+using ::testing::Args;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::StrictMock;
+using ::testing::_;
+using std::vector;
+
+class SnifferTest : public testing::Test {
+ public:
+  void SetUp() {
+    Transport_SetMock(&m_transport_mock);
+    CoarseTimer_SetMock(&m_timer_mock);
+    ON_CALL(m_timer_mock, GetTime()).WillByDefault(Return(0x01020304));
+    ON_CALL(m_timer_mock, HasElapsed(_, _)).WillByDefault(Return(true));
+    Sniffer_Initialize(Transport_Send);
+
+    m_timing.request.break_time = 1760;
+    m_timing.request.mark_time = 120;
+    for (unsigned int i = 0; i < arraysize(m_frame); i++) {
+      m_frame[i] = i;
+    }
+  }
+
+  void TearDown() {
+    CoarseTimer_SetMock(nullptr);
+    Transport_SetMock(nullptr);
+  }
+
+ protected:
+  StrictMock<MockTransport> m_transport_mock;
+  NiceMock<MockCoarseTimer> m_timer_mock;
+  TransceiverTiming m_timing;
+  uint8_t m_frame[DMX_FRAME_SIZE + 1];
+  vector<vector<uint8_t> > m_messages;
+
+  void Receive(TransceiverOperationResult result, unsigned int length) {
+    TransceiverEvent event = {
+      0, T_OP_RX, result, m_frame, length, &m_timing
+    };
+    Sniffer_Receive(&event);
+  }
+
+  // Send a complete frame, in two parts.
+  void ReceiveFrame(unsigned int length) {
+    Receive(T_RESULT_RX_START_FRAME, 1);
+    Receive(T_RESULT_RX_FRAME_TIMEOUT, length);
+  }
+
+  bool SaveMessage(uint8_t, Command, uint8_t, const IOVec* iov,
+                   unsigned int iov_count) {
+    vector<uint8_t> message;
+    for (unsigned int i = 0; i < iov_count; i++) {
+      const uint8_t *base = reinterpret_cast<const uint8_t*>(iov[i].base);
+      message.insert(message.end(), base, base + iov[i].length);
+    }
+    m_messages.push_back(message);
+    return true;
+  }
+
+  void CaptureMessages() {
+    EXPECT_CALL(m_transport_mock,
+                Send(EVENT_TOKEN, COMMAND_SNIFFER_DATA, RC_OK, _, 1))
+        .WillRepeatedly(testing::Invoke(this, &SnifferTest::SaveMessage));
+  }
+
+  static uint16_t ReadUInt16(const vector<uint8_t> &data, unsigned int i) {
+    return data[i] | (data[i + 1] << 8);
+  }
+
+  static uint32_t ReadUInt32(const vector<uint8_t> &data, unsigned int i) {
+    return ReadUInt16(data, i) | (ReadUInt16(data, i + 2) << 16);
+  }
+};
+
+TEST_F(SnifferTest, noFrames) {
+  Sniffer_Tasks();
+}
+
+TEST_F(SnifferTest, singleFrame) {
+  Receive(T_RESULT_RX_START_FRAME, 2);
+  Receive(T_RESULT_RX_CONTINUE_FRAME, 3);
+  Receive(T_RESULT_RX_FRAME_TIMEOUT, 4);
+
+  const uint8_t payload[] = {
+    0, 0, 0, 0,  // dropped
+    4, 3, 2, 1,  // timestamp
+    0xe0, 6,  // break
+    120, 0,  // mark
+    4, 0,  // length
+    0, 0,  // offset
+    0, 1, 2, 3
+  };
+  EXPECT_CALL(m_transport_mock,
+              Send(EVENT_TOKEN, COMMAND_SNIFFER_DATA, RC_OK, _, 1))
+      .With(Args<3, 4>(PayloadIs(payload, arraysize(payload))))
+      .WillOnce(Return(true));
+  Sniffer_Tasks();
+
+  // Nothing more to send.
+  Sniffer_Tasks();
+}
+
+TEST_F(SnifferTest, nextFrameClosesRecord) {
+  // A DMX frame that ends with a break has no timeout event.
+  Receive(T_RESULT_RX_START_FRAME, 3);
+  Sniffer_Tasks();
+
+  Receive(T_RESULT_RX_START_FRAME, 2);
+  CaptureMessages();
+  Sniffer_Tasks();
+
+  ASSERT_EQ(1u, m_messages.size());
+  EXPECT_EQ(4u + SNIFFER_FRAGMENT_HEADER_SIZE + 3u, m_messages[0].size());
+  EXPECT_EQ(3u, ReadUInt16(m_messages[0], 12));
+}
+
+TEST_F(SnifferTest, batching) {
+  EXPECT_CALL(m_timer_mock, HasElapsed(_, SNIFFER_FLUSH_INTERVAL))
+      .WillRepeatedly(Return(false));
+
+  // Small frames are held until the flush interval passes.
+  ReceiveFrame(24);
+  ReceiveFrame(24);
+  Sniffer_Tasks();
+
+  // Until there's enough data to fill a message.
+  CaptureMessages();
+  ReceiveFrame(DMX_FRAME_SIZE + 1);
+  Sniffer_Tasks();
+
+  ASSERT_EQ(1u, m_messages.size());
+  EXPECT_EQ(static_cast<size_t>(PAYLOAD_SIZE), m_messages[0].size());
+}
+
+TEST_F(SnifferTest, nextDeadline) {
+  EXPECT_CALL(m_timer_mock, HasElapsed(_, SNIFFER_FLUSH_INTERVAL))
+      .WillRepeatedly(Return(false));
+  EXPECT_CALL(m_timer_mock, ElapsedTime(_))
+      .WillRepeatedly(Return(5u));
+
+  uint32_t delay = 0u;
+  EXPECT_FALSE(Sniffer_NextDeadline(&delay));
+
+  // Batched records are due once the flush interval passes.
+  ReceiveFrame(24);
+  Sniffer_Tasks();
+  EXPECT_TRUE(Sniffer_NextDeadline(&delay));
+  EXPECT_EQ(SNIFFER_FLUSH_INTERVAL - 4u, delay);
+
+  // Once it's sent, there's no deadline.
+  EXPECT_CALL(m_timer_mock, HasElapsed(_, SNIFFER_FLUSH_INTERVAL))
+      .WillRepeatedly(Return(true));
+  CaptureMessages();
+  Sniffer_Tasks();
+  EXPECT_EQ(1u, m_messages.size());
+  EXPECT_FALSE(Sniffer_NextDeadline(&delay));
+}
+
+TEST_F(SnifferTest, splitRecords) {
+  ReceiveFrame(DMX_FRAME_SIZE + 1);
+  ReceiveFrame(DMX_FRAME_SIZE + 1);
+  CaptureMessages();
+  Sniffer_Tasks();
+  Sniffer_Tasks();
+  Sniffer_Tasks();
+  Sniffer_Tasks();
+
+  // Reassemble the fragments.
+  vector<vector<uint8_t> > frames;
+  for (const vector<uint8_t> &message : m_messages) {
+    ASSERT_LE(message.size(), static_cast<size_t>(PAYLOAD_SIZE));
+    EXPECT_EQ(0u, ReadUInt32(message, 0));
+    unsigned int i = 4;
+    while (i < message.size()) {
+      uint16_t length = ReadUInt16(message, i + 8);
+      uint16_t offset = ReadUInt16(message, i + 10);
+      unsigned int size = std::min<unsigned int>(
+          length - offset, message.size() - i - SNIFFER_FRAGMENT_HEADER_SIZE);
+      if (offset == 0) {
+        frames.push_back(vector<uint8_t>());
+      }
+      ASSERT_FALSE(frames.empty());
+      EXPECT_EQ(offset, frames.back().size());
+      const uint8_t *data = &message[i + SNIFFER_FRAGMENT_HEADER_SIZE];
+      frames.back().insert(frames.back().end(), data, data + size);
+      i += SNIFFER_FRAGMENT_HEADER_SIZE + size;
+    }
+  }
+
+  ASSERT_EQ(2u, frames.size());
+  for (const vector<uint8_t> &frame : frames) {
+    EXPECT_THAT(ArrayTuple(frame.data(), frame.size()),
+                DataIs(m_frame, arraysize(m_frame)));
+  }
+}
+
+TEST_F(SnifferTest, droppedFrames) {
+  // The buffer holds 7 full frames, the rest are dropped.
+  for (unsigned int i = 0; i < 10; i++) {
+    ReceiveFrame(DMX_FRAME_SIZE + 1);
+  }
+
+  CaptureMessages();
+  Sniffer_Tasks();
+  ASSERT_EQ(1u, m_messages.size());
+  EXPECT_EQ(3u, ReadUInt32(m_messages[0], 0));
+
+  // The counter is reset once it's been sent.
+  Sniffer_Tasks();
+  ASSERT_EQ(2u, m_messages.size());
+  EXPECT_EQ(0u, ReadUInt32(m_messages[1], 0));
+}
+
+TEST_F(SnifferTest, sendFailure) {
+  ReceiveFrame(4);
+
+  EXPECT_CALL(m_transport_mock,
+              Send(EVENT_TOKEN, COMMAND_SNIFFER_DATA, RC_OK, _, 1))
+      .WillOnce(Return(false));
+  Sniffer_Tasks();
+
+  // The record is sent on the next attempt.
+  CaptureMessages();
+  Sniffer_Tasks();
+  ASSERT_EQ(1u, m_messages.size());
+  EXPECT_EQ(4u + SNIFFER_FRAGMENT_HEADER_SIZE + 4u, m_messages[0].size());
+}
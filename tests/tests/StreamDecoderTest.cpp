@@ -95,9 +95,12 @@ TEST_F(StreamDecoderTest, fragmentedMessage) {
 
   // Split the calls to StreamDecoder_Process in the middle of the payload data.
   unsigned int split_index = PAYLOAD_OFFSET + MSG1_PAYLOAD_SIZE / 2;
+  EXPECT_EQ(PAYLOAD_SIZE, StreamDecoder_FreeSpace());
   StreamDecoder_Process(message1, split_index);
+  EXPECT_EQ(PAYLOAD_SIZE - MSG1_PAYLOAD_SIZE / 2, StreamDecoder_FreeSpace());
   StreamDecoder_Process(message1 + split_index,
                         arraysize(message1) - split_index);
+  EXPECT_EQ(PAYLOAD_SIZE, StreamDecoder_FreeSpace());
 
   EXPECT_TRUE(StreamDecoder_GetFragmentedFrameFlag());
   StreamDecoder_ClearFragmentedFrameFlag();
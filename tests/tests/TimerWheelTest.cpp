@@ -0,0 +1,254 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * TimerWheelTest.cpp
+ * Tests for the timer wheel code.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+
+#include "coarse_timer.h"
+#include "sys_int_mock.h"
+#include "timer_wheel.h"
+
+namespace {
+
+unsigned int g_count1 = 0u;
+unsigned int g_count2 = 0u;
+TimerWheel_Timer g_timer1;
+TimerWheel_Timer g_timer2;
+
+void Callback1() {
+  g_count1++;
+}
+
+void Callback2() {
+  g_count2++;
+}
+
+void CancelSelf() {
+  g_count1++;
+  TimerWheel_Cancel(&g_timer1);
+}
+
+void StartOther() {
+  g_count1++;
+  TimerWheel_Add(&g_timer2, 0u, 0u, Callback2);
+}
+}  // namespace
+
+class TimerWheelTest : public ::testing::TestWithParam<uint32_t> {
+ public:
+  void SetUp() {
+    SYS_INT_SetMock(&m_sys_int_mock);
+    CoarseTimer_Settings timer_settings = {
+      .timer_id = TMR_ID_2,
+      .interrupt_source = INT_SOURCE_TIMER_2
+    };
+    CoarseTimer_Initialize(&timer_settings);
+    CoarseTimer_SetCounter(GetParam());
+    TimerWheel_Initialize();
+    g_count1 = 0u;
+    g_count2 = 0u;
+  }
+
+  void TearDown() {
+    SYS_INT_SetMock(NULL);
+  }
+
+  // Advance the time, running the wheel every 10th of a millisecond.
+  void Advance(uint32_t interval) {
+    for (uint32_t i = 0; i < interval; i++) {
+      CoarseTimer_TimerEvent();
+      TimerWheel_Tasks();
+    }
+  }
+
+  testing::NiceMock<MockSysInt> m_sys_int_mock;
+};
+
+TEST_P(TimerWheelTest, oneShot) {
+  TimerWheel_Add(&g_timer1, 25u, 0u, Callback1);
+  EXPECT_TRUE(TimerWheel_IsActive(&g_timer1));
+
+  // Timers never fire early.
+  Advance(25u);
+  EXPECT_EQ(0u, g_count1);
+  Advance(TIMER_WHEEL_RESOLUTION);
+  EXPECT_EQ(1u, g_count1);
+  EXPECT_FALSE(TimerWheel_IsActive(&g_timer1));
+
+  Advance(1000u);
+  EXPECT_EQ(1u, g_count1);
+}
+
+TEST_P(TimerWheelTest, periodic) {
+  TimerWheel_Add(&g_timer1, 100u, 200u, Callback1);
+  Advance(110u);
+  EXPECT_EQ(1u, g_count1);
+  Advance(200u);
+  EXPECT_EQ(2u, g_count1);
+
+  // The period doesn't drift.
+  Advance(200u * 100u);
+  EXPECT_EQ(102u, g_count1);
+  EXPECT_TRUE(TimerWheel_IsActive(&g_timer1));
+
+  TimerWheel_Cancel(&g_timer1);
+  EXPECT_FALSE(TimerWheel_IsActive(&g_timer1));
+  Advance(1000u);
+  EXPECT_EQ(102u, g_count1);
+
+  // Cancelling twice is fine.
+  TimerWheel_Cancel(&g_timer1);
+}
+
+TEST_P(TimerWheelTest, restart) {
+  TimerWheel_Add(&g_timer1, 100u, 0u, Callback1);
+  Advance(50u);
+  TimerWheel_Add(&g_timer1, 100u, 0u, Callback1);
+  Advance(100u);
+  EXPECT_EQ(0u, g_count1);
+  Advance(TIMER_WHEEL_RESOLUTION);
+  EXPECT_EQ(1u, g_count1);
+}
+
+TEST_P(TimerWheelTest, longDelay) {
+  // Several revolutions of the wheel.
+  const uint32_t delay = 5u * TIMER_WHEEL_SLOTS * TIMER_WHEEL_RESOLUTION + 35u;
+  TimerWheel_Add(&g_timer1, delay, 0u, Callback1);
+  TimerWheel_Add(&g_timer2, 35u, 0u, Callback2);
+  Advance(delay);
+  EXPECT_EQ(0u, g_count1);
+  EXPECT_EQ(1u, g_count2);
+  Advance(TIMER_WHEEL_RESOLUTION);
+  EXPECT_EQ(1u, g_count1);
+}
+
+TEST_P(TimerWheelTest, sameSlot) {
+  TimerWheel_Add(&g_timer1, 50u, 50u, Callback1);
+  TimerWheel_Add(&g_timer2, 50u, 50u, Callback2);
+  Advance(60u);
+  EXPECT_EQ(1u, g_count1);
+  EXPECT_EQ(1u, g_count2);
+
+  TimerWheel_Cancel(&g_timer2);
+  Advance(50u);
+  EXPECT_EQ(2u, g_count1);
+  EXPECT_EQ(1u, g_count2);
+}
+
+TEST_P(TimerWheelTest, callbacks) {
+  // A periodic timer can cancel itself.
+  TimerWheel_Add(&g_timer1, 10u, 10u, CancelSelf);
+  Advance(1000u);
+  EXPECT_EQ(1u, g_count1);
+  EXPECT_FALSE(TimerWheel_IsActive(&g_timer1));
+
+  // A callback can add timers.
+  TimerWheel_Add(&g_timer1, 10u, 0u, StartOther);
+  Advance(20u);
+  EXPECT_EQ(2u, g_count1);
+  EXPECT_EQ(0u, g_count2);
+  Advance(TIMER_WHEEL_RESOLUTION);
+  EXPECT_EQ(1u, g_count2);
+}
+
+TEST_P(TimerWheelTest, catchUp) {
+  TimerWheel_Add(&g_timer1, 0u, 100u, Callback1);
+  TimerWheel_Add(&g_timer2, 500u, 0u, Callback2);
+
+  // The main loop was busy for 1s.
+  for (unsigned int i = 0; i < 10000u; i++) {
+    CoarseTimer_TimerEvent();
+  }
+  TimerWheel_Tasks();
+  EXPECT_EQ(100u, g_count1);
+  EXPECT_EQ(1u, g_count2);
+}
+
+TEST_P(TimerWheelTest, nextDeadline) {
+  uint32_t delay = 0u;
+  EXPECT_FALSE(TimerWheel_NextDeadline(&delay));
+
+  const uint32_t long_delay = 5u * TIMER_WHEEL_SLOTS * TIMER_WHEEL_RESOLUTION;
+  TimerWheel_Add(&g_timer1, 1000u, 0u, Callback1);
+  TimerWheel_Add(&g_timer2, long_delay, 0u, Callback2);
+  EXPECT_TRUE(TimerWheel_NextDeadline(&delay));
+  EXPECT_EQ(1010u, delay);
+
+  Advance(505u);
+  EXPECT_TRUE(TimerWheel_NextDeadline(&delay));
+  EXPECT_EQ(505u, delay);
+
+  Advance(505u);
+  EXPECT_EQ(1u, g_count1);
+  EXPECT_TRUE(TimerWheel_NextDeadline(&delay));
+  EXPECT_EQ(long_delay + TIMER_WHEEL_RESOLUTION - 1010u, delay);
+
+  // If the wheel is behind, the deadline has passed.
+  for (unsigned int i = 0; i < 7000u; i++) {
+    CoarseTimer_TimerEvent();
+  }
+  EXPECT_TRUE(TimerWheel_NextDeadline(&delay));
+  EXPECT_EQ(0u, delay);
+}
+
+TEST_P(TimerWheelTest, nextDeadlineAfterCancel) {
+  uint32_t delay = 0u;
+  TimerWheel_Add(&g_timer1, 1000u, 0u, Callback1);
+  TimerWheel_Add(&g_timer2, 3000u, 0u, Callback2);
+  EXPECT_TRUE(TimerWheel_NextDeadline(&delay));
+  EXPECT_EQ(1010u, delay);
+
+  // Cancelling the earliest timer moves the deadline out.
+  TimerWheel_Cancel(&g_timer1);
+  EXPECT_TRUE(TimerWheel_NextDeadline(&delay));
+  EXPECT_EQ(3010u, delay);
+
+  // Cancelling a later timer leaves it alone.
+  TimerWheel_Add(&g_timer1, 2000u, 0u, Callback1);
+  EXPECT_TRUE(TimerWheel_NextDeadline(&delay));
+  EXPECT_EQ(2010u, delay);
+  TimerWheel_Cancel(&g_timer2);
+  EXPECT_TRUE(TimerWheel_NextDeadline(&delay));
+  EXPECT_EQ(2010u, delay);
+
+  TimerWheel_Cancel(&g_timer1);
+  EXPECT_FALSE(TimerWheel_NextDeadline(&delay));
+
+  // Once the earliest timer fires, the deadline is the next one.
+  TimerWheel_Add(&g_timer1, 100u, 0u, Callback1);
+  TimerWheel_Add(&g_timer2, 300u, 0u, Callback2);
+  EXPECT_TRUE(TimerWheel_NextDeadline(&delay));
+  EXPECT_EQ(110u, delay);
+  Advance(110u);
+  EXPECT_EQ(1u, g_count1);
+  EXPECT_TRUE(TimerWheel_NextDeadline(&delay));
+  EXPECT_EQ(200u, delay);
+}
+
+TEST_P(TimerWheelTest, initialize) {
+  TimerWheel_Add(&g_timer1, 10u, 10u, Callback1);
+  TimerWheel_Initialize();
+  EXPECT_FALSE(TimerWheel_IsActive(&g_timer1));
+  Advance(100u);
+  EXPECT_EQ(0u, g_count1);
+}
+
+INSTANTIATE_TEST_CASE_P(InstantiationName,
+                        TimerWheelTest,
+                        ::testing::Values(0, 5, 0xfffffff0));
@@ -0,0 +1,134 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * TraceTest.cpp
+ * Tests for the trace recorder.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "Array.h"
+#include "CoarseTimerMock.h"
+#include "trace.h"
+
+using ::testing::DoAll;
+using ::testing::InvokeWithoutArgs;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+namespace {
+
+// Simulates an ISR that preempts Trace_Record().
+void NestedRecord() {
+  Trace_Record(2, TRACE_EVENT_UART, 7u);
+}
+
+}  // namespace
+
+class TraceTest : public testing::Test {
+ public:
+  void SetUp() {
+    CoarseTimer_SetMock(&m_coarse_timer);
+    Trace_Initialize();
+  }
+
+  void TearDown() {
+    CoarseTimer_SetMock(nullptr);
+  }
+
+ protected:
+  NiceMock<MockCoarseTimer> m_coarse_timer;
+};
+
+TEST_F(TraceTest, empty) {
+  TraceRecord records[4];
+  uint32_t lost = 99u;
+  EXPECT_EQ(0u, Trace_Read(records, arraysize(records), &lost));
+  EXPECT_EQ(0u, lost);
+}
+
+TEST_F(TraceTest, recordAndRead) {
+  EXPECT_CALL(m_coarse_timer, GetMicroseconds())
+      .WillOnce(Return(100u))
+      .WillOnce(Return(144u))
+      .WillOnce(Return(232u));
+
+  Trace_Record(1, TRACE_EVENT_STATE_CHANGE, 0u);
+  Trace_Record(1, TRACE_EVENT_TIMER, 0u);
+  Trace_Record(2, TRACE_EVENT_STATE_CHANGE, 3u);
+
+  TraceRecord records[2];
+  uint32_t lost = 99u;
+  EXPECT_EQ(2u, Trace_Read(records, arraysize(records), &lost));
+  EXPECT_EQ(0u, lost);
+  EXPECT_EQ(100u, records[0].timestamp);
+  EXPECT_EQ(1, records[0].state);
+  EXPECT_EQ(TRACE_EVENT_STATE_CHANGE, records[0].event);
+  EXPECT_EQ(0u, records[0].data_index);
+  EXPECT_EQ(144u, records[1].timestamp);
+  EXPECT_EQ(TRACE_EVENT_TIMER, records[1].event);
+
+  EXPECT_EQ(1u, Trace_Read(records, arraysize(records), &lost));
+  EXPECT_EQ(0u, lost);
+  EXPECT_EQ(232u, records[0].timestamp);
+  EXPECT_EQ(2, records[0].state);
+  EXPECT_EQ(3u, records[0].data_index);
+
+  EXPECT_EQ(0u, Trace_Read(records, arraysize(records), &lost));
+}
+
+TEST_F(TraceTest, nestedRecord) {
+  EXPECT_CALL(m_coarse_timer, GetMicroseconds())
+      .WillOnce(DoAll(InvokeWithoutArgs(NestedRecord), Return(100u)))
+      .WillOnce(Return(104u));
+
+  Trace_Record(1, TRACE_EVENT_TIMER, 3u);
+
+  TraceRecord records[4];
+  uint32_t lost = 99u;
+  ASSERT_EQ(2u, Trace_Read(records, arraysize(records), &lost));
+  EXPECT_EQ(0u, lost);
+  EXPECT_EQ(100u, records[0].timestamp);
+  EXPECT_EQ(1, records[0].state);
+  EXPECT_EQ(TRACE_EVENT_TIMER, records[0].event);
+  EXPECT_EQ(3u, records[0].data_index);
+  EXPECT_EQ(104u, records[1].timestamp);
+  EXPECT_EQ(2, records[1].state);
+  EXPECT_EQ(TRACE_EVENT_UART, records[1].event);
+  EXPECT_EQ(7u, records[1].data_index);
+}
+
+TEST_F(TraceTest, overflow) {
+  // Write twice the buffer size, the reader should skip to the newest
+  // records, leaving a margin for records added during the read.
+  for (unsigned int i = 0; i < 2 * TRACE_BUFFER_SIZE; i++) {
+    Trace_Record(0, TRACE_EVENT_UART, i);
+  }
+
+  TraceRecord records[TRACE_BUFFER_SIZE];
+  uint32_t lost = 0u;
+  unsigned int count = Trace_Read(records, arraysize(records), &lost);
+  EXPECT_LT(count, static_cast<unsigned int>(TRACE_BUFFER_SIZE));
+  EXPECT_EQ(2u * TRACE_BUFFER_SIZE, count + lost);
+  EXPECT_EQ(lost, records[0].data_index);
+  EXPECT_EQ(2u * TRACE_BUFFER_SIZE - 1, records[count - 1].data_index);
+
+  // The lost count is reset.
+  Trace_Record(0, TRACE_EVENT_UART, 0u);
+  EXPECT_EQ(1u, Trace_Read(records, arraysize(records), &lost));
+  EXPECT_EQ(0u, lost);
+}
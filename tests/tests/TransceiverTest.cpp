@@ -21,15 +21,36 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <vector>
+
 #include "Array.h"
+#include "dmx_spec.h"
+#include "plib_usart_mock.h"
+#include "sys_int_mock.h"
 #include "transceiver.h"
 #include "setting_macros.h"
 
 using ::testing::Args;
+using ::testing::ElementsAreArray;
+using ::testing::Invoke;
+using ::testing::NiceMock;
 using ::testing::StrictMock;
 using ::testing::Return;
 using ::testing::Field;
 using ::testing::_;
+using std::vector;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint8_t Transceiver_FreeBufferCount();
+void Transceiver_TimerEvent();
+void Transceiver_UARTEvent();
+
+#ifdef __cplusplus
+}
+#endif
 
 MATCHER_P3(EventIs, token, op, result, "") {
   return arg->token == token && arg->op == op && arg->result == result;
@@ -99,6 +120,7 @@ TEST_F(TransceiverTest, testModeChanges) {
   ASSERT_EQ(T_MODE_RESPONDER, Transceiver_GetMode());
   // In responder mode, the following are not permitted
   EXPECT_FALSE(Transceiver_QueueDMX(token, NULL, 0));
+  EXPECT_FALSE(Transceiver_QueueRLEDMX(token, NULL, 0));
   EXPECT_FALSE(Transceiver_QueueASC(token, 0xdd, NULL, 0));
   EXPECT_FALSE(Transceiver_QueueRDMDUB(token, NULL, 0));
   EXPECT_FALSE(Transceiver_QueueRDMRequest(token, NULL, 0, false));
@@ -111,6 +133,7 @@ TEST_F(TransceiverTest, testModeChanges) {
 
   // We still can't queue frames since the mode change hasn't completed yet
   EXPECT_FALSE(Transceiver_QueueDMX(token, NULL, 0));
+  EXPECT_FALSE(Transceiver_QueueRLEDMX(token, NULL, 0));
   EXPECT_FALSE(Transceiver_QueueASC(token, 0xdd, NULL, 0));
   EXPECT_FALSE(Transceiver_QueueRDMDUB(token, NULL, 0));
   EXPECT_FALSE(Transceiver_QueueRDMRequest(token, NULL, 0, false));
@@ -140,6 +163,7 @@ TEST_F(TransceiverTest, testModeChanges) {
 
   // In self-test mode the follow are not permitted
   EXPECT_FALSE(Transceiver_QueueDMX(token, NULL, 0));
+  EXPECT_FALSE(Transceiver_QueueRLEDMX(token, NULL, 0));
   EXPECT_FALSE(Transceiver_QueueASC(token, 0xdd, NULL, 0));
   EXPECT_FALSE(Transceiver_QueueRDMDUB(token, NULL, 0));
   EXPECT_FALSE(Transceiver_QueueRDMRequest(token, NULL, 0, false));
@@ -152,6 +176,32 @@ TEST_F(TransceiverTest, testModeChanges) {
   EXPECT_FALSE(Transceiver_SetMode(T_MODE_CONTROLLER, ++token));
 }
 
+TEST_F(TransceiverTest, testQueueWhileNextPending) {
+  TransceiverHardwareSettings settings = DefaultSettings();
+  Transceiver_Initialize(&settings, &EventHandler, &EventHandler);
+
+  uint8_t token = 1;
+  // Responder mode doesn't accept frames.
+  EXPECT_EQ(0, Transceiver_FreeSlots());
+  EXPECT_TRUE(Transceiver_SetMode(T_MODE_CONTROLLER, token));
+  EXPECT_CALL(m_event_handler,
+              Run(EventIs(token, T_OP_MODE_CHANGE, T_RESULT_OK)))
+    .WillOnce(Return(true));
+  Transceiver_Tasks();
+  ASSERT_EQ(T_MODE_CONTROLLER, Transceiver_GetMode());
+  EXPECT_EQ(1, Transceiver_FreeSlots());
+
+  // There are free buffers, but the first frame hasn't been taken yet so the
+  // second must be rejected rather than replacing it.
+  const uint8_t dmx[] = {1, 2, 3};
+  EXPECT_TRUE(Transceiver_QueueDMX(++token, dmx, arraysize(dmx)));
+  EXPECT_EQ(1, Transceiver_FreeBufferCount());
+  EXPECT_EQ(0, Transceiver_FreeSlots());
+  EXPECT_FALSE(Transceiver_QueueDMX(++token, dmx, arraysize(dmx)));
+  EXPECT_FALSE(Transceiver_QueueRLEDMX(token, NULL, 0));
+  EXPECT_EQ(1, Transceiver_FreeBufferCount());
+}
+
 TEST_F(TransceiverTest, testSetBreakTime) {
   TransceiverHardwareSettings settings = DefaultSettings();
   Transceiver_Initialize(&settings, NULL, NULL);
@@ -263,3 +313,49 @@ TEST_F(TransceiverTest, testSetResponderJitter) {
   EXPECT_EQ(11000, Transceiver_GetRDMResponderDelay());
   EXPECT_EQ(9000, Transceiver_GetRDMResponderJitter());
 }
+
+TEST_F(TransceiverTest, testControllerTxRLEDMX) {
+  NiceMock<MockPeripheralUSART> usart;
+  NiceMock<MockSysInt> sys_int;
+  PLIB_USART_SetMock(&usart);
+  SYS_INT_SetMock(&sys_int);
+
+  vector<uint8_t> tx_bytes;
+  ON_CALL(usart, TransmitterByteSend(_, _))
+    .WillByDefault(Invoke([&tx_bytes](USART_MODULE_ID, int8_t data) {
+      tx_bytes.push_back(data);
+    }));
+  ON_CALL(sys_int, SourceStatusGet(_)).WillByDefault(Return(true));
+
+  TransceiverHardwareSettings settings = DefaultSettings();
+  Transceiver_Initialize(&settings, &EventHandler, &EventHandler);
+
+  uint8_t token = 1;
+  EXPECT_TRUE(Transceiver_SetMode(T_MODE_CONTROLLER, token));
+  EXPECT_CALL(m_event_handler,
+              Run(EventIs(token, T_OP_MODE_CHANGE, T_RESULT_OK)))
+    .WillOnce(Return(true));
+  Transceiver_Tasks();
+  ASSERT_EQ(T_MODE_CONTROLLER, Transceiver_GetMode());
+
+  // A literal of 3 slots, followed by a run of 4 x 0xff.
+  const uint8_t encoded[] = {0x02, 1, 2, 3, 0xc3, 0xff};
+  const uint8_t expected[] = {NULL_START_CODE, 1, 2, 3, 0xff, 0xff, 0xff, 0xff};
+  EXPECT_TRUE(Transceiver_QueueRLEDMX(++token, encoded, arraysize(encoded)));
+
+  // Break, mark, then the data & the drain.
+  Transceiver_Tasks();
+  Transceiver_TimerEvent();
+  Transceiver_TimerEvent();
+  Transceiver_UARTEvent();
+  Transceiver_UARTEvent();
+  EXPECT_THAT(tx_bytes, ElementsAreArray(expected));
+
+  EXPECT_CALL(m_event_handler,
+              Run(EventIs(token, T_OP_TX_DMX_RLE, T_RESULT_OK)))
+    .WillOnce(Return(true));
+  Transceiver_Tasks();
+
+  PLIB_USART_SetMock(nullptr);
+  SYS_INT_SetMock(nullptr);
+}
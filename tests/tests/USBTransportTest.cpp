@@ -29,16 +29,19 @@
 #include "Matchers.h"
 #include "ResetMock.h"
 #include "StreamDecoderMock.h"
+#include "TransceiverMock.h"
 #include "flags.h"
 #include "usb_device_mock.h"
 #include "usb_transport.h"
 
 using ::testing::Args;
+using ::testing::DoAll;
 using ::testing::InSequence;
 using ::testing::Mock;
 using ::testing::NotNull;
 using ::testing::Pointee;
 using ::testing::Return;
+using ::testing::ReturnPointee;
 using ::testing::SaveArg;
 using ::testing::StrictMock;
 using ::testing::_;
@@ -50,13 +53,23 @@ class USBTransportTest : public testing::Test {
   void SetUp() {
     USBDevice_SetMock(&m_usb_mock);
     StreamDecoder_SetMock(&m_stream_decoder_mock);
+    Transceiver_SetMock(&m_transceiver_mock);
     BootloaderOptions_SetMock(&m_bootloader_options_mock);
     Reset_SetMock(&m_reset_mock);
+    Flags_Initialize(NULL);
+
+    // By default no credits are advertised, so the flags byte only contains
+    // the status bits.
+    EXPECT_CALL(m_stream_decoder_mock, FreeSpace())
+        .WillRepeatedly(ReturnPointee(&m_decoder_space));
+    EXPECT_CALL(m_transceiver_mock, FreeSlots())
+        .WillRepeatedly(ReturnPointee(&m_free_slots));
   }
 
   void TearDown() {
     USBDevice_SetMock(nullptr);
     StreamDecoder_SetMock(nullptr);
+    Transceiver_SetMock(nullptr);
     BootloaderOptions_SetMock(nullptr);
     Reset_SetMock(nullptr);
   }
@@ -67,6 +80,7 @@ class USBTransportTest : public testing::Test {
  protected:
   StrictMock<MockUSBDevice> m_usb_mock;
   StrictMock<MockStreamDecoder> m_stream_decoder_mock;
+  StrictMock<MockTransceiver> m_transceiver_mock;
   StrictMock<MockBootloaderOptions> m_bootloader_options_mock;
   StrictMock<MockReset> m_reset_mock;
 
@@ -81,6 +95,10 @@ class USBTransportTest : public testing::Test {
   // Pointer to the read buffer
   void *m_read_buffer = nullptr;
 
+  // The values returned by the credit functions.
+  unsigned int m_decoder_space = 0u;
+  uint8_t m_free_slots = 0u;
+
   static const uint8_t kToken = 99;
 };
 
@@ -498,3 +516,216 @@ TEST_F(USBTransportTest, pendingFlags) {
   CompleteWrite();
   EXPECT_FALSE(USBTransport_WritePending());
 }
+
+TEST_F(USBTransportTest, credits) {
+  USBTransport_Initialize(StreamDecoder_Process);
+  ConfigureDevice();
+
+  // The decoder credits saturate at 7.
+  m_free_slots = 1u;
+  m_decoder_space = PAYLOAD_SIZE;
+  const uint8_t expected_message[] = {
+    0x5a, kToken, 0xf0, 0x00, 0x00, 0x00, 0x00, 0xe8, 0xa5
+  };
+
+  EXPECT_CALL(
+      m_usb_mock,
+      EndpointWrite(m_usb_handle, _, 0x81, _, _,
+                    USB_DEVICE_TRANSFER_FLAGS_DATA_COMPLETE))
+      .With(Args<3, 4>(DataIs(expected_message, arraysize(expected_message))))
+      .WillOnce(Return(USB_DEVICE_RESULT_OK));
+
+  EXPECT_TRUE(USBTransport_SendResponse(kToken, COMMAND_ECHO, RC_OK, NULL, 0));
+  CompleteWrite();
+  USBTransport_Tasks();
+
+  // Partial credits are rounded down.
+  m_free_slots = 0u;
+  m_decoder_space = TRANSPORT_RX_CREDIT_SIZE * 2 - 1;
+  const uint8_t partial_message[] = {
+    0x5a, kToken, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x20, 0xa5
+  };
+
+  EXPECT_CALL(
+      m_usb_mock,
+      EndpointWrite(m_usb_handle, _, 0x81, _, _,
+                    USB_DEVICE_TRANSFER_FLAGS_DATA_COMPLETE))
+      .With(Args<3, 4>(DataIs(partial_message, arraysize(partial_message))))
+      .WillOnce(Return(USB_DEVICE_RESULT_OK));
+
+  EXPECT_TRUE(USBTransport_SendResponse(kToken, COMMAND_ECHO, RC_OK, NULL, 0));
+  CompleteWrite();
+}
+
+TEST_F(USBTransportTest, creditUpdate) {
+  USBTransport_Initialize(StreamDecoder_Process);
+  ConfigureDevice();
+
+  // The transceiver is busy, the decoder has space.
+  m_decoder_space = PAYLOAD_SIZE;
+  const uint8_t busy_message[] = {
+    0x5a, kToken, 0x30, 0x00, 0x00, 0x00, RC_BUFFER_FULL, 0xe0, 0xa5
+  };
+
+  EXPECT_CALL(
+      m_usb_mock,
+      EndpointWrite(m_usb_handle, _, 0x81, _, _,
+                    USB_DEVICE_TRANSFER_FLAGS_DATA_COMPLETE))
+      .With(Args<3, 4>(DataIs(busy_message, arraysize(busy_message))))
+      .WillOnce(Return(USB_DEVICE_RESULT_OK));
+
+  EXPECT_TRUE(
+      USBTransport_SendResponse(kToken, TX_DMX, RC_BUFFER_FULL, NULL, 0));
+
+  // Nothing has changed.
+  USBTransport_Tasks();
+  Mock::VerifyAndClearExpectations(&m_usb_mock);
+
+  // The update must wait for the pending write to complete.
+  m_free_slots = 1u;
+  USBTransport_Tasks();
+
+  const uint8_t update_message[] = {
+    0x5a, EVENT_TOKEN, 0x50, 0x00, 0x00, 0x00, RC_OK, 0xe8, 0xa5
+  };
+  EXPECT_CALL(
+      m_usb_mock,
+      EndpointWrite(m_usb_handle, _, 0x81, _, _,
+                    USB_DEVICE_TRANSFER_FLAGS_DATA_COMPLETE))
+      .With(Args<3, 4>(DataIs(update_message, arraysize(update_message))))
+      .WillOnce(Return(USB_DEVICE_RESULT_OK));
+
+  CompleteWrite();
+  USBTransport_Tasks();
+  CompleteWrite();
+
+  // Only a single update is sent.
+  USBTransport_Tasks();
+}
+
+TEST_F(USBTransportTest, responseDeferredByEvent) {
+  USBTransport_Initialize(StreamDecoder_Process);
+  ConfigureDevice();
+
+  const uint8_t payload[] = {1, 2};
+  IOVec iov = {payload, arraysize(payload)};
+
+  const uint8_t event_message[] = {
+    0x5a, EVENT_TOKEN, 0x51, 0x00, 0x02, 0x00, RC_OK, 0x00, 1, 2, 0xa5
+  };
+  const uint8_t response_message[] = {
+    0x5a, kToken, 0xf0, 0x00, 0x02, 0x00, RC_OK, 0x00, 1, 2, 0xa5
+  };
+
+  InSequence seq;
+  EXPECT_CALL(
+      m_usb_mock,
+      EndpointWrite(m_usb_handle, _, 0x81, _, _,
+                    USB_DEVICE_TRANSFER_FLAGS_DATA_COMPLETE))
+      .With(Args<3, 4>(DataIs(event_message, arraysize(event_message))))
+      .WillOnce(Return(USB_DEVICE_RESULT_OK));
+  EXPECT_CALL(
+      m_usb_mock,
+      EndpointWrite(m_usb_handle, _, 0x81, _, _,
+                    USB_DEVICE_TRANSFER_FLAGS_DATA_COMPLETE))
+      .With(Args<3, 4>(DataIs(response_message,
+                              arraysize(response_message))))
+      .WillOnce(Return(USB_DEVICE_RESULT_OK));
+
+  EXPECT_TRUE(USBTransport_SendResponse(EVENT_TOKEN, COMMAND_EVENT, RC_OK,
+                                        &iov, 1));
+  // A second event is rejected while the first is in flight.
+  EXPECT_FALSE(USBTransport_SendResponse(EVENT_TOKEN, COMMAND_EVENT, RC_OK,
+                                         &iov, 1));
+
+  // The response is held until the event has been written.
+  EXPECT_TRUE(USBTransport_SendResponse(kToken, COMMAND_ECHO, RC_OK, &iov, 1));
+  EXPECT_TRUE(USBTransport_WritePending());
+  EXPECT_FALSE(USBTransport_SendResponse(kToken, COMMAND_ECHO, RC_OK, &iov,
+                                         1));
+
+  CompleteWrite();
+  USBTransport_Tasks();
+  EXPECT_TRUE(USBTransport_WritePending());
+  CompleteWrite();
+  EXPECT_FALSE(USBTransport_WritePending());
+}
+
+TEST_F(USBTransportTest, deferredResponseRetried) {
+  USBTransport_Initialize(StreamDecoder_Process);
+  ConfigureDevice();
+
+  const uint8_t payload[] = {1, 2};
+  IOVec iov = {payload, arraysize(payload)};
+
+  const uint8_t response_message[] = {
+    0x5a, kToken, 0xf0, 0x00, 0x02, 0x00, RC_OK, 0x00, 1, 2, 0xa5
+  };
+
+  InSequence seq;
+  EXPECT_CALL(
+      m_usb_mock,
+      EndpointWrite(m_usb_handle, _, 0x81, _, _,
+                    USB_DEVICE_TRANSFER_FLAGS_DATA_COMPLETE))
+      .WillOnce(Return(USB_DEVICE_RESULT_OK));
+  EXPECT_CALL(
+      m_usb_mock,
+      EndpointWrite(m_usb_handle, _, 0x81, _, _,
+                    USB_DEVICE_TRANSFER_FLAGS_DATA_COMPLETE))
+      .With(Args<3, 4>(DataIs(response_message,
+                              arraysize(response_message))))
+      .WillOnce(Return(USB_DEVICE_RESULT_ERROR_TRANSFER_QUEUE_FULL))
+      .WillOnce(Return(USB_DEVICE_RESULT_OK));
+
+  EXPECT_TRUE(USBTransport_SendResponse(EVENT_TOKEN, COMMAND_EVENT, RC_OK,
+                                        &iov, 1));
+  EXPECT_TRUE(USBTransport_SendResponse(kToken, COMMAND_ECHO, RC_OK, &iov, 1));
+  CompleteWrite();
+
+  // The first attempt to write the deferred response fails, it must be kept.
+  USBTransport_Tasks();
+  EXPECT_TRUE(USBTransport_WritePending());
+
+  USBTransport_Tasks();
+  EXPECT_TRUE(USBTransport_WritePending());
+  CompleteWrite();
+  EXPECT_FALSE(USBTransport_WritePending());
+}
+
+TEST_F(USBTransportTest, largeEvent) {
+  USBTransport_Initialize(StreamDecoder_Process);
+  ConfigureDevice();
+
+  // Sniffer & DMX data events span many packets, they must not be truncated.
+  uint8_t payload[PAYLOAD_SIZE];
+  for (unsigned int i = 0; i < arraysize(payload); i++) {
+    payload[i] = i;
+  }
+  IOVec iovec = {payload, arraysize(payload)};
+
+  uint8_t expected_message[8 + PAYLOAD_SIZE + 1];
+  expected_message[0] = 0x5a;
+  expected_message[1] = EVENT_TOKEN;
+  expected_message[2] = 0x52;
+  expected_message[3] = 0x00;
+  expected_message[4] = 0x01;
+  expected_message[5] = 0x02;
+  expected_message[6] = RC_OK;
+  expected_message[7] = 0x00;  // flags, not truncated.
+  memcpy(expected_message + 8, payload, arraysize(payload));
+  expected_message[8 + PAYLOAD_SIZE] = 0xa5;
+  ASSERT_GT(arraysize(expected_message), USB_MAX_PACKET_SIZE);
+
+  EXPECT_CALL(
+      m_usb_mock,
+      EndpointWrite(m_usb_handle, _, 0x81, _, _,
+                    USB_DEVICE_TRANSFER_FLAGS_DATA_COMPLETE))
+      .With(Args<3, 4>(DataIs(expected_message, arraysize(expected_message))))
+      .WillOnce(Return(USB_DEVICE_RESULT_OK));
+
+  EXPECT_TRUE(USBTransport_SendResponse(EVENT_TOKEN, COMMAND_SNIFFER_DATA,
+                                        RC_OK, &iovec, 1));
+  EXPECT_TRUE(USBTransport_WritePending());
+  CompleteWrite();
+  EXPECT_FALSE(USBTransport_WritePending());
+}
@@ -0,0 +1,36 @@
+# Virtual Device
+##################################################
+# Runs the firmware natively, see tests/virtual/VirtualDevice.cpp, e.g.
+# ./tests/virtual/virtual_device -r 10 -s /tmp/ja-rule.sock
+noinst_PROGRAMS += tests/virtual/virtual_device
+
+tests_virtual_virtual_device_SOURCES = tests/virtual/VirtualDevice.cpp
+tests_virtual_virtual_device_CXXFLAGS = $(TESTING_CXXFLAGS) $(OLA_CFLAGS)
+tests_virtual_virtual_device_LDADD = \
+    tests/sim/libsim.la \
+    firmware/src/libcoarsetimer.la \
+    firmware/src/libdimmermodel.la \
+    firmware/src/libevents.la \
+    firmware/src/libflags.la \
+    firmware/src/libledmodel.la \
+    firmware/src/libmessagehandler.la \
+    firmware/src/libnetworkmodel.la \
+    firmware/src/libproxymodel.la \
+    firmware/src/librandom.la \
+    firmware/src/librdmbuffer.la \
+    firmware/src/librdmhandler.la \
+    firmware/src/librdmresponder.la \
+    firmware/src/librdmutil.la \
+    firmware/src/libreceivercounters.la \
+    firmware/src/libresponder.la \
+    firmware/src/libsniffer.la \
+    firmware/src/libstreamdecoder.la \
+    firmware/src/libtimerwheel.la \
+    firmware/src/libtransceiver.la \
+    firmware/src/libusbtransport.la \
+    tests/harmony/mocks/libharmonymock.la \
+    tests/mocks/libbootloaderoptionsmock.la \
+    tests/mocks/libresetmock.la \
+    tests/mocks/libspirgbmock.la \
+    tests/mocks/libsyslogmock.la \
+    $(OLA_LIBS) $(TESTING_LIBS)
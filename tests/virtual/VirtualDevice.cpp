@@ -0,0 +1,448 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * VirtualDevice.cpp
+ * Runs the firmware natively, as a virtual Ja Rule device.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "app.h"
+#include "coarse_timer.h"
+#include "constants.h"
+#include "dimmer_model.h"
+#include "dmx_forwarder.h"
+#include "events.h"
+#include "flags.h"
+#include "led_model.h"
+#include "message_handler.h"
+#include "network_model.h"
+#include "proxy_model.h"
+#include "rdm_handler.h"
+#include "rdm_responder.h"
+#include "receiver_counters.h"
+#include "responder.h"
+#include "setting_macros.h"
+#include "sniffer.h"
+#include "stream_decoder.h"
+#include "timer_wheel.h"
+#include "trace.h"
+#include "transceiver.h"
+#include "usb_transport.h"
+
+#include "tests/sim/InterruptController.h"
+#include "tests/sim/PeripheralInputCapture.h"
+#include "tests/sim/PeripheralPorts.h"
+#include "tests/sim/PeripheralTimer.h"
+#include "tests/sim/PeripheralUART.h"
+#include "tests/sim/PeripheralUSBDevice.h"
+#include "tests/sim/RS485Bus.h"
+#include "tests/sim/SignalGenerator.h"
+#include "tests/sim/SimulatedResponder.h"
+#include "tests/sim/Simulator.h"
+
+using std::string;
+using std::vector;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Declare the ISR symbols.
+void InputCaptureEvent(void);
+void Transceiver_TimerEvent();
+void Transceiver_UARTEvent();
+
+#ifdef __cplusplus
+}
+#endif
+
+namespace {
+
+const uint32_t kClockSpeed = 80000000;
+const uint32_t kBaudRate = 250000;
+const PORTS_CHANNEL kPort = PORT_CHANNEL_F;
+const PORTS_BIT_POS kBreakBit = PORTS_BIT_POS_8;
+const PORTS_BIT_POS kTXEnableBit = PORTS_BIT_POS_1;
+const uint8_t kDeviceUID[UID_LENGTH] = {0x7a, 0x70, 0, 0, 1, 0};
+// The simulated time to run between polls of the socket, in uS.
+const unsigned int kStepTime = 1000;
+
+volatile sig_atomic_t g_terminate = 0;
+
+void Terminate(int signal) {
+  (void) signal;
+  g_terminate = 1;
+}
+
+bool TransceiverTXEvent(const TransceiverEvent *event) {
+  MessageHandler_TransceiverEvent(event);
+  return true;
+}
+
+bool TransceiverRXEvent(const TransceiverEvent *event) {
+  if (Transceiver_GetMode() == T_MODE_SNIFFER) {
+    Sniffer_Receive(event);
+  } else {
+    Responder_Receive(event);
+  }
+  return true;
+}
+
+void SendRDMResponse(bool include_break, const IOVec *data,
+                     unsigned int iov_count) {
+  Transceiver_QueueRDMResponse(include_break, data, iov_count);
+}
+
+/*
+ * @brief The firmware, with the peripherals simulated.
+ *
+ * Only the modules which build natively are included. The temperature
+ * sensor, SPI pixel output, USB console and the moving light & sensor models
+ * are left out.
+ */
+class VirtualDevice {
+ public:
+  VirtualDevice()
+      : m_pin_callback(ola::NewCallback(&m_bus, &RS485Bus::ControllerPinChange)),
+        m_uart_callback(ola::NewCallback(&m_bus,
+                                         &RS485Bus::ControllerByteSent)),
+        m_usb_callback(ola::NewCallback(this, &VirtualDevice::USBWrite)),
+        m_app_task(ola::NewCallback(&APP_Tasks)),
+        m_simulator(kClockSpeed),
+        m_timer(&m_simulator, &m_interrupt_controller),
+        m_ic(&m_simulator, &m_interrupt_controller),
+        m_uart(&m_simulator, &m_interrupt_controller, m_uart_callback.get()),
+        m_ports(m_pin_callback.get()),
+        m_usb(&m_simulator, m_usb_callback.get(), kClockSpeed),
+        m_generator(&m_simulator, &m_ic, &m_uart, AS_IC_ID(2),
+                    AS_USART_ID(1), kClockSpeed, kBaudRate),
+        m_bus(&m_simulator, &m_generator, kPort, kBreakBit, kTXEnableBit,
+              kClockSpeed, kBaudRate),
+        m_client_fd(-1) {
+  }
+
+  void Init(unsigned int responder_count);
+  void Run(int listen_fd, bool real_time);
+
+ private:
+  std::unique_ptr<PeripheralPorts::PinChangeCallback> m_pin_callback;
+  std::unique_ptr<PeripheralUART::TXCallback> m_uart_callback;
+  std::unique_ptr<PeripheralUSBDevice::TXCallback> m_usb_callback;
+  std::unique_ptr<ola::Callback0<void>> m_app_task;
+
+  Simulator m_simulator;
+  InterruptController m_interrupt_controller;
+  PeripheralTimer m_timer;
+  PeripheralInputCapture m_ic;
+  PeripheralUART m_uart;
+  PeripheralPorts m_ports;
+  PeripheralUSBDevice m_usb;
+  SignalGenerator m_generator;
+  RS485Bus m_bus;
+  vector<std::unique_ptr<SimulatedResponder>> m_responders;
+
+  int m_client_fd;
+
+  void PollClient(int listen_fd);
+  void USBWrite(const uint8_t *data, unsigned int size);
+};
+
+void VirtualDevice::Init(unsigned int responder_count) {
+  PLIB_TMR_SetMock(&m_timer);
+  PLIB_IC_SetMock(&m_ic);
+  PLIB_USART_SetMock(&m_uart);
+  PLIB_PORTS_SetMock(&m_ports);
+  SYS_INT_SetMock(&m_interrupt_controller);
+  USBDevice_SetMock(&m_usb);
+
+  m_interrupt_controller.RegisterISR(INT_SOURCE_TIMER_1,
+      ola::NewCallback(&CoarseTimer_TimerEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_TIMER_3,
+      ola::NewCallback(&Transceiver_TimerEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_INPUT_CAPTURE_2,
+      ola::NewCallback(&InputCaptureEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_USART_1_ERROR,
+      ola::NewCallback(&Transceiver_UARTEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_USART_1_TRANSMIT,
+      ola::NewCallback(&Transceiver_UARTEvent));
+  m_interrupt_controller.RegisterISR(INT_SOURCE_USART_1_RECEIVE,
+      ola::NewCallback(&Transceiver_UARTEvent));
+
+  for (unsigned int i = 0; i < responder_count; i++) {
+    const uint8_t uid[UID_LENGTH] = {
+      0x7a, 0x70, 0, 0, static_cast<uint8_t>(2 + (i >> 8)),
+      static_cast<uint8_t>(i)
+    };
+    m_responders.emplace_back(new SimulatedResponder(&m_bus, uid));
+    m_bus.AddDevice(m_responders.back().get());
+  }
+
+  APP_Initialize();
+  m_simulator.AddTask(m_app_task.get());
+  m_usb.Connect();
+}
+
+/*
+ * @brief Run until we're terminated.
+ *
+ * The simulator is run in 1ms steps, in between the socket is polled for new
+ * data. If real_time is true, the simulated time is kept in step with the
+ * wall clock, otherwise we run as fast as possible.
+ */
+void VirtualDevice::Run(int listen_fd, bool real_time) {
+  auto start = std::chrono::steady_clock::now();
+  uint64_t start_cycle = m_simulator.Clock();
+
+  while (!g_terminate) {
+    PollClient(listen_fd);
+
+    m_simulator.SetClockLimit(kStepTime, false);
+    m_simulator.Run();
+
+    if (real_time) {
+      auto simulated = std::chrono::microseconds(
+          (m_simulator.Clock() - start_cycle) / (kClockSpeed / 1000000));
+      std::this_thread::sleep_until(start + simulated);
+    }
+  }
+
+  if (m_client_fd >= 0) {
+    close(m_client_fd);
+  }
+}
+
+void VirtualDevice::PollClient(int listen_fd) {
+  if (m_client_fd < 0) {
+    m_client_fd = accept(listen_fd, nullptr, nullptr);
+    return;
+  }
+
+  struct pollfd poll_fd = {m_client_fd, POLLIN, 0};
+  if (poll(&poll_fd, 1, 0) <= 0) {
+    return;
+  }
+
+  uint8_t data[1024];
+  ssize_t size = read(m_client_fd, data, sizeof(data));
+  if (size > 0) {
+    m_usb.HostWrite(data, size);
+  } else if (size == 0 || errno != EINTR) {
+    // The Host went away.
+    close(m_client_fd);
+    m_client_fd = -1;
+  }
+}
+
+void VirtualDevice::USBWrite(const uint8_t *data, unsigned int size) {
+  if (m_client_fd < 0) {
+    return;
+  }
+
+  while (size) {
+    ssize_t sent = send(m_client_fd, data, size, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      close(m_client_fd);
+      m_client_fd = -1;
+      return;
+    }
+    data += sent;
+    size -= sent;
+  }
+}
+
+int ListenOn(const string &path) {
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  if (fd < 0) {
+    perror("socket");
+    return -1;
+  }
+
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    printf("Socket path too long: %s\n", path.c_str());
+    close(fd);
+    return -1;
+  }
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  unlink(path.c_str());
+
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&address),
+           sizeof(address)) < 0 || listen(fd, 1) < 0) {
+    perror(path.c_str());
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+void Usage(const char *arg0) {
+  printf("Usage: %s [-f] [-r responders] [-s socket]\n\n"
+         "Runs the firmware natively, with the peripherals simulated. The\n"
+         "Host connects to the Unix socket & uses the same framing as the\n"
+         "USB device. The RS485 line is connected to a bus of simulated\n"
+         "responders.\n\n"
+         "  -f             Run faster than real time.\n"
+         "  -r responders  The number of responders on the bus.\n"
+         "  -s socket      The socket path, defaults to %s.\n",
+         arg0, "/tmp/ja-rule.sock");
+}
+}  // namespace
+
+void APP_Initialize(void) {
+  CoarseTimer_Settings timer_settings = {
+    .timer_id = AS_TIMER_ID(1),
+    .interrupt_source = AS_TIMER_INTERRUPT_SOURCE(1)
+  };
+  CoarseTimer_Initialize(&timer_settings);
+  TimerWheel_Initialize();
+  Trace_Initialize();
+
+  USBTransport_Initialize(&StreamDecoder_Process);
+
+  TransceiverHardwareSettings transceiver_settings = {
+    .usart = AS_USART_ID(1),
+    .usart_vector = AS_USART_INTERRUPT_VECTOR(1),
+    .usart_tx_source = AS_USART_INTERRUPT_TX_SOURCE(1),
+    .usart_rx_source = AS_USART_INTERRUPT_RX_SOURCE(1),
+    .usart_error_source = AS_USART_INTERRUPT_ERROR_SOURCE(1),
+    .port = kPort,
+    .break_bit = kBreakBit,
+    .tx_enable_bit = kTXEnableBit,
+    .rx_enable_bit = PORTS_BIT_POS_0,
+    .input_capture_module = AS_IC_ID(2),
+    .input_capture_vector = AS_IC_INTERRUPT_VECTOR(2),
+    .input_capture_source = AS_IC_INTERRUPT_SOURCE(2),
+    .timer_module_id = AS_TIMER_ID(3),
+    .timer_vector = AS_TIMER_INTERRUPT_VECTOR(3),
+    .timer_source = AS_TIMER_INTERRUPT_SOURCE(3),
+    .input_capture_timer = AS_IC_TMR_ID(3),
+  };
+  Transceiver_Initialize(&transceiver_settings, &TransceiverTXEvent,
+                         &TransceiverRXEvent);
+
+  RDMResponderSettings responder_settings;
+  responder_settings.identify_port = PORT_CHANNEL_D;
+  responder_settings.identify_bit = PORTS_BIT_POS_0;
+  responder_settings.mute_port = PORT_CHANNEL_D;
+  responder_settings.mute_bit = PORTS_BIT_POS_1;
+  memcpy(responder_settings.uid, kDeviceUID, UID_LENGTH);
+  RDMResponder_Initialize(&responder_settings);
+  ReceiverCounters_ResetCounters();
+  Responder_Initialize();
+
+  RDMHandlerSettings rdm_handler_settings = {
+    .default_model = LED_MODEL_ID,
+    .send_callback = &SendRDMResponse
+  };
+  RDMHandler_Initialize(&rdm_handler_settings);
+
+  // Keep these in Model ID order.
+  LEDModel_Initialize();
+  RDMHandler_AddModel(&LED_MODEL_ENTRY);
+
+  ProxyModel_Initialize();
+  RDMHandler_AddModel(&PROXY_MODEL_ENTRY);
+
+  NetworkModel_Initialize();
+  RDMHandler_AddModel(&NETWORK_MODEL_ENTRY);
+
+  DimmerModel_Initialize();
+  RDMHandler_AddModel(&DIMMER_MODEL_ENTRY);
+
+  MessageHandler_Initialize(&USBTransport_SendResponse);
+  StreamDecoder_Initialize(&MessageHandler_HandleMessage);
+
+  Flags_Initialize(&USBTransport_SendResponse);
+  Events_Initialize(&USBTransport_SendResponse);
+  Sniffer_Initialize(&USBTransport_SendResponse);
+  DMXForwarder_Initialize(&USBTransport_SendResponse);
+}
+
+void APP_Tasks(void) {
+  TimerWheel_Tasks();
+  USBTransport_Tasks();
+  Transceiver_Tasks();
+  // After the transceiver, so responses go ahead of events.
+  Events_Tasks();
+  Sniffer_Tasks();
+  DMXForwarder_Tasks();
+
+  if (Transceiver_GetMode() == T_MODE_RESPONDER) {
+    RDMHandler_Tasks();
+    Responder_Tasks();
+  }
+}
+
+void APP_Reset() {
+  Transceiver_Reset();
+  USBTransport_SoftReset();
+}
+
+int main(int argc, char *argv[]) {
+  bool real_time = true;
+  unsigned int responders = 0;
+  string socket_path = "/tmp/ja-rule.sock";
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-f") == 0) {
+      real_time = false;
+    } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      responders = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      socket_path = argv[++i];
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  int listen_fd = ListenOn(socket_path);
+  if (listen_fd < 0) {
+    return 1;
+  }
+
+  signal(SIGINT, Terminate);
+  signal(SIGTERM, Terminate);
+
+  VirtualDevice device;
+  device.Init(responders);
+  device.Run(listen_fd, real_time);
+
+  close(listen_fd);
+  unlink(socket_path.c_str());
+  return 0;
+}
@@ -1,16 +1,31 @@
 # Libraries
 ##################################################
-noinst_LTLIBRARIES += tools/libdfu.la
+noinst_LTLIBRARIES += tools/libdfu.la \
+                      tools/client/libjaruleclient.la
 tools_libdfu_la_SOURCES = tools/dfu.c \
                           tools/utils.c
 
+tools_client_libjaruleclient_la_SOURCES = \
+    tools/client/ByteTransport.h \
+    tools/client/Client.cpp \
+    tools/client/Client.h \
+    tools/client/DescriptorTransport.cpp \
+    tools/client/DescriptorTransport.h
+tools_client_libjaruleclient_la_CXXFLAGS = -I firmware/src \
+                                           $(WARNING_CXXFLAGS) -Wall -Werror
+
 # Programs
 ##################################################
 noinst_PROGRAMS += tools/hex2dfu \
+                   tools/trace2json \
                    tools/uid2dfu
 
 tools_hex2dfu_SOURCES = tools/hex2dfu.c
 tools_hex2dfu_LDADD = tools/libdfu.la
 
+tools_trace2json_SOURCES = tools/trace2json.cpp
+tools_trace2json_CXXFLAGS = -I firmware/src $(WARNING_CXXFLAGS) -Wall -Werror
+tools_trace2json_LDADD = tools/client/libjaruleclient.la
+
 tools_uid2dfu_SOURCES = tools/uid2dfu.c
 tools_uid2dfu_LDADD = tools/libdfu.la
@@ -0,0 +1,45 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * ByteTransport.h
+ * The interface between the client and the device.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#ifndef TOOLS_CLIENT_BYTETRANSPORT_H_
+#define TOOLS_CLIENT_BYTETRANSPORT_H_
+
+#include <stdint.h>
+
+namespace ja_rule {
+
+// Moves framed bytes between the Host and a Ja Rule device.
+//
+// Implementations may wrap a libusb bulk endpoint, a pipe to the simulator or
+// anything else that carries an ordered byte stream.
+class ByteTransport {
+ public:
+  virtual ~ByteTransport() {}
+
+  // Write data to the device, returns false if the transport has failed.
+  virtual bool Write(const uint8_t *data, unsigned int size) = 0;
+
+  // Read up to size bytes, waiting at most timeout_ms for data to arrive.
+  // Returns the number of bytes read, 0 on timeout or -1 if the transport
+  // has failed.
+  virtual int Read(uint8_t *data, unsigned int size, int timeout_ms) = 0;
+};
+}  // namespace ja_rule
+#endif  // TOOLS_CLIENT_BYTETRANSPORT_H_
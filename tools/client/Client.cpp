@@ -0,0 +1,302 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Client.cpp
+ * A pipelined Host side client for Ja Rule devices.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "Client.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace ja_rule {
+
+namespace {
+// SOM, token, command, length, EOM
+const unsigned int REQUEST_OVERHEAD = 7;
+const unsigned int READ_SIZE = 1024;
+}  // namespace
+
+const unsigned int Client::MAX_WINDOW_SIZE;
+
+Client::Client(ByteTransport *transport, const Options &options)
+    : m_transport(transport),
+      m_window_size(std::max(1u, std::min(options.window_size,
+                                           MAX_WINDOW_SIZE))),
+      m_timeout(options.timeout_ms),
+      m_failed(false),
+      m_next_token(0),
+      m_unmatched_responses(0),
+      m_malformed_frames(0),
+      // Until we hear from the device, assume it can take a single operation.
+      m_transceiver_credits(1),
+      m_state(STATE_START),
+      m_payload_size(0) {
+}
+
+Client::~Client() {
+  CancelAll();
+}
+
+bool Client::SendCommand(uint16_t command, const uint8_t *payload,
+                         unsigned int size, CompletionCallback callback) {
+  if (m_failed || size > PAYLOAD_SIZE) {
+    return false;
+  }
+
+  PendingCommand pending;
+  pending.command = command;
+  pending.payload.assign(payload, payload + size);
+  pending.callback = callback;
+  m_queue.push_back(pending);
+  SendQueuedCommands();
+  return !m_failed;
+}
+
+bool Client::Poll(int timeout_ms) {
+  if (m_failed) {
+    return false;
+  }
+
+  uint8_t data[READ_SIZE];
+  int r = m_transport->Read(data, READ_SIZE, timeout_ms);
+  if (r < 0) {
+    m_failed = true;
+    CancelAll();
+    return false;
+  }
+
+  for (int i = 0; i < r; i++) {
+    ProcessByte(data[i]);
+  }
+  ExpireCommands();
+  SendQueuedCommands();
+  return !m_failed;
+}
+
+bool Client::Flush() {
+  while (!m_in_flight.empty() || !m_queue.empty()) {
+    if (!Poll(m_timeout.count())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Client::SetFlagsChangedCallback(FlagsChangedCallback callback) {
+  m_flags_callback = callback;
+}
+
+void Client::SetEventCallback(EventCallback callback) {
+  m_event_callback = callback;
+}
+
+void Client::SendQueuedCommands() {
+  while (!m_failed && !m_queue.empty() &&
+         m_in_flight.size() < m_window_size) {
+    // Skip over tokens that are still in use, and the token the device uses
+    // for events.
+    while (m_next_token == EVENT_TOKEN ||
+           m_in_flight.find(m_next_token) != m_in_flight.end()) {
+      m_next_token++;
+    }
+    uint8_t token = m_next_token++;
+
+    PendingCommand pending = m_queue.front();
+    m_queue.pop_front();
+
+    InFlightCommand &in_flight = m_in_flight[token];
+    in_flight.command = pending.command;
+    in_flight.deadline = Clock::now() + m_timeout;
+    in_flight.callback = pending.callback;
+
+    if (!SendFrame(token, pending)) {
+      m_failed = true;
+      CancelAll();
+    }
+  }
+}
+
+bool Client::SendFrame(uint8_t token, const PendingCommand &command) {
+  std::vector<uint8_t> frame;
+  frame.reserve(command.payload.size() + REQUEST_OVERHEAD);
+  frame.push_back(START_OF_MESSAGE_ID);
+  frame.push_back(token);
+  frame.push_back(command.command & 0xff);
+  frame.push_back(command.command >> 8);
+  frame.push_back(command.payload.size() & 0xff);
+  frame.push_back(command.payload.size() >> 8);
+  frame.insert(frame.end(), command.payload.begin(), command.payload.end());
+  frame.push_back(END_OF_MESSAGE_ID);
+  return m_transport->Write(frame.data(), frame.size());
+}
+
+void Client::ProcessByte(uint8_t byte) {
+  switch (m_state) {
+    case STATE_START:
+      if (byte == START_OF_MESSAGE_ID) {
+        m_response = Response();
+        m_state = STATE_TOKEN;
+      }
+      break;
+    case STATE_TOKEN:
+      m_response.token = byte;
+      m_state = STATE_COMMAND_LO;
+      break;
+    case STATE_COMMAND_LO:
+      m_response.command = byte;
+      m_state = STATE_COMMAND_HI;
+      break;
+    case STATE_COMMAND_HI:
+      m_response.command |= byte << 8;
+      m_state = STATE_LENGTH_LO;
+      break;
+    case STATE_LENGTH_LO:
+      m_payload_size = byte;
+      m_state = STATE_LENGTH_HI;
+      break;
+    case STATE_LENGTH_HI:
+      m_payload_size |= byte << 8;
+      if (m_payload_size > PAYLOAD_SIZE) {
+        m_malformed_frames++;
+        m_state = STATE_START;
+      } else {
+        m_state = STATE_RC;
+      }
+      break;
+    case STATE_RC:
+      m_response.rc = byte;
+      m_state = STATE_FLAGS;
+      break;
+    case STATE_FLAGS:
+      m_response.flags = byte;
+      m_state = m_payload_size ? STATE_PAYLOAD : STATE_END;
+      break;
+    case STATE_PAYLOAD:
+      m_response.payload.push_back(byte);
+      if (m_response.payload.size() == m_payload_size) {
+        m_state = STATE_END;
+      }
+      break;
+    case STATE_END:
+      m_state = STATE_START;
+      if (byte == END_OF_MESSAGE_ID) {
+        HandleResponse();
+      } else {
+        m_malformed_frames++;
+      }
+      break;
+  }
+}
+
+void Client::HandleResponse() {
+  m_transceiver_credits = m_response.TransceiverCredits();
+  if (m_response.FlagsChanged() && m_flags_callback) {
+    m_flags_callback();
+  }
+
+  if (m_response.token == EVENT_TOKEN) {
+    // Sent by the device unprompted, there is no matching command.
+    if (m_response.command == COMMAND_EVENT && m_event_callback) {
+      HandleEvents();
+    }
+    return;
+  }
+
+  InFlightMap::iterator iter = m_in_flight.find(m_response.token);
+  if (iter == m_in_flight.end() ||
+      iter->second.command != m_response.command) {
+    m_unmatched_responses++;
+    return;
+  }
+
+  // Remove the entry before running the callback, since the callback may
+  // send another command.
+  CompletionCallback callback = iter->second.callback;
+  m_in_flight.erase(iter);
+  if (callback) {
+    callback(COMMAND_COMPLETED, m_response);
+  }
+}
+
+void Client::HandleEvents() {
+  const std::vector<uint8_t> &payload = m_response.payload;
+  for (unsigned int i = 0; i + EVENT_SIZE <= payload.size();
+       i += EVENT_SIZE) {
+    Event event;
+    event.type = payload[i];
+    event.arg = payload[i + 1];
+    event.value = payload[i + 2] | (payload[i + 3] << 8) |
+                  (payload[i + 4] << 16) |
+                  (static_cast<uint32_t>(payload[i + 5]) << 24);
+    m_event_callback(event);
+  }
+}
+
+void Client::ExpireCommands() {
+  // Collect the expired commands first, since the callbacks may send new
+  // commands.
+  std::vector<std::pair<Response, CompletionCallback> > expired;
+  Clock::time_point now = Clock::now();
+  InFlightMap::iterator iter = m_in_flight.begin();
+  while (iter != m_in_flight.end()) {
+    if (iter->second.deadline > now) {
+      ++iter;
+      continue;
+    }
+
+    Response response;
+    response.token = iter->first;
+    response.command = iter->second.command;
+    expired.push_back(std::make_pair(response, iter->second.callback));
+    m_in_flight.erase(iter++);
+  }
+
+  for (unsigned int i = 0; i < expired.size(); i++) {
+    if (expired[i].second) {
+      expired[i].second(COMMAND_TIMEOUT, expired[i].first);
+    }
+  }
+}
+
+void Client::CancelAll() {
+  // Swap out the commands first, in case a callback sends a new command.
+  InFlightMap in_flight;
+  in_flight.swap(m_in_flight);
+  std::deque<PendingCommand> queue;
+  queue.swap(m_queue);
+
+  for (InFlightMap::iterator iter = in_flight.begin();
+       iter != in_flight.end(); ++iter) {
+    Response response;
+    response.token = iter->first;
+    response.command = iter->second.command;
+    if (iter->second.callback) {
+      iter->second.callback(COMMAND_CANCELLED, response);
+    }
+  }
+
+  for (std::deque<PendingCommand>::iterator iter = queue.begin();
+       iter != queue.end(); ++iter) {
+    Response response;
+    response.command = iter->command;
+    if (iter->callback) {
+      iter->callback(COMMAND_CANCELLED, response);
+    }
+  }
+}
+}  // namespace ja_rule
@@ -0,0 +1,211 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Client.h
+ * A pipelined Host side client for Ja Rule devices.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#ifndef TOOLS_CLIENT_CLIENT_H_
+#define TOOLS_CLIENT_CLIENT_H_
+
+#include <stdint.h>
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "ByteTransport.h"
+#include "constants.h"
+#include "events.h"
+#include "transport.h"
+
+namespace ja_rule {
+
+// The outcome of a command.
+enum CommandResult {
+  COMMAND_COMPLETED,  // A response was received, check Response::rc.
+  COMMAND_TIMEOUT,  // No response was received in time.
+  COMMAND_CANCELLED,  // The transport failed or the client was destroyed.
+};
+
+// A response from the device.
+struct Response {
+  Response() : token(0), command(0), rc(0), flags(0) {}
+
+  uint8_t token;
+  uint16_t command;
+  uint8_t rc;
+  uint8_t flags;
+  std::vector<uint8_t> payload;
+
+  // True if the device's flags have changed, send a GET_FLAGS to read them.
+  bool FlagsChanged() const { return flags & TRANSPORT_FLAGS_CHANGED; }
+
+  // True if the device truncated the response payload.
+  bool Truncated() const { return flags & TRANSPORT_MSG_TRUNCATED; }
+
+  // The number of transmit operations the device can queue.
+  unsigned int TransceiverCredits() const {
+    return (flags & TRANSPORT_TX_CREDITS_MASK) >> TRANSPORT_TX_CREDITS_SHIFT;
+  }
+
+  // A lower bound on the free space in the device's stream decoder, in bytes.
+  unsigned int DecoderSpace() const {
+    return ((flags & TRANSPORT_RX_CREDITS_MASK) >> TRANSPORT_RX_CREDITS_SHIFT) *
+           TRANSPORT_RX_CREDIT_SIZE;
+  }
+};
+
+// An event the device sent unprompted, see EventType.
+struct Event {
+  uint8_t type;
+  uint8_t arg;
+  uint32_t value;
+};
+
+// Sends commands to a Ja Rule device.
+//
+// Rather than waiting for each response before sending the next command, up
+// to window_size commands are kept in flight. Responses are matched to
+// commands by token and the completion callback is run from within Poll().
+//
+// The flow control credits from the most recent response or
+// COMMAND_CREDIT_UPDATE are available from TransceiverCredits().
+//
+// The client is not thread safe.
+class Client {
+ public:
+  typedef std::function<void(CommandResult, const Response&)>
+      CompletionCallback;
+  typedef std::function<void()> FlagsChangedCallback;
+  typedef std::function<void(const Event&)> EventCallback;
+
+  struct Options {
+    Options() : window_size(4), timeout_ms(1000) {}
+
+    // The maximum number of commands in flight, 1 is stop-and-wait. This is
+    // capped at MAX_WINDOW_SIZE.
+    unsigned int window_size;
+    // How long to wait for a response.
+    unsigned int timeout_ms;
+  };
+
+  // Ownership of the transport is not transferred.
+  Client(ByteTransport *transport, const Options &options);
+
+  // Any outstanding commands are completed with COMMAND_CANCELLED.
+  ~Client();
+
+  // Queue a command for sending. If the window is open the command is sent
+  // immediately, otherwise it's sent once an earlier command completes.
+  // Returns false if the payload is too large or the transport has failed.
+  bool SendCommand(uint16_t command, const uint8_t *payload,
+                   unsigned int size, CompletionCallback callback);
+
+  // Read from the transport, waiting at most timeout_ms, and run the
+  // callbacks for any completed commands. Returns false if the transport has
+  // failed.
+  bool Poll(int timeout_ms);
+
+  // Poll until all commands have completed. Returns false if the transport
+  // has failed.
+  bool Flush();
+
+  // Called whenever a response has TRANSPORT_FLAGS_CHANGED set.
+  void SetFlagsChangedCallback(FlagsChangedCallback callback);
+
+  // Called for each event the device sends.
+  void SetEventCallback(EventCallback callback);
+
+  // The number of commands sent that haven't completed.
+  unsigned int InFlight() const { return m_in_flight.size(); }
+
+  // The number of commands waiting for the window to open.
+  unsigned int Queued() const { return m_queue.size(); }
+
+  // Responses with a token that didn't match an in-flight command.
+  unsigned int UnmatchedResponses() const { return m_unmatched_responses; }
+
+  // Frames that didn't end with END_OF_MESSAGE_ID.
+  unsigned int MalformedFrames() const { return m_malformed_frames; }
+
+  // The transceiver credits the device last advertised.
+  unsigned int TransceiverCredits() const { return m_transceiver_credits; }
+
+  static const unsigned int MAX_WINDOW_SIZE = 128;
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct PendingCommand {
+    uint16_t command;
+    std::vector<uint8_t> payload;
+    CompletionCallback callback;
+  };
+
+  struct InFlightCommand {
+    uint16_t command;
+    Clock::time_point deadline;
+    CompletionCallback callback;
+  };
+
+  typedef std::map<uint8_t, InFlightCommand> InFlightMap;
+
+  enum DecoderState {
+    STATE_START,
+    STATE_TOKEN,
+    STATE_COMMAND_LO,
+    STATE_COMMAND_HI,
+    STATE_LENGTH_LO,
+    STATE_LENGTH_HI,
+    STATE_RC,
+    STATE_FLAGS,
+    STATE_PAYLOAD,
+    STATE_END,
+  };
+
+  ByteTransport *m_transport;
+  const unsigned int m_window_size;
+  const std::chrono::milliseconds m_timeout;
+  bool m_failed;
+  uint8_t m_next_token;
+  std::deque<PendingCommand> m_queue;
+  InFlightMap m_in_flight;
+  FlagsChangedCallback m_flags_callback;
+  EventCallback m_event_callback;
+  unsigned int m_unmatched_responses;
+  unsigned int m_malformed_frames;
+  unsigned int m_transceiver_credits;
+
+  DecoderState m_state;
+  uint16_t m_payload_size;
+  Response m_response;
+
+  void SendQueuedCommands();
+  bool SendFrame(uint8_t token, const PendingCommand &command);
+  void ProcessByte(uint8_t byte);
+  void HandleResponse();
+  void HandleEvents();
+  void ExpireCommands();
+  void CancelAll();
+
+  Client(const Client&) = delete;
+  Client& operator=(const Client&) = delete;
+};
+}  // namespace ja_rule
+#endif  // TOOLS_CLIENT_CLIENT_H_
@@ -0,0 +1,72 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * DescriptorTransport.cpp
+ * A ByteTransport that uses file descriptors.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "DescriptorTransport.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace ja_rule {
+
+DescriptorTransport::DescriptorTransport(int read_fd, int write_fd)
+    : m_read_fd(read_fd),
+      m_write_fd(write_fd) {
+}
+
+bool DescriptorTransport::Write(const uint8_t *data, unsigned int size) {
+  while (size) {
+    ssize_t r = write(m_write_fd, data, size);
+    if (r < 0) {
+      if (errno == EINTR || errno == EAGAIN) {
+        continue;
+      }
+      return false;
+    }
+    data += r;
+    size -= r;
+  }
+  return true;
+}
+
+int DescriptorTransport::Read(uint8_t *data, unsigned int size,
+                              int timeout_ms) {
+  struct pollfd fds;
+  fds.fd = m_read_fd;
+  fds.events = POLLIN;
+  fds.revents = 0;
+
+  int r = poll(&fds, 1, timeout_ms);
+  if (r < 0) {
+    return errno == EINTR ? 0 : -1;
+  } else if (r == 0) {
+    return 0;
+  }
+
+  ssize_t bytes_read = read(m_read_fd, data, size);
+  if (bytes_read < 0) {
+    return (errno == EINTR || errno == EAGAIN) ? 0 : -1;
+  } else if (bytes_read == 0) {
+    // The other end has closed.
+    return -1;
+  }
+  return bytes_read;
+}
+}  // namespace ja_rule
@@ -0,0 +1,49 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * DescriptorTransport.h
+ * A ByteTransport that uses file descriptors.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#ifndef TOOLS_CLIENT_DESCRIPTORTRANSPORT_H_
+#define TOOLS_CLIENT_DESCRIPTORTRANSPORT_H_
+
+#include <stdint.h>
+
+#include "ByteTransport.h"
+
+namespace ja_rule {
+
+// A ByteTransport over a pair of file descriptors. This works with pipes,
+// sockets, ptys and the tty of a USB CDC device.
+class DescriptorTransport : public ByteTransport {
+ public:
+  // The descriptors are not closed when the transport is destroyed. The read
+  // and write descriptors may be the same.
+  DescriptorTransport(int read_fd, int write_fd);
+
+  bool Write(const uint8_t *data, unsigned int size);
+  int Read(uint8_t *data, unsigned int size, int timeout_ms);
+
+ private:
+  const int m_read_fd;
+  const int m_write_fd;
+
+  DescriptorTransport(const DescriptorTransport&) = delete;
+  DescriptorTransport& operator=(const DescriptorTransport&) = delete;
+};
+}  // namespace ja_rule
+#endif  // TOOLS_CLIENT_DESCRIPTORTRANSPORT_H_
@@ -0,0 +1,344 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * trace2json.cpp
+ * Fetch the transceiver trace from a device & write it as a Chrome trace.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <vector>
+
+#include "client/Client.h"
+#include "client/DescriptorTransport.h"
+#include "trace.h"
+#include "transceiver_state.h"
+
+namespace {
+
+const char DEFAULT_FILE[] = "trace.json";
+const unsigned int DEFAULT_DURATION = 5;
+
+// How long to wait before asking again when the trace is empty.
+const int EMPTY_POLL_MS = 10;
+
+struct Options {
+  const char *device;
+  const char *output_file;
+  unsigned int duration;
+};
+
+void DisplayHelpAndExit(const char *arg0, int exit_code) {
+  printf("Usage: %s [options] -d <device>\n", arg0);
+  printf("  -d, --device <path>  The tty or the virtual device's socket\n");
+  printf("  -h, --help           Show the help message\n");
+  printf("  -o, --output <file>  Output file, default to %s\n", DEFAULT_FILE);
+  printf("  -t, --time <s>       Seconds to capture for, default %u\n",
+         DEFAULT_DURATION);
+  exit(exit_code);
+}
+
+void InitOptions(Options *options, int argc, char *argv[]) {
+  options->device = NULL;
+  options->output_file = DEFAULT_FILE;
+  options->duration = DEFAULT_DURATION;
+
+  static struct option long_options[] = {
+      {"device", required_argument, 0, 'd'},
+      {"help", no_argument, 0, 'h'},
+      {"output", required_argument, 0, 'o'},
+      {"time", required_argument, 0, 't'},
+      {0, 0, 0, 0}
+    };
+
+  int c;
+  int option_index = 0;
+  while ((c = getopt_long(argc, argv, "d:ho:t:", long_options,
+                          &option_index)) != -1) {
+    switch (c) {
+      case 'd':
+        options->device = optarg;
+        break;
+      case 'h':
+        DisplayHelpAndExit(argv[0], EX_OK);
+        break;
+      case 'o':
+        options->output_file = optarg;
+        break;
+      case 't':
+        options->duration = atoi(optarg);
+        break;
+      default:
+        DisplayHelpAndExit(argv[0], EX_USAGE);
+    }
+  }
+  if (!options->device) {
+    DisplayHelpAndExit(argv[0], EX_USAGE);
+  }
+}
+
+// Open a tty, or connect to a Unix socket. Returns -1 on error.
+int OpenDevice(const char *path) {
+  struct stat info;
+  if (stat(path, &info) < 0) {
+    perror(path);
+    return -1;
+  }
+
+  if (!S_ISSOCK(info.st_mode)) {
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+      perror(path);
+    }
+    return fd;
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    perror("socket");
+    return -1;
+  }
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+              sizeof(address)) < 0) {
+    perror(path);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+const char *StateName(uint8_t state) {
+  switch (state) {
+    case STATE_C_INITIALIZE: return "C_INITIALIZE";
+    case STATE_C_TX_READY: return "C_TX_READY";
+    case STATE_C_IN_BREAK: return "C_IN_BREAK";
+    case STATE_C_IN_MARK: return "C_IN_MARK";
+    case STATE_C_TX_DATA: return "C_TX_DATA";
+    case STATE_C_TX_DRAIN: return "C_TX_DRAIN";
+    case STATE_C_RX_WAIT_FOR_BREAK: return "C_RX_WAIT_FOR_BREAK";
+    case STATE_C_RX_IN_BREAK: return "C_RX_IN_BREAK";
+    case STATE_C_RX_IN_MARK: return "C_RX_IN_MARK";
+    case STATE_C_RX_DATA: return "C_RX_DATA";
+    case STATE_C_RX_WAIT_FOR_DUB: return "C_RX_WAIT_FOR_DUB";
+    case STATE_C_RX_IN_DUB: return "C_RX_IN_DUB";
+    case STATE_C_RX_TIMEOUT: return "C_RX_TIMEOUT";
+    case STATE_C_COMPLETE: return "C_COMPLETE";
+    case STATE_C_BACKOFF: return "C_BACKOFF";
+    case STATE_R_INITIALIZE: return "R_INITIALIZE";
+    case STATE_R_RX_PREPARE: return "R_RX_PREPARE";
+    case STATE_R_RX_MBB: return "R_RX_MBB";
+    case STATE_R_RX_BREAK: return "R_RX_BREAK";
+    case STATE_R_RX_MARK: return "R_RX_MARK";
+    case STATE_R_RX_DATA: return "R_RX_DATA";
+    case STATE_R_TX_WAITING: return "R_TX_WAITING";
+    case STATE_R_TX_BREAK: return "R_TX_BREAK";
+    case STATE_R_TX_MARK: return "R_TX_MARK";
+    case STATE_R_TX_DATA: return "R_TX_DATA";
+    case STATE_R_TX_DRAIN: return "R_TX_DRAIN";
+    case STATE_R_TX_COMPLETE: return "R_TX_COMPLETE";
+    case STATE_T_INITIALIZE: return "T_INITIALIZE";
+    case STATE_T_TX_READY: return "T_TX_READY";
+    case STATE_T_RX_WAIT: return "T_RX_WAIT";
+    case STATE_T_VERIFY: return "T_VERIFY";
+    case STATE_RESET: return "RESET";
+    case STATE_ERROR: return "ERROR";
+    default: return "UNKNOWN";
+  }
+}
+
+const char *EventName(uint8_t event) {
+  switch (event) {
+    case TRACE_EVENT_INPUT_CAPTURE: return "InputCapture";
+    case TRACE_EVENT_TIMER: return "Timer";
+    case TRACE_EVENT_UART: return "UART";
+    default: return "Unknown";
+  }
+}
+
+// Writes the Chrome trace JSON. States are shown as duration events on one
+// track & the ISRs as instant events on another.
+class TraceWriter {
+ public:
+  explicit TraceWriter(FILE *out)
+      : m_out(out),
+        m_first(true),
+        m_have_state(false),
+        m_have_time(false),
+        m_last_raw(0),
+        m_time(0),
+        m_state(0),
+        m_state_start(0) {
+    fprintf(m_out, "{\"traceEvents\": [\n");
+  }
+
+  void Lost(uint32_t count) {
+    CloseState();
+    StartEvent();
+    fprintf(m_out, "{\"name\": \"lost\", \"ph\": \"i\", \"s\": \"g\", "
+            "\"ts\": %llu, \"pid\": 1, \"tid\": 1, "
+            "\"args\": {\"records\": %u}}", m_time, count);
+  }
+
+  void Record(const TraceRecord &record) {
+    // The device timestamp wraps every ~71 minutes, unwrap it.
+    if (m_have_time) {
+      m_time += static_cast<uint32_t>(record.timestamp - m_last_raw);
+    } else {
+      m_time = record.timestamp;
+      m_have_time = true;
+    }
+    m_last_raw = record.timestamp;
+
+    if (record.event == TRACE_EVENT_STATE_CHANGE) {
+      CloseState();
+      m_have_state = true;
+      m_state = record.state;
+      m_state_start = m_time;
+      m_state_index = record.data_index;
+      return;
+    }
+
+    StartEvent();
+    fprintf(m_out, "{\"name\": \"%s\", \"ph\": \"i\", \"s\": \"t\", "
+            "\"ts\": %llu, \"pid\": 1, \"tid\": 2, "
+            "\"args\": {\"state\": \"%s\", \"index\": %u}}",
+            EventName(record.event), m_time, StateName(record.state),
+            record.data_index);
+  }
+
+  void Finish() {
+    CloseState();
+    fprintf(m_out, "\n]}\n");
+  }
+
+ private:
+  FILE *m_out;
+  bool m_first;
+  bool m_have_state;
+  bool m_have_time;
+  uint32_t m_last_raw;
+  unsigned long long m_time;  // NOLINT(runtime/int)
+  uint8_t m_state;
+  unsigned long long m_state_start;  // NOLINT(runtime/int)
+  uint16_t m_state_index;
+
+  void StartEvent() {
+    if (!m_first) {
+      fprintf(m_out, ",\n");
+    }
+    m_first = false;
+  }
+
+  void CloseState() {
+    if (!m_have_state) {
+      return;
+    }
+    StartEvent();
+    fprintf(m_out, "{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %llu, "
+            "\"dur\": %llu, \"pid\": 1, \"tid\": 1, "
+            "\"args\": {\"index\": %u}}",
+            StateName(m_state), m_state_start, m_time - m_state_start,
+            m_state_index);
+    m_have_state = false;
+  }
+};
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  InitOptions(&options, argc, argv);
+
+  int fd = OpenDevice(options.device);
+  if (fd < 0) {
+    exit(EX_UNAVAILABLE);
+  }
+
+  FILE *out = fopen(options.output_file, "w");
+  if (!out) {
+    perror(options.output_file);
+    exit(EX_CANTCREAT);
+  }
+
+  ja_rule::DescriptorTransport transport(fd, fd);
+  ja_rule::Client client(&transport, ja_rule::Client::Options());
+  TraceWriter writer(out);
+
+  // Keep fetching until the time is up, backing off when the trace is empty.
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point end = Clock::now() +
+      std::chrono::seconds(options.duration);
+  unsigned int record_count = 0;
+  uint32_t lost_count = 0;
+  bool ok = true;
+  while (ok && Clock::now() < end) {
+    unsigned int count = 0;
+    client.SendCommand(
+        COMMAND_GET_TRACE, NULL, 0,
+        [&](ja_rule::CommandResult result, const ja_rule::Response &response) {
+          if (result != ja_rule::COMMAND_COMPLETED || response.rc != RC_OK ||
+              response.payload.size() < sizeof(uint32_t)) {
+            printf("GET_TRACE failed\n");
+            ok = false;
+            return;
+          }
+          uint32_t lost;
+          memcpy(&lost, response.payload.data(), sizeof(lost));
+          if (lost) {
+            writer.Lost(lost);
+            lost_count += lost;
+          }
+          count = (response.payload.size() - sizeof(lost)) /
+                  sizeof(TraceRecord);
+          for (unsigned int i = 0; i < count; i++) {
+            TraceRecord record;
+            memcpy(&record,
+                   response.payload.data() + sizeof(lost) +
+                       i * sizeof(TraceRecord),
+                   sizeof(record));
+            writer.Record(record);
+          }
+        });
+    if (!client.Flush()) {
+      ok = false;
+    }
+    record_count += count;
+    if (count == 0) {
+      usleep(EMPTY_POLL_MS * 1000);
+    }
+  }
+
+  writer.Finish();
+  fclose(out);
+  close(fd);
+  printf("Wrote %u records to %s, %u lost\n", record_count,
+         options.output_file, lost_count);
+  return ok ? EX_OK : EX_IOERR;
+}